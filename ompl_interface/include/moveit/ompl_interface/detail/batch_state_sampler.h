@@ -0,0 +1,237 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_BATCH_STATE_SAMPLER_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_BATCH_STATE_SAMPLER_
+
+#include "moveit/ompl_interface/parameterization/model_based_state_space.h"
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <ompl/base/StateSampler.h>
+#include <ompl/base/ValidStateSampler.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+
+namespace ompl_interface
+{
+
+/** @class SampleBatch
+    @brief A batch of samples of the variables of a group, stored as a structure of arrays: the values
+    of each variable for all the samples are contiguous.  Each sample also carries a validity mark. */
+class SampleBatch
+{
+public:
+
+  SampleBatch(unsigned int variable_count = 0) : variable_count_(variable_count), size_(0)
+  {
+  }
+
+  /// Resize the batch to hold \e size samples, all marked valid.  Values are not preserved.
+  void resize(std::size_t size)
+  {
+    size_ = size;
+    values_.resize(variable_count_ * size_);
+    valid_.assign(size_, 1);
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  unsigned int getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  /// The values of variable \e v for all samples
+  double* getVariable(unsigned int v)
+  {
+    return &values_[v * size_];
+  }
+
+  const double* getVariable(unsigned int v) const
+  {
+    return &values_[v * size_];
+  }
+
+  /// Copy the variables of sample \e i to an array ordered like the variables of the group
+  void getSample(std::size_t i, double *values) const
+  {
+    for (unsigned int v = 0 ; v < variable_count_ ; ++v)
+      values[v] = values_[v * size_ + i];
+  }
+
+  /// Copy an array ordered like the variables of the group to sample \e i
+  void setSample(std::size_t i, const double *values)
+  {
+    for (unsigned int v = 0 ; v < variable_count_ ; ++v)
+      values_[v * size_ + i] = values[v];
+  }
+
+  bool isValid(std::size_t i) const
+  {
+    return valid_[i];
+  }
+
+  void setValid(std::size_t i, bool valid)
+  {
+    valid_[i] = valid;
+  }
+
+  std::size_t countValid() const
+  {
+    return std::count(valid_.begin(), valid_.end(), 1);
+  }
+
+private:
+
+  unsigned int               variable_count_;
+  std::size_t                size_;
+  std::vector<double>        values_;
+  std::vector<unsigned char> valid_;
+};
+
+class ConstrainedSampler;
+class OMPLPlanningContext;
+
+MOVEIT_CLASS_FORWARD(BatchStateSampler);
+
+/** @class BatchStateSampler
+    @brief Fill SampleBatch instances with uniform samples of a ModelBasedStateSpace, and filter them
+    with kinematic constraints.  Without a state sampler, the batch is filled one variable at a time:
+    bounded single variable joints get a contiguous run of random values and only the remaining joints
+    are sampled individually.  With a state sampler every sample comes from it; a ConstrainedSampler
+    fills the whole batch in one call.  Filtering first checks the joint constraints on the contiguous
+    values, then computes the poses of the constrained links for all remaining samples along the chain
+    of joints above each link, and checks the position and orientation constraints on those poses.  Only
+    the samples these checks cannot decide get the complete check.  Forward kinematics for the workspace
+    representation is only computed when a sample is copied to a state. */
+class BatchStateSampler : private boost::noncopyable
+{
+public:
+
+  BatchStateSampler(const ModelBasedStateSpacePtr &space, const ompl::base::StateSamplerPtr &sampler = ompl::base::StateSamplerPtr());
+  ~BatchStateSampler();
+
+  /// Replace the content of \e batch by \e count uniform samples
+  void sampleUniform(SampleBatch &batch, std::size_t count);
+
+  /// Mark the samples of \e batch that do not satisfy \e kset as invalid and return the number of valid samples.
+  /// \e work_state is used for forward kinematics; its variables outside the group are left as they are.
+  /// Joint constraints on single variable joints that are neither continuous nor mimic, and position and
+  /// orientation constraints expressed in a fixed frame are checked on the whole batch; samples within rounding
+  /// of a joint or orientation tolerance, and all samples if \e kset has other constraints, get the complete check.
+  std::size_t filter(SampleBatch &batch, const kinematic_constraints::KinematicConstraintSet &kset,
+                     robot_state::RobotState &work_state) const;
+
+  /// Copy sample \e i of \e batch to an OMPL state
+  void getState(const SampleBatch &batch, std::size_t i, ompl::base::State *state) const;
+
+private:
+
+  /// A joint of a LinkChain, with the constant transform from the previous joint to its origin
+  struct ChainJoint
+  {
+    Eigen::Affine3d                 offset;
+    const robot_model::JointModel  *joint;
+    /// The index of the first variable of the joint in the group
+    unsigned int                    index;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /// The joints of the group above a link, from the pose of the first link that no variable of the group moves
+  struct LinkChain
+  {
+    Eigen::Affine3d                                               base;
+    std::vector<ChainJoint, Eigen::aligned_allocator<ChainJoint> > joints;
+    /// The transform from the last joint to the link
+    Eigen::Affine3d                                               tip;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /// Build the chain of \e link; the variables outside the group are taken from \e state, which must be up to date
+  void computeLinkChain(const robot_model::LinkModel *link, const robot_state::RobotState &state, LinkChain &chain) const;
+
+  /// The pose of the link of \e chain for \e values, ordered like the variables of the group
+  void computeLinkPose(const LinkChain &chain, const double *values, Eigen::Affine3d &pose) const;
+
+  ModelBasedStateSpacePtr                     space_;
+  ompl::base::StateSamplerPtr                 sampler_;
+  ConstrainedSampler                         *constrained_sampler_;
+  ompl::base::State                          *scratch_;
+  std::vector<double>                         values_;
+  random_numbers::RandomNumberGenerator       rng_;
+
+  std::vector<const robot_model::JointModel*> joints_;
+  std::vector<unsigned int>                   indices_;
+  /// True for joints sampled by filling the column of their single variable
+  std::vector<bool>                           columns_;
+};
+
+/** @class BatchValidStateSampler
+    @brief A valid state sampler for roadmap planners, which draw many independent samples: samples are drawn
+    and filtered by the path constraints a batch at a time with a BatchStateSampler, and handed out one at a
+    time once the state validity checker accepts them.  With path constraints, the batches come from the state
+    sampler of the planning context; without, they are filled one variable at a time.  Samples near a state
+    come from the state sampler of the planning context. */
+class BatchValidStateSampler : public ompl::base::ValidStateSampler
+{
+public:
+
+  BatchValidStateSampler(const OMPLPlanningContext *pc);
+
+  virtual bool sample(ompl::base::State *state);
+  virtual bool sampleNear(ompl::base::State *state, const ompl::base::State *near, const double distance);
+
+private:
+
+  /// Draw and filter a new batch; return false if no sample in it satisfies the path constraints
+  bool refill();
+
+  const OMPLPlanningContext                  *planning_context_;
+  ompl::base::StateSamplerPtr                 sampler_;
+  BatchStateSampler                           batch_sampler_;
+  SampleBatch                                 batch_;
+  /// The next sample of batch_ to consider
+  std::size_t                                 next_;
+  robot_state::RobotState                     work_state_;
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_COLLISION_SPHERES_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_COLLISION_SPHERES_
+
+#include "moveit/ompl_interface/detail/static_collision_environment.h"
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(CollisionSpheres);
+
+class EnvironmentDistanceField;
+
+/** @class CollisionSpheres
+    @brief A conservative approximation of the collision geometry of a group by spheres.  Every
+    shape of the moving links (and of the bodies attached to them) and every object of the static
+    collision environment is covered by a few spheres.  If all spheres that may collide clear each
+    other by a margin, the state is known to be collision free and the exact check can be skipped.
+    Each moving body and each object of the environment also has a bounding sphere around its spheres,
+    so pairs that are far apart are discarded with a single test. */
+class CollisionSpheres
+{
+public:
+
+  struct Sphere
+  {
+    Eigen::Vector3d center;
+    double          radius;
+  };
+
+  CollisionSpheres(const StaticCollisionEnvironment &environment,
+                   const planning_scene::PlanningSceneConstPtr &scene,
+                   const robot_state::RobotState &start_state,
+                   double margin);
+
+  /// Return true if all geometry could be approximated by spheres (planes and octrees cannot)
+  bool isValid() const
+  {
+    return valid_;
+  }
+
+  /// Return true if the spheres of the moving bodies clear the environment and each other by the margin.
+  /// A return value of false is inconclusive.  The state must have its link transforms up to date.
+  bool isClear(const robot_state::RobotState &state) const;
+
+  /// The smallest distance between the spheres of the moving bodies and the static environment, as
+  /// represented by \e field.  Zero if any sphere penetrates the environment.
+  double clearance(const robot_state::RobotState &state, const EnvironmentDistanceField &field) const;
+
+  /// The volume of the spheres of the moving bodies that is inside the static environment, as represented by \e field
+  double penetration(const robot_state::RobotState &state, const EnvironmentDistanceField &field) const;
+
+  /// The names of the moving bodies (the links of the group and the bodies attached to them)
+  void getMovingBodyNames(std::vector<std::string> &names) const;
+
+  /// Cover a shape at a given pose by spheres. Returns false if the shape is unbounded.
+  static bool computeSpheres(const shapes::Shape &shape, const Eigen::Affine3d &pose, std::vector<Sphere> &spheres);
+
+private:
+
+  /// A link of the group, or a body attached to one, with its spheres expressed in the frame of the link
+  struct MovingBody
+  {
+    std::string                       name;
+    const robot_model::LinkModel     *link;
+    std::set<std::string>             touch_links;
+    std::vector<Sphere>               spheres;
+    /// A sphere around all spheres of the body, in the frame of the link
+    Sphere                            bound;
+    /// The indices of the obstacles this body is not allowed to touch
+    std::vector<unsigned int>         obstacles;
+  };
+
+  /// An object of the static environment: a range of obstacle spheres and a sphere around them
+  struct Obstacle
+  {
+    Sphere                            bound;
+    unsigned int                      first;
+    unsigned int                      end;
+  };
+
+  /// The smallest sphere centered at the center of the box around \e spheres that contains them
+  static Sphere computeBound(const std::vector<Sphere> &spheres, std::size_t first, std::size_t end);
+
+  bool addMovingBody(const std::string &name, const robot_model::LinkModel *link, const std::vector<shapes::ShapeConstPtr> &shapes,
+                     const EigenSTL::vector_Affine3d &poses, const std::set<std::string> &touch_links,
+                     double scale, double padding);
+
+  std::vector<MovingBody>                                   moving_bodies_;
+  std::vector<Sphere>                                       obstacle_spheres_;
+  std::vector<Obstacle>                                     obstacles_;
+  std::vector<std::pair<unsigned int, unsigned int> >       self_pairs_;
+  double                                                    margin_;
+  bool                                                      valid_;
+};
+
+}
+
+#endif
@@ -41,8 +41,12 @@
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <moveit/constraint_samplers/constraint_sampler.h>
 
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include "moveit/ompl_interface/detail/goal_state_cache.h"
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_model/joint_model_group.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/shared_ptr.hpp>
 
 namespace ompl_interface
 {
@@ -50,19 +54,100 @@ namespace ompl_interface
 class OMPLPlanningContext;
 
 /** @class ConstrainedGoalSampler
- *  An interface to the OMPL goal lazy sampler*/
+ *  An interface to the OMPL goal lazy sampler.  Goal states closer than a small fraction of the extent
+ *  of the space to a goal state already found are discarded.  If constraint samplers for parallel
+ *  workers are given, every round of the sampling thread runs the workers concurrently on the shared
+ *  WorkerPool, each starting its inverse kinematics from its own random seeds.  With a GoalStateCache,
+ *  the goal states cached for the same constraints that are still valid are added before sampling
+ *  starts, and the goal states found are added to the cache. */
 class ConstrainedGoalSampler : public ompl::base::GoalLazySamples
 {
 public:
 
+  /** @brief Constructor
+   *  @param max_attempts The sampling attempts after which the sampling thread stops
+   *  @param max_goal_samples The number of goal states after which the sampling thread stops
+   *  @param ik_attempts The inverse kinematics attempts per goal sample, sequentially or in a worker
+   *  @param worker_samplers One (distinct) WorkerIKConstraintSampler per parallel worker.  Sampling is sequential if empty,
+   *  or if any of them is another kind of sampler, whose solver may be shared.
+   *  @param goal_state_cache If not NULL, the goal states of earlier requests for the same constraints */
   ConstrainedGoalSampler(const OMPLPlanningContext *pc, const kinematic_constraints::KinematicConstraintSetPtr &ks,
-                         const constraint_samplers::ConstraintSamplerPtr &cs = constraint_samplers::ConstraintSamplerPtr());
+                         const constraint_samplers::ConstraintSamplerPtr &cs = constraint_samplers::ConstraintSamplerPtr(),
+                         unsigned int max_attempts = 1000, unsigned int max_goal_samples = 50, unsigned int ik_attempts = 4,
+                         const std::vector<constraint_samplers::ConstraintSamplerPtr> &worker_samplers =
+                         std::vector<constraint_samplers::ConstraintSamplerPtr>(),
+                         GoalStateCache *goal_state_cache = NULL);
+  virtual ~ConstrainedGoalSampler();
 
 private:
 
+  enum SampleResult
+    {
+      SAMPLE_FOUND,
+      SAMPLE_VIOLATES_CONSTRAINTS,
+      SAMPLE_FAILED
+    };
+
+  /// Where the validity callback of a constraint sampler writes the goal state it checks.  The callback is
+  /// installed once per constraint sampler and reads this before every check.
+  struct ValidityTarget
+  {
+    ValidityTarget(ompl::base::State *goal = NULL) : goal(goal), verbose(false)
+    {
+    }
+
+    ompl::base::State *goal;
+    bool               verbose;
+  };
+
+  /// The memory used by the validity callback, one instance per calling thread
+  struct CallbackScratch
+  {
+    CallbackScratch(const robot_state::RobotState &state) : state(state)
+    {
+    }
+
+    robot_state::RobotState state;
+    std::vector<double>     group_values;
+  };
+
+  /// A parallel sampling worker; the members are only used by the task running the worker
+  struct Worker
+  {
+    Worker(const constraint_samplers::ConstraintSamplerPtr &cs, const robot_state::RobotState &state, ompl::base::State *goal)
+      : sampler(cs), work_state(state), target(goal), attempts(0), invalid(0), found(false)
+    {
+    }
+
+    constraint_samplers::ConstraintSamplerPtr sampler;
+    robot_state::RobotState                   work_state;
+    ValidityTarget                            target;
+    random_numbers::RandomNumberGenerator     rng;
+    std::vector<double>                       seed;
+    unsigned int                              attempts;
+    unsigned int                              invalid;
+    bool                                      found;
+  };
+  typedef boost::shared_ptr<Worker> WorkerPtr;
+
   bool sampleUsingConstraintSampler(const ompl::base::GoalLazySamples *gls, ompl::base::State *new_goal);
-  bool stateValidityCallback(ompl::base::State* new_goal, robot_state::RobotState const* state,
-                              const robot_model::JointModelGroup*, const double*, bool verbose=false) const;
+  bool sampleInParallel(const ompl::base::GoalLazySamples *gls, ompl::base::State *new_goal);
+  void runWorker(Worker *worker, const ompl::base::GoalLazySamples *gls);
+
+  /// Make \e sampler check the validity of its inverse kinematics solutions, writing them to \e target
+  void installValidityCallback(constraint_samplers::ConstraintSampler &sampler, ValidityTarget *target) const;
+
+  /// Project \e work_state onto the goal constraints with \e sampler (whose validity callback writes to
+  /// \e target) and check the result, which is left in target.goal
+  SampleResult sampleGoal(constraint_samplers::ConstraintSampler &sampler, robot_state::RobotState &work_state,
+                          ValidityTarget &target, bool verbose) const;
+  void countInvalidSamples(unsigned int invalid, unsigned int attempts_so_far);
+
+  /// Add the cached goal states that satisfy the constraints and are valid in the current scene
+  void addCachedGoalStates();
+  void cacheGoalState(const ompl::base::State *state);
+  bool stateValidityCallback(const ValidityTarget *target, robot_state::RobotState const* state,
+                             const robot_model::JointModelGroup*, const double*) const;
   bool checkStateValidity(ompl::base::State* new_goal, const robot_state::RobotState& state, bool verbose=false) const;
 
   const OMPLPlanningContext                       *planning_context_;
@@ -70,9 +155,19 @@ private:
   constraint_samplers::ConstraintSamplerPtr        constraint_sampler_;
   ompl::base::StateSamplerPtr                      default_sampler_;
   robot_state::RobotState                          work_state_;
+  ValidityTarget                                   target_;
+  ThreadLocalStorage<CallbackScratch>              callback_scratch_;
   unsigned int                                     invalid_sampled_constraints_;
   bool                                             warned_invalid_samples_;
   unsigned int                                     verbose_display_;
+  unsigned int                                     max_attempts_;
+  unsigned int                                     max_goal_samples_;
+  unsigned int                                     ik_attempts_;
+  std::vector<WorkerPtr>                           workers_;
+  /// The attempts of the parallel workers so far
+  unsigned int                                     parallel_attempts_;
+  GoalStateCache                                  *goal_state_cache_;
+  std::string                                      goal_state_cache_key_;
 };
 }
 
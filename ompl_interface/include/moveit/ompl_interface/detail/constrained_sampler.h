@@ -40,20 +40,116 @@
 #include <ompl/base/StateSampler.h>
 #include <moveit/constraint_samplers/constraint_sampler.h>
 #include "moveit/ompl_interface/ompl_planning_context.h"
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
 
 namespace ompl_interface
 {
 
+class SampleBatch;
+
+/** @class ConstrainedSamplerStatistics
+ *  The sampling counts of the ConstrainedSamplers of a planning context, accumulated over a solve.
+ *  Every thread counts its own samples as they are drawn; getCounts() sums them and reset() zeroes
+ *  them, so neither may run while the samplers are used */
+class ConstrainedSamplerStatistics
+{
+public:
+
+  struct Counts
+  {
+    Counts() : constrained_calls(0), constrained_successes(0), constrained_time(0.0),
+               uniform_samples(0), uniform_satisfied(0), uniform_time(0.0)
+    {
+    }
+
+    void add(const Counts &other)
+    {
+      constrained_calls += other.constrained_calls;
+      constrained_successes += other.constrained_successes;
+      constrained_time += other.constrained_time;
+      uniform_samples += other.uniform_samples;
+      uniform_satisfied += other.uniform_satisfied;
+      uniform_time += other.uniform_time;
+    }
+
+    void addConstrainedCall(bool success, double time)
+    {
+      ++constrained_calls;
+      if (success)
+        ++constrained_successes;
+      constrained_time += time;
+    }
+
+    void addUniformSample(bool satisfied, double time)
+    {
+      ++uniform_samples;
+      if (satisfied)
+        ++uniform_satisfied;
+      uniform_time += time;
+    }
+
+    /// Calls to the constraint sampler, the ones that produced a state, and the time they took (seconds)
+    unsigned int constrained_calls;
+    unsigned int constrained_successes;
+    double       constrained_time;
+
+    /// Uniform samples, the ones that happened to satisfy the constraints, and the time they took (seconds)
+    unsigned int uniform_samples;
+    unsigned int uniform_satisfied;
+    double       uniform_time;
+  };
+
+  /// The counts of the calling thread
+  Counts& getThreadCounts()
+  {
+    return *counts_.get();
+  }
+
+  Counts getCounts() const
+  {
+    std::vector<Counts*> instances;
+    counts_.getInstances(instances);
+    Counts total;
+    for (std::size_t i = 0 ; i < instances.size() ; ++i)
+      total.add(*instances[i]);
+    return total;
+  }
+
+  void reset()
+  {
+    std::vector<Counts*> instances;
+    counts_.getInstances(instances);
+    for (std::size_t i = 0 ; i < instances.size() ; ++i)
+      *instances[i] = Counts();
+  }
+
+private:
+
+  ThreadLocalStorage<Counts> counts_;
+};
+
+typedef boost::shared_ptr<ConstrainedSamplerStatistics> ConstrainedSamplerStatisticsPtr;
+
 /** @class ConstrainedSampler
- *  This class defines a sampler that tries to find a sample that satisfies the constraints*/
+ *  This class defines a sampler that tries to find a sample that satisfies the constraints.
+ *  The number of attempts the constraint sampler gets per call, the number of calls before
+ *  falling back to a uniform sample and the fraction of uniform samples are adapted online,
+ *  to produce as many states satisfying the constraints per second as possible. */
 class ConstrainedSampler : public ompl::base::StateSampler
 {
 public:
   /** @brief Default constructor
    *  @param pg The planning group
    *  @param cs A pointer to a kinematic constraint sampler
+   *  @param constraints If not empty, uniform samples are checked against these constraints, and the
+   *  mix of constrained and uniform samples is adapted as well
+   *  @param statistics If not empty, every sample of this sampler is counted in it
    */
-  ConstrainedSampler(const OMPLPlanningContext *pc, const constraint_samplers::ConstraintSamplerPtr &cs);
+  ConstrainedSampler(const OMPLPlanningContext *pc, const constraint_samplers::ConstraintSamplerPtr &cs,
+                     const kinematic_constraints::KinematicConstraintSetPtr &constraints = kinematic_constraints::KinematicConstraintSetPtr(),
+                     const ConstrainedSamplerStatisticsPtr &statistics = ConstrainedSamplerStatisticsPtr());
+
+  virtual ~ConstrainedSampler();
 
   /** @brief Sample a state (uniformly)*/
   virtual void sampleUniform(ompl::base::State *state);
@@ -64,12 +160,42 @@ public:
   /** @brief Sample a state using the specified Gaussian*/
   virtual void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, const double stdDev);
 
+  /** @brief Fill \e batch with samples drawn like sampleUniform() does, in a single call for the whole batch.
+   *  \e state is used as scratch space */
+  void sampleBatch(SampleBatch &batch, ompl::base::State *state);
+
   double getConstrainedSamplingRate() const;
 
+  /// The attempts the constraint sampler currently gets per call
+  unsigned int getAttempts() const
+  {
+    return attempts_;
+  }
+
+  /// The calls to the constraint sampler sampleUniform() currently makes before falling back to a uniform sample
+  unsigned int getCalls() const
+  {
+    return calls_;
+  }
+
+  /// The probability sampleUniform() currently tries the constraint sampler at all with
+  double getConstrainedFraction() const
+  {
+    return constrained_fraction_;
+  }
+
 private:
 
   bool sampleC(ompl::base::State *state);
 
+  /// Try sampleC() as many times as the current budget allows
+  bool sampleConstrained(ompl::base::State *state);
+
+  void sampleUniformFallback(ompl::base::State *state);
+
+  /// Update the budgets from the counts of the last window of samples
+  void adapt();
+
   const OMPLPlanningContext                         *planning_context_;
   ompl::base::StateSamplerPtr                       default_;
   constraint_samplers::ConstraintSamplerPtr         constraint_sampler_;
@@ -77,6 +203,25 @@ private:
   unsigned int                                      constrained_success_;
   unsigned int                                      constrained_failure_;
   double                                            inv_dim_;
+
+  kinematic_constraints::KinematicConstraintSetPtr  constraints_;
+  ConstrainedSamplerStatisticsPtr                   statistics_;
+
+  /// Attempts per call of the constraint sampler, and calls before a uniform sample is used instead
+  unsigned int                                      attempts_;
+  unsigned int                                      calls_;
+  /// The probability of trying the constraint sampler at all in sampleUniform()
+  double                                            constrained_fraction_;
+  /// The fraction of samples spent on the slower of constrained and uniform sampling; it decays while
+  /// uniform samples never satisfy the constraints
+  double                                            exploration_;
+
+  /// The counts since the budgets were last adapted
+  ConstrainedSamplerStatistics::Counts              window_;
+  /// The yield (successes per second) of the constraint sampler in the previous window, and
+  /// the direction the number of attempts was last changed in
+  double                                            previous_yield_;
+  int                                               attempts_direction_;
 };
 
 }
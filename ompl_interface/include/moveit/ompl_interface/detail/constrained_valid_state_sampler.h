@@ -47,7 +47,8 @@ namespace ompl_interface
 class OMPLPlanningContext;
 
 /** @class ValidConstrainedSampler
- *  This class defines a sampler that tries to find a valid sample that satisfies the specified constraints */
+ *  This class defines a sampler that tries to find a valid sample that satisfies the specified constraints.
+ *  Up to the number of attempts of the sampler are made, and samples are checked by the state validity checker. */
 class ValidConstrainedSampler : public ompl::base::ValidStateSampler
 {
 public:
@@ -61,6 +62,9 @@ public:
 
 private:
 
+  /// Sample a state satisfying the constraints (not checked for validity)
+  bool sampleConstrained(ompl::base::State *state);
+
   const OMPLPlanningContext                        *planning_context_;
   kinematic_constraints::KinematicConstraintSetPtr  kinematic_constraint_set_;
   constraint_samplers::ConstraintSamplerPtr         constraint_sampler_;
@@ -0,0 +1,94 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_ENVIRONMENT_DISTANCE_FIELD_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_ENVIRONMENT_DISTANCE_FIELD_
+
+#include "moveit/ompl_interface/detail/static_collision_environment.h"
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(EnvironmentDistanceField);
+
+/** @class EnvironmentDistanceField
+    @brief A voxelized signed distance field of a set of static shapes.  Distances are positive
+    outside the shapes and negative inside.  The field is computed in parallel by the shared
+    worker pool, and the number of voxels is bounded: if the requested resolution would exceed the bound,
+    the resolution is coarsened until it does not. */
+class EnvironmentDistanceField
+{
+public:
+
+  EnvironmentDistanceField(const std::vector<shapes::ShapeConstPtr> &shapes, const EigenSTL::vector_Affine3d &poses,
+                           double resolution, std::size_t max_voxels);
+
+  /// Return the field for the objects of the static environment that none of the \e moving_bodies is allowed to touch.
+  /// The last field computed is cached, so planning repeatedly in the same scene only computes it once; concurrent
+  /// requests for the field being computed wait for it, requests for other fields do not.
+  static EnvironmentDistanceFieldConstPtr get(const StaticCollisionEnvironment &environment,
+                                              const std::vector<std::string> &moving_bodies,
+                                              double resolution, std::size_t max_voxels);
+
+  /// The (interpolated) signed distance at a point.  Outside the bounds of the field, the distance
+  /// to the bounds is added to the value at the closest point of the field.
+  double getDistance(const Eigen::Vector3d &point) const;
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+private:
+
+  float& voxel(std::size_t x, std::size_t y, std::size_t z)
+  {
+    return distances_[(z * size_[1] + y) * size_[0] + x];
+  }
+
+  float voxel(std::size_t x, std::size_t y, std::size_t z) const
+  {
+    return distances_[(z * size_[1] + y) * size_[0] + x];
+  }
+
+  Eigen::Vector3d    origin_;
+  double             resolution_;
+  std::size_t        size_[3];
+  std::vector<float> distances_;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_GOAL_STATE_CACHE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_GOAL_STATE_CACHE_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit_msgs/Constraints.h>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+#include <list>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(GoalStateCache);
+
+/** @class GoalStateCache
+    @brief Goal configurations (joint values of a group) found for goal constraints in earlier requests.
+    The key is the robot model, the group and the serialized constraints message, so requests that
+    repeat a goal find the configurations of the previous ones.  The cached configurations were valid
+    in the scene of the request that found them; they must be checked again before they are used.
+    When the cache is full, the goals that were least recently used are forgotten. */
+class GoalStateCache : private boost::noncopyable
+{
+public:
+
+  GoalStateCache(std::size_t max_goals = 256, std::size_t max_states_per_goal = 50, double duplicate_distance = 1e-4);
+
+  /// The key of \e constraints for \e group of \e model.  The time stamps of the constraints are ignored
+  static std::string computeKey(const robot_model::RobotModel &model, const std::string &group, const moveit_msgs::Constraints &constraints);
+
+  /// The configurations cached for \e key, most recently found first
+  std::vector<std::vector<double> > getStates(const std::string &key);
+
+  /// Remember the configuration \e values for \e key, unless it is within the duplicate distance
+  /// (for every joint value) of a configuration already cached
+  void addState(const std::string &key, const std::vector<double> &values);
+
+  std::size_t getGoalCount() const;
+
+  void clear();
+
+  /// The cache shared by the planning contexts of the process
+  static GoalStateCache& getShared();
+
+private:
+
+  struct Entry
+  {
+    std::vector<std::vector<double> >  states;
+    std::list<std::string>::iterator   recent;
+  };
+
+  /// Mark \e entry as the most recently used; the lock must be held
+  void touch(Entry &entry);
+
+  boost::unordered_map<std::string, Entry>  entries_;
+  /// The keys, most recently used first
+  std::list<std::string>                    recent_;
+  std::size_t                               max_goals_;
+  std::size_t                               max_states_per_goal_;
+  double                                    duplicate_distance_;
+  mutable boost::mutex                      lock_;
+};
+
+}
+
+#endif
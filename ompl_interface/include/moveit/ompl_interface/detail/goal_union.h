@@ -38,11 +38,21 @@
 #define MOVEIT_OMPL_INTERFACE_GOALMUX_
 
 #include <ompl/base/goals/GoalSampleableRegion.h>
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/RandomNumbers.h>
+#include <boost/thread/mutex.hpp>
 
 namespace ompl_interface
 {
 
-/** @class GoalSampleableRegionMux*/
+/** @class GoalSampleableRegionMux
+ *  A union of sampleable goal regions.  Goals are sampled from the member goals with a probability
+ *  that grows with the rate at which a member finds goal states and shrinks with the distance of its
+ *  goal states from the start state.  The goal states of the members that are sets of states (such
+ *  as lazy samplers) are kept in a nearest neighbors structure, so the goal checks do not have to go
+ *  through every member.  Lazy samplers add their states as they find them; the states added to other
+ *  sets of states are indexed when the union is next checked or sampled.  Other member goals are checked
+ *  one by one. */
 class GoalSampleableRegionMux : public ompl::base::GoalSampleableRegion
 {
 public:
@@ -51,9 +61,10 @@ public:
    *  @param goals The input set of goals*/
   GoalSampleableRegionMux(const std::vector<ompl::base::GoalPtr> &goals);
 
-  virtual ~GoalSampleableRegionMux()
-  {
-  }
+  virtual ~GoalSampleableRegionMux();
+
+  /** @brief Set the start state the distances of the goal states are measured from (copied)*/
+  void setStartState(const ompl::base::State *st);
 
   /** @brief Sample a goal*/
   virtual void sampleGoal(ompl::base::State *st) const;
@@ -84,8 +95,54 @@ public:
 
 protected:
 
+  /// A goal state of a member goal, in the nearest neighbors structure
+  struct IndexedState
+  {
+    ompl::base::State *state;
+    unsigned int       goal;
+  };
+
+  double distanceIndexedStates(const IndexedState *a, const IndexedState *b) const;
+
+  /// Add a copy of \e st, a goal state of member \e goal, to the nearest neighbors structure
+  void addIndexedState(unsigned int goal, const ompl::base::State *st);
+  /// As addIndexedState(); index_lock_ must be held
+  void insertIndexedState(unsigned int goal, const ompl::base::State *st) const;
+
+  /// Index the states added to the members that are plain sets of goal states; index_lock_ must be held
+  void syncPlainGoals() const;
+
+  /// Recompute the cumulative weights of the member goals; weights_lock_ must be held
+  void updateWeights() const;
+
   std::vector<ompl::base::GoalPtr> goals_;
-  mutable unsigned int             gindex_;
+
+  /// The members whose goal states are indexed, and the others
+  std::vector<bool>                indexed_;
+  std::vector<unsigned int>        other_goals_;
+  /// The indexed members that are not lazy samplers
+  std::vector<unsigned int>        plain_goals_;
+
+  boost::shared_ptr<ompl::NearestNeighbors<IndexedState*> > index_;
+  mutable std::vector<IndexedState*> indexed_states_;
+  /// The largest threshold of the indexed members
+  double                           max_threshold_;
+  mutable boost::mutex             index_lock_;
+
+  ompl::base::State               *start_;
+  /// The distance from the start state to the closest goal state of each member
+  mutable std::vector<double>      start_distance_;
+  /// The number of states of each plain member indexed so far (protected by index_lock_)
+  mutable std::vector<unsigned int> indexed_counts_;
+
+  /// Set when goal states or the start state change (protected by index_lock_)
+  mutable bool                     weights_outdated_;
+
+  /// The cumulative weights of the members and the samples drawn since they were computed
+  mutable std::vector<double>      cumulative_weights_;
+  mutable unsigned int             samples_since_update_;
+  mutable ompl::RNG                rng_;
+  mutable boost::mutex             weights_lock_;
 };
 
 }
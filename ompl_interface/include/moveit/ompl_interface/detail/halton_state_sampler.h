@@ -0,0 +1,84 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_HALTON_STATE_SAMPLER_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_HALTON_STATE_SAMPLER_
+
+#include <ompl/base/StateSampler.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/cstdint.hpp>
+#include "moveit/ompl_interface/parameterization/model_based_state_space.h"
+
+namespace ompl_interface
+{
+
+/** @class HaltonStateSampler
+    @brief A deterministic low-discrepancy state sampler.  Uniform samples are the points of a
+    scrambled Halton sequence (one prime base per variable, with digit permutations seeded by the
+    stream number) mapped to the bounds of the joints, which covers the space more evenly than
+    independent random samples.  Samplers created with the same stream number produce the same
+    sequence; different streams produce differently scrambled sequences.  Joints that do not have a
+    single bounded variable (planar and floating joints) are sampled randomly, as are samples near
+    a state. */
+class HaltonStateSampler : public ompl::base::StateSampler
+{
+public:
+
+  HaltonStateSampler(const ModelBasedStateSpace *space, unsigned int stream);
+
+  virtual void sampleUniform(ompl::base::State *state);
+  virtual void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, const double distance);
+  virtual void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, const double stdDev);
+
+private:
+
+  /// The scrambled radical inverse of index_ in the base of a dimension
+  double radicalInverse(std::size_t dimension) const;
+
+  const robot_model::JointModelGroup            *joint_model_group_;
+  const robot_model::JointBoundsVector          *joint_bounds_;
+  std::vector<const robot_model::JointModel*>   joints_;
+  std::vector<unsigned int>                     indices_;
+  /// The dimension of the sequence used for each joint, or -1 for joints sampled randomly
+  std::vector<int>                              dimensions_;
+  std::vector<unsigned int>                     bases_;
+  std::vector<std::vector<unsigned int> >       permutations_;
+  boost::uint64_t                               index_;
+  random_numbers::RandomNumberGenerator         moveit_rng_;
+};
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_IK_CACHE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_IK_CACHE_
+
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include <moveit/macros/class_forward.h>
+#include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(IKCache);
+
+/** @class IKCache
+    @brief A cache of inverse kinematics solutions, indexed by a spatial hash of the position and the
+    orientation of the pose they were computed for.  A lookup considers the cached solutions in the cell
+    of the queried pose and in the cells of the neighboring positions with the same orientation,
+    restricted to those on the same branch as the seed of the query (no joint farther from the seed than
+    a threshold).  The solution for the closest pose is returned; the lookup is a hit if that pose is
+    within tolerance of the query, and the solution can be used as is.  Otherwise the solution is a
+    better seed for the solver.  Several solvers are distinguished by a component index.
+
+    The cache is thread safe.  The cells are spread over shards with their own locks, and a cell is
+    replaced rather than modified on insertion, so a lookup only holds a lock while it takes a reference
+    to a cell, not while it scans the cell.  A cell keeps at most MAX_CELL_ENTRIES solutions (the oldest
+    is dropped), and a solution within tolerance of one already in its cell, on the same branch, is not
+    stored.  Every thread counts its own statistics; they are summed by getStatistics() and zeroed by
+    resetStatistics(), which must not run concurrently with lookups (e.g., before and after a solve). */
+class IKCache
+{
+public:
+
+  enum Result
+    {
+      /// No cached solution near the pose
+      MISS,
+      /// The returned solution is for a nearby pose and can be used as a seed
+      SEED,
+      /// The returned solution is for a pose within tolerance of the query
+      HIT
+    };
+
+  struct Statistics
+  {
+    Statistics() : lookups(0), hits(0), seeds(0), solver_calls(0), solver_time(0.0)
+    {
+    }
+
+    unsigned int lookups;
+    unsigned int hits;
+    unsigned int seeds;
+    unsigned int solver_calls;
+    double       solver_time;
+  };
+
+  /// The orientation cells are \e orientation_resolution wide in each of the x, y and z components of the quaternion
+  IKCache(double position_resolution = 0.05, double position_tolerance = 1e-4, double orientation_tolerance = 1e-3,
+          double branch_distance = 0.5, std::size_t max_entries = 100000, double orientation_resolution = 0.25);
+
+  /// Look up a solution for \e position and \e orientation (a quaternion, x y z w) near \e seed
+  Result lookup(unsigned int component, const double *position, const double *orientation,
+                const std::vector<double> &seed, std::vector<double> &solution) const;
+
+  /// Store a solution computed by the solver; a shard of the cache is emptied when it is full
+  void insert(unsigned int component, const double *position, const double *orientation, const std::vector<double> &solution);
+
+  /// Account for one call of the solver that took \e seconds
+  void recordSolverCall(double seconds);
+
+  Statistics getStatistics() const;
+  void resetStatistics();
+
+  void clear();
+
+private:
+
+  struct Entry
+  {
+    unsigned int        component;
+    double              position[3];
+    double              orientation[4];
+    std::vector<double> solution;
+  };
+
+  typedef std::vector<Entry> Cell;
+  typedef boost::shared_ptr<const Cell> CellConstPtr;
+
+  /// A part of the cells, with its own lock
+  struct Shard
+  {
+    Shard() : size(0)
+    {
+    }
+
+    boost::unordered_map<std::size_t, CellConstPtr> cells;
+    std::size_t                                     size;
+    boost::mutex                                    lock;
+  };
+
+  static const unsigned int SHARD_COUNT = 16;
+  static const std::size_t MAX_CELL_ENTRIES = 16;
+
+  /// The cells of an orientation: the quaternion, with q and -q identified, discretized
+  void orientationCell(const double *orientation, int *cell) const;
+  std::size_t cellKey(unsigned int component, int x, int y, int z, const int *orientation_cell) const;
+
+  /// True if \e a and \e b are the same pose within tolerance, and their solutions are on the same branch
+  bool isDuplicate(const Entry &a, const Entry &b) const;
+
+  double               position_resolution_;
+  double               position_tolerance_;
+  double               orientation_tolerance_;
+  double               branch_distance_;
+  std::size_t          max_entries_;
+  double               orientation_resolution_;
+
+  mutable Shard                  shards_[SHARD_COUNT];
+  ThreadLocalStorage<Statistics> statistics_;
+};
+
+}
+
+#endif
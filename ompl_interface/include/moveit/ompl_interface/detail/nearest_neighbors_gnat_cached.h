@@ -0,0 +1,187 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_GNAT_CACHED_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_GNAT_CACHED_
+
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+#include <boost/functional/hash.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+
+namespace ompl_interface
+{
+
+/** @class NearestNeighborsGNATCached
+    @brief A GNAT that remembers the distances it computes during one operation.  A GNAT query
+    measures the distance to the pivot of every node it considers, and measures it again when it scans
+    the leaf the pivot is stored in; insertions and rebuilds similarly measure the same pairs more than
+    once.  The distances are kept in a small direct-mapped cache that is invalidated at the start of
+    every add, remove and query, because planners reuse the same element (with different contents)
+    for consecutive queries.  This pays off when the distance is expensive compared to a cache lookup;
+    for cheap joint space distances the plain GNAT is as fast. */
+template<typename _T>
+class NearestNeighborsGNATCached : public ompl::NearestNeighborsGNAT<_T>
+{
+public:
+
+  typedef ompl::NearestNeighborsGNAT<_T> Base;
+  typedef typename ompl::NearestNeighbors<_T>::DistanceFunction DistanceFunction;
+
+  /// The cache holds \e cache_size distances (rounded up to a power of two)
+  NearestNeighborsGNATCached(unsigned int cache_size = 1024)
+    : Base()
+    , epoch_(1)
+    , computed_count_(0)
+    , cached_count_(0)
+  {
+    std::size_t size = 1;
+    while (size < cache_size)
+      size <<= 1;
+    cache_.resize(size);
+    mask_ = size - 1;
+  }
+
+  virtual void setDistanceFunction(const DistanceFunction &dist_fun)
+  {
+    uncached_dist_fun_ = dist_fun;
+    newEpoch();
+    Base::setDistanceFunction(boost::bind(&NearestNeighborsGNATCached::cachedDistance, this, _1, _2));
+  }
+
+  virtual void clear()
+  {
+    newEpoch();
+    Base::clear();
+  }
+
+  virtual void add(const _T &data)
+  {
+    newEpoch();
+    Base::add(data);
+  }
+
+  virtual void add(const std::vector<_T> &data)
+  {
+    newEpoch();
+    Base::add(data);
+  }
+
+  virtual bool remove(const _T &data)
+  {
+    newEpoch();
+    return Base::remove(data);
+  }
+
+  virtual _T nearest(const _T &data) const
+  {
+    newEpoch();
+    return Base::nearest(data);
+  }
+
+  virtual void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const
+  {
+    newEpoch();
+    Base::nearestK(data, k, nbh);
+  }
+
+  virtual void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const
+  {
+    newEpoch();
+    Base::nearestR(data, radius, nbh);
+  }
+
+  /// The number of distances computed, and the number of distances served from the cache
+  void getCacheStatistics(std::size_t &computed, std::size_t &cached) const
+  {
+    computed = computed_count_;
+    cached = cached_count_;
+  }
+
+private:
+
+  struct Entry
+  {
+    Entry() : epoch(0), distance(0.0)
+    {
+    }
+
+    _T           first;
+    _T           second;
+    unsigned int epoch;
+    double       distance;
+  };
+
+  // entries of earlier epochs are stale; wrapping around to 0 requires forgetting every entry
+  void newEpoch() const
+  {
+    if (++epoch_ == 0)
+    {
+      for (std::size_t i = 0 ; i < cache_.size() ; ++i)
+        cache_[i].epoch = 0;
+      epoch_ = 1;
+    }
+  }
+
+  // the distance is symmetric, so the pair is hashed and compared in either order
+  double cachedDistance(const _T &a, const _T &b) const
+  {
+    std::size_t h = boost::hash<_T>()(a) ^ boost::hash<_T>()(b);
+    h ^= (h >> 4) ^ (h >> 12);
+    Entry &entry = cache_[h & mask_];
+    if (entry.epoch == epoch_ && ((entry.first == a && entry.second == b) || (entry.first == b && entry.second == a)))
+    {
+      ++cached_count_;
+      return entry.distance;
+    }
+    ++computed_count_;
+    entry.first = a;
+    entry.second = b;
+    entry.epoch = epoch_;
+    entry.distance = uncached_dist_fun_(a, b);
+    return entry.distance;
+  }
+
+  DistanceFunction           uncached_dist_fun_;
+  mutable std::vector<Entry> cache_;
+  std::size_t                mask_;
+  mutable unsigned int       epoch_;
+  mutable std::size_t        computed_count_;
+  mutable std::size_t        cached_count_;
+};
+
+}
+
+#endif
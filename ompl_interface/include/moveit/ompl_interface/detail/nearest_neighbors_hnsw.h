@@ -0,0 +1,356 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_HNSW_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_HNSW_
+
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/RandomNumbers.h>
+#include <ompl/util/Exception.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <map>
+#include <cmath>
+
+namespace ompl_interface
+{
+
+/** @class NearestNeighborsHNSW
+    @brief Approximate nearest neighbors using a hierarchical navigable small world graph.  Every
+    element is linked to its closest elements on a random number of layers; queries descend greedily
+    through the sparse upper layers and run a bounded best-first search on the bottom layer.  The cost
+    of a query grows roughly logarithmically with the number of elements and, unlike for space
+    partitioning structures, does not degrade with the dimension of the space.  Removed elements
+    stay in the graph for navigation until more than half the elements are removed, at which point
+    the graph is rebuilt; queries pass through them but do not count them towards the size of the
+    search, which grows until enough elements are found or the graph is exhausted.  Only the
+    distance function is used, so any distance (including wraparound of continuous joints and
+    per-joint weights) is supported. */
+template<typename _T>
+class NearestNeighborsHNSW : public ompl::NearestNeighbors<_T>
+{
+public:
+
+  NearestNeighborsHNSW(unsigned int max_links = 16, unsigned int ef_construction = 64, unsigned int ef_search = 32)
+    : ompl::NearestNeighbors<_T>()
+    , max_links_(max_links)
+    , ef_construction_(ef_construction)
+    , ef_search_(ef_search)
+    , level_factor_(1.0 / log((double)max_links))
+    , entry_(NO_NODE)
+    , max_level_(0)
+    , removed_count_(0)
+    , visit_epoch_(0)
+  {
+  }
+
+  virtual void clear()
+  {
+    nodes_.clear();
+    index_.clear();
+    entry_ = NO_NODE;
+    max_level_ = 0;
+    removed_count_ = 0;
+  }
+
+  virtual bool reportsSortedResults() const
+  {
+    return true;
+  }
+
+  virtual void add(const _T &data)
+  {
+    const std::size_t id = nodes_.size();
+    const unsigned int level = randomLevel();
+    nodes_.push_back(Node());
+    nodes_.back().data = data;
+    nodes_.back().removed = false;
+    nodes_.back().links.resize(level + 1);
+    index_[data] = id;
+
+    if (entry_ == NO_NODE)
+    {
+      entry_ = id;
+      max_level_ = level;
+      return;
+    }
+
+    // descend greedily through the layers above the level of the new node
+    std::size_t closest = entry_;
+    double closest_dist = this->distFun_(data, nodes_[entry_].data);
+    for (unsigned int l = max_level_ ; l > level ; --l)
+      greedyClosest(data, l, closest, closest_dist);
+
+    // link the new node on every layer it belongs to
+    std::vector<Candidate> candidates;
+    for (unsigned int l = std::min(level, max_level_) ; ; --l)
+    {
+      searchLayer(data, closest, closest_dist, l, ef_construction_, false, candidates);
+      const std::size_t count = std::min<std::size_t>(max_links_, candidates.size());
+      for (std::size_t i = 0 ; i < count ; ++i)
+      {
+        const std::size_t other = candidates[i].second;
+        nodes_[id].links[l].push_back(other);
+        nodes_[other].links[l].push_back(id);
+        if (nodes_[other].links[l].size() > maxLinks(l))
+          pruneLinks(other, l);
+      }
+      closest = candidates[0].second;
+      closest_dist = candidates[0].first;
+      if (l == 0)
+        break;
+    }
+
+    if (level > max_level_)
+    {
+      max_level_ = level;
+      entry_ = id;
+    }
+  }
+
+  virtual bool remove(const _T &data)
+  {
+    typename std::map<_T, std::size_t>::iterator it = index_.find(data);
+    if (it == index_.end())
+      return false;
+    nodes_[it->second].removed = true;
+    index_.erase(it);
+    ++removed_count_;
+
+    // too many elements that only serve for navigation; rebuild the graph
+    if (removed_count_ * 2 > nodes_.size())
+    {
+      std::vector<_T> elements;
+      list(elements);
+      clear();
+      for (std::size_t i = 0 ; i < elements.size() ; ++i)
+        add(elements[i]);
+    }
+    return true;
+  }
+
+  virtual _T nearest(const _T &data) const
+  {
+    std::vector<_T> nbh;
+    nearestK(data, 1, nbh);
+    if (nbh.empty())
+      throw ompl::Exception("No elements found in nearest neighbors data structure");
+    return nbh[0];
+  }
+
+  virtual void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const
+  {
+    nbh.clear();
+    if (k == 0 || size() == 0)
+      return;
+
+    std::size_t closest = entry_;
+    double closest_dist = this->distFun_(data, nodes_[entry_].data);
+    for (unsigned int l = max_level_ ; l > 0 ; --l)
+      greedyClosest(data, l, closest, closest_dist);
+
+    std::vector<Candidate> candidates;
+    searchLayer(data, closest, closest_dist, 0, std::max<std::size_t>(ef_search_, k), true, candidates);
+    for (std::size_t i = 0 ; i < candidates.size() && nbh.size() < k ; ++i)
+      nbh.push_back(nodes_[candidates[i].second].data);
+  }
+
+  virtual void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const
+  {
+    // grow the number of neighbors until the farthest one is outside the radius, or the search runs
+    // out of elements (fewer than k are found only when it has exhausted the graph)
+    std::size_t k = ef_search_;
+    while (true)
+    {
+      nearestK(data, k, nbh);
+      if (nbh.size() < k || this->distFun_(data, nbh.back()) > radius)
+        break;
+      k *= 2;
+    }
+    while (!nbh.empty() && this->distFun_(data, nbh.back()) > radius)
+      nbh.pop_back();
+  }
+
+  virtual std::size_t size() const
+  {
+    return nodes_.size() - removed_count_;
+  }
+
+  virtual void list(std::vector<_T> &data) const
+  {
+    data.clear();
+    data.reserve(size());
+    for (std::size_t i = 0 ; i < nodes_.size() ; ++i)
+      if (!nodes_[i].removed)
+        data.push_back(nodes_[i].data);
+  }
+
+private:
+
+  static const std::size_t NO_NODE = (std::size_t)-1;
+
+  struct Node
+  {
+    _T                                    data;
+    bool                                  removed;
+    std::vector<std::vector<std::size_t> > links;
+  };
+
+  /// A node and its distance to the query
+  typedef std::pair<double, std::size_t> Candidate;
+
+  unsigned int randomLevel()
+  {
+    return (unsigned int)floor(-log(1.0 - rng_.uniform01()) * level_factor_);
+  }
+
+  std::size_t maxLinks(unsigned int level) const
+  {
+    return level == 0 ? 2 * max_links_ : max_links_;
+  }
+
+  /// Move to closer neighbors on one layer until there is none
+  void greedyClosest(const _T &data, unsigned int level, std::size_t &closest, double &closest_dist) const
+  {
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      if (level >= nodes_[closest].links.size())
+        break;
+      const std::vector<std::size_t> &links = nodes_[closest].links[level];
+      for (std::size_t i = 0 ; i < links.size() ; ++i)
+      {
+        double d = this->distFun_(data, nodes_[links[i]].data);
+        if (d < closest_dist)
+        {
+          closest_dist = d;
+          closest = links[i];
+          changed = true;
+        }
+      }
+    }
+  }
+
+  /// Best-first search on one layer, keeping the \e ef closest nodes; the result is sorted by distance.  If
+  /// \e live_only, removed nodes are traversed but neither kept nor counted, so the search continues until it
+  /// keeps \e ef nodes that are not removed or runs out of reachable nodes.
+  void searchLayer(const _T &data, std::size_t entry, double entry_dist, unsigned int level, std::size_t ef,
+                   bool live_only, std::vector<Candidate> &result) const
+  {
+    if (visited_.size() < nodes_.size())
+      visited_.resize(nodes_.size(), 0);
+    if (++visit_epoch_ == 0)
+    {
+      std::fill(visited_.begin(), visited_.end(), 0);
+      visit_epoch_ = 1;
+    }
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > frontier;
+    std::priority_queue<Candidate> best;
+    frontier.push(Candidate(entry_dist, entry));
+    if (!live_only || !nodes_[entry].removed)
+      best.push(Candidate(entry_dist, entry));
+    visited_[entry] = visit_epoch_;
+
+    while (!frontier.empty())
+    {
+      const Candidate current = frontier.top();
+      if (best.size() >= ef && current.first > best.top().first)
+        break;
+      frontier.pop();
+
+      const std::vector<std::size_t> &links = nodes_[current.second].links[level];
+      for (std::size_t i = 0 ; i < links.size() ; ++i)
+      {
+        const std::size_t n = links[i];
+        if (visited_[n] == visit_epoch_)
+          continue;
+        visited_[n] = visit_epoch_;
+        double d = this->distFun_(data, nodes_[n].data);
+        if (best.size() < ef || d < best.top().first)
+        {
+          frontier.push(Candidate(d, n));
+          if (live_only && nodes_[n].removed)
+            continue;
+          best.push(Candidate(d, n));
+          if (best.size() > ef)
+            best.pop();
+        }
+      }
+    }
+
+    result.resize(best.size());
+    for (std::size_t i = result.size() ; i > 0 ; --i)
+    {
+      result[i - 1] = best.top();
+      best.pop();
+    }
+  }
+
+  /// Keep only the closest links of a node on one layer
+  void pruneLinks(std::size_t node, unsigned int level)
+  {
+    std::vector<std::size_t> &links = nodes_[node].links[level];
+    std::vector<Candidate> candidates(links.size());
+    for (std::size_t i = 0 ; i < links.size() ; ++i)
+      candidates[i] = Candidate(this->distFun_(nodes_[node].data, nodes_[links[i]].data), links[i]);
+    std::sort(candidates.begin(), candidates.end());
+    links.resize(maxLinks(level));
+    for (std::size_t i = 0 ; i < links.size() ; ++i)
+      links[i] = candidates[i].second;
+  }
+
+  unsigned int                      max_links_;
+  unsigned int                      ef_construction_;
+  unsigned int                      ef_search_;
+  double                            level_factor_;
+
+  std::vector<Node>                 nodes_;
+  std::map<_T, std::size_t>         index_;
+  std::size_t                       entry_;
+  unsigned int                      max_level_;
+  std::size_t                       removed_count_;
+  ompl::RNG                         rng_;
+
+  /// Marks of the nodes visited by the current search (not thread safe, like the other OMPL structures)
+  mutable std::vector<unsigned int> visited_;
+  mutable unsigned int              visit_epoch_;
+};
+
+}
+
+#endif
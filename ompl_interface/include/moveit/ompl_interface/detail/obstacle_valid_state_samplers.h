@@ -0,0 +1,131 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_OBSTACLE_VALID_STATE_SAMPLERS_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_OBSTACLE_VALID_STATE_SAMPLERS_
+
+#include <ompl/base/ValidStateSampler.h>
+#include <ompl/base/StateSampler.h>
+
+namespace ompl_interface
+{
+
+class OMPLPlanningContext;
+
+/** @class ObstacleValidStateSampler
+    @brief Base class of the valid state samplers that concentrate their samples near obstacles, where
+    narrow passages are.  Candidate states come from the state sampler of the space (so they follow
+    the path constraints and the configured uniform sampler), and are checked by the state validity
+    checker of the planning context. */
+class ObstacleValidStateSampler : public ompl::base::ValidStateSampler
+{
+public:
+
+  ObstacleValidStateSampler(const OMPLPlanningContext *pc);
+  virtual ~ObstacleValidStateSampler();
+
+  virtual bool sample(ompl::base::State *state);
+  virtual bool sampleNear(ompl::base::State *state, const ompl::base::State *near, const double distance);
+
+  /// The standard deviation of the Gaussian steps away from a candidate state
+  void setStdDev(double stddev)
+  {
+    stddev_ = stddev;
+  }
+
+  double getStdDev() const
+  {
+    return stddev_;
+  }
+
+protected:
+
+  /// Sample a valid state; the candidates are uniform, or within \e distance of \e near if it is not NULL
+  virtual bool sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance) = 0;
+
+  void sampleCandidate(ompl::base::State *state, const ompl::base::State *near, double distance);
+
+  const OMPLPlanningContext  *planning_context_;
+  ompl::base::StateSamplerPtr sampler_;
+  ompl::base::State          *work_;
+  ompl::base::State          *other_;
+  double                      stddev_;
+};
+
+/** @class GaussianValidSampler
+    @brief Sample pairs of states a Gaussian step apart and keep the valid state of the pairs where
+    exactly one of the two is valid */
+class GaussianValidSampler : public ObstacleValidStateSampler
+{
+public:
+
+  GaussianValidSampler(const OMPLPlanningContext *pc);
+
+protected:
+
+  virtual bool sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance);
+};
+
+/** @class BridgeTestValidSampler
+    @brief Sample pairs of invalid states a Gaussian step apart and keep their midpoint if it is valid.
+    The samples lie in passages between obstacles rather than along every obstacle surface. */
+class BridgeTestValidSampler : public ObstacleValidStateSampler
+{
+public:
+
+  BridgeTestValidSampler(const OMPLPlanningContext *pc);
+
+protected:
+
+  virtual bool sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance);
+};
+
+/** @class ObstacleBasedValidSampler
+    @brief Sample a valid and an invalid state and keep the last valid state of the motion from the
+    valid one to the invalid one, which lies on the boundary of an obstacle */
+class ObstacleBasedValidSampler : public ObstacleValidStateSampler
+{
+public:
+
+  ObstacleBasedValidSampler(const OMPLPlanningContext *pc);
+
+protected:
+
+  virtual bool sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance);
+};
+
+}
+
+#endif
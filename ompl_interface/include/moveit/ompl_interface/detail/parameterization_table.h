@@ -0,0 +1,109 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_PARAMETERIZATION_TABLE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_PARAMETERIZATION_TABLE_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/Constraints.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <map>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(ParameterizationTable);
+
+/** @class ParameterizationTable
+    @brief Remembers, for each group and signature of path constraints, how fast each state space
+    parameterization produced states satisfying the constraints in the races run so far.  Once every
+    parameterization has been raced a few times, the fastest one is used without racing.  The table
+    is saved to a text file after every race, so the results carry over to later runs. */
+class ParameterizationTable : private boost::noncopyable
+{
+public:
+
+  /// The number of races of each parameterization before the fastest one is trusted
+  static const unsigned int RACES;
+
+  /// Load the table stored at \e path, if the file exists.  An empty path keeps the table in memory only
+  explicit ParameterizationTable(const std::string &path);
+
+  /// Set \e parameterization to the fastest one recorded for (\e group, \e signature).  Return false if there
+  /// are no records, or if some parameterization has been raced fewer than \e races times
+  bool getFastest(const std::string &group, const std::string &signature, std::string &parameterization, unsigned int races) const;
+
+  /// Record the number of states per second satisfying the constraints that \e parameterization produced, and save the table
+  void recordRace(const std::string &group, const std::string &signature, const std::string &parameterization, double rate);
+
+  const std::string& getPath() const
+  {
+    return path_;
+  }
+
+  /// The kinds of the constraints and the links, joints and frames they apply to (but not their values),
+  /// without white space
+  static std::string computeSignature(const moveit_msgs::Constraints &constraints);
+
+  /// The file in the ROS home directory ($ROS_HOME, or ~/.ros)
+  static std::string getDefaultPath();
+
+  /// The table stored at \e path, shared by the planning contexts of the process
+  static ParameterizationTablePtr getShared(const std::string &path);
+
+private:
+
+  struct Record
+  {
+    unsigned int races;
+    double       rate;
+  };
+
+  /// The records of each parameterization
+  typedef std::map<std::string, Record> Records;
+
+  void load();
+  void save() const;
+
+  std::string                                             path_;
+  std::map<std::pair<std::string, std::string>, Records>  records_;
+  mutable boost::mutex                                    lock_;
+};
+
+}
+
+#endif
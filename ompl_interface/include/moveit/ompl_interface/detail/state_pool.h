@@ -0,0 +1,115 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_STATE_POOL_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_STATE_POOL_
+
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+namespace ompl_interface
+{
+
+/** @class StatePool
+    @brief Fixed size memory blocks for states, carved out of large contiguous chunks.  Every
+    thread allocates from and frees to a free list of its own, without locking; blocks move
+    between the thread free lists and the shared free list (or the chunks) in batches.  The chunks
+    themselves are only returned to the system when the pool is destroyed or release() is called
+    with no block in use. */
+class StatePool : private boost::noncopyable
+{
+public:
+
+  /// The alignment of every block (and of every field laid out with align())
+  static const std::size_t ALIGNMENT = 16;
+
+  StatePool(std::size_t block_size, std::size_t blocks_per_chunk = 1024);
+  ~StatePool();
+
+  /// Round \e size up to a multiple of the alignment
+  static std::size_t align(std::size_t size)
+  {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+
+  std::size_t getBlockSize() const
+  {
+    return block_size_;
+  }
+
+  void* allocate();
+  void free(void *block);
+
+  /// Return all chunks to the system if no block is in use. Returns true on success.
+  /// No other thread may allocate or free blocks during the call.
+  bool release();
+
+private:
+
+  /// The free list of a thread, and the blocks allocated minus the blocks freed by the thread
+  struct ThreadCache
+  {
+    ThreadCache() : free_list(NULL), free_count(0), in_use(0)
+    {
+    }
+
+    void        *free_list;
+    std::size_t  free_count;
+    long         in_use;
+  };
+
+  /// Move a batch of blocks from the shared free list (or new chunk memory) to the free list of a thread
+  void refill(ThreadCache &cache);
+
+  /// Move \e count blocks from the free list of a thread to the shared free list
+  void drain(ThreadCache &cache, std::size_t count);
+
+  /// The blocks in use, summed over all threads; no thread may use the pool meanwhile
+  long countBlocksInUse() const;
+
+  std::size_t                      block_size_;
+  std::size_t                      blocks_per_chunk_;
+  std::vector<char*>               chunks_;
+  std::size_t                      next_block_;
+  void                            *free_list_;
+  ThreadLocalStorage<ThreadCache>  caches_;
+  boost::mutex                     lock_;
+};
+
+}
+
+#endif
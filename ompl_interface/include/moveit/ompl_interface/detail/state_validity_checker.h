@@ -38,6 +38,9 @@
 #define MOVEIT_OMPL_INTERFACE_DETAIL_STATE_VALIDITY_CHECKER_
 
 #include "moveit/ompl_interface/detail/threadsafe_state_storage.h"
+#include "moveit/ompl_interface/detail/static_collision_environment.h"
+#include "moveit/ompl_interface/detail/collision_spheres.h"
+#include "moveit/ompl_interface/detail/environment_distance_field.h"
 #include <moveit/collision_detection/collision_common.h>
 #include <ompl/base/StateValidityChecker.h>
 
@@ -81,6 +84,14 @@ protected:
   bool isValidWithCache(const ompl::base::State *state, bool verbose) const;
   bool isValidWithCache(const ompl::base::State *state, double &dist, bool verbose) const;
 
+  /// Check the state for collision, using the precomputed static environment when available
+  void checkCollision(const collision_detection::CollisionRequest &req, collision_detection::CollisionResult &res,
+                      const robot_state::RobotState &state) const;
+
+  /// Return true if the state is collision free. The collision spheres are tried first; the exact check
+  /// only runs when they are inconclusive
+  bool isCollisionFree(const robot_state::RobotState &state, bool verbose) const;
+
   const OMPLPlanningContext            *planning_context_;
   std::string                           group_name_;
   TSStateStorage                        tss_;
@@ -90,6 +101,9 @@ protected:
   collision_detection::CollisionRequest collision_request_with_distance_verbose_;
 
   collision_detection::CollisionRequest collision_request_with_cost_;
+  StaticCollisionEnvironmentPtr         static_environment_;
+  CollisionSpheresPtr                   collision_spheres_;
+  EnvironmentDistanceFieldConstPtr      distance_field_;
   bool                                  verbose_;
 };
 
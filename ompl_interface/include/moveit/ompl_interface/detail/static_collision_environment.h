@@ -0,0 +1,118 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_STATIC_COLLISION_ENVIRONMENT_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_STATIC_COLLISION_ENVIRONMENT_
+
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/collision_detection/collision_world.h>
+#include <moveit/collision_detection/collision_robot.h>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(StaticCollisionEnvironment);
+
+/** @class StaticCollisionEnvironment
+    @brief A collision environment specialized for planning a single group.  Everything that does not
+    move while the group moves (world objects, robot links not updated by the group and the bodies
+    attached to them) is merged once into collision worlds whose broadphase structures are reused
+    for every check.  Only the links (and attached bodies) of the group are posed and tested against
+    those worlds and against each other for every state.  As in planning_scene::PlanningScene, the
+    world objects are checked against the padded robot, and the static parts of the robot (a self
+    collision) against the unpadded robot. */
+class StaticCollisionEnvironment
+{
+public:
+
+  /// Prefix used for the world objects that stand in for the static parts of the robot
+  static const std::string STATIC_BODY_PREFIX;
+
+  StaticCollisionEnvironment(const planning_scene::PlanningSceneConstPtr &scene,
+                             const robot_model::JointModelGroup *group,
+                             const robot_state::RobotState &start_state);
+
+  /// Return true if the environment could be constructed (requires the FCL collision checker)
+  bool isValid() const
+  {
+    return static_world_.get() != NULL;
+  }
+
+  /// Check the moving links of the group for collision with the static environment and with each other.
+  /// The state must have its link transforms up to date.
+  void checkCollision(const collision_detection::CollisionRequest &req, collision_detection::CollisionResult &res,
+                      const robot_state::RobotState &state) const;
+
+  /// The links that move with the group and have collision geometry
+  const std::vector<const robot_model::LinkModel*>& getMovingLinks() const
+  {
+    return moving_links_;
+  }
+
+  /// The world containing the environment as well as the static parts of the robot
+  collision_detection::WorldConstPtr getStaticWorld() const
+  {
+    return world_;
+  }
+
+  /// The collision matrix between the moving links and the objects in the static world
+  const collision_detection::AllowedCollisionMatrix& getAllowedCollisionMatrix() const
+  {
+    return world_acm_;
+  }
+
+private:
+
+  void addStaticBody(const collision_detection::WorldPtr &robot_bodies,
+                     const std::string &name, const std::vector<shapes::ShapeConstPtr> &shapes,
+                     const EigenSTL::vector_Affine3d &poses, const std::set<std::string> &touch_links,
+                     const std::map<std::string, std::set<std::string> > &moving_bodies,
+                     const collision_detection::AllowedCollisionMatrix &acm);
+
+  collision_detection::WorldPtr                  world_;
+  /// The world objects of the scene, checked against the padded group
+  collision_detection::CollisionWorldPtr         static_world_;
+  /// The static parts of the robot, checked against the unpadded group
+  collision_detection::CollisionWorldPtr         static_robot_world_;
+  collision_detection::CollisionRobotConstPtr    group_robot_;
+  collision_detection::CollisionRobotConstPtr    group_robot_unpadded_;
+  collision_detection::AllowedCollisionMatrix    world_acm_;
+  collision_detection::AllowedCollisionMatrix    self_acm_;
+  std::vector<const robot_model::LinkModel*>     moving_links_;
+};
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_THREAD_LOCAL_STORAGE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_THREAD_LOCAL_STORAGE_
+
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+
+namespace ompl_interface
+{
+
+/** @class ThreadLocalSlot
+    @brief Associates one pointer per thread with the lifetime of an owner object.  Every thread
+    keeps a small table of the slots it has used, so finding the pointer of the calling thread
+    takes no lock.  Slot identifiers are never reused, and the entries of destroyed slots are
+    pruned from a thread's table the next time that thread registers a new pointer, so this works
+    with long-lived (pooled) threads that outlive their owners. */
+class ThreadLocalSlot : private boost::noncopyable
+{
+public:
+
+  ThreadLocalSlot();
+
+  /// The pointer registered by the calling thread, or NULL
+  void* get() const;
+
+  /// Register the pointer for the calling thread
+  void set(void *data) const;
+
+private:
+
+  boost::uint64_t          id_;
+  boost::shared_ptr<bool>  alive_;
+};
+
+/** @class ThreadLocalStorage
+    @brief One instance of T per thread, copied from a prototype the first time a thread asks for it.
+    The instances are owned by this object and destroyed with it. */
+template<typename T>
+class ThreadLocalStorage : private boost::noncopyable
+{
+public:
+
+  explicit ThreadLocalStorage(const T &prototype = T()) : prototype_(prototype)
+  {
+  }
+
+  ~ThreadLocalStorage()
+  {
+    for (std::size_t i = 0 ; i < instances_.size() ; ++i)
+      delete instances_[i];
+  }
+
+  /// The instance of the calling thread
+  T* get() const
+  {
+    T *instance = static_cast<T*>(slot_.get());
+    if (!instance)
+    {
+      instance = new T(prototype_);
+      {
+        boost::mutex::scoped_lock slock(lock_);
+        instances_.push_back(instance);
+      }
+      slot_.set(instance);
+    }
+    return instance;
+  }
+
+  const T& getPrototype() const
+  {
+    return prototype_;
+  }
+
+  /// The instances of all threads so far.  They may only be used while the threads that own them are not using them.
+  void getInstances(std::vector<T*> &instances) const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    instances = instances_;
+  }
+
+private:
+
+  T                        prototype_;
+  ThreadLocalSlot          slot_;
+  mutable std::vector<T*>  instances_;
+  mutable boost::mutex     lock_;
+};
+
+}
+
+#endif
@@ -37,8 +37,8 @@
 #ifndef MOVEIT_OMPL_INTERFACE_DETAIL_THREADSAFE_STATE_STORAGE_
 #define MOVEIT_OMPL_INTERFACE_DETAIL_THREADSAFE_STATE_STORAGE_
 
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
 #include <moveit/robot_state/robot_state.h>
-#include <boost/thread.hpp>
 
 namespace ompl_interface
 {
@@ -49,15 +49,12 @@ public:
 
   TSStateStorage(const robot_model::RobotModelPtr &kmodel);
   TSStateStorage(const robot_state::RobotState &start_state);
-  ~TSStateStorage();
 
   robot_state::RobotState* getStateStorage() const;
 
 private:
 
-  robot_state::RobotState                                       start_state_;
-  mutable std::map<boost::thread::id, robot_state::RobotState*> thread_states_;
-  mutable boost::mutex                                                  lock_;
+  ThreadLocalStorage<robot_state::RobotState> thread_states_;
 };
 
 }
@@ -0,0 +1,125 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_WORKER_IK_CONSTRAINT_SAMPLER_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_WORKER_IK_CONSTRAINT_SAMPLER_
+
+#include <moveit/constraint_samplers/constraint_sampler.h>
+#include <moveit/constraint_samplers/constraint_sampler_allocator.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/kinematics_base/kinematics_base.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/scoped_ptr.hpp>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(WorkerIKConstraintSampler);
+
+/** @class WorkerIKConstraintSampler
+    @brief Samples states satisfying a position and/or an orientation constraint on the tip link of a group by
+    inverse kinematics, as the IKConstraintSampler of MoveIt, but with a solver of its own, allocated by the
+    solver allocator of the group.  Samplers of the same group can therefore run concurrently, as the parallel
+    goal sampling workers do, whatever the thread safety of the kinematics plugin. */
+class WorkerIKConstraintSampler : public constraint_samplers::ConstraintSampler
+{
+public:
+
+  WorkerIKConstraintSampler(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name);
+
+  /// True if \e constr can be sampled for \e group: one position and/or one orientation constraint, on the tip
+  /// link of the solver of the group, and no other constraint
+  static bool canSample(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name,
+                        const moveit_msgs::Constraints &constr);
+
+  virtual bool configure(const moveit_msgs::Constraints &constr);
+
+  /// Sample from a random seed; the joints outside the group are those of \e reference_state
+  virtual bool sample(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts);
+
+  /// Sample with the group values of \e state as the seed of the first attempt
+  virtual bool project(robot_state::RobotState &state, unsigned int max_attempts);
+
+  virtual const std::string& getName() const
+  {
+    static const std::string SAMPLER_NAME = "WorkerIKConstraintSampler";
+    return SAMPLER_NAME;
+  }
+
+  const kinematics::KinematicsBaseConstPtr& getSolver() const
+  {
+    return solver_;
+  }
+
+protected:
+
+  virtual void clear();
+
+private:
+
+  /// Sample a pose of the tip in the model frame
+  bool samplePose(Eigen::Vector3d &position, Eigen::Quaterniond &orientation, robot_state::RobotState &state, unsigned int max_attempts);
+  bool callIK(robot_state::RobotState &state, const Eigen::Vector3d &position, const Eigen::Quaterniond &orientation);
+  void validityCallback(robot_state::RobotState *state, const geometry_msgs::Pose &pose, const std::vector<double> &ik_solution,
+                        moveit_msgs::MoveItErrorCodes &error_code) const;
+
+  boost::scoped_ptr<kinematic_constraints::PositionConstraint>    position_constraint_;
+  boost::scoped_ptr<kinematic_constraints::OrientationConstraint> orientation_constraint_;
+  kinematics::KinematicsBaseConstPtr                              solver_;
+  /// The base frame of the solver, and whether poses have to be transformed to it from the model frame
+  std::string                                                     ik_frame_;
+  bool                                                            transform_ik_;
+  double                                                          ik_timeout_;
+  random_numbers::RandomNumberGenerator                           rng_;
+  std::vector<double>                                             seed_;
+  std::vector<double>                                             values_;
+};
+
+/** @class WorkerIKConstraintSamplerAllocator
+    @brief Allocates WorkerIKConstraintSampler instances, for the constraints they can sample, from a ConstraintSamplerManager */
+class WorkerIKConstraintSamplerAllocator : public constraint_samplers::ConstraintSamplerAllocator
+{
+public:
+
+  virtual constraint_samplers::ConstraintSamplerPtr alloc(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name,
+                                                          const moveit_msgs::Constraints &constr);
+  virtual bool canService(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name,
+                          const moveit_msgs::Constraints &constr) const;
+};
+
+}
+
+#endif
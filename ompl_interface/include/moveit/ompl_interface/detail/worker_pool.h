@@ -0,0 +1,108 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_WORKER_POOL_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_WORKER_POOL_
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/exception_ptr.hpp>
+#include <deque>
+#include <vector>
+
+namespace ompl_interface
+{
+
+/** @class WorkerPool
+    @brief A set of threads that stay alive to execute short tasks.  run() hands a batch of tasks to
+    the workers and returns once all of them are done; the calling thread executes tasks of its own
+    batch as well, so calls from within a task (or from many planner threads at once) cannot starve.
+    An exception thrown by a task is passed on to the caller of run().  A single pool is shared by the
+    planning contexts of the process (getShared()). */
+class WorkerPool : private boost::noncopyable
+{
+public:
+
+  typedef boost::function<void()> Task;
+
+  /// Start \e threads workers (one per hardware thread, minus the calling thread, if 0)
+  explicit WorkerPool(unsigned int threads = 0);
+  ~WorkerPool();
+
+  /// Execute all \e tasks and wait for them to finish.  If tasks throw, the first exception is rethrown once all
+  /// tasks are done.
+  void run(const std::vector<Task> &tasks);
+
+  unsigned int getThreadCount() const
+  {
+    return threads_.size();
+  }
+
+  /// The pool shared by the process, started on first use
+  static WorkerPool& getShared();
+
+private:
+
+  struct Batch
+  {
+    const std::vector<Task> *tasks;
+    std::size_t              next;
+    std::size_t              pending;
+    boost::exception_ptr     error;
+  };
+
+  void worker();
+
+  /// Take the next task of the front batch; the lock must be held and a batch must be queued
+  std::size_t takeTask(Batch *&batch);
+
+  /// Execute a task, returning the exception it throws, if any
+  static boost::exception_ptr executeTask(const Task &task);
+
+  /// Mark a task of \e batch as done, with the exception it threw; the lock must be held
+  void finishTask(Batch *batch, const boost::exception_ptr &error);
+
+  std::vector<boost::thread*> threads_;
+  std::deque<Batch*>          batches_;
+  boost::mutex                lock_;
+  boost::condition_variable   work_available_;
+  boost::condition_variable   batch_done_;
+  bool                        stop_;
+};
+
+}
+
+#endif
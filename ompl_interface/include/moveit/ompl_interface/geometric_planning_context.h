@@ -39,6 +39,9 @@
 
 #include <ros/ros.h>
 #include "moveit/ompl_interface/ompl_planning_context.h"
+#include "moveit/ompl_interface/detail/ik_cache.h"
+#include "moveit/ompl_interface/detail/constrained_sampler.h"
+#include "moveit/ompl_interface/detail/parameterization_table.h"
 //#include "moveit/ompl_interface/constraints_library.h"
 #include <ompl/geometric/SimpleSetup.h>
 #include <boost/thread/mutex.hpp>
@@ -96,6 +99,9 @@ public:
     /// \brief Return the set of constraints that must be satisfied along the entire path
     virtual const kinematic_constraints::KinematicConstraintSetPtr& getPathConstraints() const;
 
+    /// \brief Return the counts of the path constrained samplers during the last solve
+    ConstrainedSamplerStatistics::Counts getConstrainedSamplingStatistics() const;
+
     // TODO: Remove this.
     // ConstraintsLibraryPtr getConstraintsLibrary() const;
 
@@ -119,11 +125,41 @@ protected:
     /// \e mbss_ member.
     virtual void allocateStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec);
 
+    /// \brief Return true if the path constraints can be represented in a PoseModelStateSpace for \e jmg
+    /// (only position and orientation constraints, and inverse kinematics for all the joints of the group)
+    bool canUsePoseModelStateSpace(const robot_model::JointModelGroup *jmg) const;
+
+    /// \brief Allocate a representation based on the joint values of the group, projected onto the
+    /// path constraints if \e projected is true
+    ModelBasedStateSpacePtr allocateJointModelStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec, bool projected) const;
+
+    /// \brief Set \e mbss_ to the parameterization that produces states satisfying the path constraints
+    /// fastest, if the table of past races knows it.  Otherwise, the candidates are kept in \e raced_state_spaces_
+    /// and \e mbss_ is the joint space until the start state is set.
+    void allocateFastestStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec);
+
+    /// \brief Race the samplers of \e raced_state_spaces_ from the start state, and set up the context for the fastest
+    void raceStateSpaces();
+
+    /// \brief The table of parameterization races of this context
+    ParameterizationTablePtr getParameterizationTable() const;
+
+    /// \brief Set up the OMPL SimpleSetup, planner and samplers for \e mbss_
+    void setupStateSpace();
+
+    /// \brief The number of states per second satisfying the path constraints that the sampler of \e state_space produces
+    double measureConstrainedSamplingRate(const ModelBasedStateSpacePtr &state_space);
+
     /// \brief Allocate a (possibly constrained) state sampler.  If there are no path constraints, the
     /// sampler is the default from OMPL.  Otherwise, a custom sampler is created to sample states from
     /// the constraints specified in the motion plan request.
     virtual ompl::base::StateSamplerPtr allocPathConstrainedSampler(const ompl::base::StateSpace* ss) const;
 
+    /// \brief Allocate the valid state sampler of the planners: an obstacle aware sampler if configured,
+    /// otherwise a sampler of states satisfying the path constraints if there are any, or the uniform
+    /// valid state sampler from OMPL.
+    virtual ompl::base::ValidStateSamplerPtr allocValidStateSampler(const ompl::base::SpaceInformation* si) const;
+
     /// \brief A method that is invoked immediately before every call to solve()
     virtual void preSolve();
 
@@ -186,6 +222,9 @@ protected:
     /// \brief The constraint sampler factory.
     constraint_samplers::ConstraintSamplerManagerPtr constraint_sampler_manager_;
 
+    /// \brief The constraint sampler factory of the parallel goal sampling workers
+    constraint_samplers::ConstraintSamplerManagerPtr worker_sampler_manager_;
+
     // \brief A pointer to the constraints library.  Used for precomputed state sampling.
     // TODO: Remove this.
     //ConstraintsLibraryPtr constraints_library_;
@@ -196,6 +235,57 @@ protected:
     /// \brief The id of the planner this context is configured for
     std::string planner_id_;
 
+    /// \brief The nearest neighbors structure of the planners (gnat, sqrtapprox, linear or hnsw).  Empty for the planner default.
+    std::string nearest_neighbors_;
+
+    /// \brief The distance between joint space states (default or weighted)
+    std::string distance_metric_;
+
+    /// \brief The representation of states under path constraints (default, projected or auto)
+    std::string parameterization_;
+
+    /// \brief The file of the table of parameterization races (auto parameterization).  Empty for the default
+    std::string parameterization_table_;
+
+    /// \brief The parameterizations to race once the start state is known (auto parameterization), by type
+    std::map<std::string, ModelBasedStateSpacePtr> raced_state_spaces_;
+
+    /// \brief The state space options applied by setupStateSpace()
+    std::string serialization_format_;
+    bool use_ik_cache_;
+    bool parallel_ik_;
+    std::string interpolation_steering_;
+    std::string optimization_objective_;
+    std::string projection_evaluator_;
+
+    /// \brief The sampler of uniform joint space states (random or halton)
+    std::string state_sampler_;
+
+    /// \brief The valid state sampler of the planners (default, uniform, gaussian, bridge_test or obstacle_based)
+    std::string valid_state_sampler_;
+
+    /// \brief The stream of the next low-discrepancy state sampler
+    mutable unsigned int sampler_stream_;
+    /// \brief Mutex around sampler_stream_, as samplers are allocated by the planner threads
+    mutable boost::mutex sampler_stream_lock_;
+
+    /// \brief Inverse kinematics solutions reused by the workspace representation, if enabled
+    IKCachePtr ik_cache_;
+
+    /// \brief The number of parallel workers sampling each goal (sequential sampling if 1)
+    unsigned int goal_sampling_threads_;
+    /// \brief The sampling attempts and the number of goal states after which the sampling of a goal stops
+    unsigned int goal_sampling_attempts_;
+    unsigned int max_goal_samples_;
+    /// \brief The inverse kinematics attempts per goal sample
+    unsigned int goal_ik_attempts_;
+
+    /// \brief If true, goal regions start with the goal states found by earlier requests for the same constraints
+    bool use_goal_state_cache_;
+
+    /// \brief The counts of the path constrained samplers during the current solve
+    ConstrainedSamplerStatisticsPtr constrained_sampler_statistics_;
+
     /// \brief The set of planner allocators that have been registered
     std::map<std::string, PlannerAllocator> planner_allocators_;
 
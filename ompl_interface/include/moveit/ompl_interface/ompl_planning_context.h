@@ -70,7 +70,10 @@ struct PlanningContextSpecification
 class OMPLPlanningContext : public planning_interface::PlanningContext
 {
 public:
-    OMPLPlanningContext() : planning_interface::PlanningContext("UNINITIALIZED", "NO_GROUP"), use_state_validity_cache_(true) {}
+    OMPLPlanningContext() : planning_interface::PlanningContext("UNINITIALIZED", "NO_GROUP"), use_state_validity_cache_(true),
+                            use_static_collision_environment_(false), use_collision_spheres_(false),
+                            collision_sphere_margin_(0.01), use_distance_field_(false), distance_field_resolution_(0.02),
+                            distance_field_max_voxels_(1 << 23) {}
 
     virtual ~OMPLPlanningContext() {}
 
@@ -142,10 +145,92 @@ public:
         use_state_validity_cache_ = flag;
     }
 
+    /// \brief Return true if the StateValidityChecker precomputes the parts of the
+    /// environment that are static while the group moves
+    bool useStaticCollisionEnvironment() const
+    {
+        return use_static_collision_environment_;
+    }
+
+    /// \brief Enable/disable the precomputed static collision environment in the StateValidityChecker
+    void useStaticCollisionEnvironment(bool flag)
+    {
+        use_static_collision_environment_ = flag;
+    }
+
+    /// \brief Return true if the StateValidityChecker tries a sphere approximation of the
+    /// geometry before the exact collision check
+    bool useCollisionSpheres() const
+    {
+        return use_collision_spheres_;
+    }
+
+    /// \brief Enable/disable the sphere approximation in the StateValidityChecker
+    void useCollisionSpheres(bool flag)
+    {
+        use_collision_spheres_ = flag;
+    }
+
+    /// \brief The distance by which the collision spheres must clear each other for a state to be accepted
+    double getCollisionSphereMargin() const
+    {
+        return collision_sphere_margin_;
+    }
+
+    /// \brief Set the distance by which the collision spheres must clear each other for a state to be accepted
+    void setCollisionSphereMargin(double margin)
+    {
+        collision_sphere_margin_ = margin;
+    }
+
+    /// \brief Return true if the StateValidityChecker answers clearance and cost queries
+    /// using a distance field of the static environment
+    bool useDistanceField() const
+    {
+        return use_distance_field_;
+    }
+
+    /// \brief Enable/disable the distance field in the StateValidityChecker
+    void useDistanceField(bool flag)
+    {
+        use_distance_field_ = flag;
+    }
+
+    /// \brief The requested size of the voxels of the distance field
+    double getDistanceFieldResolution() const
+    {
+        return distance_field_resolution_;
+    }
+
+    /// \brief The largest number of voxels the distance field may use
+    unsigned int getDistanceFieldMaxVoxels() const
+    {
+        return distance_field_max_voxels_;
+    }
+
 protected:
 
     /// \brief Flag indicating whether caching is used in the StateValidityChecker.
     bool use_state_validity_cache_;
+
+    /// \brief Flag indicating whether the StateValidityChecker checks the moving links of the group
+    /// against a precomputed static environment
+    bool use_static_collision_environment_;
+
+    /// \brief Flag indicating whether the StateValidityChecker tries collision spheres before the exact check
+    bool use_collision_spheres_;
+
+    /// \brief Clearance required between collision spheres
+    double collision_sphere_margin_;
+
+    /// \brief Flag indicating whether clearance and cost are computed from a distance field
+    bool use_distance_field_;
+
+    /// \brief Requested resolution of the distance field
+    double distance_field_resolution_;
+
+    /// \brief Bound on the memory used by the distance field
+    unsigned int distance_field_max_voxels_;
 };
 
 }
@@ -0,0 +1,85 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_BOUNDED_JOINT_KERNELS_
+#define MOVEIT_OMPL_INTERFACE_BOUNDED_JOINT_KERNELS_
+
+#include <moveit/robot_model/joint_model_group.h>
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(BoundedJointKernels);
+
+/** @class BoundedJointKernels
+    @brief Distance, interpolation and bounds operations for groups made only of bounded revolute
+    and prismatic joints.  The per-variable arithmetic is vectorized (AVX or SSE2, depending on
+    the instruction set the code is compiled for, with a scalar fallback) and performs the same
+    floating point operations as the generic JointModelGroup implementation, so the results are
+    identical. */
+class BoundedJointKernels
+{
+public:
+
+  /// Return true if every active joint of the group is a bounded revolute or a prismatic joint and there are no mimic joints
+  static bool isApplicable(const robot_model::JointModelGroup *group, const robot_model::JointBoundsVector &bounds);
+
+  BoundedJointKernels(const robot_model::JointModelGroup *group, const robot_model::JointBoundsVector &bounds, double margin);
+
+  /// Same as JointModelGroup::distance()
+  double distance(const double *state1, const double *state2) const;
+
+  /// Same as JointModelGroup::interpolate()
+  void interpolate(const double *from, const double *to, double t, double *state) const;
+
+  /// Same as JointModelGroup::satisfiesPositionBounds(), with the margin passed to the constructor
+  bool satisfiesBounds(const double *values) const;
+
+  /// Same as JointModelGroup::enforcePositionBounds()
+  void enforceBounds(double *values) const;
+
+private:
+
+  std::size_t         size_;
+  std::vector<double> factors_;
+  std::vector<double> lower_;
+  std::vector<double> upper_;
+  std::vector<double> lower_margin_;
+  std::vector<double> upper_margin_;
+};
+
+}
+
+#endif
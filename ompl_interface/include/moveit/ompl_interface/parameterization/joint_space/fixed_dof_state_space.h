@@ -0,0 +1,82 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_FIXED_DOF_STATE_SPACE_
+#define MOVEIT_OMPL_INTERFACE_FIXED_DOF_STATE_SPACE_
+
+#include "moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h"
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace ompl_interface
+{
+
+/// A JointModelStateSpace for groups with exactly N variables.  Knowing the number of variables at
+/// compile time lets copies and comparisons be fully unrolled.  Distance and interpolation are inherited,
+/// and use the vectorized BoundedJointKernels when the group allows it.
+template<unsigned int N>
+class FixedDofStateSpace : public JointModelStateSpace
+{
+public:
+
+  FixedDofStateSpace(const ModelBasedStateSpaceSpecification &spec) : JointModelStateSpace(spec)
+  {
+    if (variable_count_ != N)
+      throw std::runtime_error("Group '" + spec.joint_model_group_->getName() + "' does not have the expected number of variables");
+  }
+
+  virtual void copyState(ompl::base::State *destination, const ompl::base::State *source) const
+  {
+    memcpy(destination->as<StateType>()->values, source->as<StateType>()->values, N * sizeof(double));
+    destination->as<StateType>()->tag = source->as<StateType>()->tag;
+    destination->as<StateType>()->flags = source->as<StateType>()->flags;
+    destination->as<StateType>()->distance = source->as<StateType>()->distance;
+  }
+
+  virtual bool equalStates(const ompl::base::State *state1, const ompl::base::State *state2) const
+  {
+    const double *v1 = state1->as<StateType>()->values;
+    const double *v2 = state2->as<StateType>()->values;
+    for (unsigned int i = 0 ; i < N ; ++i)
+      if (fabs(v1[i] - v2[i]) > std::numeric_limits<double>::epsilon())
+        return false;
+    return true;
+  }
+};
+
+}
+
+#endif
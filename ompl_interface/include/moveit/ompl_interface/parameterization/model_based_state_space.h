@@ -37,6 +37,8 @@
 #ifndef MOVEIT_OMPL_INTERFACE_MODEL_BASED_STATE_SPACE_
 #define MOVEIT_OMPL_INTERFACE_MODEL_BASED_STATE_SPACE_
 
+#include "moveit/ompl_interface/detail/state_pool.h"
+#include "moveit/ompl_interface/parameterization/bounded_joint_kernels.h"
 #include <ompl/base/StateSpace.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
@@ -170,6 +172,17 @@ public:
     double distance;
   };
 
+  /// The encoding of the variables of serialized states
+  enum SerializationFormat
+    {
+      /// Every variable as a double
+      SERIALIZE_RAW = 0,
+      /// Bounded variables as 16 bit fixed point numbers relative to their bounds, other variables as doubles
+      SERIALIZE_QUANTIZED_16 = 1,
+      /// Bounded variables as 32 bit fixed point numbers relative to their bounds, other variables as doubles
+      SERIALIZE_QUANTIZED_32 = 2
+    };
+
   ModelBasedStateSpace(const ModelBasedStateSpaceSpecification &spec);
   virtual ~ModelBasedStateSpace();
 
@@ -206,8 +219,21 @@ public:
   virtual void deserialize(ompl::base::State *state, const void *serialization) const;
   virtual double* getValueAddressAtIndex(ompl::base::State *state, const unsigned int index) const;
 
+  /// The signature includes the serialization format (unless it is raw), so states stored in one format are not loaded in another
+  virtual void computeSignature(std::vector<int> &signature) const;
+
+  /// Select the encoding of serialized states; the serialization length changes accordingly
+  void setSerializationFormat(SerializationFormat format);
+
+  SerializationFormat getSerializationFormat() const
+  {
+    return serialization_format_;
+  }
+
   virtual ompl::base::StateSamplerPtr allocDefaultStateSampler() const;
 
+  /// Return the memory of the state pool to the system, if no state is allocated
+  bool releaseStateMemory();
 
   const robot_model::RobotModelConstPtr& getRobotModel() const
   {
@@ -264,10 +290,14 @@ public:
 
 protected:
 
+  /// Set the tag of an interpolated state from the tags of the states it was interpolated between
+  void interpolateTag(const ompl::base::State *from, const ompl::base::State *to, const double t, ompl::base::State *state) const;
+
   ModelBasedStateSpaceSpecification spec_;
   std::vector<robot_model::JointModel::Bounds> joint_bounds_storage_;
   std::vector<const robot_model::JointModel*> joint_model_vector_;
   unsigned int variable_count_;
+  unsigned int dimension_;
   size_t state_values_size_;
 
   InterpolationFunction interpolation_function_;
@@ -276,6 +306,19 @@ protected:
   double tag_snap_to_segment_;
   double tag_snap_to_segment_complement_;
 
+  /// Storage for states; every state (header and values) occupies one block
+  boost::shared_ptr<StatePool> state_pool_;
+
+  /// Vectorized operations, if the group consists only of bounded revolute and prismatic joints
+  BoundedJointKernelsPtr kernels_;
+
+  SerializationFormat serialization_format_;
+  unsigned int serialization_length_;
+  /// For each variable, the lower bound and the step of the fixed point encoding (a zero step for variables serialized as doubles)
+  std::vector<std::pair<double, double> > quantization_;
+  /// For each variable, true if it belongs to a continuous joint and is wrapped to its bounds before encoding
+  std::vector<bool> quantization_wraps_;
+
 };
 
 typedef boost::shared_ptr<ModelBasedStateSpace> ModelBasedStateSpacePtr;
@@ -0,0 +1,121 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_PROJECTED_STATE_SPACE_
+#define MOVEIT_OMPL_INTERFACE_PROJECTED_STATE_SPACE_
+
+#include "moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h"
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <Eigen/Cholesky>
+
+namespace ompl_interface
+{
+
+OMPL_CLASS_FORWARD(ProjectedStateSpace);
+
+/** @class ProjectedStateSpace
+    @brief A joint space representation that keeps its states on the manifold defined by the position
+    and orientation path constraints.  Sampled and interpolated states are projected onto the constraints
+    by damped Newton iterations on the Jacobian of the constrained links; joint constraints are enforced
+    by clamping.  Unlike the PoseModelStateSpace, no inverse kinematics solver is needed, but the group
+    must be a chain.  States that cannot be projected are marked invalid. */
+class ProjectedStateSpace : public JointModelStateSpace
+{
+public:
+
+  static const std::string PARAMETERIZATION_TYPE;
+
+  ProjectedStateSpace(const ModelBasedStateSpaceSpecification &spec, const moveit_msgs::Constraints &constraints,
+                      const robot_state::Transforms &tf, const robot_state::RobotState &reference_state);
+
+  virtual void interpolate(const ompl::base::State *from, const ompl::base::State *to, const double t, ompl::base::State *state) const;
+  virtual ompl::base::StateSamplerPtr allocDefaultStateSampler() const;
+
+  /// Move \e state onto the constraints.  Return false (and mark the state invalid) if the iterations do not converge
+  bool project(ompl::base::State *state) const;
+
+  /// Set the values of the joints outside the group, used when computing the poses of the constrained links
+  void setReferenceState(const robot_state::RobotState &reference_state);
+
+  /// Return true if there are constraints the states are projected onto
+  bool hasProjectedConstraints() const
+  {
+    return !position_constraints_.empty() || !orientation_constraints_.empty() || !joint_constraints_.empty();
+  }
+
+private:
+
+  /// The robot state and the buffers of the Newton iterations of a thread, sized once so projecting allocates nothing
+  struct Workspace
+  {
+    Workspace(const robot_state::RobotState &reference_state) : state(reference_state)
+    {
+    }
+
+    robot_state::RobotState      state;
+    Eigen::VectorXd              error;
+    Eigen::MatrixXd              jacobian;
+    Eigen::MatrixXd              link_jacobian;
+    Eigen::MatrixXd              jjt;
+    Eigen::LDLT<Eigen::MatrixXd> ldlt;
+    Eigen::VectorXd              solution;
+    Eigen::VectorXd              step;
+  };
+
+  /// Write the residual of the unsatisfied constraints to \e ws.error and the corresponding rows of the Jacobian
+  /// to \e ws.jacobian, with zero rows for the satisfied ones; return the number of unsatisfied rows
+  unsigned int computeResidual(Workspace &ws) const;
+  void clampJointConstraints(ompl::base::State *state) const;
+
+  std::vector<kinematic_constraints::PositionConstraintPtr>    position_constraints_;
+  std::vector<kinematic_constraints::OrientationConstraintPtr> orientation_constraints_;
+  std::vector<kinematic_constraints::JointConstraintPtr>       joint_constraints_;
+
+  /// For each joint constraint, the index of the constrained variable in the group
+  std::vector<unsigned int> joint_constraint_index_;
+
+  /// The link the group is attached to; the frame of the Jacobian
+  const robot_model::LinkModel *base_link_;
+
+  /// The robot state and buffers used by each thread to project states
+  boost::shared_ptr<ThreadLocalStorage<Workspace> > workspaces_;
+
+  double jump_factor_;
+};
+
+}
+
+#endif
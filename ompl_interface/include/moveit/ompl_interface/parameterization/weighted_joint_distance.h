@@ -0,0 +1,80 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_WEIGHTED_JOINT_DISTANCE_
+#define MOVEIT_OMPL_INTERFACE_WEIGHTED_JOINT_DISTANCE_
+
+#include "moveit/ompl_interface/parameterization/model_based_state_space.h"
+
+namespace ompl_interface
+{
+
+MOVEIT_CLASS_FORWARD(WeightedJointDistance);
+
+/** @class WeightedJointDistance
+    @brief A distance between the states of a ModelBasedStateSpace in which each joint is weighted by how far
+    its motion moves the robot.  The weight of a revolute joint is the radius swept by the links that move
+    with it (the distance from the joint axis to the farthest point of their bounding spheres, with the
+    robot in its default state), so a shoulder joint counts more than a wrist roll.  Other joints keep a
+    unit weight.  The weights are normalized to average one, which keeps distances (and the planner
+    parameters derived from the extent of the space) on the scale of the unweighted metric.  Meant to be
+    passed to ModelBasedStateSpace::setDistanceFunction(). */
+class WeightedJointDistance
+{
+public:
+
+  WeightedJointDistance(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup *group);
+
+  double distance(const ompl::base::State *state1, const ompl::base::State *state2) const;
+
+  /// The weight of each active joint of the group, in the order of JointModelGroup::getActiveJointModels()
+  const std::vector<double>& getWeights() const
+  {
+    return weights_;
+  }
+
+private:
+
+  /// The radius swept by the links that move with a revolute joint
+  static double sweptRadius(const robot_model::JointModel *joint, const robot_state::RobotState &state);
+
+  std::vector<const robot_model::JointModel*> joints_;
+  std::vector<unsigned int>                   indices_;
+  std::vector<double>                         weights_;
+};
+
+}
+
+#endif
@@ -38,7 +38,10 @@
 #define MOVEIT_OMPL_INTERFACE_POSE_MODEL_STATE_SPACE_
 
 #include "moveit/ompl_interface/parameterization/model_based_state_space.h"
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include "moveit/ompl_interface/detail/ik_cache.h"
 #include <ompl/base/spaces/SE3StateSpace.h>
+#include <geometry_msgs/Pose.h>
 
 namespace ompl_interface
 {
@@ -96,6 +99,19 @@ public:
     ompl::base::SE3StateSpace::StateType **poses;
   };
 
+  /// Counts of the work done by the space, summed over the threads
+  struct Statistics
+  {
+    Statistics() : ik_calls(0), jump_rejections(0)
+    {
+    }
+
+    /// Inverse kinematics computations for a component, including those the IK cache answers
+    unsigned int ik_calls;
+    /// Interpolated states marked invalid because their joint values jumped away from the motion
+    unsigned int jump_rejections;
+  };
+
   PoseModelStateSpace(const ModelBasedStateSpaceSpecification &spec);
   virtual ~PoseModelStateSpace();
 
@@ -112,19 +128,115 @@ public:
   bool computeStateIK(ompl::base::State *state) const;
   bool computeStateK(ompl::base::State *state) const;
 
+  /// The pose of the tip frame of component \e idx, in the base frame of its solver, and its geometric Jacobian (a column
+  /// per variable of the group, zero for the variables outside the chain) for the joint values of \e state.
+  /// Returns false if the chain of the component is not known.
+  bool computeJacobian(const ompl::base::State *state, unsigned int idx, Eigen::Affine3d &pose, Eigen::MatrixXd &jacobian) const;
+
+  /// The counts of all threads; must not run concurrently with planning, like resetStatistics()
+  Statistics getStatistics() const;
+  void resetStatistics();
+
+  /// Use \e cache to reuse the solutions of inverse kinematics (or stop reusing them, if the pointer is empty)
+  void setIKCache(const IKCachePtr &cache)
+  {
+    ik_cache_ = cache;
+  }
+
+  /// Compute the joint values of interpolated states by Jacobian steps from the start of the motion, instead of inverse kinematics
+  void setJacobianSteering(bool steering)
+  {
+    jacobian_steering_ = steering;
+  }
+
+  /// Solve inverse kinematics for the components (e.g., the arms of a bimanual group) concurrently, on the shared worker pool
+  void setParallelIK(bool parallel)
+  {
+    parallel_ik_ = parallel;
+  }
+
+  /// Compute forward kinematics from the robot model where the kinematic chain allows it (the default), or always with the kinematics solver
+  void setDirectFK(bool direct)
+  {
+    direct_fk_ = direct;
+  }
+
   virtual void setPlanningVolume(double minX, double maxX, double minY, double maxY, double minZ, double maxZ);
   virtual void copyToOMPLState(ompl::base::State *state, const robot_state::RobotState &rstate) const;
   virtual void sanityChecks() const;
 
 private:
 
+  /// Construct an SE3 state (and its components) in place, in a block of getSE3BlockSize() bytes
+  static ompl::base::SE3StateSpace::StateType* constructSE3State(char *memory);
+  static void destroySE3State(ompl::base::SE3StateSpace::StateType *state);
+  static std::size_t getSE3BlockSize();
+
+  /// Task for the worker pool: inverse kinematics for one component
+  void computeComponentIK(StateType *state, unsigned int idx, char *solved) const;
+
   struct PoseComponent
   {
+    /// Buffers for the kinematics solver and the steering steps, kept per thread so they are not reallocated for every call
+    struct Scratch
+    {
+      Scratch() : steered_step(0)
+      {
+      }
+
+      std::vector<double>                      values;
+      std::vector<double>                      solution;
+      std::vector<geometry_msgs::Pose>         poses;
+      Eigen::Matrix3Xd                         axes;
+      Eigen::Matrix3Xd                         origins;
+      Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian;
+      Eigen::VectorXd                          step;
+
+      /// The motion steered along last on this thread (the poses of its ends and the joint values it starts from),
+      /// the last of its steps reached, and the joint values there
+      std::vector<double>                      motion;
+      std::vector<double>                      steered_motion;
+      unsigned int                             steered_step;
+      std::vector<double>                      steered_values;
+    };
+
+    /// A joint of the kinematic chain from the base frame of the solver to its tip frame
+    struct ChainJoint
+    {
+      /// The constant transform from the previous joint of the chain (or the base frame) to this joint
+      Eigen::Affine3d offset;
+      /// The joint, or NULL for the last element, whose offset leads to the tip frame
+      const robot_model::JointModel *joint;
+      /// The index of the variable of the joint in the state
+      unsigned int index;
+      /// The axis of the joint, in its own frame
+      Eigen::Vector3d axis;
+      /// True for revolute joints, false for prismatic ones
+      bool revolute;
+
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
     PoseComponent(const robot_model::JointModelGroup *subgroup,
                   const robot_model::JointModelGroup::KinematicsSolver &k);
 
-    bool computeStateFK(StateType *full_state, unsigned int idx) const;
-    bool computeStateIK(StateType *full_state, unsigned int idx) const;
+    /// Compute the pose of the tip frame from the robot model, if \e direct and the chain is known, or with the kinematics solver
+    bool computeStateFK(StateType *full_state, unsigned int idx, bool direct) const;
+    /// Compute the joint values for the pose, using (and filling) \e cache if it is not NULL
+    bool computeStateIK(StateType *full_state, unsigned int idx, IKCache *cache) const;
+
+    /// Starting from the joint values of \e from, follow the interpolation between the poses of \e from and \e to
+    /// up to \e t with damped least squares steps.  The steps divide the whole motion, and every thread remembers
+    /// the last step it reached, so consecutive interpolations along a motion (for increasing \e t) continue
+    /// from there instead of from \e from.  Returns false if the chain is not known or the steps diverge.
+    bool steer(const StateType *from, const StateType *to, double t, StateType *state, unsigned int idx) const;
+
+    /// Newton iterations with damped least squares steps from the joint values in \e values towards \e target.
+    /// Returns false if they diverge.
+    bool steerTo(const Eigen::Affine3d &target, double *values, Scratch &scratch) const;
+
+    /// The pose of the tip frame of the chain and its geometric Jacobian, in the base frame of the solver
+    void computeChainJacobian(const double *values, Eigen::Affine3d &pose, Eigen::Matrix<double, 6, Eigen::Dynamic> &jacobian) const;
 
     bool operator<(const PoseComponent &o) const
     {
@@ -136,10 +248,25 @@ private:
     std::vector<unsigned int> bijection_;
     ompl::base::StateSpacePtr state_space_;
     std::vector<std::string> fk_link_;
+    boost::shared_ptr<ThreadLocalStorage<Scratch> > scratch_;
+
+    /// The chain from the base frame to the tip frame; empty if forward kinematics needs the kinematics solver
+    std::vector<ChainJoint, Eigen::aligned_allocator<ChainJoint> > chain_;
+
+  private:
+
+    /// Find the joints between the base and tip frames of the solver, and precompute the constant transforms between them
+    void initializeChain();
   };
 
   std::vector<PoseComponent> poses_;
   double jump_factor_;
+  IKCachePtr ik_cache_;
+  bool parallel_ik_;
+  bool jacobian_steering_;
+  bool direct_fk_;
+
+  ThreadLocalStorage<Statistics> statistics_;
 };
 
 }
@@ -36,6 +36,7 @@
 
 #include <moveit/ompl_interface/constraints_library.h>
 #include <moveit/ompl_interface/detail/constrained_sampler.h>
+#include <moveit/ompl_interface/detail/batch_state_sampler.h>
 #include <moveit/profiler/profiler.h>
 #include <ompl/tools/config/SelfConfig.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -47,6 +48,9 @@ namespace ompl_interface
 
 namespace
 {
+/// Number of states sampled at once when constructing a constraint approximation
+const std::size_t SAMPLE_BATCH_SIZE = 256;
+
 template<typename T>
 void msgToHex(const T& msg, std::string &hex)
 {
@@ -439,7 +443,9 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
       csmp = new ConstrainedSampler(pcontext_, cs);
   }
 
-  ompl::base::StateSamplerPtr ss(csmp ? ompl::base::StateSamplerPtr(csmp) : pcontext_->getOMPLStateSpace()->allocDefaultStateSampler());
+  // without a constrained sampler, the batches are filled one joint at a time
+  BatchStateSampler batch_sampler(pcontext_->getOMPLStateSpace(), csmp ? ompl::base::StateSamplerPtr(csmp) : ompl::base::StateSamplerPtr());
+  SampleBatch batch;
 
   ompl::base::ScopedState<> temp(pcontext_->getOMPLStateSpace());
   int done = -1;
@@ -447,12 +453,11 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
   ompl::time::point start = ompl::time::now();
   while (sstor->size() < options.samples)
   {
-    ++attempts;
     int done_now = 100 * sstor->size() / options.samples;
     if (done != done_now)
     {
       done = done_now;
-      logInform("%d%% complete (kept %0.1lf%% sampled states)", done, 100.0 * (double)sstor->size() / (double)attempts);
+      logInform("%d%% complete (kept %0.1lf%% sampled states)", done, attempts > 0 ? 100.0 * (double)sstor->size() / (double)attempts : 0.0);
     }
 
     if (!slow_warn && attempts > 10 && attempts > sstor->size() * 100)
@@ -467,16 +472,16 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
       break;
     }
 
-    ss->sampleUniform(temp.get());
-    pcontext_->getOMPLStateSpace()->copyToRobotState(kstate, temp.get());
-    if (kset.decide(kstate).satisfied)
-    {
-      if (sstor->size() < options.samples)
+    batch_sampler.sampleUniform(batch, std::min<std::size_t>(SAMPLE_BATCH_SIZE, options.samples - sstor->size()));
+    attempts += batch.size();
+    batch_sampler.filter(batch, kset, kstate);
+    for (std::size_t i = 0 ; i < batch.size() && sstor->size() < options.samples ; ++i)
+      if (batch.isValid(i))
       {
+        batch_sampler.getState(batch, i, temp.get());
         temp->as<ModelBasedStateSpace::StateType>()->tag = sstor->size();
         sstor->addState(temp.get());
       }
-    }
   }
 
   result.state_sampling_time = ompl::time::seconds(ompl::time::now() - start);
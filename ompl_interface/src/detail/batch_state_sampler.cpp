@@ -0,0 +1,410 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/batch_state_sampler.h"
+#include "moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h"
+#include "moveit/ompl_interface/detail/constrained_sampler.h"
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_state/transforms.h>
+#include <eigen_stl_containers/eigen_stl_vector_container.h>
+#include <boost/math/constants/constants.hpp>
+#include <ompl/base/SpaceInformation.h>
+#include <cmath>
+
+namespace
+{
+// The margin around the tolerances of the constraints within which the checks on the whole batch leave the
+// decision to the complete check, so that rounding in forward kinematics cannot change the outcome
+const double TOLERANCE_MARGIN = 1e-9;
+// Samples drawn at a time by BatchValidStateSampler
+const std::size_t VALID_SAMPLER_BATCH_SIZE = 64;
+}
+
+ompl_interface::BatchStateSampler::BatchStateSampler(const ModelBasedStateSpacePtr &space, const ompl::base::StateSamplerPtr &sampler)
+  : space_(space)
+  , sampler_(sampler)
+  , constrained_sampler_(dynamic_cast<ConstrainedSampler*>(sampler.get()))
+  , scratch_(space->allocState())
+  , values_(space->getJointModelGroup()->getVariableCount())
+{
+  const robot_model::JointModelGroup *group = space_->getJointModelGroup();
+  const robot_model::JointBoundsVector &bounds = space_->getJointsBounds();
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    joints_.push_back(joints[i]);
+    indices_.push_back(group->getVariableGroupIndex(joints[i]->getVariableNames()[0]));
+    columns_.push_back(bounds[i]->size() == 1 && (*bounds[i])[0].position_bounded_);
+  }
+}
+
+ompl_interface::BatchStateSampler::~BatchStateSampler()
+{
+  space_->freeState(scratch_);
+}
+
+void ompl_interface::BatchStateSampler::sampleUniform(SampleBatch &batch, std::size_t count)
+{
+  const robot_model::JointModelGroup *group = space_->getJointModelGroup();
+  if (batch.getVariableCount() != group->getVariableCount())
+    batch = SampleBatch(group->getVariableCount());
+  batch.resize(count);
+
+  if (constrained_sampler_)
+  {
+    constrained_sampler_->sampleBatch(batch, scratch_);
+    return;
+  }
+  if (sampler_)
+  {
+    for (std::size_t i = 0 ; i < count ; ++i)
+    {
+      sampler_->sampleUniform(scratch_);
+      batch.setSample(i, scratch_->as<ModelBasedStateSpace::StateType>()->values);
+    }
+    return;
+  }
+
+  // one contiguous run of values per bounded single variable joint
+  const robot_model::JointBoundsVector &bounds = space_->getJointsBounds();
+  bool remaining = false;
+  for (std::size_t j = 0 ; j < joints_.size() ; ++j)
+    if (columns_[j])
+    {
+      const double lower = (*bounds[j])[0].min_position_;
+      const double upper = (*bounds[j])[0].max_position_;
+      double *column = batch.getVariable(indices_[j]);
+      for (std::size_t i = 0 ; i < count ; ++i)
+        column[i] = rng_.uniformReal(lower, upper);
+    }
+    else
+      remaining = true;
+
+  // the remaining joints and the mimic joints need the complete sample
+  if (!remaining && group->getMimicJointModels().empty())
+    return;
+  for (std::size_t i = 0 ; i < count ; ++i)
+  {
+    batch.getSample(i, &values_[0]);
+    for (std::size_t j = 0 ; j < joints_.size() ; ++j)
+      if (!columns_[j])
+        joints_[j]->getVariableRandomPositions(rng_, &values_[indices_[j]], *bounds[j]);
+    group->updateMimicJoints(&values_[0]);
+    batch.setSample(i, &values_[0]);
+  }
+}
+
+void ompl_interface::BatchStateSampler::computeLinkChain(const robot_model::LinkModel *link, const robot_state::RobotState &state,
+                                                         LinkChain &chain) const
+{
+  const robot_model::JointModelGroup *group = space_->getJointModelGroup();
+
+  // the links from the constrained one up to the root, and the topmost of them moved by a joint of the group
+  std::vector<const robot_model::LinkModel*> links;
+  std::size_t top = 0;
+  bool moved = false;
+  for (const robot_model::LinkModel *l = link ; l ; l = l->getParentLinkModel())
+  {
+    const robot_model::JointModel *joint = l->getParentJointModel();
+    if (joint->getVariableCount() > 0 && group->hasJointModel(joint->getName()))
+    {
+      top = links.size();
+      moved = true;
+    }
+    links.push_back(l);
+  }
+
+  chain.joints.clear();
+  chain.tip = Eigen::Affine3d::Identity();
+  if (!moved)
+  {
+    chain.base = state.getGlobalLinkTransform(link);
+    return;
+  }
+  const robot_model::LinkModel *base = links[top]->getParentLinkModel();
+  chain.base = base ? state.getGlobalLinkTransform(base) : Eigen::Affine3d::Identity();
+
+  // the joints outside the group are folded into the constant offsets
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  Eigen::Affine3d transform;
+  for (std::size_t i = top + 1 ; i > 0 ; --i)
+  {
+    offset = offset * links[i - 1]->getJointOriginTransform();
+    const robot_model::JointModel *joint = links[i - 1]->getParentJointModel();
+    if (joint->getVariableCount() == 0)
+      continue;
+    if (group->hasJointModel(joint->getName()))
+    {
+      ChainJoint cj;
+      cj.offset = offset;
+      cj.joint = joint;
+      cj.index = group->getVariableGroupIndex(joint->getVariableNames()[0]);
+      chain.joints.push_back(cj);
+      offset.setIdentity();
+    }
+    else
+    {
+      joint->computeTransform(state.getJointPositions(joint), transform);
+      offset = offset * transform;
+    }
+  }
+  chain.tip = offset;
+}
+
+void ompl_interface::BatchStateSampler::computeLinkPose(const LinkChain &chain, const double *values, Eigen::Affine3d &pose) const
+{
+  Eigen::Affine3d transform;
+  pose = chain.base;
+  for (std::size_t i = 0 ; i < chain.joints.size() ; ++i)
+  {
+    chain.joints[i].joint->computeTransform(values + chain.joints[i].index, transform);
+    pose = pose * chain.joints[i].offset * transform;
+  }
+  pose = pose * chain.tip;
+}
+
+std::size_t ompl_interface::BatchStateSampler::filter(SampleBatch &batch, const kinematic_constraints::KinematicConstraintSet &kset,
+                                                      robot_state::RobotState &work_state) const
+{
+  const robot_model::JointModelGroup *group = space_->getJointModelGroup();
+  const robot_model::RobotModelConstPtr &model = space_->getRobotModel();
+  const std::size_t count = batch.size();
+
+  // samples only the complete check can decide
+  std::vector<unsigned char> undecided(count, 0);
+  // false if some constraint is only checked by the complete check
+  bool checked = kset.getVisibilityConstraints().empty();
+
+  // the joint constraints on bounded joints of the group, on the contiguous values
+  const std::vector<moveit_msgs::JointConstraint> &joint_constraints = kset.getJointConstraints();
+  for (std::size_t c = 0 ; c < joint_constraints.size() ; ++c)
+  {
+    kinematic_constraints::JointConstraint jc(model);
+    const robot_model::JointModel *joint = jc.configure(joint_constraints[c]) ? jc.getJointModel() : NULL;
+    if (!joint || !group->hasJointModel(joint->getName()) || joint->getVariableCount() != 1 || joint->getMimic() ||
+        (joint->getType() != robot_model::JointModel::PRISMATIC && joint->getType() != robot_model::JointModel::REVOLUTE) ||
+        (joint->getType() == robot_model::JointModel::REVOLUTE &&
+         static_cast<const robot_model::RevoluteJointModel*>(joint)->isContinuous()))
+    {
+      checked = false;
+      continue;
+    }
+    const double lower = jc.getDesiredJointPosition() - jc.getJointToleranceBelow();
+    const double upper = jc.getDesiredJointPosition() + jc.getJointToleranceAbove();
+    const double *column = batch.getVariable(group->getVariableGroupIndex(joint->getName()));
+    for (std::size_t i = 0 ; i < count ; ++i)
+      if (column[i] < lower - TOLERANCE_MARGIN || column[i] > upper + TOLERANCE_MARGIN)
+        batch.setValid(i, false);
+      else if (column[i] < lower + TOLERANCE_MARGIN || column[i] > upper - TOLERANCE_MARGIN)
+        undecided[i] = 1;
+  }
+
+  // the position and orientation constraints in fixed frames, on the poses of their links
+  robot_state::Transforms tf(model->getModelFrame());
+  std::vector<kinematic_constraints::PositionConstraintPtr> position_constraints;
+  std::vector<kinematic_constraints::OrientationConstraintPtr> orientation_constraints;
+  const std::vector<moveit_msgs::PositionConstraint> &position_msgs = kset.getPositionConstraints();
+  for (std::size_t c = 0 ; c < position_msgs.size() ; ++c)
+  {
+    kinematic_constraints::PositionConstraintPtr pc(new kinematic_constraints::PositionConstraint(model));
+    if (pc->configure(position_msgs[c], tf) && !pc->mobileReferenceFrame())
+      position_constraints.push_back(pc);
+    else
+      checked = false;
+  }
+  const std::vector<moveit_msgs::OrientationConstraint> &orientation_msgs = kset.getOrientationConstraints();
+  for (std::size_t c = 0 ; c < orientation_msgs.size() ; ++c)
+  {
+    kinematic_constraints::OrientationConstraintPtr oc(new kinematic_constraints::OrientationConstraint(model));
+    if (oc->configure(orientation_msgs[c], tf) && !oc->mobileReferenceFrame())
+      orientation_constraints.push_back(oc);
+    else
+      checked = false;
+  }
+
+  if (!position_constraints.empty() || !orientation_constraints.empty())
+  {
+    // one chain per constrained link; the links above the group are placed by the variables of work_state
+    std::vector<const robot_model::LinkModel*> links;
+    for (std::size_t c = 0 ; c < position_constraints.size() ; ++c)
+      links.push_back(position_constraints[c]->getLinkModel());
+    for (std::size_t c = 0 ; c < orientation_constraints.size() ; ++c)
+      links.push_back(orientation_constraints[c]->getLinkModel());
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    work_state.update();
+    std::vector<LinkChain, Eigen::aligned_allocator<LinkChain> > chains(links.size());
+    for (std::size_t l = 0 ; l < links.size() ; ++l)
+      computeLinkChain(links[l], work_state, chains[l]);
+
+    // forward kinematics for the whole batch
+    EigenSTL::vector_Affine3d poses(links.size() * count);
+    std::vector<double> values(batch.getVariableCount());
+    for (std::size_t i = 0 ; i < count ; ++i)
+      if (batch.isValid(i))
+      {
+        batch.getSample(i, &values[0]);
+        for (std::size_t l = 0 ; l < links.size() ; ++l)
+          computeLinkPose(chains[l], &values[0], poses[l * count + i]);
+      }
+
+    for (std::size_t c = 0 ; c < position_constraints.size() ; ++c)
+    {
+      const kinematic_constraints::PositionConstraint &pc = *position_constraints[c];
+      const std::vector<bodies::BodyPtr> &regions = pc.getConstraintRegions();
+      const Eigen::Affine3d *link_poses = &poses[(std::lower_bound(links.begin(), links.end(), pc.getLinkModel()) - links.begin()) * count];
+      for (std::size_t i = 0 ; i < count ; ++i)
+      {
+        if (!batch.isValid(i))
+          continue;
+        const Eigen::Vector3d point = link_poses[i] * pc.getLinkOffset();
+        bool inside = false;
+        for (std::size_t r = 0 ; r < regions.size() && !inside ; ++r)
+          inside = regions[r]->containsPoint(point);
+        if (!inside)
+          batch.setValid(i, false);
+      }
+    }
+
+    for (std::size_t c = 0 ; c < orientation_constraints.size() ; ++c)
+    {
+      const kinematic_constraints::OrientationConstraint &oc = *orientation_constraints[c];
+      const Eigen::Matrix3d desired_inverse = oc.getDesiredRotationMatrix().transpose();
+      const Eigen::Vector3d tolerance(oc.getXAxisTolerance(), oc.getYAxisTolerance(), oc.getZAxisTolerance());
+      const Eigen::Affine3d *link_poses = &poses[(std::lower_bound(links.begin(), links.end(), oc.getLinkModel()) - links.begin()) * count];
+      for (std::size_t i = 0 ; i < count ; ++i)
+      {
+        if (!batch.isValid(i))
+          continue;
+        // the XYZ Euler angles of the deviation from the desired orientation, folded like the constraint does
+        const Eigen::Matrix3d deviation = desired_inverse * link_poses[i].rotation();
+        Eigen::Vector3d xyz = deviation.eulerAngles(0, 1, 2);
+        for (unsigned int k = 0 ; k < 3 ; ++k)
+          xyz(k) = std::min(fabs(xyz(k)), boost::math::constants::pi<double>() - fabs(xyz(k)));
+        if ((xyz.array() > tolerance.array() + TOLERANCE_MARGIN).any())
+          batch.setValid(i, false);
+        else if ((xyz.array() > tolerance.array() - TOLERANCE_MARGIN).any())
+          undecided[i] = 1;
+      }
+    }
+  }
+
+  // forward kinematics of the complete state and the complete check only for the remaining samples
+  std::vector<double> values(batch.getVariableCount());
+  std::size_t valid = 0;
+  for (std::size_t i = 0 ; i < count ; ++i)
+  {
+    if (!batch.isValid(i))
+      continue;
+    if (checked && !undecided[i])
+    {
+      ++valid;
+      continue;
+    }
+    batch.getSample(i, &values[0]);
+    work_state.setJointGroupPositions(group, &values[0]);
+    work_state.update();
+    if (kset.decide(work_state).satisfied)
+      ++valid;
+    else
+      batch.setValid(i, false);
+  }
+  return valid;
+}
+
+void ompl_interface::BatchStateSampler::getState(const SampleBatch &batch, std::size_t i, ompl::base::State *state) const
+{
+  batch.getSample(i, state->as<ModelBasedStateSpace::StateType>()->values);
+  state->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+
+  // the workspace representation also needs the pose of the end-effectors
+  if (const PoseModelStateSpace *pose_space = dynamic_cast<const PoseModelStateSpace*>(space_.get()))
+  {
+    state->as<PoseModelStateSpace::StateType>()->setJointsComputed(true);
+    state->as<PoseModelStateSpace::StateType>()->setPoseComputed(false);
+    pose_space->computeStateFK(state);
+  }
+}
+
+ompl_interface::BatchValidStateSampler::BatchValidStateSampler(const OMPLPlanningContext *pc)
+  : ompl::base::ValidStateSampler(pc->getOMPLSpaceInformation().get())
+  , planning_context_(pc)
+  , sampler_(si_->allocStateSampler())
+  , batch_sampler_(pc->getOMPLStateSpace(), pc->getPathConstraints() ? sampler_ : ompl::base::StateSamplerPtr())
+  , next_(0)
+  , work_state_(pc->getCompleteInitialRobotState())
+{
+  name_ = "batch";
+}
+
+bool ompl_interface::BatchValidStateSampler::refill()
+{
+  batch_sampler_.sampleUniform(batch_, VALID_SAMPLER_BATCH_SIZE);
+  next_ = 0;
+  const kinematic_constraints::KinematicConstraintSetPtr &constraints = planning_context_->getPathConstraints();
+  return !constraints || batch_sampler_.filter(batch_, *constraints, work_state_) > 0;
+}
+
+bool ompl_interface::BatchValidStateSampler::sample(ompl::base::State *state)
+{
+  for (unsigned int i = 0 ; i < attempts_ ; ++i)
+  {
+    while (next_ < batch_.size() && !batch_.isValid(next_))
+      ++next_;
+    if (next_ == batch_.size())
+    {
+      if (!refill())
+        continue;
+      while (!batch_.isValid(next_))
+        ++next_;
+    }
+    batch_sampler_.getState(batch_, next_++, state);
+    if (si_->isValid(state))
+      return true;
+  }
+  return false;
+}
+
+bool ompl_interface::BatchValidStateSampler::sampleNear(ompl::base::State *state, const ompl::base::State *near, const double distance)
+{
+  for (unsigned int i = 0 ; i < attempts_ ; ++i)
+  {
+    sampler_->sampleUniformNear(state, near, distance);
+    if (si_->isValid(state))
+      return true;
+  }
+  return false;
+}
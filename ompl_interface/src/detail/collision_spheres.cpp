@@ -0,0 +1,356 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/collision_spheres.h"
+#include "moveit/ompl_interface/detail/environment_distance_field.h"
+#include <geometric_shapes/shapes.h>
+#include <ompl/util/Console.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+
+namespace
+{
+// the largest number of spheres a single shape is split into
+const unsigned int MAX_SPHERES_PER_SHAPE = 8;
+
+bool isAlwaysAllowed(const collision_detection::AllowedCollisionMatrix &acm, const std::string &name1, const std::string &name2)
+{
+  collision_detection::AllowedCollision::Type type;
+  return acm.getAllowedCollision(name1, name2, type) && type == collision_detection::AllowedCollision::ALWAYS;
+}
+}
+
+ompl_interface::CollisionSpheres::CollisionSpheres(const StaticCollisionEnvironment &environment,
+                                                   const planning_scene::PlanningSceneConstPtr &scene,
+                                                   const robot_state::RobotState &start_state,
+                                                   double margin)
+  : margin_(margin)
+  , valid_(false)
+{
+  // the links of the group, padded and scaled as they are for collision checking with the world
+  const collision_detection::CollisionRobotConstPtr &robot = scene->getCollisionRobot();
+  const std::vector<const robot_model::LinkModel*> &links = environment.getMovingLinks();
+  std::set<std::string> no_touch_links;
+  for (std::size_t i = 0 ; i < links.size() ; ++i)
+    if (!addMovingBody(links[i]->getName(), links[i], links[i]->getShapes(), links[i]->getCollisionOriginTransforms(),
+                       no_touch_links, robot->getLinkScale(links[i]->getName()), robot->getLinkPadding(links[i]->getName())))
+      return;
+
+  // the bodies attached to the links of the group
+  std::set<const robot_model::LinkModel*> moving_set(links.begin(), links.end());
+  std::vector<const robot_state::AttachedBody*> attached_bodies;
+  start_state.getAttachedBodies(attached_bodies);
+  for (std::size_t i = 0 ; i < attached_bodies.size() ; ++i)
+    if (moving_set.find(attached_bodies[i]->getAttachedLink()) != moving_set.end())
+      if (!addMovingBody(attached_bodies[i]->getName(), attached_bodies[i]->getAttachedLink(), attached_bodies[i]->getShapes(),
+                         attached_bodies[i]->getFixedTransforms(), attached_bodies[i]->getTouchLinks(), 1.0, 0.0))
+        return;
+
+  // the static environment; each object is only checked against the moving bodies it is not allowed to touch
+  const collision_detection::WorldConstPtr world = environment.getStaticWorld();
+  const collision_detection::AllowedCollisionMatrix &world_acm = environment.getAllowedCollisionMatrix();
+  for (collision_detection::World::const_iterator it = world->begin() ; it != world->end() ; ++it)
+  {
+    std::vector<unsigned int> bodies;
+    for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+      if (!isAlwaysAllowed(world_acm, it->first, moving_bodies_[i].name))
+        bodies.push_back(i);
+    if (bodies.empty())
+      continue;
+
+    Obstacle obstacle;
+    obstacle.first = obstacle_spheres_.size();
+    for (std::size_t j = 0 ; j < it->second->shapes_.size() ; ++j)
+      if (!computeSpheres(*it->second->shapes_[j], it->second->shape_poses_[j], obstacle_spheres_))
+      {
+        logDebug("Object '%s' cannot be approximated by spheres. Not using collision spheres.", it->first.c_str());
+        return;
+      }
+    obstacle.end = obstacle_spheres_.size();
+    if (obstacle.end == obstacle.first)
+      continue;
+    obstacle.bound = computeBound(obstacle_spheres_, obstacle.first, obstacle.end);
+    for (std::size_t i = 0 ; i < bodies.size() ; ++i)
+      moving_bodies_[bodies[i]].obstacles.push_back(obstacles_.size());
+    obstacles_.push_back(obstacle);
+  }
+
+  // the pairs of moving bodies that are checked for self collision
+  const collision_detection::AllowedCollisionMatrix &acm = scene->getAllowedCollisionMatrix();
+  for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+    for (std::size_t j = i + 1 ; j < moving_bodies_.size() ; ++j)
+    {
+      const MovingBody &a = moving_bodies_[i];
+      const MovingBody &b = moving_bodies_[j];
+      if (a.touch_links.find(b.name) != a.touch_links.end() || b.touch_links.find(a.name) != b.touch_links.end() ||
+          isAlwaysAllowed(acm, a.name, b.name))
+        continue;
+      self_pairs_.push_back(std::make_pair(i, j));
+    }
+
+  valid_ = true;
+  logDebug("Approximated %u moving bodies and %u obstacles (%u spheres) by spheres; %u self collision pairs",
+           (unsigned int)moving_bodies_.size(), (unsigned int)obstacles_.size(), (unsigned int)obstacle_spheres_.size(),
+           (unsigned int)self_pairs_.size());
+}
+
+bool ompl_interface::CollisionSpheres::addMovingBody(const std::string &name, const robot_model::LinkModel *link,
+                                                     const std::vector<shapes::ShapeConstPtr> &shapes,
+                                                     const EigenSTL::vector_Affine3d &poses, const std::set<std::string> &touch_links,
+                                                     double scale, double padding)
+{
+  if (shapes.empty())
+    return true;
+
+  MovingBody body;
+  body.name = name;
+  body.link = link;
+  body.touch_links = touch_links;
+  for (std::size_t i = 0 ; i < shapes.size() ; ++i)
+  {
+    boost::scoped_ptr<shapes::Shape> shape(shapes[i]->clone());
+    shape->scaleAndPadd(scale, padding);
+    if (!computeSpheres(*shape, poses[i], body.spheres))
+    {
+      logDebug("Body '%s' cannot be approximated by spheres. Not using collision spheres.", name.c_str());
+      return false;
+    }
+  }
+  if (body.spheres.empty())
+    return true;
+  body.bound = computeBound(body.spheres, 0, body.spheres.size());
+  moving_bodies_.push_back(body);
+  return true;
+}
+
+ompl_interface::CollisionSpheres::Sphere ompl_interface::CollisionSpheres::computeBound(const std::vector<Sphere> &spheres,
+                                                                                        std::size_t first, std::size_t end)
+{
+  Eigen::Vector3d lo = spheres[first].center - Eigen::Vector3d::Constant(spheres[first].radius);
+  Eigen::Vector3d hi = spheres[first].center + Eigen::Vector3d::Constant(spheres[first].radius);
+  for (std::size_t i = first + 1 ; i < end ; ++i)
+  {
+    lo = lo.cwiseMin(spheres[i].center - Eigen::Vector3d::Constant(spheres[i].radius));
+    hi = hi.cwiseMax(spheres[i].center + Eigen::Vector3d::Constant(spheres[i].radius));
+  }
+  Sphere bound;
+  bound.center = (lo + hi) / 2.0;
+  bound.radius = 0.0;
+  for (std::size_t i = first ; i < end ; ++i)
+    bound.radius = std::max(bound.radius, (spheres[i].center - bound.center).norm() + spheres[i].radius);
+  return bound;
+}
+
+bool ompl_interface::CollisionSpheres::computeSpheres(const shapes::Shape &shape, const Eigen::Affine3d &pose, std::vector<Sphere> &spheres)
+{
+  // compute the center and half extents of a box around the shape, in the frame of the shape
+  Eigen::Vector3d center = Eigen::Vector3d::Zero();
+  Eigen::Vector3d half;
+  switch (shape.type)
+  {
+  case shapes::SPHERE:
+    {
+      Sphere s;
+      s.center = pose.translation();
+      s.radius = static_cast<const shapes::Sphere&>(shape).radius;
+      spheres.push_back(s);
+      return true;
+    }
+  case shapes::BOX:
+    {
+      const double *size = static_cast<const shapes::Box&>(shape).size;
+      half = Eigen::Vector3d(size[0], size[1], size[2]) / 2.0;
+    }
+    break;
+  case shapes::CYLINDER:
+    {
+      const shapes::Cylinder &cylinder = static_cast<const shapes::Cylinder&>(shape);
+      half = Eigen::Vector3d(cylinder.radius, cylinder.radius, cylinder.length / 2.0);
+    }
+    break;
+  case shapes::CONE:
+    {
+      const shapes::Cone &cone = static_cast<const shapes::Cone&>(shape);
+      half = Eigen::Vector3d(cone.radius, cone.radius, cone.length / 2.0);
+    }
+    break;
+  case shapes::MESH:
+    {
+      const shapes::Mesh &mesh = static_cast<const shapes::Mesh&>(shape);
+      if (mesh.vertex_count == 0)
+        return true;
+      Eigen::Vector3d lo = Eigen::Map<const Eigen::Vector3d>(mesh.vertices);
+      Eigen::Vector3d hi = lo;
+      for (unsigned int i = 1 ; i < mesh.vertex_count ; ++i)
+      {
+        Eigen::Map<const Eigen::Vector3d> v(mesh.vertices + 3 * i);
+        lo = lo.cwiseMin(v);
+        hi = hi.cwiseMax(v);
+      }
+      center = (lo + hi) / 2.0;
+      half = (hi - lo) / 2.0;
+    }
+    break;
+  default:
+    return false;
+  }
+
+  // split the box along its longest axis, so that long links are not covered by a single large sphere
+  int axis;
+  double longest = half.maxCoeff(&axis);
+  double second = std::max(half[(axis + 1) % 3], half[(axis + 2) % 3]);
+  unsigned int count = 1;
+  if (second > std::numeric_limits<double>::epsilon())
+    count = std::min(MAX_SPHERES_PER_SHAPE, (unsigned int)ceil(longest / second));
+  else if (longest > 0.0)
+    count = MAX_SPHERES_PER_SHAPE;
+
+  Eigen::Vector3d sub = half;
+  sub[axis] = longest / count;
+  Eigen::Vector3d step = Eigen::Vector3d::Zero();
+  step[axis] = 2.0 * sub[axis];
+  Eigen::Vector3d start = center;
+  start[axis] -= longest - sub[axis];
+
+  Sphere s;
+  s.radius = sub.norm();
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    s.center = pose * (start + step * i);
+    spheres.push_back(s);
+  }
+  return true;
+}
+
+bool ompl_interface::CollisionSpheres::isClear(const robot_state::RobotState &state) const
+{
+  // moving bodies against the static environment
+  for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+  {
+    const MovingBody &body = moving_bodies_[i];
+    if (body.obstacles.empty())
+      continue;
+    const Eigen::Affine3d &t = state.getGlobalLinkTransform(body.link);
+    const Eigen::Vector3d body_center = t * body.bound.center;
+    for (std::size_t k = 0 ; k < body.obstacles.size() ; ++k)
+    {
+      const Obstacle &obstacle = obstacles_[body.obstacles[k]];
+      double bd = body.bound.radius + obstacle.bound.radius + margin_;
+      if ((body_center - obstacle.bound.center).squaredNorm() > bd * bd)
+        continue;
+      for (std::size_t j = 0 ; j < body.spheres.size() ; ++j)
+      {
+        const Eigen::Vector3d c = t * body.spheres[j].center;
+        double sd = body.spheres[j].radius + obstacle.bound.radius + margin_;
+        if ((c - obstacle.bound.center).squaredNorm() > sd * sd)
+          continue;
+        for (unsigned int m = obstacle.first ; m < obstacle.end ; ++m)
+        {
+          const Sphere &o = obstacle_spheres_[m];
+          double d = body.spheres[j].radius + o.radius + margin_;
+          if ((c - o.center).squaredNorm() <= d * d)
+            return false;
+        }
+      }
+    }
+  }
+
+  // moving bodies against each other
+  for (std::size_t i = 0 ; i < self_pairs_.size() ; ++i)
+  {
+    const MovingBody &a = moving_bodies_[self_pairs_[i].first];
+    const MovingBody &b = moving_bodies_[self_pairs_[i].second];
+    const Eigen::Affine3d &ta = state.getGlobalLinkTransform(a.link);
+    const Eigen::Affine3d &tb = state.getGlobalLinkTransform(b.link);
+    double bd = a.bound.radius + b.bound.radius + margin_;
+    if ((ta * a.bound.center - tb * b.bound.center).squaredNorm() > bd * bd)
+      continue;
+    for (std::size_t j = 0 ; j < a.spheres.size() ; ++j)
+    {
+      const Eigen::Vector3d c = ta * a.spheres[j].center;
+      for (std::size_t k = 0 ; k < b.spheres.size() ; ++k)
+      {
+        double d = a.spheres[j].radius + b.spheres[k].radius + margin_;
+        if ((c - tb * b.spheres[k].center).squaredNorm() <= d * d)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+double ompl_interface::CollisionSpheres::clearance(const robot_state::RobotState &state, const EnvironmentDistanceField &field) const
+{
+  double result = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+  {
+    const Eigen::Affine3d &t = state.getGlobalLinkTransform(moving_bodies_[i].link);
+    for (std::size_t j = 0 ; j < moving_bodies_[i].spheres.size() ; ++j)
+    {
+      double d = field.getDistance(t * moving_bodies_[i].spheres[j].center) - moving_bodies_[i].spheres[j].radius;
+      if (d <= 0.0)
+        return 0.0;
+      if (d < result)
+        result = d;
+    }
+  }
+  return result;
+}
+
+double ompl_interface::CollisionSpheres::penetration(const robot_state::RobotState &state, const EnvironmentDistanceField &field) const
+{
+  double volume = 0.0;
+  for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+  {
+    const Eigen::Affine3d &t = state.getGlobalLinkTransform(moving_bodies_[i].link);
+    for (std::size_t j = 0 ; j < moving_bodies_[i].spheres.size() ; ++j)
+    {
+      // the volume of the spherical cap that reaches into the environment
+      double r = moving_bodies_[i].spheres[j].radius;
+      double h = std::min(2.0 * r, r - field.getDistance(t * moving_bodies_[i].spheres[j].center));
+      if (h > 0.0)
+        volume += boost::math::constants::pi<double>() * h * h * (3.0 * r - h) / 3.0;
+    }
+  }
+  return volume;
+}
+
+void ompl_interface::CollisionSpheres::getMovingBodyNames(std::vector<std::string> &names) const
+{
+  names.resize(moving_bodies_.size());
+  for (std::size_t i = 0 ; i < moving_bodies_.size() ; ++i)
+    names[i] = moving_bodies_[i].name;
+}
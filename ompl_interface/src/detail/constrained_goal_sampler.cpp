@@ -37,27 +37,81 @@
 #include "moveit/ompl_interface/detail/constrained_goal_sampler.h"
 #include "moveit/ompl_interface/ompl_planning_context.h"
 #include "moveit/ompl_interface/detail/state_validity_checker.h"
+#include "moveit/ompl_interface/detail/worker_pool.h"
+#include "moveit/ompl_interface/detail/worker_ik_constraint_sampler.h"
 #include <moveit/profiler/profiler.h>
 
+namespace
+{
+// Goal states closer than this fraction of the extent of the space to a goal state already found are discarded
+const double DUPLICATE_GOAL_DISTANCE = 1e-3;
+// Sampling attempts of a parallel worker in one round
+const unsigned int WORKER_ATTEMPTS = 4;
+}
+
 ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(const OMPLPlanningContext *pc,
                                                                const kinematic_constraints::KinematicConstraintSetPtr &ks,
-                                                               const constraint_samplers::ConstraintSamplerPtr &cs)
+                                                               const constraint_samplers::ConstraintSamplerPtr &cs,
+                                                               unsigned int max_attempts, unsigned int max_goal_samples,
+                                                               unsigned int ik_attempts,
+                                                               const std::vector<constraint_samplers::ConstraintSamplerPtr> &worker_samplers,
+                                                               GoalStateCache *goal_state_cache)
   : ompl::base::GoalLazySamples(pc->getOMPLSpaceInformation(),
-                        boost::bind(&ConstrainedGoalSampler::sampleUsingConstraintSampler, this, _1, _2), false)
+                        boost::bind(&ConstrainedGoalSampler::sampleUsingConstraintSampler, this, _1, _2), false,
+                        DUPLICATE_GOAL_DISTANCE * pc->getOMPLSpaceInformation()->getMaximumExtent())
   , planning_context_(pc)
   , kinematic_constraint_set_(ks)
   , constraint_sampler_(cs)
   , work_state_(pc->getCompleteInitialRobotState())
+  , callback_scratch_(CallbackScratch(pc->getCompleteInitialRobotState()))
   , invalid_sampled_constraints_(0)
   , warned_invalid_samples_(false)
   , verbose_display_(0)
+  , max_attempts_(max_attempts)
+  , max_goal_samples_(max_goal_samples)
+  , ik_attempts_(ik_attempts)
+  , parallel_attempts_(0)
+  , goal_state_cache_(goal_state_cache)
 {
+  bool worker_samplers_ok = true;
   if (!constraint_sampler_)
     default_sampler_ = si_->allocStateSampler();
-  logDebug("Constructed a ConstrainedGoalSampler instance at address %p", this);
+  else
+  {
+    installValidityCallback(*constraint_sampler_, &target_);
+    // the workers call inverse kinematics concurrently, with solvers of their own
+    for (std::size_t i = 0 ; i < worker_samplers.size() ; ++i)
+      if (!dynamic_cast<WorkerIKConstraintSampler*>(worker_samplers[i].get()))
+      {
+        logWarn("Goal sampling workers need samplers with inverse kinematics solvers of their own.  Sampling goal states sequentially");
+        worker_samplers_ok = false;
+        break;
+      }
+    for (std::size_t i = 0 ; worker_samplers_ok && i < worker_samplers.size() ; ++i)
+    {
+      workers_.push_back(WorkerPtr(new Worker(worker_samplers[i], pc->getCompleteInitialRobotState(), si_->allocState())));
+      installValidityCallback(*workers_.back()->sampler, &workers_.back()->target);
+    }
+  }
+  logDebug("Constructed a ConstrainedGoalSampler instance at address %p (%u parallel workers)", this, (unsigned int)workers_.size());
+  if (goal_state_cache_)
+  {
+    goal_state_cache_key_ = GoalStateCache::computeKey(*pc->getOMPLStateSpace()->getRobotModel(), pc->getOMPLStateSpace()->getJointModelGroupName(),
+                                                       kinematic_constraint_set_->getAllConstraints());
+    addCachedGoalStates();
+  }
+  // keep sampling, for goal states that differ from the cached ones
   startSampling();
 }
 
+ompl_interface::ConstrainedGoalSampler::~ConstrainedGoalSampler()
+{
+  // the sampling thread uses the members of this class
+  stopSampling();
+  for (std::size_t i = 0 ; i < workers_.size() ; ++i)
+    si_->freeState(workers_[i]->target.goal);
+}
+
 bool ompl_interface::ConstrainedGoalSampler::checkStateValidity(ompl::base::State* new_goal,
                                                                        const robot_state::RobotState& state,
                                                                        bool verbose) const
@@ -66,25 +120,105 @@ bool ompl_interface::ConstrainedGoalSampler::checkStateValidity(ompl::base::Stat
   return static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(new_goal, verbose);
 }
 
-bool ompl_interface::ConstrainedGoalSampler::stateValidityCallback(ompl::base::State* new_goal,
-                                                                          robot_state::RobotState const* state,
-                                                                          const robot_model::JointModelGroup* jmg,
-                                                                          const double* jpos,
-                                                                          bool verbose) const
+bool ompl_interface::ConstrainedGoalSampler::stateValidityCallback(const ValidityTarget *target,
+                                                                   robot_state::RobotState const* state,
+                                                                   const robot_model::JointModelGroup* jmg,
+                                                                   const double* jpos) const
+{
+  // the seed state is not changed; the solution is written to the calling thread's state, which differs from
+  // the seed only in the variables of the planning group
+  CallbackScratch &scratch = *callback_scratch_.get();
+  const robot_model::JointModelGroup *group = planning_context_->getOMPLStateSpace()->getJointModelGroup();
+  if (jmg != group)
+  {
+    scratch.group_values.resize(group->getVariableCount());
+    state->copyJointGroupPositions(group, scratch.group_values);
+    scratch.state.setJointGroupPositions(group, scratch.group_values);
+  }
+  scratch.state.setJointGroupPositions(jmg, jpos);
+  // no forward kinematics here: the validity checker updates the transforms of the group in its own state
+  return checkStateValidity(target->goal, scratch.state, target->verbose);
+}
+
+void ompl_interface::ConstrainedGoalSampler::installValidityCallback(constraint_samplers::ConstraintSampler &sampler,
+                                                                     ValidityTarget *target) const
+{
+  sampler.setGroupStateValidityCallback(boost::bind(&ConstrainedGoalSampler::stateValidityCallback, this, target,
+                                                    _1,  // pointer to state
+                                                    _2,  // const* joint model group
+                                                    _3)); // double* of joint positions
+}
+
+ompl_interface::ConstrainedGoalSampler::SampleResult
+ompl_interface::ConstrainedGoalSampler::sampleGoal(constraint_samplers::ConstraintSampler &sampler, robot_state::RobotState &work_state,
+                                                   ValidityTarget &target, bool verbose) const
+{
+  // the validity callback of the sampler reads the target
+  target.verbose = verbose;
+
+  if (!sampler.project(work_state, ik_attempts_))
+    return SAMPLE_FAILED;
+
+  work_state.update();
+  if (!kinematic_constraint_set_->decide(work_state, verbose).satisfied)
+    return SAMPLE_VIOLATES_CONSTRAINTS;
+  return checkStateValidity(target.goal, work_state, verbose) ? SAMPLE_FOUND : SAMPLE_FAILED;
+}
+
+void ompl_interface::ConstrainedGoalSampler::addCachedGoalStates()
+{
+  std::vector<std::vector<double> > cached = goal_state_cache_->getStates(goal_state_cache_key_);
+  if (cached.empty() || !si_->getStateValidityChecker())
+    return;
+
+  const robot_model::JointModelGroup *group = planning_context_->getOMPLStateSpace()->getJointModelGroup();
+  ompl::base::State *goal = si_->allocState();
+  unsigned int added = 0;
+  for (std::size_t i = 0 ; i < cached.size() ; ++i)
+  {
+    if (cached[i].size() != group->getVariableCount())
+      continue;
+    // the scene may have changed since the state was found
+    work_state_.setJointGroupPositions(group, cached[i]);
+    work_state_.update();
+    if (kinematic_constraint_set_->decide(work_state_).satisfied && checkStateValidity(goal, work_state_) && si_->satisfiesBounds(goal))
+    {
+      addState(goal);
+      ++added;
+    }
+  }
+  si_->freeState(goal);
+  logDebug("Added %u of %u cached goal states", added, (unsigned int)cached.size());
+}
+
+void ompl_interface::ConstrainedGoalSampler::cacheGoalState(const ompl::base::State *state)
 {
-  // we copy the state to not change the seed state
-  robot_state::RobotState solution_state( *state );
-  solution_state.setJointGroupPositions(jmg, jpos);
-  solution_state.update();
-  return checkStateValidity(new_goal, solution_state, verbose);
+  if (!goal_state_cache_)
+    return;
+  const double *values = state->as<ModelBasedStateSpace::StateType>()->values;
+  unsigned int count = planning_context_->getOMPLStateSpace()->getJointModelGroup()->getVariableCount();
+  goal_state_cache_->addState(goal_state_cache_key_, std::vector<double>(values, values + count));
+}
+
+void ompl_interface::ConstrainedGoalSampler::countInvalidSamples(unsigned int invalid, unsigned int attempts_so_far)
+{
+  invalid_sampled_constraints_ += invalid;
+  if (!warned_invalid_samples_ && invalid > 0 && invalid_sampled_constraints_ >= (attempts_so_far * 8) / 10)
+  {
+    warned_invalid_samples_ = true;
+    logWarn("More than 80%% of the sampled goal states fail to satisfy the constraints imposed on the goal sampler. Is the constrained sampler working correctly?");
+  }
 }
 
 bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const ompl::base::GoalLazySamples *gls, ompl::base::State *new_goal)
 {
   //  moveit::Profiler::ScopedBlock sblock("ConstrainedGoalSampler::sampleUsingConstraintSampler");
 
+  if (!workers_.empty())
+    return sampleInParallel(gls, new_goal);
+
   //unsigned int max_attempts = planning_context_->getMaximumGoalSamplingAttempts();
-  unsigned int max_attempts = 1000;
+  unsigned int max_attempts = max_attempts_;
   unsigned int attempts_so_far = gls->samplingAttemptsCount();
 
   // terminate after too many attempts
@@ -93,8 +227,7 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
 
   // terminate after a maximum number of samples
   //if (gls->getStateCount() >= planning_context_->getMaximumGoalSamples())
-  unsigned int max_goal_samples = 50;
-  if (gls->getStateCount() >= max_goal_samples)
+  if (gls->getStateCount() >= max_goal_samples_)
     return false;
 
   // terminate the sampling thread when a solution has been found
@@ -114,36 +247,15 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
 
     if (constraint_sampler_)
     {
-      // makes the constraint sampler also perform a validity callback
-      robot_state::GroupStateValidityCallbackFn gsvcf = boost::bind(&ompl_interface::ConstrainedGoalSampler::stateValidityCallback,
-                                                                    this,
-                                                                    new_goal,
-                                                                    _1,  // pointer to state
-                                                                    _2,  // const* joint model group
-                                                                    _3,  // double* of joint positions
-                                                                    verbose);
-      constraint_sampler_->setGroupStateValidityCallback( gsvcf );
-
-      unsigned int max_state_sampling_attempts = 4;
-      //if (constraint_sampler_->project(work_state_, planning_context_->getMaximumStateSamplingAttempts()))
-      if (constraint_sampler_->project(work_state_, max_state_sampling_attempts))
+      target_.goal = new_goal;
+      SampleResult result = sampleGoal(*constraint_sampler_, work_state_, target_, verbose);
+      if (result == SAMPLE_FOUND)
       {
-        work_state_.update();
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
-        {
-          if (checkStateValidity(new_goal, work_state_, verbose))
-            return true;
-        }
-        else
-        {
-          invalid_sampled_constraints_++;
-          if (!warned_invalid_samples_ && invalid_sampled_constraints_ >= (attempts_so_far * 8) / 10)
-          {
-            warned_invalid_samples_ = true;
-            logWarn("More than 80%% of the sampled goal states fail to satisfy the constraints imposed on the goal sampler. Is the constrained sampler working correctly?");
-          }
-        }
+        cacheGoalState(new_goal);
+        return true;
       }
+      if (result == SAMPLE_VIOLATES_CONSTRAINTS)
+        countInvalidSamples(1, attempts_so_far);
     }
     else
     {
@@ -152,9 +264,73 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       {
         planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, new_goal);
         if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
+        {
+          cacheGoalState(new_goal);
           return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool ompl_interface::ConstrainedGoalSampler::sampleInParallel(const ompl::base::GoalLazySamples *gls, ompl::base::State *new_goal)
+{
+  std::vector<WorkerPool::Task> tasks(workers_.size());
+  for (std::size_t i = 0 ; i < workers_.size() ; ++i)
+    tasks[i] = boost::bind(&ConstrainedGoalSampler::runWorker, this, workers_[i].get(), gls);
+
+  while (parallel_attempts_ < max_attempts_ && gls->getStateCount() < max_goal_samples_ && gls->isSampling() &&
+         !planning_context_->getOMPLProblemDefinition()->hasSolution())
+  {
+    WorkerPool::getShared().run(tasks);
+
+    // the first goal state found is returned to the sampling thread, the others are added directly
+    bool found = false;
+    for (std::size_t i = 0 ; i < workers_.size() ; ++i)
+    {
+      Worker &worker = *workers_[i];
+      parallel_attempts_ += worker.attempts;
+      countInvalidSamples(worker.invalid, parallel_attempts_);
+      if (!worker.found)
+        continue;
+      cacheGoalState(worker.target.goal);
+      if (found)
+        const_cast<ompl::base::GoalLazySamples*>(gls)->addStateIfDifferent(worker.target.goal, minDist_);
+      else
+      {
+        si_->copyState(new_goal, worker.target.goal);
+        found = true;
       }
     }
+    if (found)
+      return true;
   }
   return false;
 }
+
+void ompl_interface::ConstrainedGoalSampler::runWorker(Worker *worker, const ompl::base::GoalLazySamples *gls)
+{
+  const robot_model::JointModelGroup *group = planning_context_->getOMPLStateSpace()->getJointModelGroup();
+  worker->attempts = 0;
+  worker->invalid = 0;
+  worker->found = false;
+  worker->seed.resize(group->getVariableCount());
+
+  while (worker->attempts < WORKER_ATTEMPTS && gls->isSampling())
+  {
+    // start every attempt from a random seed of the worker's own, so the workers do not converge to the same solutions
+    group->getVariableRandomPositions(worker->rng, &worker->seed[0]);
+    worker->work_state.setJointGroupPositions(group, worker->seed);
+    ++worker->attempts;
+
+    SampleResult result = sampleGoal(*worker->sampler, worker->work_state, worker->target, false);
+    if (result == SAMPLE_FOUND)
+    {
+      worker->found = true;
+      break;
+    }
+    if (result == SAMPLE_VIOLATES_CONSTRAINTS)
+      ++worker->invalid;
+  }
+}
@@ -35,9 +35,31 @@
 /* Author: Ioan Sucan */
 
 #include "moveit/ompl_interface/detail/constrained_sampler.h"
+#include "moveit/ompl_interface/detail/batch_state_sampler.h"
 #include <moveit/profiler/profiler.h>
+#include <ompl/util/Time.h>
+#include <algorithm>
+#include <cmath>
 
-ompl_interface::ConstrainedSampler::ConstrainedSampler(const OMPLPlanningContext *pc, const constraint_samplers::ConstraintSamplerPtr &cs)
+namespace
+{
+// Samples between adaptations of the budgets
+const unsigned int ADAPTATION_WINDOW = 64;
+const unsigned int MAX_ATTEMPTS = 32;
+const unsigned int MAX_CALLS = 8;
+// The probability of a constrained sample the number of calls aims for
+const double TARGET_SUCCESS = 0.9;
+// The fraction of samples spent on the slower of constrained and uniform sampling, to keep measuring it
+const double EXPLORATION = 0.1;
+// The factor the uniform share shrinks by after every window in which no uniform sample satisfied the
+// constraints, and the share it stops shrinking at
+const double EXPLORATION_DECAY = 0.5;
+const double MIN_EXPLORATION = 1e-3;
+}
+
+ompl_interface::ConstrainedSampler::ConstrainedSampler(const OMPLPlanningContext *pc, const constraint_samplers::ConstraintSamplerPtr &cs,
+                                                       const kinematic_constraints::KinematicConstraintSetPtr &constraints,
+                                                       const ConstrainedSamplerStatisticsPtr &statistics)
   : ompl::base::StateSampler(pc->getOMPLStateSpace().get())
   , planning_context_(pc)
   , default_(space_->allocDefaultStateSampler())
@@ -45,10 +67,22 @@ ompl_interface::ConstrainedSampler::ConstrainedSampler(const OMPLPlanningContext
   , work_state_(pc->getCompleteInitialRobotState())
   , constrained_success_(0)
   , constrained_failure_(0)
+  , constraints_(constraints)
+  , statistics_(statistics)
+  , attempts_(4)
+  , calls_(3)
+  , constrained_fraction_(constraints ? 1.0 - EXPLORATION : 1.0)
+  , exploration_(EXPLORATION)
+  , previous_yield_(0.0)
+  , attempts_direction_(1)
 {
   inv_dim_ = space_->getDimension() > 0 ? 1.0 / (double)space_->getDimension() : 1.0;
 }
 
+ompl_interface::ConstrainedSampler::~ConstrainedSampler()
+{
+}
+
 double ompl_interface::ConstrainedSampler::getConstrainedSamplingRate() const
 {
   if (constrained_success_ == 0)
@@ -61,31 +95,111 @@ bool ompl_interface::ConstrainedSampler::sampleC(ompl::base::State *state)
 {
   //  moveit::Profiler::ScopedBlock sblock("sampleWithConstraints");
 
-  //unsigned int max_attempts = planning_context_->getMaximumStateSamplingAttempts();
-  unsigned int max_attempts = 4;
-
-  if (constraint_sampler_->sample(work_state_, planning_context_->getCompleteInitialRobotState(), max_attempts))
+  ompl::time::point start = ompl::time::now();
+  bool success = false;
+  if (constraint_sampler_->sample(work_state_, planning_context_->getCompleteInitialRobotState(), attempts_))
   {
     planning_context_->getOMPLStateSpace()->copyToOMPLState(state, work_state_);
-    if (space_->satisfiesBounds(state))
-    {
-      ++constrained_success_;
+    success = space_->satisfiesBounds(state);
+  }
+  double time = ompl::time::seconds(ompl::time::now() - start);
+  window_.addConstrainedCall(success, time);
+  if (statistics_)
+    statistics_->getThreadCounts().addConstrainedCall(success, time);
+
+  if (success)
+    ++constrained_success_;
+  else
+    ++constrained_failure_;
+
+  if (window_.constrained_calls + window_.uniform_samples >= ADAPTATION_WINDOW)
+    adapt();
+  return success;
+}
+
+bool ompl_interface::ConstrainedSampler::sampleConstrained(ompl::base::State *state)
+{
+  for (unsigned int i = 0 ; i < calls_ ; ++i)
+    if (sampleC(state))
       return true;
+  return false;
+}
+
+void ompl_interface::ConstrainedSampler::sampleUniformFallback(ompl::base::State *state)
+{
+  ompl::time::point start = ompl::time::now();
+  default_->sampleUniform(state);
+  bool satisfied = false;
+  if (constraints_)
+  {
+    planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, state);
+    satisfied = constraints_->decide(work_state_).satisfied;
+  }
+  double time = ompl::time::seconds(ompl::time::now() - start);
+  window_.addUniformSample(satisfied, time);
+  if (statistics_)
+    statistics_->getThreadCounts().addUniformSample(satisfied, time);
+
+  if (window_.constrained_calls + window_.uniform_samples >= ADAPTATION_WINDOW)
+    adapt();
+}
+
+void ompl_interface::ConstrainedSampler::adapt()
+{
+  if (window_.constrained_calls > 0 && window_.constrained_time > 0.0)
+  {
+    // hill climb on the number of constrained states per second
+    double yield = (double)window_.constrained_successes / window_.constrained_time;
+    if (yield < previous_yield_)
+      attempts_direction_ = -attempts_direction_;
+    previous_yield_ = yield;
+    if (attempts_direction_ > 0)
+      attempts_ = std::min(MAX_ATTEMPTS, attempts_ + 1);
+    else
+      attempts_ = std::max(1u, attempts_ - 1);
+
+    // call the constraint sampler often enough to get a constrained state with probability TARGET_SUCCESS,
+    // but do not insist if it hardly ever succeeds
+    double p = (double)window_.constrained_successes / (double)window_.constrained_calls;
+    if (p <= 0.0 || p >= TARGET_SUCCESS)
+      calls_ = 1;
+    else
+      calls_ = std::min(MAX_CALLS, (unsigned int)ceil(log(1.0 - TARGET_SUCCESS) / log(1.0 - p)));
+
+    // favor uniform samples if they satisfy the constraints more often per second; while they never
+    // do, spend ever fewer samples on them
+    if (constraints_ && window_.uniform_samples > 0 && window_.uniform_time > 0.0)
+    {
+      if (window_.uniform_satisfied == 0)
+        exploration_ = std::max(MIN_EXPLORATION, exploration_ * EXPLORATION_DECAY);
+      else
+        exploration_ = EXPLORATION;
+      constrained_fraction_ = yield >= (double)window_.uniform_satisfied / window_.uniform_time ? 1.0 - exploration_ : exploration_;
     }
   }
-  ++constrained_failure_;
-  return false;
+
+  window_ = ConstrainedSamplerStatistics::Counts();
 }
 
 void ompl_interface::ConstrainedSampler::sampleUniform(ompl::base::State *state)
 {
-  if (!sampleC(state) && !sampleC(state) && !sampleC(state))
-    default_->sampleUniform(state);
+  if ((constrained_fraction_ >= 1.0 || rng_.uniform01() < constrained_fraction_) && sampleConstrained(state))
+    return;
+  sampleUniformFallback(state);
+}
+
+void ompl_interface::ConstrainedSampler::sampleBatch(SampleBatch &batch, ompl::base::State *state)
+{
+  for (std::size_t i = 0 ; i < batch.size() ; ++i)
+  {
+    ConstrainedSampler::sampleUniform(state);
+    batch.setSample(i, state->as<ModelBasedStateSpace::StateType>()->values);
+  }
 }
 
 void ompl_interface::ConstrainedSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, const double distance)
 {
-  if (sampleC(state) || sampleC(state) || sampleC(state))
+  if (sampleConstrained(state))
   {
     double total_d = space_->distance(state, near);
     if (total_d > distance)
@@ -100,7 +214,7 @@ void ompl_interface::ConstrainedSampler::sampleUniformNear(ompl::base::State *st
 
 void ompl_interface::ConstrainedSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, const double stdDev)
 {
-  if (sampleC(state) || sampleC(state) || sampleC(state))
+  if (sampleConstrained(state))
   {
     double total_d = space_->distance(state, mean);
     double distance = rng_.gaussian(0.0, stdDev);
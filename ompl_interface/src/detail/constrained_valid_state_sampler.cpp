@@ -75,6 +75,14 @@ bool ompl_interface::ValidConstrainedSampler::project(ompl::base::State *state)
 bool ompl_interface::ValidConstrainedSampler::sample(ompl::base::State *state)
 {
   //  moveit::Profiler::ScopedBlock pblock("ValidConstrainedSampler::sample");
+  for (unsigned int i = 0 ; i < attempts_ ; ++i)
+    if (sampleConstrained(state) && si_->isValid(state))
+      return true;
+  return false;
+}
+
+bool ompl_interface::ValidConstrainedSampler::sampleConstrained(ompl::base::State *state)
+{
   if (constraint_sampler_)
   {
     unsigned int max_state_sampling_attempts = 4;
@@ -109,7 +117,7 @@ bool ompl_interface::ValidConstrainedSampler::sampleNear(ompl::base::State *stat
     double dist = pow(rng_.uniform01(), inv_dim_) * distance;
     si_->getStateSpace()->interpolate(near, state, dist / total_d, state);
     planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, state);
-    if (!kinematic_constraint_set_->decide(work_state_).satisfied)
+    if (!kinematic_constraint_set_->decide(work_state_).satisfied || !si_->isValid(state))
       return false;
   }
   return true;
@@ -0,0 +1,357 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/environment_distance_field.h"
+#include "moveit/ompl_interface/detail/worker_pool.h"
+#include <geometric_shapes/bodies.h>
+#include <ompl/util/Console.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+// free space kept around the shapes, so that distances close to them are computed exactly
+const double BOUNDS_PADDING = 0.3;
+
+// the squared distance of voxels that have no source (yet)
+const double NO_SOURCE = 1e20;
+
+typedef boost::shared_ptr<bodies::Body> BodyPtr;
+
+// call fn(begin, end) on consecutive ranges of [0, count), one per worker of the shared pool and one for the caller
+void parallelFor(std::size_t count, const boost::function<void(std::size_t, std::size_t)> &fn)
+{
+  ompl_interface::WorkerPool &pool = ompl_interface::WorkerPool::getShared();
+  std::size_t chunks = std::min<std::size_t>(pool.getThreadCount() + 1, count);
+  if (chunks <= 1)
+  {
+    fn(0, count);
+    return;
+  }
+  std::size_t chunk = (count + chunks - 1) / chunks;
+  std::vector<ompl_interface::WorkerPool::Task> tasks;
+  for (std::size_t begin = 0 ; begin < count ; begin += chunk)
+    tasks.push_back(boost::bind(fn, begin, std::min(count, begin + chunk)));
+  pool.run(tasks);
+}
+
+// mark the voxels whose centers are inside one of the bodies, for slices [z_begin, z_end)
+void rasterize(float *outside, float *inside, const std::size_t *size, const Eigen::Vector3d &origin, double resolution,
+               const std::vector<BodyPtr> &bodies, const std::vector<bodies::BoundingSphere> &spheres,
+               std::size_t z_begin, std::size_t z_end)
+{
+  const std::size_t slice = size[0] * size[1];
+  std::fill(outside + z_begin * slice, outside + z_end * slice, (float)NO_SOURCE);
+  std::fill(inside + z_begin * slice, inside + z_end * slice, 0.0f);
+
+  for (std::size_t b = 0 ; b < bodies.size() ; ++b)
+  {
+    // the range of voxels covered by the bounding sphere of the body
+    std::size_t lo[3], hi[3];
+    for (int a = 0 ; a < 3 ; ++a)
+    {
+      double l = (spheres[b].center[a] - spheres[b].radius - origin[a]) / resolution;
+      double h = (spheres[b].center[a] + spheres[b].radius - origin[a]) / resolution;
+      lo[a] = (std::size_t)std::max(0.0, ceil(l));
+      hi[a] = (std::size_t)std::max(0.0, std::min((double)size[a] - 1.0, floor(h))) + 1;
+    }
+    lo[2] = std::max(lo[2], z_begin);
+    hi[2] = std::min(hi[2], z_end);
+
+    for (std::size_t z = lo[2] ; z < hi[2] ; ++z)
+      for (std::size_t y = lo[1] ; y < hi[1] ; ++y)
+        for (std::size_t x = lo[0] ; x < hi[0] ; ++x)
+        {
+          std::size_t index = z * slice + y * size[0] + x;
+          if (outside[index] != 0.0f && bodies[b]->containsPoint(origin + Eigen::Vector3d(x, y, z) * resolution))
+          {
+            outside[index] = 0.0f;
+            inside[index] = (float)NO_SOURCE;
+          }
+        }
+  }
+}
+
+// the abscissa where the parabolas rooted at samples q and p intersect
+inline double intersect(const std::vector<double> &f, std::size_t q, std::size_t p)
+{
+  return ((f[q] + (double)q * q) - (f[p] + (double)p * p)) / (2.0 * q - 2.0 * p);
+}
+
+// squared euclidean distance transform of one line, in place (Felzenszwalb & Huttenlocher)
+void transformLine(float *line, std::size_t stride, std::size_t n, std::vector<double> &f, std::vector<std::size_t> &v, std::vector<double> &z)
+{
+  for (std::size_t q = 0 ; q < n ; ++q)
+    f[q] = line[q * stride];
+
+  // lower envelope of the parabolas rooted at each sample
+  std::size_t k = 0;
+  v[0] = 0;
+  z[0] = -std::numeric_limits<double>::infinity();
+  z[1] = std::numeric_limits<double>::infinity();
+  for (std::size_t q = 1 ; q < n ; ++q)
+  {
+    double s = intersect(f, q, v[k]);
+    while (s <= z[k])
+      s = intersect(f, q, v[--k]);
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = std::numeric_limits<double>::infinity();
+  }
+
+  k = 0;
+  for (std::size_t q = 0 ; q < n ; ++q)
+  {
+    while (z[k + 1] < q)
+      ++k;
+    double d = (double)q - (double)v[k];
+    line[q * stride] = d * d + f[v[k]];
+  }
+}
+
+// transform all lines along one axis; the lines are distributed over [begin, end) of the outer axis
+void transformAxis(float *grid, const std::size_t *size, int axis, std::size_t begin, std::size_t end)
+{
+  const std::size_t stride[3] = { 1, size[0], size[0] * size[1] };
+  const int outer = axis == 2 ? 1 : 2;
+  const int inner = axis == 0 ? 1 : 0;
+
+  std::vector<double> f(size[axis]), z(size[axis] + 1);
+  std::vector<std::size_t> v(size[axis]);
+  for (std::size_t o = begin ; o < end ; ++o)
+    for (std::size_t i = 0 ; i < size[inner] ; ++i)
+      transformLine(grid + o * stride[outer] + i * stride[inner], stride[axis], size[axis], f, v, z);
+}
+
+// combine the distances to the nearest occupied and nearest free voxels into signed distances
+void combine(float *outside, const float *inside, double resolution, std::size_t begin, std::size_t end)
+{
+  for (std::size_t i = begin ; i < end ; ++i)
+    outside[i] = outside[i] > 0.0f ? (sqrt(outside[i]) - 0.5) * resolution : -(sqrt(inside[i]) - 0.5) * resolution;
+}
+
+bool isAlwaysAllowed(const collision_detection::AllowedCollisionMatrix &acm, const std::string &name1, const std::string &name2)
+{
+  collision_detection::AllowedCollision::Type type;
+  return acm.getAllowedCollision(name1, name2, type) && type == collision_detection::AllowedCollision::ALWAYS;
+}
+
+// the last field requested, and what it was requested for; while building, it is computed outside the lock
+struct CachedField
+{
+  CachedField() : resolution(0.0), max_voxels(0), building(false)
+  {
+  }
+
+  bool matches(const std::vector<shapes::ShapeConstPtr> &other_shapes, const EigenSTL::vector_Affine3d &other_poses,
+               double other_resolution, std::size_t other_max_voxels) const
+  {
+    // the shapes are kept alive by the cache, so comparing pointers is enough to identify them
+    bool same = (building || field) && other_shapes == shapes && other_resolution == resolution && other_max_voxels == max_voxels;
+    for (std::size_t i = 0 ; same && i < other_poses.size() ; ++i)
+      same = other_poses[i].matrix() == poses[i].matrix();
+    return same;
+  }
+
+  std::vector<shapes::ShapeConstPtr>               shapes;
+  EigenSTL::vector_Affine3d                        poses;
+  double                                           resolution;
+  std::size_t                                      max_voxels;
+  bool                                             building;
+  ompl_interface::EnvironmentDistanceFieldConstPtr field;
+};
+}
+
+ompl_interface::EnvironmentDistanceField::EnvironmentDistanceField(const std::vector<shapes::ShapeConstPtr> &shapes,
+                                                                   const EigenSTL::vector_Affine3d &poses,
+                                                                   double resolution, std::size_t max_voxels)
+  : origin_(Eigen::Vector3d::Zero())
+  , resolution_(resolution)
+{
+  size_[0] = size_[1] = size_[2] = 0;
+
+  std::vector<BodyPtr> bodies;
+  std::vector<bodies::BoundingSphere> spheres;
+  Eigen::Vector3d lo = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+  Eigen::Vector3d hi = -lo;
+  for (std::size_t i = 0 ; i < shapes.size() ; ++i)
+  {
+    BodyPtr body(bodies::createBodyFromShape(shapes[i].get()));
+    if (!body)
+    {
+      logWarn("Shapes of type %d are not included in the distance field", (int)shapes[i]->type);
+      continue;
+    }
+    body->setPose(poses[i]);
+    bodies::BoundingSphere sphere;
+    body->computeBoundingSphere(sphere);
+    lo = lo.cwiseMin(sphere.center - Eigen::Vector3d::Constant(sphere.radius));
+    hi = hi.cwiseMax(sphere.center + Eigen::Vector3d::Constant(sphere.radius));
+    bodies.push_back(body);
+    spheres.push_back(sphere);
+  }
+  if (bodies.empty())
+    return;
+
+  origin_ = lo - Eigen::Vector3d::Constant(BOUNDS_PADDING);
+  Eigen::Vector3d extent = hi - lo + Eigen::Vector3d::Constant(2.0 * BOUNDS_PADDING);
+
+  // coarsen the resolution until the field fits in the allowed number of voxels
+  while (true)
+  {
+    for (int a = 0 ; a < 3 ; ++a)
+      size_[a] = std::max<std::size_t>(2, (std::size_t)ceil(extent[a] / resolution_) + 1);
+    if (size_[0] * size_[1] * size_[2] <= max_voxels)
+      break;
+    resolution_ *= 1.25;
+  }
+  if (resolution_ > resolution)
+    logInform("Distance field resolution coarsened from %lf to %lf to stay within %u voxels",
+              resolution, resolution_, (unsigned int)max_voxels);
+
+  const std::size_t count = size_[0] * size_[1] * size_[2];
+  distances_.resize(count);
+  std::vector<float> inside(count);
+
+  parallelFor(size_[2], boost::bind(&rasterize, &distances_[0], &inside[0], size_, boost::cref(origin_), resolution_,
+                                    boost::cref(bodies), boost::cref(spheres), _1, _2));
+  for (int axis = 0 ; axis < 3 ; ++axis)
+  {
+    std::size_t outer = size_[axis == 2 ? 1 : 2];
+    parallelFor(outer, boost::bind(&transformAxis, &distances_[0], size_, axis, _1, _2));
+    parallelFor(outer, boost::bind(&transformAxis, &inside[0], size_, axis, _1, _2));
+  }
+  parallelFor(count, boost::bind(&combine, &distances_[0], &inside[0], resolution_, _1, _2));
+
+  logDebug("Computed distance field of %u shapes: %u x %u x %u voxels at resolution %lf",
+           (unsigned int)bodies.size(), (unsigned int)size_[0], (unsigned int)size_[1], (unsigned int)size_[2], resolution_);
+}
+
+ompl_interface::EnvironmentDistanceFieldConstPtr
+ompl_interface::EnvironmentDistanceField::get(const StaticCollisionEnvironment &environment, const std::vector<std::string> &moving_bodies,
+                                              double resolution, std::size_t max_voxels)
+{
+  // the objects none of the moving bodies may touch
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Affine3d poses;
+  const collision_detection::WorldConstPtr world = environment.getStaticWorld();
+  for (collision_detection::World::const_iterator it = world->begin() ; it != world->end() ; ++it)
+  {
+    bool allowed = false;
+    for (std::size_t i = 0 ; i < moving_bodies.size() && !allowed ; ++i)
+      allowed = isAlwaysAllowed(environment.getAllowedCollisionMatrix(), it->first, moving_bodies[i]);
+    if (allowed)
+      continue;
+    shapes.insert(shapes.end(), it->second->shapes_.begin(), it->second->shapes_.end());
+    poses.insert(poses.end(), it->second->shape_poses_.begin(), it->second->shape_poses_.end());
+  }
+
+  static boost::mutex lock;
+  static boost::condition_variable built;
+  static CachedField cache;
+
+  // wait for the field if another thread is computing it already
+  boost::mutex::scoped_lock slock(lock);
+  while (cache.matches(shapes, poses, resolution, max_voxels))
+  {
+    if (!cache.building)
+      return cache.field;
+    built.wait(slock);
+  }
+
+  // compute the field without holding the lock, so requests for other fields do not wait for it
+  cache.shapes = shapes;
+  cache.poses = poses;
+  cache.resolution = resolution;
+  cache.max_voxels = max_voxels;
+  cache.building = true;
+  cache.field.reset();
+  slock.unlock();
+
+  EnvironmentDistanceFieldConstPtr field;
+  try
+  {
+    field.reset(new EnvironmentDistanceField(shapes, poses, resolution, max_voxels));
+  }
+  catch (...)
+  {
+    // the threads waiting for this field compute it themselves
+    slock.lock();
+    if (cache.building && cache.matches(shapes, poses, resolution, max_voxels))
+      cache.building = false;
+    built.notify_all();
+    throw;
+  }
+
+  slock.lock();
+  // a request for other shapes may have replaced the entry in the meantime
+  if (cache.building && cache.matches(shapes, poses, resolution, max_voxels))
+  {
+    cache.field = field;
+    cache.building = false;
+  }
+  built.notify_all();
+  return field;
+}
+
+double ompl_interface::EnvironmentDistanceField::getDistance(const Eigen::Vector3d &point) const
+{
+  if (distances_.empty())
+    return std::numeric_limits<double>::infinity();
+
+  // continuous voxel coordinates, clamped to the field
+  Eigen::Vector3d g = (point - origin_) / resolution_;
+  Eigen::Vector3d c;
+  std::size_t i[3];
+  double t[3];
+  for (int a = 0 ; a < 3 ; ++a)
+  {
+    c[a] = std::max(0.0, std::min((double)size_[a] - 1.0, g[a]));
+    i[a] = std::min((std::size_t)c[a], size_[a] - 2);
+    t[a] = c[a] - i[a];
+  }
+
+  // trilinear interpolation
+  double d00 = voxel(i[0], i[1], i[2]) * (1.0 - t[0]) + voxel(i[0] + 1, i[1], i[2]) * t[0];
+  double d10 = voxel(i[0], i[1] + 1, i[2]) * (1.0 - t[0]) + voxel(i[0] + 1, i[1] + 1, i[2]) * t[0];
+  double d01 = voxel(i[0], i[1], i[2] + 1) * (1.0 - t[0]) + voxel(i[0] + 1, i[1], i[2] + 1) * t[0];
+  double d11 = voxel(i[0], i[1] + 1, i[2] + 1) * (1.0 - t[0]) + voxel(i[0] + 1, i[1] + 1, i[2] + 1) * t[0];
+  double d = (d00 * (1.0 - t[1]) + d10 * t[1]) * (1.0 - t[2]) + (d01 * (1.0 - t[1]) + d11 * t[1]) * t[2];
+
+  return d + (g - c).norm() * resolution_;
+}
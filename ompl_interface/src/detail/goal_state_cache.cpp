@@ -0,0 +1,148 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/goal_state_cache.h"
+#include <ros/serialization.h>
+#include <algorithm>
+#include <cmath>
+
+ompl_interface::GoalStateCache::GoalStateCache(std::size_t max_goals, std::size_t max_states_per_goal, double duplicate_distance)
+  : max_goals_(max_goals)
+  , max_states_per_goal_(max_states_per_goal)
+  , duplicate_distance_(duplicate_distance)
+{
+}
+
+std::string ompl_interface::GoalStateCache::computeKey(const robot_model::RobotModel &model, const std::string &group,
+                                                       const moveit_msgs::Constraints &constraints)
+{
+  // requests built from the same goal differ in their time stamps only
+  moveit_msgs::Constraints msg = constraints;
+  for (std::size_t i = 0 ; i < msg.position_constraints.size() ; ++i)
+    msg.position_constraints[i].header.stamp = ros::Time();
+  for (std::size_t i = 0 ; i < msg.orientation_constraints.size() ; ++i)
+    msg.orientation_constraints[i].header.stamp = ros::Time();
+  for (std::size_t i = 0 ; i < msg.visibility_constraints.size() ; ++i)
+  {
+    msg.visibility_constraints[i].target_pose.header.stamp = ros::Time();
+    msg.visibility_constraints[i].sensor_pose.header.stamp = ros::Time();
+  }
+
+  uint32_t length = ros::serialization::serializationLength(msg);
+  std::vector<uint8_t> buffer(length);
+  if (length > 0)
+  {
+    ros::serialization::OStream stream(&buffer[0], length);
+    ros::serialization::serialize(stream, msg);
+  }
+
+  std::string key = model.getName();
+  key.push_back('\0');
+  key += group;
+  key.push_back('\0');
+  key.append(buffer.begin(), buffer.end());
+  return key;
+}
+
+void ompl_interface::GoalStateCache::touch(Entry &entry)
+{
+  recent_.splice(recent_.begin(), recent_, entry.recent);
+}
+
+std::vector<std::vector<double> > ompl_interface::GoalStateCache::getStates(const std::string &key)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  boost::unordered_map<std::string, Entry>::iterator it = entries_.find(key);
+  if (it == entries_.end())
+    return std::vector<std::vector<double> >();
+  touch(it->second);
+  return it->second.states;
+}
+
+void ompl_interface::GoalStateCache::addState(const std::string &key, const std::vector<double> &values)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  boost::unordered_map<std::string, Entry>::iterator it = entries_.find(key);
+  if (it == entries_.end())
+  {
+    // forget the least recently used goal
+    if (entries_.size() >= max_goals_ && !recent_.empty())
+    {
+      entries_.erase(recent_.back());
+      recent_.pop_back();
+    }
+    recent_.push_front(key);
+    it = entries_.insert(std::make_pair(key, Entry())).first;
+    it->second.recent = recent_.begin();
+  }
+  else
+    touch(it->second);
+
+  std::vector<std::vector<double> > &states = it->second.states;
+  for (std::size_t i = 0 ; i < states.size() ; ++i)
+  {
+    if (states[i].size() != values.size())
+      continue;
+    bool duplicate = true;
+    for (std::size_t j = 0 ; j < values.size() && duplicate ; ++j)
+      duplicate = fabs(states[i][j] - values[j]) <= duplicate_distance_;
+    if (duplicate)
+      return;
+  }
+
+  // the most recently found configurations come first; the oldest are forgotten
+  states.insert(states.begin(), values);
+  if (states.size() > max_states_per_goal_)
+    states.resize(max_states_per_goal_);
+}
+
+std::size_t ompl_interface::GoalStateCache::getGoalCount() const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  return entries_.size();
+}
+
+void ompl_interface::GoalStateCache::clear()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  entries_.clear();
+  recent_.clear();
+}
+
+ompl_interface::GoalStateCache& ompl_interface::GoalStateCache::getShared()
+{
+  static GoalStateCache cache;
+  return cache;
+}
@@ -36,9 +36,18 @@
 
 #include "moveit/ompl_interface/detail/goal_union.h"
 #include <ompl/base/goals/GoalLazySamples.h>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <limits>
 
 namespace
 {
+// Samples between updates of the weights of the member goals (they are also updated when goal states are found)
+const unsigned int REWEIGHT_INTERVAL = 64;
+// The smallest weight of a member goal that can be sampled, relative to the largest weight
+const double MIN_WEIGHT_FRACTION = 0.05;
+
 ompl::base::SpaceInformationPtr getGoalsSI(const std::vector<ompl::base::GoalPtr> &goals)
 {
   if (goals.empty())
@@ -54,8 +63,127 @@ ompl::base::SpaceInformationPtr getGoalsSI(const std::vector<ompl::base::GoalPtr
 }
 
 ompl_interface::GoalSampleableRegionMux::GoalSampleableRegionMux(const std::vector<ompl::base::GoalPtr> &goals) :
-  ompl::base::GoalSampleableRegion(getGoalsSI(goals)), goals_(goals), gindex_(0)
+  ompl::base::GoalSampleableRegion(getGoalsSI(goals)), goals_(goals), indexed_(goals.size(), false), max_threshold_(0.0), start_(NULL),
+  start_distance_(goals.size(), std::numeric_limits<double>::infinity()), indexed_counts_(goals.size(), 0), weights_outdated_(true),
+  samples_since_update_(0)
+{
+  index_.reset(new ompl::NearestNeighborsGNAT<IndexedState*>());
+  index_->setDistanceFunction(boost::bind(&GoalSampleableRegionMux::distanceIndexedStates, this, _1, _2));
+
+  for (std::size_t i = 0 ; i < goals_.size() ; ++i)
+  {
+    if (!goals_[i]->hasType(ompl::base::GOAL_STATES))
+    {
+      other_goals_.push_back(i);
+      continue;
+    }
+    indexed_[i] = true;
+    max_threshold_ = std::max(max_threshold_, goals_[i]->as<ompl::base::GoalRegion>()->getThreshold());
+
+    // the states of plain sets of goal states are indexed when the goal is next checked
+    if (!goals_[i]->hasType(ompl::base::GOAL_LAZY_SAMPLES))
+    {
+      plain_goals_.push_back(i);
+      continue;
+    }
+
+    // states sampled from now on are indexed as they are found; the ones found so far are indexed here
+    const ompl::base::GoalStates *goal_states = goals_[i]->as<ompl::base::GoalStates>();
+    static_cast<ompl::base::GoalLazySamples*>(goals_[i].get())->setNewStateCallback(boost::bind(&GoalSampleableRegionMux::addIndexedState, this, i, _1));
+    for (unsigned int j = 0 ; j < goal_states->getStateCount() ; ++j)
+      addIndexedState(i, goal_states->getState(j));
+  }
+}
+
+ompl_interface::GoalSampleableRegionMux::~GoalSampleableRegionMux()
+{
+  // the sampling threads call back into this instance
+  stopSampling();
+  for (std::size_t i = 0 ; i < goals_.size() ; ++i)
+    if (goals_[i]->hasType(ompl::base::GOAL_LAZY_SAMPLES))
+      static_cast<ompl::base::GoalLazySamples*>(goals_[i].get())->setNewStateCallback(ompl::base::NewStateCallbackFn());
+  for (std::size_t i = 0 ; i < indexed_states_.size() ; ++i)
+  {
+    si_->freeState(indexed_states_[i]->state);
+    delete indexed_states_[i];
+  }
+  if (start_)
+    si_->freeState(start_);
+}
+
+double ompl_interface::GoalSampleableRegionMux::distanceIndexedStates(const IndexedState *a, const IndexedState *b) const
+{
+  return si_->distance(a->state, b->state);
+}
+
+// Called by the sampling threads of the member goals while they hold their own lock, so only index_lock_ may be taken here
+void ompl_interface::GoalSampleableRegionMux::addIndexedState(unsigned int goal, const ompl::base::State *st)
+{
+  boost::mutex::scoped_lock slock(index_lock_);
+  insertIndexedState(goal, st);
+}
+
+void ompl_interface::GoalSampleableRegionMux::insertIndexedState(unsigned int goal, const ompl::base::State *st) const
+{
+  IndexedState *indexed = new IndexedState();
+  indexed->state = si_->cloneState(st);
+  indexed->goal = goal;
+  index_->add(indexed);
+  indexed_states_.push_back(indexed);
+  if (start_)
+    start_distance_[goal] = std::min(start_distance_[goal], si_->distance(start_, indexed->state));
+  weights_outdated_ = true;
+}
+
+void ompl_interface::GoalSampleableRegionMux::syncPlainGoals() const
 {
+  for (std::size_t i = 0 ; i < plain_goals_.size() ; ++i)
+  {
+    const unsigned int goal = plain_goals_[i];
+    const ompl::base::GoalStates *goal_states = goals_[goal]->as<ompl::base::GoalStates>();
+    const unsigned int count = goal_states->getStateCount();
+    if (count == indexed_counts_[goal])
+      continue;
+
+    // the states were cleared: index the member again
+    if (count < indexed_counts_[goal])
+    {
+      std::vector<IndexedState*> kept;
+      for (std::size_t j = 0 ; j < indexed_states_.size() ; ++j)
+        if (indexed_states_[j]->goal == goal)
+        {
+          index_->remove(indexed_states_[j]);
+          si_->freeState(indexed_states_[j]->state);
+          delete indexed_states_[j];
+        }
+        else
+          kept.push_back(indexed_states_[j]);
+      indexed_states_.swap(kept);
+      start_distance_[goal] = std::numeric_limits<double>::infinity();
+      indexed_counts_[goal] = 0;
+      weights_outdated_ = true;
+    }
+    for (unsigned int j = indexed_counts_[goal] ; j < count ; ++j)
+      insertIndexedState(goal, goal_states->getState(j));
+    indexed_counts_[goal] = count;
+  }
+}
+
+void ompl_interface::GoalSampleableRegionMux::setStartState(const ompl::base::State *st)
+{
+  {
+    boost::mutex::scoped_lock slock(index_lock_);
+    if (!start_)
+      start_ = si_->allocState();
+    si_->copyState(start_, st);
+    std::fill(start_distance_.begin(), start_distance_.end(), std::numeric_limits<double>::infinity());
+    for (std::size_t i = 0 ; i < indexed_states_.size() ; ++i)
+    {
+      double &d = start_distance_[indexed_states_[i]->goal];
+      d = std::min(d, si_->distance(start_, indexed_states_[i]->state));
+    }
+    weights_outdated_ = true;
+  }
 }
 
 void ompl_interface::GoalSampleableRegionMux::startSampling()
@@ -72,18 +200,78 @@ void ompl_interface::GoalSampleableRegionMux::stopSampling()
       static_cast<ompl::base::GoalLazySamples*>(goals_[i].get())->stopSampling();
 }
 
-void ompl_interface::GoalSampleableRegionMux::sampleGoal(ompl::base::State *st) const
+void ompl_interface::GoalSampleableRegionMux::updateWeights() const
 {
+  std::vector<double> distances;
+  {
+    boost::mutex::scoped_lock slock(index_lock_);
+    distances = start_distance_;
+    weights_outdated_ = false;
+  }
+
+  // distances are relative to the mean distance of the members that have goal states
+  double mean_distance = 0.0;
+  unsigned int known = 0;
+  for (std::size_t i = 0 ; i < distances.size() ; ++i)
+    if (distances[i] < std::numeric_limits<double>::infinity())
+    {
+      mean_distance += distances[i];
+      ++known;
+    }
+  if (known > 0)
+    mean_distance /= (double)known;
+
+  std::vector<double> weights(goals_.size(), 0.0);
+  double max_weight = 0.0;
   for (std::size_t i = 0 ; i < goals_.size() ; ++i)
   {
-    if (goals_[gindex_]->as<ompl::base::GoalSampleableRegion>()->maxSampleCount() > 0)
+    if (goals_[i]->as<ompl::base::GoalSampleableRegion>()->maxSampleCount() == 0)
+      continue;
+    // the rate at which goal states are found (with a prior of one success in two attempts)
+    double rate = 1.0;
+    if (goals_[i]->hasType(ompl::base::GOAL_LAZY_SAMPLES))
     {
-      goals_[gindex_]->as<ompl::base::GoalSampleableRegion>()->sampleGoal(st);
-      return;
+      const ompl::base::GoalLazySamples *gls = goals_[i]->as<ompl::base::GoalLazySamples>();
+      rate = (double)(gls->getStateCount() + 1) / (double)(gls->samplingAttemptsCount() + 2);
     }
-    gindex_ = (gindex_ + 1) % goals_.size();
+    weights[i] = rate;
+    if (mean_distance > 0.0 && distances[i] < std::numeric_limits<double>::infinity())
+      weights[i] /= 1.0 + distances[i] / mean_distance;
+    max_weight = std::max(max_weight, weights[i]);
   }
-  throw ompl::Exception("There are no states to sample");
+
+  cumulative_weights_.resize(goals_.size());
+  double total = 0.0;
+  for (std::size_t i = 0 ; i < goals_.size() ; ++i)
+  {
+    // every goal that can be sampled keeps a share of the samples
+    if (weights[i] > 0.0)
+      total += std::max(weights[i], MIN_WEIGHT_FRACTION * max_weight);
+    cumulative_weights_[i] = total;
+  }
+  samples_since_update_ = 0;
+}
+
+void ompl_interface::GoalSampleableRegionMux::sampleGoal(ompl::base::State *st) const
+{
+  unsigned int goal;
+  {
+    boost::mutex::scoped_lock slock(weights_lock_);
+    bool outdated;
+    {
+      boost::mutex::scoped_lock ilock(index_lock_);
+      syncPlainGoals();
+      outdated = weights_outdated_;
+    }
+    if (outdated || ++samples_since_update_ >= REWEIGHT_INTERVAL)
+      updateWeights();
+    if (cumulative_weights_.empty() || cumulative_weights_.back() <= 0.0)
+      throw ompl::Exception("There are no states to sample");
+    double r = rng_.uniformReal(0.0, cumulative_weights_.back());
+    goal = std::min(std::upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(), r) - cumulative_weights_.begin(),
+                    (std::ptrdiff_t)goals_.size() - 1);
+  }
+  goals_[goal]->as<ompl::base::GoalSampleableRegion>()->sampleGoal(st);
 }
 
 unsigned int ompl_interface::GoalSampleableRegionMux::maxSampleCount() const
@@ -112,18 +300,69 @@ bool ompl_interface::GoalSampleableRegionMux::couldSample() const
 
 bool ompl_interface::GoalSampleableRegionMux::isSatisfied(const ompl::base::State *st, double *distance) const
 {
-  for (std::size_t i = 0 ; i < goals_.size() ; ++i)
-    if (goals_[i]->isSatisfied(st, distance))
+  double min_d = std::numeric_limits<double>::infinity();
+  {
+    boost::mutex::scoped_lock slock(index_lock_);
+    syncPlainGoals();
+    if (index_->size() > 0)
+    {
+      IndexedState query;
+      query.state = const_cast<ompl::base::State*>(st);
+      query.goal = 0;
+      IndexedState *nearest = index_->nearest(&query);
+      min_d = si_->distance(st, nearest->state);
+      bool satisfied = min_d < goals_[nearest->goal]->as<ompl::base::GoalRegion>()->getThreshold();
+
+      // a state a little farther away may belong to a member with a larger threshold
+      if (!satisfied && min_d < max_threshold_)
+      {
+        std::vector<IndexedState*> nbh;
+        index_->nearestR(&query, max_threshold_, nbh);
+        for (std::size_t i = 0 ; i < nbh.size() && !satisfied ; ++i)
+          satisfied = si_->distance(st, nbh[i]->state) < goals_[nbh[i]->goal]->as<ompl::base::GoalRegion>()->getThreshold();
+      }
+      if (satisfied)
+      {
+        if (distance)
+          *distance = min_d;
+        return true;
+      }
+    }
+  }
+
+  for (std::size_t i = 0 ; i < other_goals_.size() ; ++i)
+  {
+    double d = std::numeric_limits<double>::infinity();
+    if (goals_[other_goals_[i]]->isSatisfied(st, &d))
+    {
+      if (distance)
+        *distance = d;
       return true;
+    }
+    min_d = std::min(min_d, d);
+  }
+  if (distance)
+    *distance = min_d;
   return false;
 }
 
 double ompl_interface::GoalSampleableRegionMux::distanceGoal(const ompl::base::State *st) const
 {
   double min_d = std::numeric_limits<double>::infinity();
-  for (std::size_t i = 0 ; i < goals_.size() ; ++i)
   {
-    double d = goals_[i]->as<ompl::base::GoalRegion>()->distanceGoal(st);
+    boost::mutex::scoped_lock slock(index_lock_);
+    syncPlainGoals();
+    if (index_->size() > 0)
+    {
+      IndexedState query;
+      query.state = const_cast<ompl::base::State*>(st);
+      query.goal = 0;
+      min_d = si_->distance(st, index_->nearest(&query)->state);
+    }
+  }
+  for (std::size_t i = 0 ; i < other_goals_.size() ; ++i)
+  {
+    double d = goals_[other_goals_[i]]->as<ompl::base::GoalRegion>()->distanceGoal(st);
     if (d < min_d)
       min_d = d;
   }
@@ -0,0 +1,142 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/halton_state_sampler.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <algorithm>
+
+namespace
+{
+/// The first \e count prime numbers
+std::vector<unsigned int> primes(std::size_t count)
+{
+  std::vector<unsigned int> result;
+  for (unsigned int n = 2 ; result.size() < count ; ++n)
+  {
+    bool prime = true;
+    for (std::size_t i = 0 ; i < result.size() && result[i] * result[i] <= n ; ++i)
+      if (n % result[i] == 0)
+      {
+        prime = false;
+        break;
+      }
+    if (prime)
+      result.push_back(n);
+  }
+  return result;
+}
+
+/// Seed of the digit permutations and of the random part of the samples, for a stream
+const boost::uint32_t STREAM_SEED = 0x9e3779b9u;
+}
+
+ompl_interface::HaltonStateSampler::HaltonStateSampler(const ModelBasedStateSpace *space, unsigned int stream)
+  : ompl::base::StateSampler(space)
+  , joint_model_group_(space->getJointModelGroup())
+  , joint_bounds_(&space->getJointsBounds())
+  , index_(1)
+  , moveit_rng_(STREAM_SEED * (stream + 1))
+{
+  const std::vector<const robot_model::JointModel*> &joints = joint_model_group_->getActiveJointModels();
+  int dimension = 0;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    joints_.push_back(joints[i]);
+    indices_.push_back(joint_model_group_->getVariableGroupIndex(joints[i]->getVariableNames()[0]));
+    const robot_model::JointModel::Bounds &b = *(*joint_bounds_)[i];
+    // continuous revolute joints are sampled in [-pi, pi], like by the joint model
+    if (b.size() == 1 && (b[0].position_bounded_ || joints[i]->getType() == robot_model::JointModel::REVOLUTE))
+      dimensions_.push_back(dimension++);
+    else
+      dimensions_.push_back(-1);
+  }
+
+  // random digit permutations that keep 0 fixed, so the trailing zero digits of the index do not matter
+  bases_ = primes(dimension);
+  boost::random::mt19937 generator(STREAM_SEED ^ stream);
+  permutations_.resize(dimension);
+  for (int d = 0 ; d < dimension ; ++d)
+  {
+    std::vector<unsigned int> &p = permutations_[d];
+    p.resize(bases_[d]);
+    for (unsigned int i = 0 ; i < bases_[d] ; ++i)
+      p[i] = i;
+    for (unsigned int i = bases_[d] - 1 ; i > 1 ; --i)
+      std::swap(p[i], p[1 + generator() % i]);
+  }
+}
+
+double ompl_interface::HaltonStateSampler::radicalInverse(std::size_t dimension) const
+{
+  const unsigned int base = bases_[dimension];
+  const std::vector<unsigned int> &p = permutations_[dimension];
+  const double inv_base = 1.0 / base;
+  double f = inv_base;
+  double r = 0.0;
+  for (boost::uint64_t i = index_ ; i > 0 ; i /= base)
+  {
+    r += p[i % base] * f;
+    f *= inv_base;
+  }
+  return r;
+}
+
+void ompl_interface::HaltonStateSampler::sampleUniform(ompl::base::State *state)
+{
+  double *values = state->as<ModelBasedStateSpace::StateType>()->values;
+  for (std::size_t i = 0 ; i < joints_.size() ; ++i)
+    if (dimensions_[i] >= 0)
+    {
+      const robot_model::VariableBounds &b = (*(*joint_bounds_)[i])[0];
+      values[indices_[i]] = b.min_position_ + radicalInverse(dimensions_[i]) * (b.max_position_ - b.min_position_);
+    }
+    else
+      joints_[i]->getVariableRandomPositions(moveit_rng_, values + indices_[i], *(*joint_bounds_)[i]);
+  joint_model_group_->updateMimicJoints(values);
+  state->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+  ++index_;
+}
+
+void ompl_interface::HaltonStateSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, const double distance)
+{
+  joint_model_group_->getVariableRandomPositionsNearBy(moveit_rng_, state->as<ModelBasedStateSpace::StateType>()->values, *joint_bounds_,
+                                                       near->as<ModelBasedStateSpace::StateType>()->values, distance);
+  state->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+}
+
+void ompl_interface::HaltonStateSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, const double stdDev)
+{
+  sampleUniformNear(state, mean, moveit_rng_.gaussian(0.0, stdDev));
+}
@@ -0,0 +1,241 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/ik_cache.h"
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+ompl_interface::IKCache::IKCache(double position_resolution, double position_tolerance, double orientation_tolerance,
+                                 double branch_distance, std::size_t max_entries, double orientation_resolution)
+  : position_resolution_(position_resolution)
+  , position_tolerance_(position_tolerance)
+  , orientation_tolerance_(orientation_tolerance)
+  , branch_distance_(branch_distance)
+  , max_entries_(max_entries)
+  , orientation_resolution_(orientation_resolution)
+{
+}
+
+void ompl_interface::IKCache::orientationCell(const double *orientation, int *cell) const
+{
+  // w is determined by x, y and z up to its sign, which is made positive
+  const double sign = orientation[3] < 0.0 ? -1.0 : 1.0;
+  for (int i = 0 ; i < 3 ; ++i)
+    cell[i] = (int)floor(sign * orientation[i] / orientation_resolution_);
+}
+
+std::size_t ompl_interface::IKCache::cellKey(unsigned int component, int x, int y, int z, const int *orientation_cell) const
+{
+  std::size_t key = 0;
+  boost::hash_combine(key, component);
+  boost::hash_combine(key, x);
+  boost::hash_combine(key, y);
+  boost::hash_combine(key, z);
+  for (int i = 0 ; i < 3 ; ++i)
+    boost::hash_combine(key, orientation_cell[i]);
+  return key;
+}
+
+ompl_interface::IKCache::Result ompl_interface::IKCache::lookup(unsigned int component, const double *position, const double *orientation,
+                                                                const std::vector<double> &seed, std::vector<double> &solution) const
+{
+  const int cx = (int)floor(position[0] / position_resolution_);
+  const int cy = (int)floor(position[1] / position_resolution_);
+  const int cz = (int)floor(position[2] / position_resolution_);
+  int oc[3];
+  orientationCell(orientation, oc);
+
+  // take references to the cells; they are not modified once inserted, so they are scanned without locking
+  CellConstPtr cells[27];
+  unsigned int cell_count = 0;
+  for (int dx = -1 ; dx <= 1 ; ++dx)
+    for (int dy = -1 ; dy <= 1 ; ++dy)
+      for (int dz = -1 ; dz <= 1 ; ++dz)
+      {
+        const std::size_t key = cellKey(component, cx + dx, cy + dy, cz + dz, oc);
+        Shard &shard = shards_[key % SHARD_COUNT];
+        boost::mutex::scoped_lock slock(shard.lock);
+        boost::unordered_map<std::size_t, CellConstPtr>::const_iterator it = shard.cells.find(key);
+        if (it != shard.cells.end())
+          cells[cell_count++] = it->second;
+      }
+
+  const Entry *best = NULL;
+  double best_position = std::numeric_limits<double>::infinity();
+  double best_angle = 0.0;
+  for (unsigned int c = 0 ; c < cell_count ; ++c)
+    for (std::size_t i = 0 ; i < cells[c]->size() ; ++i)
+    {
+      const Entry &e = (*cells[c])[i];
+      if (e.component != component || e.solution.size() != seed.size())
+        continue;
+
+      // only solutions on the branch of the seed
+      bool near_seed = true;
+      for (std::size_t j = 0 ; j < seed.size() && near_seed ; ++j)
+        near_seed = fabs(e.solution[j] - seed[j]) <= branch_distance_;
+      if (!near_seed)
+        continue;
+
+      double d = sqrt((e.position[0] - position[0]) * (e.position[0] - position[0]) +
+                      (e.position[1] - position[1]) * (e.position[1] - position[1]) +
+                      (e.position[2] - position[2]) * (e.position[2] - position[2]));
+      double dot = fabs(e.orientation[0] * orientation[0] + e.orientation[1] * orientation[1] +
+                        e.orientation[2] * orientation[2] + e.orientation[3] * orientation[3]);
+      double angle = 2.0 * acos(std::min(dot, 1.0));
+      if (d + angle < best_position + best_angle)
+      {
+        best = &e;
+        best_position = d;
+        best_angle = angle;
+      }
+    }
+
+  Result result = MISS;
+  if (best)
+  {
+    solution = best->solution;
+    result = best_position <= position_tolerance_ && best_angle <= orientation_tolerance_ ? HIT : SEED;
+  }
+
+  Statistics &statistics = *statistics_.get();
+  ++statistics.lookups;
+  if (result == HIT)
+    ++statistics.hits;
+  else
+    if (result == SEED)
+      ++statistics.seeds;
+  return result;
+}
+
+bool ompl_interface::IKCache::isDuplicate(const Entry &a, const Entry &b) const
+{
+  if (a.component != b.component || a.solution.size() != b.solution.size())
+    return false;
+  for (std::size_t j = 0 ; j < a.solution.size() ; ++j)
+    if (fabs(a.solution[j] - b.solution[j]) > branch_distance_)
+      return false;
+  double d = sqrt((a.position[0] - b.position[0]) * (a.position[0] - b.position[0]) +
+                  (a.position[1] - b.position[1]) * (a.position[1] - b.position[1]) +
+                  (a.position[2] - b.position[2]) * (a.position[2] - b.position[2]));
+  double dot = fabs(a.orientation[0] * b.orientation[0] + a.orientation[1] * b.orientation[1] +
+                    a.orientation[2] * b.orientation[2] + a.orientation[3] * b.orientation[3]);
+  return d <= position_tolerance_ && 2.0 * acos(std::min(dot, 1.0)) <= orientation_tolerance_;
+}
+
+void ompl_interface::IKCache::insert(unsigned int component, const double *position, const double *orientation, const std::vector<double> &solution)
+{
+  Entry e;
+  e.component = component;
+  for (int i = 0 ; i < 3 ; ++i)
+    e.position[i] = position[i];
+  for (int i = 0 ; i < 4 ; ++i)
+    e.orientation[i] = orientation[i];
+  e.solution = solution;
+  int oc[3];
+  orientationCell(orientation, oc);
+  const std::size_t key = cellKey(component, (int)floor(position[0] / position_resolution_),
+                                  (int)floor(position[1] / position_resolution_), (int)floor(position[2] / position_resolution_), oc);
+
+  Shard &shard = shards_[key % SHARD_COUNT];
+  boost::mutex::scoped_lock slock(shard.lock);
+  if (shard.size >= std::max<std::size_t>(max_entries_ / SHARD_COUNT, 1))
+  {
+    shard.cells.clear();
+    shard.size = 0;
+  }
+
+  CellConstPtr &cell = shard.cells[key];
+  if (cell)
+    for (std::size_t i = 0 ; i < cell->size() ; ++i)
+      if (isDuplicate((*cell)[i], e))
+        return;
+
+  // lookups may be scanning the current cell, so it is copied (without its oldest entry, if full)
+  boost::shared_ptr<Cell> updated(new Cell());
+  if (cell)
+  {
+    std::size_t first = cell->size() >= MAX_CELL_ENTRIES ? cell->size() - MAX_CELL_ENTRIES + 1 : 0;
+    updated->reserve(cell->size() - first + 1);
+    updated->insert(updated->end(), cell->begin() + first, cell->end());
+    shard.size -= first;
+  }
+  updated->push_back(e);
+  cell = updated;
+  ++shard.size;
+}
+
+void ompl_interface::IKCache::recordSolverCall(double seconds)
+{
+  Statistics &statistics = *statistics_.get();
+  ++statistics.solver_calls;
+  statistics.solver_time += seconds;
+}
+
+ompl_interface::IKCache::Statistics ompl_interface::IKCache::getStatistics() const
+{
+  std::vector<Statistics*> instances;
+  statistics_.getInstances(instances);
+  Statistics total;
+  for (std::size_t i = 0 ; i < instances.size() ; ++i)
+  {
+    total.lookups += instances[i]->lookups;
+    total.hits += instances[i]->hits;
+    total.seeds += instances[i]->seeds;
+    total.solver_calls += instances[i]->solver_calls;
+    total.solver_time += instances[i]->solver_time;
+  }
+  return total;
+}
+
+void ompl_interface::IKCache::resetStatistics()
+{
+  std::vector<Statistics*> instances;
+  statistics_.getInstances(instances);
+  for (std::size_t i = 0 ; i < instances.size() ; ++i)
+    *instances[i] = Statistics();
+}
+
+void ompl_interface::IKCache::clear()
+{
+  for (unsigned int i = 0 ; i < SHARD_COUNT ; ++i)
+  {
+    boost::mutex::scoped_lock slock(shards_[i].lock);
+    shards_[i].cells.clear();
+    shards_[i].size = 0;
+  }
+}
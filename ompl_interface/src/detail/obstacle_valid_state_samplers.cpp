@@ -0,0 +1,159 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/obstacle_valid_state_samplers.h"
+#include "moveit/ompl_interface/ompl_planning_context.h"
+#include <ompl/base/SpaceInformation.h>
+
+namespace
+{
+// The default standard deviation of the Gaussian steps, as a fraction of the extent of the space
+const double STD_DEV_FRACTION = 0.1;
+}
+
+ompl_interface::ObstacleValidStateSampler::ObstacleValidStateSampler(const OMPLPlanningContext *pc)
+  : ompl::base::ValidStateSampler(pc->getOMPLSpaceInformation().get())
+  , planning_context_(pc)
+  , sampler_(si_->allocStateSampler())
+  , work_(si_->allocState())
+  , other_(si_->allocState())
+  , stddev_(STD_DEV_FRACTION * si_->getMaximumExtent())
+{
+}
+
+ompl_interface::ObstacleValidStateSampler::~ObstacleValidStateSampler()
+{
+  si_->freeState(work_);
+  si_->freeState(other_);
+}
+
+bool ompl_interface::ObstacleValidStateSampler::sample(ompl::base::State *state)
+{
+  return sampleFrom(state, NULL, 0.0);
+}
+
+bool ompl_interface::ObstacleValidStateSampler::sampleNear(ompl::base::State *state, const ompl::base::State *near, const double distance)
+{
+  return sampleFrom(state, near, distance);
+}
+
+void ompl_interface::ObstacleValidStateSampler::sampleCandidate(ompl::base::State *state, const ompl::base::State *near, double distance)
+{
+  if (near)
+    sampler_->sampleUniformNear(state, near, distance);
+  else
+    sampler_->sampleUniform(state);
+}
+
+ompl_interface::GaussianValidSampler::GaussianValidSampler(const OMPLPlanningContext *pc) : ObstacleValidStateSampler(pc)
+{
+  name_ = "gaussian";
+}
+
+bool ompl_interface::GaussianValidSampler::sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance)
+{
+  for (unsigned int i = 0 ; i < attempts_ ; ++i)
+  {
+    sampleCandidate(state, near, distance);
+    sampler_->sampleGaussian(work_, state, stddev_);
+    bool valid = si_->isValid(state);
+    if (valid != si_->isValid(work_))
+    {
+      if (!valid)
+        si_->copyState(state, work_);
+      return true;
+    }
+  }
+  return false;
+}
+
+ompl_interface::BridgeTestValidSampler::BridgeTestValidSampler(const OMPLPlanningContext *pc) : ObstacleValidStateSampler(pc)
+{
+  name_ = "bridge_test";
+}
+
+bool ompl_interface::BridgeTestValidSampler::sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance)
+{
+  for (unsigned int i = 0 ; i < attempts_ ; ++i)
+  {
+    // both ends of the bridge are in collision
+    sampleCandidate(work_, near, distance);
+    if (si_->isValid(work_))
+      continue;
+    sampler_->sampleGaussian(other_, work_, stddev_);
+    if (si_->isValid(other_))
+      continue;
+    si_->getStateSpace()->interpolate(work_, other_, 0.5, state);
+    if (si_->isValid(state))
+      return true;
+  }
+  return false;
+}
+
+ompl_interface::ObstacleBasedValidSampler::ObstacleBasedValidSampler(const OMPLPlanningContext *pc) : ObstacleValidStateSampler(pc)
+{
+  name_ = "obstacle_based";
+}
+
+bool ompl_interface::ObstacleBasedValidSampler::sampleFrom(ompl::base::State *state, const ompl::base::State *near, double distance)
+{
+  // a valid state (in work_) and an invalid one (in other_)
+  bool have_valid = false;
+  bool have_invalid = false;
+  for (unsigned int i = 0 ; i < attempts_ && !(have_valid && have_invalid) ; ++i)
+  {
+    sampleCandidate(state, near, distance);
+    if (si_->isValid(state))
+    {
+      if (!have_valid)
+        si_->copyState(work_, state);
+      have_valid = true;
+    }
+    else
+    {
+      if (!have_invalid)
+        si_->copyState(other_, state);
+      have_invalid = true;
+    }
+  }
+  if (!have_valid || !have_invalid)
+    return false;
+
+  // walk towards the invalid state until the obstacle is reached
+  std::pair<ompl::base::State*, double> last_valid(state, 0.0);
+  if (si_->checkMotion(work_, other_, last_valid))
+    si_->copyState(state, work_);
+  return true;
+}
@@ -0,0 +1,175 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/parameterization_table.h"
+#include <ompl/util/Console.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <vector>
+
+const unsigned int ompl_interface::ParameterizationTable::RACES = 3;
+
+ompl_interface::ParameterizationTable::ParameterizationTable(const std::string &path) : path_(path)
+{
+  load();
+}
+
+bool ompl_interface::ParameterizationTable::getFastest(const std::string &group, const std::string &signature,
+                                                       std::string &parameterization, unsigned int races) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  std::map<std::pair<std::string, std::string>, Records>::const_iterator it = records_.find(std::make_pair(group, signature));
+  if (it == records_.end() || it->second.empty())
+    return false;
+  double fastest = -1.0;
+  for (Records::const_iterator jt = it->second.begin() ; jt != it->second.end() ; ++jt)
+  {
+    if (jt->second.races < races)
+      return false;
+    if (jt->second.rate > fastest)
+    {
+      fastest = jt->second.rate;
+      parameterization = jt->first;
+    }
+  }
+  return true;
+}
+
+void ompl_interface::ParameterizationTable::recordRace(const std::string &group, const std::string &signature,
+                                                       const std::string &parameterization, double rate)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  Record &record = records_[std::make_pair(group, signature)][parameterization];
+  if (record.races == 0)
+    record.rate = rate;
+  else
+    // running mean over the races
+    record.rate += (rate - record.rate) / (double)(record.races + 1);
+  ++record.races;
+  save();
+}
+
+std::string ompl_interface::ParameterizationTable::computeSignature(const moveit_msgs::Constraints &constraints)
+{
+  std::vector<std::string> parts;
+  for (std::size_t i = 0 ; i < constraints.joint_constraints.size() ; ++i)
+    parts.push_back("joint:" + constraints.joint_constraints[i].joint_name);
+  for (std::size_t i = 0 ; i < constraints.position_constraints.size() ; ++i)
+    parts.push_back("position:" + constraints.position_constraints[i].header.frame_id + "/" + constraints.position_constraints[i].link_name);
+  for (std::size_t i = 0 ; i < constraints.orientation_constraints.size() ; ++i)
+    parts.push_back("orientation:" + constraints.orientation_constraints[i].header.frame_id + "/" + constraints.orientation_constraints[i].link_name);
+  for (std::size_t i = 0 ; i < constraints.visibility_constraints.size() ; ++i)
+    parts.push_back("visibility:" + constraints.visibility_constraints[i].target_pose.header.frame_id + "/" +
+                    constraints.visibility_constraints[i].sensor_pose.header.frame_id);
+  if (parts.empty())
+    return "none";
+
+  std::sort(parts.begin(), parts.end());
+  std::string signature = parts[0];
+  for (std::size_t i = 1 ; i < parts.size() ; ++i)
+    signature += ";" + parts[i];
+  for (std::size_t i = 0 ; i < signature.size() ; ++i)
+    if (isspace(signature[i]))
+      signature[i] = '_';
+  return signature;
+}
+
+std::string ompl_interface::ParameterizationTable::getDefaultPath()
+{
+  const char *ros_home = getenv("ROS_HOME");
+  if (ros_home)
+    return std::string(ros_home) + "/ompl_parameterizations.table";
+  const char *home = getenv("HOME");
+  return std::string(home ? home : ".") + "/.ros/ompl_parameterizations.table";
+}
+
+ompl_interface::ParameterizationTablePtr ompl_interface::ParameterizationTable::getShared(const std::string &path)
+{
+  static std::map<std::string, ParameterizationTablePtr> tables;
+  static boost::mutex lock;
+  boost::mutex::scoped_lock slock(lock);
+  ParameterizationTablePtr &table = tables[path];
+  if (!table)
+    table.reset(new ParameterizationTable(path));
+  return table;
+}
+
+void ompl_interface::ParameterizationTable::load()
+{
+  if (path_.empty())
+    return;
+  std::ifstream fin(path_.c_str());
+  if (!fin.good())
+  {
+    logDebug("No state space parameterization table at '%s'", path_.c_str());
+    return;
+  }
+
+  std::string group, signature, parameterization;
+  Record record;
+  unsigned int count = 0;
+  while (fin >> group >> signature >> parameterization >> record.races >> record.rate)
+  {
+    records_[std::make_pair(group, signature)][parameterization] = record;
+    ++count;
+  }
+  logDebug("Loaded %u state space parameterization records from '%s'", count, path_.c_str());
+}
+
+void ompl_interface::ParameterizationTable::save() const
+{
+  if (path_.empty())
+    return;
+
+  // write a new file and replace the old one, so a table being read is always complete
+  const std::string temporary = path_ + ".tmp";
+  {
+    std::ofstream fout(temporary.c_str());
+    if (!fout.good())
+    {
+      logWarn("Unable to save the state space parameterization table to '%s'", path_.c_str());
+      return;
+    }
+    for (std::map<std::pair<std::string, std::string>, Records>::const_iterator it = records_.begin() ; it != records_.end() ; ++it)
+      for (Records::const_iterator jt = it->second.begin() ; jt != it->second.end() ; ++jt)
+        fout << it->first.first << " " << it->first.second << " " << jt->first << " " << jt->second.races << " " << jt->second.rate << std::endl;
+  }
+  if (std::rename(temporary.c_str(), path_.c_str()) != 0)
+    logWarn("Unable to save the state space parameterization table to '%s'", path_.c_str());
+}
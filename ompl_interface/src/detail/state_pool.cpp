@@ -0,0 +1,166 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/state_pool.h"
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <new>
+
+namespace
+{
+// The blocks moved between the free list of a thread and the shared one at a time; a thread keeps at most twice as many
+const std::size_t TRANSFER_BLOCKS = 32;
+
+// the free lists are threaded through the blocks themselves
+inline void*& nextBlock(void *block)
+{
+  return *static_cast<void**>(block);
+}
+}
+
+ompl_interface::StatePool::StatePool(std::size_t block_size, std::size_t blocks_per_chunk)
+  : block_size_(align(std::max(block_size, sizeof(void*))))
+  , blocks_per_chunk_(blocks_per_chunk)
+  , next_block_(blocks_per_chunk)
+  , free_list_(NULL)
+{
+}
+
+ompl_interface::StatePool::~StatePool()
+{
+  long in_use = countBlocksInUse();
+  if (in_use > 0)
+    logWarn("Destroying a state pool with %ld states still in use", in_use);
+  for (std::size_t i = 0 ; i < chunks_.size() ; ++i)
+    ::operator delete(chunks_[i]);
+}
+
+void* ompl_interface::StatePool::allocate()
+{
+  ThreadCache *cache = caches_.get();
+  if (!cache->free_list)
+    refill(*cache);
+  void *block = cache->free_list;
+  cache->free_list = nextBlock(block);
+  --cache->free_count;
+  ++cache->in_use;
+  return block;
+}
+
+void ompl_interface::StatePool::free(void *block)
+{
+  // blocks are freed to the free list of the calling thread, whichever thread allocated them
+  ThreadCache *cache = caches_.get();
+  nextBlock(block) = cache->free_list;
+  cache->free_list = block;
+  ++cache->free_count;
+  --cache->in_use;
+  if (cache->free_count >= 2 * TRANSFER_BLOCKS)
+    drain(*cache, TRANSFER_BLOCKS);
+}
+
+void ompl_interface::StatePool::refill(ThreadCache &cache)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::size_t i = 0 ; i < TRANSFER_BLOCKS ; ++i)
+  {
+    void *block;
+    if (free_list_)
+    {
+      block = free_list_;
+      free_list_ = nextBlock(block);
+    }
+    else
+    {
+      if (next_block_ == blocks_per_chunk_)
+      {
+        chunks_.push_back(static_cast<char*>(::operator new(block_size_ * blocks_per_chunk_)));
+        next_block_ = 0;
+      }
+      block = chunks_.back() + block_size_ * next_block_++;
+    }
+    nextBlock(block) = cache.free_list;
+    cache.free_list = block;
+    ++cache.free_count;
+  }
+}
+
+void ompl_interface::StatePool::drain(ThreadCache &cache, std::size_t count)
+{
+  // detach the first blocks of the thread's list, then splice them into the shared list
+  void *first = cache.free_list;
+  void *last = first;
+  for (std::size_t i = 1 ; i < count ; ++i)
+    last = nextBlock(last);
+  cache.free_list = nextBlock(last);
+  cache.free_count -= count;
+
+  boost::mutex::scoped_lock slock(lock_);
+  nextBlock(last) = free_list_;
+  free_list_ = first;
+}
+
+long ompl_interface::StatePool::countBlocksInUse() const
+{
+  // a block allocated by one thread and freed by another counts in both threads
+  std::vector<ThreadCache*> caches;
+  caches_.getInstances(caches);
+  long in_use = 0;
+  for (std::size_t i = 0 ; i < caches.size() ; ++i)
+    in_use += caches[i]->in_use;
+  return in_use;
+}
+
+bool ompl_interface::StatePool::release()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (countBlocksInUse() > 0)
+    return false;
+
+  // the free lists of the threads point into the chunks
+  std::vector<ThreadCache*> caches;
+  caches_.getInstances(caches);
+  for (std::size_t i = 0 ; i < caches.size() ; ++i)
+  {
+    caches[i]->free_list = NULL;
+    caches[i]->free_count = 0;
+  }
+  for (std::size_t i = 0 ; i < chunks_.size() ; ++i)
+    ::operator delete(chunks_[i]);
+  chunks_.clear();
+  next_block_ = blocks_per_chunk_;
+  free_list_ = NULL;
+  return true;
+}
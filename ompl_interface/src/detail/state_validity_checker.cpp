@@ -61,6 +61,35 @@ ompl_interface::StateValidityChecker::StateValidityChecker(const OMPLPlanningCon
 
   collision_request_with_distance_verbose_ = collision_request_with_distance_;
   collision_request_with_distance_verbose_.verbose = true;
+
+  // precompute the parts of the environment that do not move while the group moves
+  if (planning_context_->useStaticCollisionEnvironment())
+  {
+    static_environment_.reset(new StaticCollisionEnvironment(planning_context_->getPlanningScene(),
+                                                             planning_context_->getOMPLStateSpace()->getJointModelGroup(),
+                                                             pc->getCompleteInitialRobotState()));
+    if (!static_environment_->isValid())
+      static_environment_.reset();
+  }
+
+  // conservative sphere approximation, so that states far from obstacles skip the exact check
+  if (static_environment_ && (planning_context_->useCollisionSpheres() || planning_context_->useDistanceField()))
+  {
+    collision_spheres_.reset(new CollisionSpheres(*static_environment_, planning_context_->getPlanningScene(),
+                                                  pc->getCompleteInitialRobotState(), planning_context_->getCollisionSphereMargin()));
+    if (!collision_spheres_->isValid())
+      collision_spheres_.reset();
+  }
+
+  // signed distance field of the static environment, so clearance and cost are answered by lookups
+  if (collision_spheres_ && planning_context_->useDistanceField())
+  {
+    std::vector<std::string> moving_bodies;
+    collision_spheres_->getMovingBodyNames(moving_bodies);
+    distance_field_ = EnvironmentDistanceField::get(*static_environment_, moving_bodies,
+                                                    planning_context_->getDistanceFieldResolution(),
+                                                    planning_context_->getDistanceFieldMaxVoxels());
+  }
 }
 
 void ompl_interface::StateValidityChecker::setVerbose(bool flag)
@@ -80,6 +109,27 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State *stat
   return planning_context_->useStateValidityCache() ? isValidWithCache(state, dist, verbose) : isValidWithoutCache(state, dist, verbose);
 }
 
+void ompl_interface::StateValidityChecker::checkCollision(const collision_detection::CollisionRequest &req,
+                                                          collision_detection::CollisionResult &res,
+                                                          const robot_state::RobotState &state) const
+{
+  if (static_environment_)
+    static_environment_->checkCollision(req, res, state);
+  else
+    planning_context_->getPlanningScene()->checkCollision(req, res, state);
+}
+
+bool ompl_interface::StateValidityChecker::isCollisionFree(const robot_state::RobotState &state, bool verbose) const
+{
+  // verbose checks always report the contacts of the exact geometry
+  if (!verbose && collision_spheres_ && planning_context_->useCollisionSpheres() && collision_spheres_->isClear(state))
+    return true;
+
+  collision_detection::CollisionResult res;
+  checkCollision(verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, state);
+  return res.collision == false;
+}
+
 double ompl_interface::StateValidityChecker::cost(const ompl::base::State *state) const
 {
   double cost = 0.0;
@@ -87,9 +137,13 @@ double ompl_interface::StateValidityChecker::cost(const ompl::base::State *state
   robot_state::RobotState *kstate = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
 
+  // Volume of the link spheres inside obstacles
+  if (distance_field_)
+    return collision_spheres_->penetration(*kstate, *distance_field_);
+
   // Calculates cost from a summation of distance to obstacles times the size of the obstacle
   collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(collision_request_with_cost_, res, *kstate);
+  checkCollision(collision_request_with_cost_, res, *kstate);
 
   for (std::set<collision_detection::CostSource>::const_iterator it = res.cost_sources.begin() ; it != res.cost_sources.end() ; ++it)
     cost += it->cost * it->getVolume();
@@ -102,8 +156,11 @@ double ompl_interface::StateValidityChecker::clearance(const ompl::base::State *
   robot_state::RobotState *kstate = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
 
+  if (distance_field_)
+    return collision_spheres_->clearance(*kstate, *distance_field_);
+
   collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(collision_request_with_distance_, res, *kstate);
+  checkCollision(collision_request_with_distance_, res, *kstate);
   return res.collision ? 0.0 : (res.distance < 0.0 ? std::numeric_limits<double>::infinity() : res.distance);
 }
 
@@ -131,9 +188,7 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
     return false;
 
   // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *kstate);
-  return res.collision == false;
+  return isCollisionFree(*kstate, verbose);
 }
 
 bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base::State *state, double &dist, bool verbose) const
@@ -169,7 +224,7 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
 
   // check collision avoidance
   collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *kstate);
+  checkCollision(verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *kstate);
   dist = res.distance;
   return res.collision == false;
 }
@@ -206,9 +261,7 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
   }
 
   // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *kstate);
-  if (res.collision == false)
+  if (isCollisionFree(*kstate, verbose))
   {
     const_cast<ompl::base::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
     return true;
@@ -261,7 +314,7 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
 
   // check collision avoidance
   collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *kstate);
+  checkCollision(verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *kstate);
   dist = res.distance;
   return res.collision == false;
 }
@@ -0,0 +1,165 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/static_collision_environment.h"
+#include <moveit/collision_detection_fcl/collision_robot_fcl.h>
+#include <moveit/collision_detection_fcl/collision_world_fcl.h>
+#include <ompl/util/Console.h>
+
+const std::string ompl_interface::StaticCollisionEnvironment::STATIC_BODY_PREFIX = "static_body/";
+
+namespace
+{
+/// A copy of an FCL collision robot that only knows about the geometry of a subset of the robot links.
+/// The FCL objects for the remaining links are never constructed, neither for self-collision nor for
+/// collision checks with a world.
+class GroupCollisionRobotFCL : public collision_detection::CollisionRobotFCL
+{
+public:
+
+  GroupCollisionRobotFCL(const collision_detection::CollisionRobotFCL &robot, const std::set<const robot_model::LinkModel*> &links)
+    : collision_detection::CollisionRobotFCL(robot)
+  {
+    for (std::size_t i = 0 ; i < geoms_.size() ; ++i)
+      if (geoms_[i] && geoms_[i]->collision_geometry_data_->type == collision_detection::BodyTypes::ROBOT_LINK &&
+          links.find(geoms_[i]->collision_geometry_data_->ptr.link) == links.end())
+        geoms_[i].reset();
+  }
+};
+}
+
+ompl_interface::StaticCollisionEnvironment::StaticCollisionEnvironment(const planning_scene::PlanningSceneConstPtr &scene,
+                                                                       const robot_model::JointModelGroup *group,
+                                                                       const robot_state::RobotState &start_state)
+  : world_acm_(scene->getAllowedCollisionMatrix())
+  , self_acm_(scene->getAllowedCollisionMatrix())
+{
+  const collision_detection::CollisionRobotFCL *robot_fcl =
+    dynamic_cast<const collision_detection::CollisionRobotFCL*>(scene->getCollisionRobot().get());
+  const collision_detection::CollisionRobotFCL *robot_fcl_unpadded =
+    dynamic_cast<const collision_detection::CollisionRobotFCL*>(scene->getCollisionRobotUnpadded().get());
+  if (!robot_fcl || !robot_fcl_unpadded)
+  {
+    logDebug("The active collision checker is not FCL. Not precomputing the static collision environment for group '%s'",
+             group->getName().c_str());
+    return;
+  }
+
+  robot_state::RobotState state(start_state);
+  state.update();
+
+  // the links that move when the group moves
+  moving_links_ = group->getUpdatedLinkModelsWithGeometry();
+  std::set<const robot_model::LinkModel*> moving_set(moving_links_.begin(), moving_links_.end());
+
+  std::vector<const robot_state::AttachedBody*> attached_bodies;
+  state.getAttachedBodies(attached_bodies);
+
+  // names of everything that is checked against the static world for every state, with their touch links
+  std::map<std::string, std::set<std::string> > moving_bodies;
+  for (std::size_t i = 0 ; i < moving_links_.size() ; ++i)
+    moving_bodies[moving_links_[i]->getName()];
+  for (std::size_t i = 0 ; i < attached_bodies.size() ; ++i)
+    if (moving_set.find(attached_bodies[i]->getAttachedLink()) != moving_set.end())
+      moving_bodies[attached_bodies[i]->getName()] = attached_bodies[i]->getTouchLinks();
+
+  // the environment, as seen by this plan, and the static parts of the robot
+  world_.reset(new collision_detection::World(*scene->getWorld()));
+  collision_detection::WorldPtr environment(new collision_detection::World(*scene->getWorld()));
+  collision_detection::WorldPtr robot_bodies(new collision_detection::World());
+
+  // the links of the robot that do not move
+  const std::vector<const robot_model::LinkModel*> &links = state.getRobotModel()->getLinkModelsWithCollisionGeometry();
+  std::set<std::string> no_touch_links;
+  unsigned int static_links = 0;
+  for (std::size_t i = 0 ; i < links.size() ; ++i)
+  {
+    if (moving_set.find(links[i]) != moving_set.end())
+      continue;
+    EigenSTL::vector_Affine3d poses(links[i]->getShapes().size());
+    for (std::size_t j = 0 ; j < poses.size() ; ++j)
+      poses[j] = state.getGlobalLinkTransform(links[i]) * links[i]->getCollisionOriginTransforms()[j];
+    addStaticBody(robot_bodies, links[i]->getName(), links[i]->getShapes(), poses, no_touch_links, moving_bodies, self_acm_);
+    ++static_links;
+  }
+
+  // the bodies attached to links that do not move
+  for (std::size_t i = 0 ; i < attached_bodies.size() ; ++i)
+    if (moving_set.find(attached_bodies[i]->getAttachedLink()) == moving_set.end())
+      addStaticBody(robot_bodies, attached_bodies[i]->getName(), attached_bodies[i]->getShapes(),
+                    attached_bodies[i]->getGlobalCollisionBodyTransforms(), attached_bodies[i]->getTouchLinks(),
+                    moving_bodies, self_acm_);
+
+  static_world_.reset(new collision_detection::CollisionWorldFCL(environment));
+  static_robot_world_.reset(new collision_detection::CollisionWorldFCL(robot_bodies));
+  group_robot_.reset(new GroupCollisionRobotFCL(*robot_fcl, moving_set));
+  group_robot_unpadded_.reset(new GroupCollisionRobotFCL(*robot_fcl_unpadded, moving_set));
+
+  logDebug("Precomputed static collision environment for group '%s': %u moving links, %u static links, %u world objects",
+           group->getName().c_str(), (unsigned int)moving_links_.size(), static_links, (unsigned int)scene->getWorld()->size());
+}
+
+void ompl_interface::StaticCollisionEnvironment::addStaticBody(const collision_detection::WorldPtr &robot_bodies,
+                                                               const std::string &name, const std::vector<shapes::ShapeConstPtr> &shapes,
+                                                               const EigenSTL::vector_Affine3d &poses, const std::set<std::string> &touch_links,
+                                                               const std::map<std::string, std::set<std::string> > &moving_bodies,
+                                                               const collision_detection::AllowedCollisionMatrix &acm)
+{
+  if (shapes.empty())
+    return;
+  const std::string static_name = STATIC_BODY_PREFIX + name;
+  world_->addToObject(static_name, shapes, poses);
+  robot_bodies->addToObject(static_name, shapes, poses);
+
+  // the static copy inherits the allowed collisions of the body it stands in for
+  collision_detection::AllowedCollision::Type type;
+  for (std::map<std::string, std::set<std::string> >::const_iterator it = moving_bodies.begin() ; it != moving_bodies.end() ; ++it)
+    if (touch_links.find(it->first) != touch_links.end() || it->second.find(name) != it->second.end() ||
+        (acm.getAllowedCollision(name, it->first, type) && type == collision_detection::AllowedCollision::ALWAYS))
+      world_acm_.setEntry(static_name, it->first, true);
+}
+
+void ompl_interface::StaticCollisionEnvironment::checkCollision(const collision_detection::CollisionRequest &req,
+                                                                collision_detection::CollisionResult &res,
+                                                                const robot_state::RobotState &state) const
+{
+  // same order as planning_scene::PlanningScene::checkCollision(): the padded robot is checked against the world,
+  // the unpadded one against itself (including its static parts)
+  static_world_->checkRobotCollision(req, res, *group_robot_, state, world_acm_);
+  if (!res.collision || (req.contacts && res.contacts.size() < req.max_contacts))
+    static_robot_world_->checkRobotCollision(req, res, *group_robot_unpadded_, state, world_acm_);
+  if (!res.collision || (req.contacts && res.contacts.size() < req.max_contacts))
+    group_robot_unpadded_->checkSelfCollision(req, res, state, self_acm_);
+}
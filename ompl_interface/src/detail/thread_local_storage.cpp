@@ -0,0 +1,102 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/thread_local_storage.h"
+#include <boost/thread/tss.hpp>
+#include <boost/weak_ptr.hpp>
+#include <algorithm>
+
+namespace
+{
+struct SlotEntry
+{
+  boost::uint64_t        id;
+  boost::weak_ptr<bool>  alive;
+  void                  *data;
+};
+
+bool isExpired(const SlotEntry &entry)
+{
+  return entry.alive.expired();
+}
+
+// the slots used by each thread; only ever accessed by the thread itself
+boost::thread_specific_ptr<std::vector<SlotEntry> > thread_slots;
+
+boost::mutex next_id_lock;
+boost::uint64_t next_id = 0;
+}
+
+ompl_interface::ThreadLocalSlot::ThreadLocalSlot() : alive_(new bool(true))
+{
+  boost::mutex::scoped_lock slock(next_id_lock);
+  id_ = ++next_id;
+}
+
+void* ompl_interface::ThreadLocalSlot::get() const
+{
+  const std::vector<SlotEntry> *slots = thread_slots.get();
+  if (slots)
+    for (std::size_t i = 0 ; i < slots->size() ; ++i)
+      if ((*slots)[i].id == id_)
+        return (*slots)[i].data;
+  return NULL;
+}
+
+void ompl_interface::ThreadLocalSlot::set(void *data) const
+{
+  std::vector<SlotEntry> *slots = thread_slots.get();
+  if (!slots)
+  {
+    slots = new std::vector<SlotEntry>();
+    thread_slots.reset(slots);
+  }
+
+  // forget the slots whose owners no longer exist
+  slots->erase(std::remove_if(slots->begin(), slots->end(), &isExpired), slots->end());
+
+  for (std::size_t i = 0 ; i < slots->size() ; ++i)
+    if ((*slots)[i].id == id_)
+    {
+      (*slots)[i].data = data;
+      return;
+    }
+
+  SlotEntry entry;
+  entry.id = id_;
+  entry.alive = alive_;
+  entry.data = data;
+  slots->push_back(entry);
+}
@@ -36,32 +36,25 @@
 
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr &kmodel) : start_state_(kmodel)
+namespace
 {
-  start_state_.setToDefaultValues();
+robot_state::RobotState defaultState(const robot_model::RobotModelPtr &kmodel)
+{
+  robot_state::RobotState state(kmodel);
+  state.setToDefaultValues();
+  return state;
+}
 }
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState &start_state) : start_state_(start_state)
+ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr &kmodel) : thread_states_(defaultState(kmodel))
 {
 }
 
-ompl_interface::TSStateStorage::~TSStateStorage()
+ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState &start_state) : thread_states_(start_state)
 {
-  for (std::map<boost::thread::id, robot_state::RobotState*>::iterator it = thread_states_.begin() ; it != thread_states_.end() ; ++it)
-    delete it->second;
 }
 
 robot_state::RobotState* ompl_interface::TSStateStorage::getStateStorage() const
 {
-  robot_state::RobotState *st = NULL;
-  boost::mutex::scoped_lock slock(lock_);/// \todo use Thread Local Storage?
-  std::map<boost::thread::id, robot_state::RobotState*>::const_iterator it = thread_states_.find(boost::this_thread::get_id());
-  if (it == thread_states_.end())
-  {
-    st = new robot_state::RobotState(start_state_);
-    thread_states_[boost::this_thread::get_id()] = st;
-  }
-  else
-    st = it->second;
-  return st;
+  return thread_states_.get();
 }
@@ -0,0 +1,294 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "moveit/ompl_interface/detail/worker_ik_constraint_sampler.h"
+#include <moveit/robot_state/transforms.h>
+#include <ompl/util/Console.h>
+#include <boost/bind.hpp>
+#include <limits>
+
+namespace
+{
+std::string stripSlash(const std::string &frame)
+{
+  return !frame.empty() && frame[0] == '/' ? frame.substr(1) : frame;
+}
+}
+
+ompl_interface::WorkerIKConstraintSampler::WorkerIKConstraintSampler(const planning_scene::PlanningSceneConstPtr &scene,
+                                                                     const std::string &group_name)
+  : constraint_samplers::ConstraintSampler(scene, group_name)
+  , transform_ik_(false)
+  , ik_timeout_(0.0)
+{
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::canSample(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name,
+                                                          const moveit_msgs::Constraints &constr)
+{
+  const robot_model::JointModelGroup *jmg = scene->getRobotModel()->getJointModelGroup(group_name);
+  if (!jmg || !jmg->getGroupKinematics().first || !jmg->getSolverInstance())
+    return false;
+  if (!constr.joint_constraints.empty() || !constr.visibility_constraints.empty() ||
+      constr.position_constraints.size() > 1 || constr.orientation_constraints.size() > 1 ||
+      (constr.position_constraints.empty() && constr.orientation_constraints.empty()))
+    return false;
+
+  const std::string &link = constr.position_constraints.empty() ? constr.orientation_constraints[0].link_name :
+    constr.position_constraints[0].link_name;
+  if (!constr.orientation_constraints.empty() && constr.orientation_constraints[0].link_name != link)
+    return false;
+  return stripSlash(jmg->getSolverInstance()->getTipFrame()) == link;
+}
+
+void ompl_interface::WorkerIKConstraintSampler::clear()
+{
+  constraint_samplers::ConstraintSampler::clear();
+  position_constraint_.reset();
+  orientation_constraint_.reset();
+  solver_.reset();
+  transform_ik_ = false;
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::configure(const moveit_msgs::Constraints &constr)
+{
+  clear();
+  if (!canSample(scene_, jmg_->getName(), constr))
+    return false;
+
+  // the solver of this sampler only
+  kinematics::KinematicsBasePtr solver = jmg_->getGroupKinematics().first.allocator_(jmg_);
+  if (!solver)
+  {
+    logError("Unable to allocate a kinematics solver for group '%s'", jmg_->getName().c_str());
+    return false;
+  }
+  solver_ = solver;
+
+  const robot_model::RobotModelConstPtr &robot_model = scene_->getRobotModel();
+  if (!constr.position_constraints.empty())
+  {
+    position_constraint_.reset(new kinematic_constraints::PositionConstraint(robot_model));
+    if (!position_constraint_->configure(constr.position_constraints[0], scene_->getTransforms()))
+    {
+      clear();
+      return false;
+    }
+    if (position_constraint_->mobileReferenceFrame())
+      frame_depends_.push_back(position_constraint_->getReferenceFrame());
+  }
+  if (!constr.orientation_constraints.empty())
+  {
+    orientation_constraint_.reset(new kinematic_constraints::OrientationConstraint(robot_model));
+    if (!orientation_constraint_->configure(constr.orientation_constraints[0], scene_->getTransforms()))
+    {
+      clear();
+      return false;
+    }
+    if (orientation_constraint_->mobileReferenceFrame())
+      frame_depends_.push_back(orientation_constraint_->getReferenceFrame());
+  }
+
+  ik_frame_ = stripSlash(solver_->getBaseFrame());
+  transform_ik_ = !robot_state::Transforms::sameFrame(ik_frame_, robot_model->getModelFrame());
+  if (transform_ik_)
+    frame_depends_.push_back(ik_frame_);
+  ik_timeout_ = jmg_->getDefaultIKTimeout();
+  seed_.resize(jmg_->getKinematicsSolverJointBijection().size());
+  values_.resize(jmg_->getVariableCount());
+  is_valid_ = true;
+  return true;
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::samplePose(Eigen::Vector3d &position, Eigen::Quaterniond &orientation,
+                                                           robot_state::RobotState &state, unsigned int max_attempts)
+{
+  if (position_constraint_)
+  {
+    const std::vector<bodies::BodyPtr> &regions = position_constraint_->getConstraintRegions();
+    if (!regions.empty())
+    {
+      bool found = false;
+      std::size_t k = rng_.uniformInteger(0, regions.size() - 1);
+      for (std::size_t i = 0 ; i < regions.size() && !found ; ++i)
+        found = regions[(i + k) % regions.size()]->samplePointInside(rng_, max_attempts, position);
+      if (!found)
+        return false;
+    }
+    if (position_constraint_->mobileReferenceFrame())
+      position = state.getFrameTransform(position_constraint_->getReferenceFrame()) * position;
+  }
+  else
+  {
+    // the position of the tip for random joint values
+    robot_state::RobotState random_state(state);
+    jmg_->getVariableRandomPositions(rng_, values_);
+    random_state.setJointGroupPositions(jmg_, values_);
+    random_state.update();
+    position = random_state.getGlobalLinkTransform(jmg_->getLinkModelNames().back()).translation();
+  }
+
+  if (orientation_constraint_)
+  {
+    // a rotation within the tolerances about the axes of the desired orientation
+    const double eps = std::numeric_limits<double>::epsilon();
+    double angle_x = 2.0 * (rng_.uniform01() - 0.5) * (orientation_constraint_->getXAxisTolerance() - eps);
+    double angle_y = 2.0 * (rng_.uniform01() - 0.5) * (orientation_constraint_->getYAxisTolerance() - eps);
+    double angle_z = 2.0 * (rng_.uniform01() - 0.5) * (orientation_constraint_->getZAxisTolerance() - eps);
+    Eigen::Matrix3d diff(Eigen::AngleAxisd(angle_x, Eigen::Vector3d::UnitX()) *
+                         Eigen::AngleAxisd(angle_y, Eigen::Vector3d::UnitY()) *
+                         Eigen::AngleAxisd(angle_z, Eigen::Vector3d::UnitZ()));
+    orientation = Eigen::Quaterniond(orientation_constraint_->getDesiredRotationMatrix() * diff);
+    if (orientation_constraint_->mobileReferenceFrame())
+      orientation = Eigen::Quaterniond(state.getFrameTransform(orientation_constraint_->getReferenceFrame()).rotation()) * orientation;
+  }
+  else
+  {
+    double q[4];
+    rng_.quaternion(q);
+    orientation = Eigen::Quaterniond(q[3], q[0], q[1], q[2]);
+  }
+
+  // the point to reach is fixed to the link, not its origin
+  if (position_constraint_ && position_constraint_->hasLinkOffset())
+    position = position - orientation.toRotationMatrix() * position_constraint_->getLinkOffset();
+  return true;
+}
+
+void ompl_interface::WorkerIKConstraintSampler::validityCallback(robot_state::RobotState *state, const geometry_msgs::Pose &,
+                                                                 const std::vector<double> &ik_solution,
+                                                                 moveit_msgs::MoveItErrorCodes &error_code) const
+{
+  const std::vector<unsigned int> &bijection = jmg_->getKinematicsSolverJointBijection();
+  std::vector<double> solution(bijection.size());
+  for (std::size_t i = 0 ; i < bijection.size() ; ++i)
+    solution[bijection[i]] = ik_solution[i];
+  error_code.val = group_state_validity_callback_(state, jmg_, &solution[0]) ?
+    moveit_msgs::MoveItErrorCodes::SUCCESS : moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::callIK(robot_state::RobotState &state, const Eigen::Vector3d &position,
+                                                       const Eigen::Quaterniond &orientation)
+{
+  Eigen::Affine3d pose(Eigen::Translation3d(position) * orientation.toRotationMatrix());
+  // the solver expects poses in its base frame
+  if (transform_ik_)
+    pose = state.getFrameTransform(ik_frame_).inverse() * pose;
+  Eigen::Quaterniond q(pose.rotation());
+  geometry_msgs::Pose ik_query;
+  ik_query.position.x = pose.translation().x();
+  ik_query.position.y = pose.translation().y();
+  ik_query.position.z = pose.translation().z();
+  ik_query.orientation.x = q.x();
+  ik_query.orientation.y = q.y();
+  ik_query.orientation.z = q.z();
+  ik_query.orientation.w = q.w();
+
+  const std::vector<unsigned int> &bijection = jmg_->getKinematicsSolverJointBijection();
+  state.copyJointGroupPositions(jmg_, values_);
+  for (std::size_t i = 0 ; i < bijection.size() ; ++i)
+    seed_[i] = values_[bijection[i]];
+
+  std::vector<double> ik_solution;
+  moveit_msgs::MoveItErrorCodes error;
+  bool solved = group_state_validity_callback_ ?
+    solver_->searchPositionIK(ik_query, seed_, ik_timeout_, ik_solution,
+                              boost::bind(&WorkerIKConstraintSampler::validityCallback, this, &state, _1, _2, _3), error) :
+    solver_->searchPositionIK(ik_query, seed_, ik_timeout_, ik_solution, error);
+  if (!solved)
+    return false;
+  for (std::size_t i = 0 ; i < bijection.size() ; ++i)
+    values_[bijection[i]] = ik_solution[i];
+  state.setJointGroupPositions(jmg_, values_);
+  return true;
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::sample(robot_state::RobotState &state, const robot_state::RobotState &reference_state,
+                                                       unsigned int max_attempts)
+{
+  if (!is_valid_)
+    return false;
+  if (&state != &reference_state)
+    state = reference_state;
+  for (unsigned int a = 0 ; a < max_attempts ; ++a)
+  {
+    jmg_->getVariableRandomPositions(rng_, values_);
+    state.setJointGroupPositions(jmg_, values_);
+    state.update();
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+    if (!samplePose(position, orientation, state, max_attempts))
+      return false;
+    if (callIK(state, position, orientation))
+      return true;
+  }
+  return false;
+}
+
+bool ompl_interface::WorkerIKConstraintSampler::project(robot_state::RobotState &state, unsigned int max_attempts)
+{
+  if (!is_valid_)
+    return false;
+  state.update();
+  for (unsigned int a = 0 ; a < max_attempts ; ++a)
+  {
+    // a failed call leaves the seed in the state
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+    if (!samplePose(position, orientation, state, max_attempts))
+      return false;
+    if (callIK(state, position, orientation))
+      return true;
+  }
+  return false;
+}
+
+constraint_samplers::ConstraintSamplerPtr
+ompl_interface::WorkerIKConstraintSamplerAllocator::alloc(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name,
+                                                          const moveit_msgs::Constraints &constr)
+{
+  WorkerIKConstraintSamplerPtr sampler(new WorkerIKConstraintSampler(scene, group_name));
+  if (!sampler->configure(constr))
+    return constraint_samplers::ConstraintSamplerPtr();
+  return sampler;
+}
+
+bool ompl_interface::WorkerIKConstraintSamplerAllocator::canService(const planning_scene::PlanningSceneConstPtr &scene,
+                                                                    const std::string &group_name,
+                                                                    const moveit_msgs::Constraints &constr) const
+{
+  return WorkerIKConstraintSampler::canSample(scene, group_name, constr);
+}
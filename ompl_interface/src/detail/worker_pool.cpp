@@ -0,0 +1,159 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/detail/worker_pool.h"
+#include <boost/bind.hpp>
+#include <algorithm>
+
+ompl_interface::WorkerPool::WorkerPool(unsigned int threads) : stop_(false)
+{
+  if (threads == 0)
+    threads = std::max(1u, boost::thread::hardware_concurrency()) - 1;
+  for (unsigned int i = 0 ; i < threads ; ++i)
+    threads_.push_back(new boost::thread(boost::bind(&WorkerPool::worker, this)));
+}
+
+ompl_interface::WorkerPool::~WorkerPool()
+{
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    stop_ = true;
+  }
+  work_available_.notify_all();
+  for (std::size_t i = 0 ; i < threads_.size() ; ++i)
+  {
+    threads_[i]->join();
+    delete threads_[i];
+  }
+}
+
+ompl_interface::WorkerPool& ompl_interface::WorkerPool::getShared()
+{
+  static WorkerPool pool;
+  return pool;
+}
+
+std::size_t ompl_interface::WorkerPool::takeTask(Batch *&batch)
+{
+  batch = batches_.front();
+  std::size_t index = batch->next++;
+  if (batch->next == batch->tasks->size())
+    batches_.pop_front();
+  return index;
+}
+
+boost::exception_ptr ompl_interface::WorkerPool::executeTask(const Task &task)
+{
+  // an exception must not escape a worker thread (std::terminate), nor skip the accounting of the batch
+  try
+  {
+    task();
+  }
+  catch (...)
+  {
+    return boost::current_exception();
+  }
+  return boost::exception_ptr();
+}
+
+void ompl_interface::WorkerPool::finishTask(Batch *batch, const boost::exception_ptr &error)
+{
+  if (error && !batch->error)
+    batch->error = error;
+  if (--batch->pending == 0)
+    batch_done_.notify_all();
+}
+
+void ompl_interface::WorkerPool::worker()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  while (true)
+  {
+    while (!stop_ && batches_.empty())
+      work_available_.wait(slock);
+    if (stop_)
+      return;
+
+    Batch *batch;
+    std::size_t index = takeTask(batch);
+    slock.unlock();
+    boost::exception_ptr error = executeTask((*batch->tasks)[index]);
+    slock.lock();
+    finishTask(batch, error);
+  }
+}
+
+void ompl_interface::WorkerPool::run(const std::vector<Task> &tasks)
+{
+  if (tasks.size() < 2 || threads_.empty())
+  {
+    boost::exception_ptr first_error;
+    for (std::size_t i = 0 ; i < tasks.size() ; ++i)
+    {
+      boost::exception_ptr error = executeTask(tasks[i]);
+      if (error && !first_error)
+        first_error = error;
+    }
+    if (first_error)
+      boost::rethrow_exception(first_error);
+    return;
+  }
+
+  Batch batch;
+  batch.tasks = &tasks;
+  batch.next = 0;
+  batch.pending = tasks.size();
+
+  boost::mutex::scoped_lock slock(lock_);
+  batches_.push_back(&batch);
+  work_available_.notify_all();
+
+  // help with the tasks of this batch that no worker has taken yet
+  while (batch.next < tasks.size())
+  {
+    std::size_t index = batch.next++;
+    if (batch.next == tasks.size())
+      batches_.erase(std::find(batches_.begin(), batches_.end(), &batch));
+    slock.unlock();
+    boost::exception_ptr error = executeTask(tasks[index]);
+    slock.lock();
+    finishTask(&batch, error);
+  }
+
+  while (batch.pending > 0)
+    batch_done_.wait(slock);
+  if (batch.error)
+    boost::rethrow_exception(batch.error);
+}
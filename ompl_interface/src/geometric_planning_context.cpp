@@ -36,20 +36,34 @@
 
 #include "moveit/ompl_interface/geometric_planning_context.h"
 #include "moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h"
+#include "moveit/ompl_interface/parameterization/joint_space/fixed_dof_state_space.h"
 #include "moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h"
+#include "moveit/ompl_interface/parameterization/projected_space/projected_state_space.h"
+#include "moveit/ompl_interface/parameterization/weighted_joint_distance.h"
 #include "moveit/ompl_interface/detail/state_validity_checker.h"
 #include "moveit/ompl_interface/detail/projection_evaluators.h"
 #include "moveit/ompl_interface/detail/constrained_goal_sampler.h"
+#include "moveit/ompl_interface/detail/worker_ik_constraint_sampler.h"
+#include "moveit/ompl_interface/detail/goal_state_cache.h"
 #include "moveit/ompl_interface/detail/goal_union.h"
 #include "moveit/ompl_interface/detail/constrained_sampler.h"
+#include "moveit/ompl_interface/detail/constrained_valid_state_sampler.h"
+#include "moveit/ompl_interface/detail/obstacle_valid_state_samplers.h"
+#include "moveit/ompl_interface/detail/batch_state_sampler.h"
+#include "moveit/ompl_interface/detail/nearest_neighbors_hnsw.h"
+#include "moveit/ompl_interface/detail/nearest_neighbors_gnat_cached.h"
+#include "moveit/ompl_interface/detail/halton_state_sampler.h"
 
 #include <pluginlib/class_loader.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/math/constants/constants.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <ompl/tools/multiplan/ParallelPlan.h>
 #include <ompl/tools/config/SelfConfig.h>
+#include <ompl/base/samplers/UniformValidStateSampler.h>
 
 #include <ompl/geometric/planners/rrt/RRT.h>
 #include <ompl/geometric/planners/rrt/pRRT.h>
@@ -66,10 +80,23 @@
 #include <ompl/geometric/planners/prm/PRM.h>
 #include <ompl/geometric/planners/prm/PRMstar.h>
 
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+#include <ompl/datastructures/NearestNeighborsSqrtApprox.h>
+#include <ompl/datastructures/NearestNeighborsLinear.h>
+
+#include <ompl/base/objectives/PathLengthOptimizationObjective.h>
+#include <ompl/base/objectives/MaximizeMinClearanceObjective.h>
+#include <ompl/base/objectives/StateCostIntegralObjective.h>
+#include <ompl/util/Time.h>
+
 namespace og = ompl::geometric;
 
 using namespace ompl_interface;
 
+// The time (seconds) and number of samples each parameterization gets in a race
+static const double PARAMETERIZATION_RACE_TIME = 0.05;
+static const unsigned int PARAMETERIZATION_RACE_SAMPLES = 1000;
+
 GeometricPlanningContext::GeometricPlanningContext() : OMPLPlanningContext()
 {
     initializePlannerAllocators();
@@ -85,6 +112,23 @@ GeometricPlanningContext::GeometricPlanningContext() : OMPLPlanningContext()
     initialized_ = false;
 
     planner_id_ = "";
+
+    sampler_stream_ = 0;
+
+    goal_sampling_threads_ = 1;
+    goal_sampling_attempts_ = 1000;
+    goal_ik_attempts_ = 4;
+    max_goal_samples_ = 50;
+    use_goal_state_cache_ = false;
+
+    use_ik_cache_ = false;
+    parallel_ik_ = false;
+
+    constrained_sampler_statistics_.reset(new ConstrainedSamplerStatistics());
+
+    // Samplers with inverse kinematics solvers of their own, for the parallel goal sampling workers
+    worker_sampler_manager_.reset(new constraint_samplers::ConstraintSamplerManager());
+    worker_sampler_manager_->registerSamplerAllocator(constraint_samplers::ConstraintSamplerAllocatorPtr(new WorkerIKConstraintSamplerAllocator()));
 }
 
 GeometricPlanningContext::~GeometricPlanningContext()
@@ -109,6 +153,123 @@ static ompl::base::PlannerPtr allocatePlanner(const ompl::base::SpaceInformation
   return planner;
 }
 
+// Read (and remove) a context parameter from the planner configuration.  Returns false if the
+// parameter is not specified or its value cannot be parsed.
+template<typename T>
+static bool extractContextParam(std::map<std::string, std::string>& config, const std::string& key, T& value)
+{
+    std::map<std::string, std::string>::iterator it = config.find(key);
+    if (it == config.end())
+        return false;
+
+    std::string str = boost::trim_copy(it->second);
+    config.erase(it);
+    try
+    {
+        value = boost::lexical_cast<T>(str);
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+        ROS_ERROR("Unable to parse value '%s' for parameter '%s'", str.c_str(), key.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool extractContextParam(std::map<std::string, std::string>& config, const std::string& key, bool& value)
+{
+    std::string str;
+    if (!extractContextParam(config, key, str))
+        return false;
+
+    if (str == "1" || str == "true" || str == "True")
+        value = true;
+    else if (str == "0" || str == "false" || str == "False")
+        value = false;
+    else
+    {
+        ROS_ERROR("Unable to parse value '%s' for boolean parameter '%s'", str.c_str(), key.c_str());
+        return false;
+    }
+    return true;
+}
+
+namespace
+{
+/// Integral of the collision cost reported by the StateValidityChecker along the path
+class CollisionCostObjective : public ompl::base::StateCostIntegralObjective
+{
+public:
+    CollisionCostObjective(const ompl::base::SpaceInformationPtr &si) : ompl::base::StateCostIntegralObjective(si, true)
+    {
+        description_ = "Collision Cost";
+    }
+
+    virtual ompl::base::Cost stateCost(const ompl::base::State *s) const
+    {
+        const StateValidityChecker *svc = dynamic_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get());
+        return ompl::base::Cost(svc ? svc->cost(s) : 0.0);
+    }
+};
+}
+
+static ompl::base::OptimizationObjectivePtr allocateOptimizationObjective(const ompl::base::SpaceInformationPtr &si, const std::string &name)
+{
+    if (name == "path_length")
+        return ompl::base::OptimizationObjectivePtr(new ompl::base::PathLengthOptimizationObjective(si));
+    if (name == "clearance")
+        return ompl::base::OptimizationObjectivePtr(new ompl::base::MaximizeMinClearanceObjective(si));
+    if (name == "collision_cost")
+        return ompl::base::OptimizationObjectivePtr(new CollisionCostObjective(si));
+
+    ROS_ERROR("Unknown optimization objective '%s'.  Using the default objective", name.c_str());
+    return ompl::base::OptimizationObjectivePtr();
+}
+
+// Replace the nearest neighbors structure of a planner.  Returns false if the planner does not expose one
+template<template<typename T> class NN>
+static bool setPlannerNearestNeighbors(const ompl::base::PlannerPtr &planner)
+{
+    if (og::RRT *rrt = dynamic_cast<og::RRT*>(planner.get()))
+        rrt->setNearestNeighbors<NN>();
+    else if (og::RRTConnect *rrt_connect = dynamic_cast<og::RRTConnect*>(planner.get()))
+        rrt_connect->setNearestNeighbors<NN>();
+    else if (og::LazyRRT *lazy_rrt = dynamic_cast<og::LazyRRT*>(planner.get()))
+        lazy_rrt->setNearestNeighbors<NN>();
+    else if (og::TRRT *trrt = dynamic_cast<og::TRRT*>(planner.get()))
+        trrt->setNearestNeighbors<NN>();
+    else if (og::RRTstar *rrt_star = dynamic_cast<og::RRTstar*>(planner.get()))
+        rrt_star->setNearestNeighbors<NN>();
+    else if (og::PRM *prm = dynamic_cast<og::PRM*>(planner.get())) // also PRMstar
+        prm->setNearestNeighbors<NN>();
+    else
+        return false;
+    return true;
+}
+
+static void setPlannerNearestNeighbors(const ompl::base::PlannerPtr &planner, const std::string &name)
+{
+    bool supported;
+    if (name == "gnat")
+        supported = setPlannerNearestNeighbors<ompl::NearestNeighborsGNAT>(planner);
+    else if (name == "gnat_cached")
+        supported = setPlannerNearestNeighbors<NearestNeighborsGNATCached>(planner);
+    else if (name == "sqrtapprox")
+        supported = setPlannerNearestNeighbors<ompl::NearestNeighborsSqrtApprox>(planner);
+    else if (name == "linear")
+        supported = setPlannerNearestNeighbors<ompl::NearestNeighborsLinear>(planner);
+    else if (name == "hnsw")
+        supported = setPlannerNearestNeighbors<NearestNeighborsHNSW>(planner);
+    else
+    {
+        ROS_ERROR("Unknown nearest neighbors structure '%s'.  Using the planner default", name.c_str());
+        return;
+    }
+
+    if (!supported)
+        ROS_WARN("Planner '%s' does not support selecting the nearest neighbors structure", planner->getName().c_str());
+}
+
 void GeometricPlanningContext::initializePlannerAllocators()
 {
     registerPlannerAllocator("geometric::RRT", boost::bind(&allocatePlanner<og::RRT>, _1, _2, _3));
@@ -157,6 +318,61 @@ void GeometricPlanningContext::initialize(const std::string& ros_namespace, cons
     if (it != spec_.config.end())
         spec_.config.erase(it);
 
+    // Check the moving links of the group against a precomputed static environment
+    extractContextParam(spec_.config, "static_collision_environment", use_static_collision_environment_);
+    // Accept states whose bounding spheres are clear of obstacles without the exact check
+    extractContextParam(spec_.config, "collision_spheres", use_collision_spheres_);
+    extractContextParam(spec_.config, "collision_sphere_margin", collision_sphere_margin_);
+    // Answer clearance and cost queries from a distance field of the static environment
+    extractContextParam(spec_.config, "distance_field", use_distance_field_);
+    extractContextParam(spec_.config, "distance_field_resolution", distance_field_resolution_);
+    extractContextParam(spec_.config, "distance_field_max_voxels", distance_field_max_voxels_);
+    extractContextParam(spec_.config, "optimization_objective", optimization_objective_);
+    // The encoding of stored states (e.g., constraint approximations)
+    extractContextParam(spec_.config, "serialization_format", serialization_format_);
+    // Reuse inverse kinematics solutions in the workspace representation
+    extractContextParam(spec_.config, "ik_cache", use_ik_cache_);
+    // Solve inverse kinematics for the groups of a multi-arm workspace representation concurrently
+    extractContextParam(spec_.config, "parallel_ik", parallel_ik_);
+    // How the workspace representation computes the joint values of interpolated states
+    extractContextParam(spec_.config, "interpolation_steering", interpolation_steering_);
+    // The structure used by the planner to answer nearest neighbor queries
+    extractContextParam(spec_.config, "nearest_neighbors", nearest_neighbors_);
+    // The distance between joint space states
+    extractContextParam(spec_.config, "distance_metric", distance_metric_);
+    // Sample goal states with several workers per goal, and the limits of the sampling of a goal
+    extractContextParam(spec_.config, "goal_sampling_threads", goal_sampling_threads_);
+    extractContextParam(spec_.config, "goal_sampling_attempts", goal_sampling_attempts_);
+    extractContextParam(spec_.config, "goal_ik_attempts", goal_ik_attempts_);
+    extractContextParam(spec_.config, "max_goal_samples", max_goal_samples_);
+    // Start from the goal states found by earlier requests for the same goal
+    extractContextParam(spec_.config, "goal_state_cache", use_goal_state_cache_);
+    // How states are represented when there are path constraints
+    extractContextParam(spec_.config, "parameterization", parameterization_);
+    if (!parameterization_.empty() && parameterization_ != "default" && parameterization_ != "projected" && parameterization_ != "auto")
+    {
+        ROS_ERROR("Unknown state space parameterization '%s'.  Using the default parameterization", parameterization_.c_str());
+        parameterization_.clear();
+    }
+    // Where the automatic parameterization remembers the fastest representation
+    extractContextParam(spec_.config, "parameterization_table", parameterization_table_);
+    // The sampler of uniform joint space states
+    extractContextParam(spec_.config, "state_sampler", state_sampler_);
+    if (!state_sampler_.empty() && state_sampler_ != "random" && state_sampler_ != "halton")
+    {
+        ROS_ERROR("Unknown state sampler '%s'.  Using random samples", state_sampler_.c_str());
+        state_sampler_.clear();
+    }
+    // The sampler of valid states used by the planners (e.g., PRM)
+    extractContextParam(spec_.config, "valid_state_sampler", valid_state_sampler_);
+    if (!valid_state_sampler_.empty() && valid_state_sampler_ != "default" && valid_state_sampler_ != "uniform" &&
+        valid_state_sampler_ != "gaussian" && valid_state_sampler_ != "bridge_test" && valid_state_sampler_ != "obstacle_based" &&
+        valid_state_sampler_ != "batch")
+    {
+        ROS_ERROR("Unknown valid state sampler '%s'.  Using the default valid state sampler", valid_state_sampler_.c_str());
+        valid_state_sampler_.clear();
+    }
+
     OMPLPlanningContext::initialize(ros_namespace, spec_);
 
     constraint_sampler_manager_ = spec_.constraint_sampler_mgr;
@@ -190,20 +406,62 @@ void GeometricPlanningContext::initialize(const std::string& ros_namespace, cons
     //     ROS_INFO_STREAM(ss.str());
     // }
 
+    // OMPL ProjectionEvaluator, registered when the state space is set up
+    it = spec_.config.find("projection_evaluator");
+    if (it != spec_.config.end())
+    {
+        projection_evaluator_ = boost::trim_copy(it->second);
+        spec_.config.erase(it);
+    }
+    else
+        projection_evaluator_.clear();
+
     // OMPL StateSpace
     ModelBasedStateSpaceSpecification state_space_spec(spec_.model, spec_.group);
     allocateStateSpace(state_space_spec);
+    setupStateSpace();
+
+    initialized_ = true;
+}
+
+void GeometricPlanningContext::setupStateSpace()
+{
+    if (serialization_format_ == "quantized16")
+        mbss_->setSerializationFormat(ModelBasedStateSpace::SERIALIZE_QUANTIZED_16);
+    else if (serialization_format_ == "quantized32")
+        mbss_->setSerializationFormat(ModelBasedStateSpace::SERIALIZE_QUANTIZED_32);
+    else if (!serialization_format_.empty() && serialization_format_ != "raw")
+        ROS_ERROR("Unknown serialization format '%s'.  Storing states as doubles", serialization_format_.c_str());
+    if (PoseModelStateSpace *pose_space = dynamic_cast<PoseModelStateSpace*>(mbss_.get()))
+    {
+        if (use_ik_cache_)
+        {
+            // the solutions remain valid for the lifetime of the context
+            if (!ik_cache_)
+                ik_cache_.reset(new IKCache());
+            pose_space->setIKCache(ik_cache_);
+        }
+        pose_space->setParallelIK(parallel_ik_);
+        if (interpolation_steering_ == "jacobian")
+            pose_space->setJacobianSteering(true);
+        else if (!interpolation_steering_.empty() && interpolation_steering_ != "ik")
+            ROS_ERROR("Unknown interpolation steering '%s'.  Using inverse kinematics", interpolation_steering_.c_str());
+    }
 
     // OMPL SimpleSetup
     simple_setup_.reset(new ompl::geometric::SimpleSetup(mbss_));
 
-    // OMPL ProjectionEvaluator
-    it = spec_.config.find("projection_evaluator");
-    if (it != spec_.config.end())
+    // OMPL OptimizationObjective
+    if (!optimization_objective_.empty())
     {
-        setProjectionEvaluator(boost::trim_copy(it->second));
-        spec_.config.erase(it);
+        ompl::base::OptimizationObjectivePtr obj = allocateOptimizationObjective(simple_setup_->getSpaceInformation(), optimization_objective_);
+        if (obj)
+            simple_setup_->setOptimizationObjective(obj);
     }
+
+    // OMPL ProjectionEvaluator
+    if (!projection_evaluator_.empty())
+        setProjectionEvaluator(projection_evaluator_);
     else if (planner_id_ != "")
         ROS_WARN("No projection evaluator for '%s'", planner_id_.c_str());
 
@@ -217,55 +475,191 @@ void GeometricPlanningContext::initialize(const std::string& ros_namespace, cons
     // OMPL StateSampler
     mbss_->setStateSamplerAllocator(boost::bind(&GeometricPlanningContext::allocPathConstrainedSampler, this, _1));
 
-    initialized_ = true;
+    // OMPL ValidStateSampler
+    simple_setup_->getSpaceInformation()->setValidStateSamplerAllocator(boost::bind(&GeometricPlanningContext::allocValidStateSampler, this, _1));
 }
 
 void GeometricPlanningContext::allocateStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec)
 {
-    bool allocated = false;
+    // Race the representations that apply to the path constraints, unless it is known which is fastest
+    raced_state_spaces_.clear();
+    if (parameterization_ == "auto" && path_constraints_)
+    {
+        allocateFastestStateSpace(state_space_spec);
+        return;
+    }
 
     // If there are (only) position and/or orientation constraints, make sure we have a means to
     // compute IK solutions.  If so, allocate a pose model (workspace) state space representation
-    if ((!request_.path_constraints.position_constraints.empty() || !request_.path_constraints.orientation_constraints.empty()) &&
-         request_.path_constraints.joint_constraints.empty() && request_.path_constraints.visibility_constraints.empty())
+    if (parameterization_ != "projected" && canUsePoseModelStateSpace(state_space_spec.joint_model_group_))
+        mbss_.reset(new PoseModelStateSpace(state_space_spec));
+    // The default is a representation based on the joint angles of the group
+    else
+        mbss_ = allocateJointModelStateSpace(state_space_spec, parameterization_ == "projected");
+}
+
+bool GeometricPlanningContext::canUsePoseModelStateSpace(const robot_model::JointModelGroup *jmg) const
+{
+    if ((request_.path_constraints.position_constraints.empty() && request_.path_constraints.orientation_constraints.empty()) ||
+        !request_.path_constraints.joint_constraints.empty() || !request_.path_constraints.visibility_constraints.empty() || !jmg)
+        return false;
+
+    const std::pair<robot_model::JointModelGroup::KinematicsSolver, robot_model::JointModelGroup::KinematicsSolverMap>& slv = jmg->getGroupKinematics();
+    // check that we have a direct means to compute IK
+    if (slv.first)
+        return jmg->getVariableCount() == slv.first.bijection_.size();
+    if (slv.second.empty())
+        return false;
+
+    // or an IK solver for each of the subgroups
+    unsigned int vc = 0;
+    unsigned int bc = 0;
+    for (robot_model::JointModelGroup::KinematicsSolverMap::const_iterator jt = slv.second.begin() ; jt != slv.second.end() ; ++jt)
     {
-        const robot_model::JointModelGroup *jmg = state_space_spec.joint_model_group_;
-        if (jmg)
-        {
-            const std::pair<robot_model::JointModelGroup::KinematicsSolver, robot_model::JointModelGroup::KinematicsSolverMap>& slv = jmg->getGroupKinematics();
-            bool ik = false;
-            // check that we have a direct means to compute IK
-            if (slv.first)
-                ik = jmg->getVariableCount() == slv.first.bijection_.size();
-            else if (!slv.second.empty())
-            {
-                // or an IK solver for each of the subgroups
-                unsigned int vc = 0;
-                unsigned int bc = 0;
-                for (robot_model::JointModelGroup::KinematicsSolverMap::const_iterator jt = slv.second.begin() ; jt != slv.second.end() ; ++jt)
-                {
-                    vc += jt->first->getVariableCount();
-                    bc += jt->second.bijection_.size();
-                }
-                if (vc == jmg->getVariableCount() && vc == bc)
-                    ik = true;
-            }
+        vc += jt->first->getVariableCount();
+        bc += jt->second.bijection_.size();
+    }
+    return vc == jmg->getVariableCount() && vc == bc;
+}
 
-            if (ik)
-            {
-                PoseModelStateSpacePtr state_space_(new PoseModelStateSpace(state_space_spec));
-                mbss_ = boost::static_pointer_cast<ModelBasedStateSpace>(state_space_);
-                allocated = true;
-            }
-        }
+ModelBasedStateSpacePtr GeometricPlanningContext::allocateJointModelStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec,
+                                                                               bool projected) const
+{
+    // The most common numbers of variables get a specialized implementation
+    JointModelStateSpacePtr state_space_;
+    switch (state_space_spec.joint_model_group_->getVariableCount())
+    {
+    case 6:
+        state_space_.reset(new FixedDofStateSpace<6>(state_space_spec));
+        break;
+    case 7:
+        state_space_.reset(new FixedDofStateSpace<7>(state_space_spec));
+        break;
+    default:
+        state_space_.reset(new JointModelStateSpace(state_space_spec));
     }
 
-    // The default is a representation based on the joint angles of the group
-    if (!allocated)
+    // Keep the states on the path constraints by projecting them, if requested
+    if (projected && path_constraints_)
     {
-        JointModelStateSpacePtr state_space_(new JointModelStateSpace(state_space_spec));
-        mbss_ = boost::static_pointer_cast<ModelBasedStateSpace>(state_space_);
+        ProjectedStateSpacePtr projected_space(new ProjectedStateSpace(state_space_spec, request_.path_constraints,
+                                                                       getPlanningScene()->getTransforms(),
+                                                                       *complete_initial_robot_state_));
+        if (projected_space->hasProjectedConstraints())
+            state_space_ = projected_space;
+        else
+            ROS_WARN("None of the path constraints can be projected.  Using the default parameterization");
+    }
+
+    if (distance_metric_ == "weighted")
+    {
+        WeightedJointDistancePtr metric(new WeightedJointDistance(state_space_spec.robot_model_, state_space_spec.joint_model_group_));
+        state_space_->setDistanceFunction(boost::bind(&WeightedJointDistance::distance, metric, _1, _2));
     }
+    else if (!distance_metric_.empty() && distance_metric_ != "default")
+        ROS_ERROR("Unknown distance metric '%s'.  Using the default metric", distance_metric_.c_str());
+
+    return state_space_;
+}
+
+void GeometricPlanningContext::allocateFastestStateSpace(const ModelBasedStateSpaceSpecification& state_space_spec)
+{
+    // The parameterizations that apply to the path constraints
+    std::map<std::string, ModelBasedStateSpacePtr> candidates;
+    candidates[JointModelStateSpace::PARAMETERIZATION_TYPE] = allocateJointModelStateSpace(state_space_spec, false);
+    if (canUsePoseModelStateSpace(state_space_spec.joint_model_group_))
+        candidates[PoseModelStateSpace::PARAMETERIZATION_TYPE].reset(new PoseModelStateSpace(state_space_spec));
+    ModelBasedStateSpacePtr projected = allocateJointModelStateSpace(state_space_spec, true);
+    if (dynamic_cast<const ProjectedStateSpace*>(projected.get()))
+        candidates[ProjectedStateSpace::PARAMETERIZATION_TYPE] = projected;
+
+    const std::string signature = ParameterizationTable::computeSignature(request_.path_constraints);
+    std::string fastest;
+    if (candidates.size() > 1 &&
+        (!getParameterizationTable()->getFastest(getGroupName(), signature, fastest, ParameterizationTable::RACES) ||
+         candidates.find(fastest) == candidates.end()))
+    {
+        // The samplers are raced from the start state, which is not known yet; plan in joint space until then
+        raced_state_spaces_ = candidates;
+        mbss_ = candidates[JointModelStateSpace::PARAMETERIZATION_TYPE];
+        return;
+    }
+
+    std::map<std::string, ModelBasedStateSpacePtr>::const_iterator it = candidates.find(fastest);
+    if (it == candidates.end())
+        it = candidates.find(JointModelStateSpace::PARAMETERIZATION_TYPE);
+    ROS_INFO("%s: Using the %s parameterization for path constraints '%s'", name_.c_str(), it->first.c_str(), signature.c_str());
+    mbss_ = it->second;
+}
+
+ParameterizationTablePtr GeometricPlanningContext::getParameterizationTable() const
+{
+    return ParameterizationTable::getShared(parameterization_table_.empty() ? ParameterizationTable::getDefaultPath() : parameterization_table_);
+}
+
+void GeometricPlanningContext::raceStateSpaces()
+{
+    const std::string signature = ParameterizationTable::computeSignature(request_.path_constraints);
+    ParameterizationTablePtr table = getParameterizationTable();
+    for (std::map<std::string, ModelBasedStateSpacePtr>::const_iterator it = raced_state_spaces_.begin() ; it != raced_state_spaces_.end() ; ++it)
+    {
+        double rate = measureConstrainedSamplingRate(it->second);
+        ROS_DEBUG("%s: The %s parameterization produced %.1f states per second satisfying the path constraints",
+                  name_.c_str(), it->first.c_str(), rate);
+        table->recordRace(getGroupName(), signature, it->first, rate);
+    }
+
+    std::string fastest;
+    table->getFastest(getGroupName(), signature, fastest, 0);
+    std::map<std::string, ModelBasedStateSpacePtr>::const_iterator it = raced_state_spaces_.find(fastest);
+    if (it == raced_state_spaces_.end())
+        it = raced_state_spaces_.find(JointModelStateSpace::PARAMETERIZATION_TYPE);
+    ROS_INFO("%s: Using the %s parameterization for path constraints '%s'", name_.c_str(), it->first.c_str(), signature.c_str());
+    ModelBasedStateSpacePtr fastest_space = it->second;
+    raced_state_spaces_.clear();
+
+    // The context was set up for the joint space in the meantime
+    if (fastest_space != mbss_)
+    {
+        mbss_ = fastest_space;
+        setupStateSpace();
+    }
+}
+
+double GeometricPlanningContext::measureConstrainedSamplingRate(const ModelBasedStateSpacePtr &state_space)
+{
+    // the sampler is allocated for the state space of the context
+    ModelBasedStateSpacePtr previous = mbss_;
+    mbss_ = state_space;
+    if (ProjectedStateSpace *projected_space = dynamic_cast<ProjectedStateSpace*>(mbss_.get()))
+        projected_space->setReferenceState(*complete_initial_robot_state_);
+    ompl::base::StateSamplerPtr sampler = allocPathConstrainedSampler(mbss_.get());
+    ompl::base::State *state = mbss_->allocState();
+    robot_state::RobotState rstate(*complete_initial_robot_state_);
+
+    unsigned int samples = 0;
+    unsigned int satisfied = 0;
+    ompl::time::point start = ompl::time::now();
+    double elapsed = 0.0;
+    while (elapsed < PARAMETERIZATION_RACE_TIME && samples < PARAMETERIZATION_RACE_SAMPLES)
+    {
+        sampler->sampleUniform(state);
+        ++samples;
+        // the samplers mark the states they know to be invalid (e.g., failed inverse kinematics)
+        const ModelBasedStateSpace::StateType *sample = state->as<ModelBasedStateSpace::StateType>();
+        if (!sample->isValidityKnown() || sample->isMarkedValid())
+        {
+            mbss_->copyToRobotState(rstate, state);
+            rstate.update();
+            if (path_constraints_->decide(rstate).satisfied)
+                ++satisfied;
+        }
+        elapsed = ompl::time::seconds(ompl::time::now() - start);
+    }
+
+    mbss_->freeState(state);
+    mbss_ = previous;
+    return elapsed > 0.0 ? satisfied / elapsed : 0.0;
 }
 
 ompl::base::StateSamplerPtr GeometricPlanningContext::allocPathConstrainedSampler(const ompl::base::StateSpace* ss) const
@@ -278,6 +672,13 @@ ompl::base::StateSamplerPtr GeometricPlanningContext::allocPathConstrainedSample
 
     ROS_DEBUG("%s: Allocating a new state sampler (attempts to use path constraints)", name_.c_str());
 
+    // The projected representation moves its own samples onto the path constraints
+    if (dynamic_cast<const ProjectedStateSpace*>(ss))
+    {
+        ROS_DEBUG("%s: Allocating projected state sampler for state space", name_.c_str());
+        return ss->allocDefaultStateSampler();
+    }
+
     //if (path_constraints_ && constraints_library_)
     if (path_constraints_)
     {
@@ -300,20 +701,72 @@ ompl::base::StateSamplerPtr GeometricPlanningContext::allocPathConstrainedSample
         if (cs)
         {
             ROS_INFO("%s: Allocating specialized state sampler for state space", name_.c_str());
-            return ompl::base::StateSamplerPtr(new ConstrainedSampler(this, cs));
+            return ompl::base::StateSamplerPtr(new ConstrainedSampler(this, cs, path_constraints_, constrained_sampler_statistics_));
         }
     }
+
+    // Each low-discrepancy sampler gets its own stream, numbered in order of allocation since the last solve
+    if (state_sampler_ == "halton" && dynamic_cast<const JointModelStateSpace*>(ss))
+    {
+        unsigned int stream;
+        {
+            boost::mutex::scoped_lock slock(sampler_stream_lock_);
+            stream = sampler_stream_++;
+        }
+        ROS_DEBUG("%s: Allocating Halton state sampler (stream %u) for state space", name_.c_str(), stream);
+        return ompl::base::StateSamplerPtr(new HaltonStateSampler(mbss_.get(), stream));
+    }
+
     ROS_DEBUG("%s: Allocating default state sampler for state space", name_.c_str());
     return ss->allocDefaultStateSampler();
 }
 
+ompl::base::ValidStateSamplerPtr GeometricPlanningContext::allocValidStateSampler(const ompl::base::SpaceInformation* si) const
+{
+    if (simple_setup_->getSpaceInformation().get() != si)
+    {
+        ROS_ERROR("%s: Attempted to allocate a valid state sampler for an unknown space information", name_.c_str());
+        return ompl::base::ValidStateSamplerPtr();
+    }
+
+    // The obstacle aware samplers draw their candidates from the (path constrained) state sampler
+    if (valid_state_sampler_ == "gaussian")
+        return ompl::base::ValidStateSamplerPtr(new GaussianValidSampler(this));
+    if (valid_state_sampler_ == "bridge_test")
+        return ompl::base::ValidStateSamplerPtr(new BridgeTestValidSampler(this));
+    if (valid_state_sampler_ == "obstacle_based")
+        return ompl::base::ValidStateSamplerPtr(new ObstacleBasedValidSampler(this));
+
+    // Roadmap planners draw many independent samples; the batches are filtered by the path constraints in bulk
+    if (valid_state_sampler_ == "batch")
+        return ompl::base::ValidStateSamplerPtr(new BatchValidStateSampler(this));
+
+    // The projected representation satisfies the path constraints with its state sampler already
+    if (valid_state_sampler_ != "uniform" && path_constraints_ && !dynamic_cast<const ProjectedStateSpace*>(mbss_.get()))
+    {
+        constraint_samplers::ConstraintSamplerPtr cs = constraint_sampler_manager_->selectSampler(getPlanningScene(), getGroupName(), path_constraints_->getAllConstraints());
+        if (cs)
+        {
+            ROS_DEBUG("%s: Allocating constrained valid state sampler", name_.c_str());
+            return ompl::base::ValidStateSamplerPtr(new ValidConstrainedSampler(this, path_constraints_, cs));
+        }
+    }
+
+    return ompl::base::ValidStateSamplerPtr(new ompl::base::UniformValidStateSampler(si));
+}
+
 void GeometricPlanningContext::clear()
 {
     simple_setup_->clear();
     simple_setup_->clearStartStates();
     simple_setup_->setGoal(ompl::base::GoalPtr());
     simple_setup_->setStateValidityChecker(ompl::base::StateValidityCheckerPtr());
+    simple_setup_->getProblemDefinition()->clearSolutionPaths();
     goal_constraints_.clear();
+
+    // with all states freed, the memory of the state pool can be released in bulk
+    if (!mbss_->releaseStateMemory())
+        ROS_DEBUG("States are still in use; not releasing the memory of the state pool");
 }
 
 void GeometricPlanningContext::preSolve()
@@ -322,6 +775,17 @@ void GeometricPlanningContext::preSolve()
     const ompl::base::PlannerPtr planner = simple_setup_->getPlanner();
     if(planner)
         planner->clear();
+    if (ik_cache_)
+        ik_cache_->resetStatistics();
+    if (PoseModelStateSpace *pose_space = dynamic_cast<PoseModelStateSpace*>(mbss_.get()))
+        pose_space->resetStatistics();
+    // every sample of this solve is counted from here on
+    constrained_sampler_statistics_->reset();
+    {
+        // the samplers allocated for this solve reproduce the streams of the previous one
+        boost::mutex::scoped_lock slock(sampler_stream_lock_);
+        sampler_stream_ = 0;
+    }
     startGoalSampling();
     simple_setup_->getSpaceInformation()->getMotionValidator()->resetMotionCounter();
 }
@@ -331,6 +795,24 @@ void GeometricPlanningContext::postSolve()
     stopGoalSampling();
     if (simple_setup_->getProblemDefinition()->hasApproximateSolution())
         ROS_WARN("Solution is approximate");
+    if (ik_cache_)
+    {
+        IKCache::Statistics stats = ik_cache_->getStatistics();
+        if (stats.lookups > 0)
+            ROS_INFO("IK cache: %u lookups, %u hits (%.1lf%%), %u seeded; %u IK calls took %lf seconds", stats.lookups, stats.hits,
+                     100.0 * (double)stats.hits / (double)stats.lookups, stats.seeds, stats.solver_calls, stats.solver_time);
+    }
+    if (const PoseModelStateSpace *pose_space = dynamic_cast<const PoseModelStateSpace*>(mbss_.get()))
+    {
+        PoseModelStateSpace::Statistics stats = pose_space->getStatistics();
+        ROS_DEBUG("%s: %u IK calls, %u interpolated states rejected for jumps in the joint values", name_.c_str(),
+                  stats.ik_calls, stats.jump_rejections);
+    }
+    ConstrainedSamplerStatistics::Counts counts = constrained_sampler_statistics_->getCounts();
+    if (counts.constrained_calls > 0)
+        ROS_INFO("Path constrained sampling: %u of %u constraint sampler calls succeeded in %lf seconds; %u of %u uniform samples satisfied the constraints in %lf seconds",
+                 counts.constrained_successes, counts.constrained_calls, counts.constrained_time,
+                 counts.uniform_satisfied, counts.uniform_samples, counts.uniform_time);
 }
 
 void GeometricPlanningContext::startGoalSampling()
@@ -643,6 +1125,11 @@ void GeometricPlanningContext::setCompleteInitialRobotState(const robot_state::R
     }
 
     *complete_initial_robot_state_ = state;
+    // The automatic parameterization races the samplers from this start state
+    if (!raced_state_spaces_.empty())
+        raceStateSpaces();
+    if (ProjectedStateSpace *projected_space = dynamic_cast<ProjectedStateSpace*>(mbss_.get()))
+        projected_space->setReferenceState(*complete_initial_robot_state_);
 
     // Start state
     ompl::base::ScopedState<> start_state(mbss_);
@@ -704,7 +1191,23 @@ bool GeometricPlanningContext::setGoalConstraints(const std::vector<moveit_msgs:
             cs = constraint_sampler_manager_->selectSampler(getPlanningScene(), getGroupName(), goal_constraints_[i]->getAllConstraints());
         if (cs)
         {
-            ompl::base::GoalPtr g = ompl::base::GoalPtr(new ConstrainedGoalSampler(this, goal_constraints_[i], cs));
+            // Every parallel worker needs a constraint sampler, and an inverse kinematics solver, of its own
+            std::vector<constraint_samplers::ConstraintSamplerPtr> worker_samplers;
+            for (unsigned int j = 0 ; goal_sampling_threads_ > 1 && j < goal_sampling_threads_ ; ++j)
+            {
+                constraint_samplers::ConstraintSamplerPtr wcs =
+                    worker_sampler_manager_->selectSampler(getPlanningScene(), getGroupName(), goal_constraints_[i]->getAllConstraints());
+                if (!dynamic_cast<WorkerIKConstraintSampler*>(wcs.get()))
+                {
+                    ROS_WARN("Goal constraints cannot be sampled by parallel workers.  Sampling goal states sequentially");
+                    worker_samplers.clear();
+                    break;
+                }
+                worker_samplers.push_back(wcs);
+            }
+            ompl::base::GoalPtr g = ompl::base::GoalPtr(new ConstrainedGoalSampler(this, goal_constraints_[i], cs, goal_sampling_attempts_,
+                                                                                   max_goal_samples_, goal_ik_attempts_, worker_samplers,
+                                                                                   use_goal_state_cache_ ? &GoalStateCache::getShared() : NULL));
             goals.push_back(g);
         }
         else
@@ -720,7 +1223,13 @@ bool GeometricPlanningContext::setGoalConstraints(const std::vector<moveit_msgs:
         if (goals.size() == 1)
             goal = goals[0];
         else
-            goal = ompl::base::GoalPtr(new GoalSampleableRegionMux(goals));
+        {
+            GoalSampleableRegionMux *mux = new GoalSampleableRegionMux(goals);
+            // goals closer to the start state are sampled more often
+            if (simple_setup_->getProblemDefinition()->getStartStateCount() > 0)
+                mux->setStartState(simple_setup_->getProblemDefinition()->getStartState(0));
+            goal = ompl::base::GoalPtr(mux);
+        }
 
         simple_setup_->setGoal(goal);
         return true;
@@ -735,6 +1244,11 @@ const kinematic_constraints::KinematicConstraintSetPtr& GeometricPlanningContext
     return path_constraints_;
 }
 
+ConstrainedSamplerStatistics::Counts GeometricPlanningContext::getConstrainedSamplingStatistics() const
+{
+    return constrained_sampler_statistics_->getCounts();
+}
+
 const robot_model::RobotModelConstPtr& GeometricPlanningContext::getRobotModel() const
 {
     return spec_.model;
@@ -750,7 +1264,12 @@ ompl::base::PlannerPtr GeometricPlanningContext::configurePlanner(const std::str
     std::map<std::string, PlannerAllocator>::const_iterator it = planner_allocators_.find(planner_name);
     // Allocating planner using planner allocator
     if (it != planner_allocators_.end())
-        return it->second(simple_setup_->getSpaceInformation(), spec_.name, params);
+    {
+        ompl::base::PlannerPtr planner = it->second(simple_setup_->getSpaceInformation(), spec_.name, params);
+        if (planner && !nearest_neighbors_.empty())
+            setPlannerNearestNeighbors(planner, nearest_neighbors_);
+        return planner;
+    }
 
     // No planner configured by this name
     ROS_WARN("No planner allocator found with name '%s'", planner_name.c_str());
@@ -157,6 +157,10 @@ planning_interface::PlanningContextPtr OMPLPlanningContextManager::getPlanningCo
 
         context->initialize(nh_.getNamespace(), spec);
 
+        // Set the start state first: it may change the state space of the context (automatic parameterization)
+        robot_state::RobotStatePtr start_state = planning_scene->getCurrentStateUpdated(req.start_state);
+        context->setCompleteInitialRobotState(start_state);
+
         const moveit_msgs::WorkspaceParameters &wparams = req.workspace_parameters;
         if (wparams.min_corner.x == wparams.max_corner.x && wparams.min_corner.x == 0.0 &&
             wparams.min_corner.y == wparams.max_corner.y && wparams.min_corner.y == 0.0 &&
@@ -171,10 +175,7 @@ planning_interface::PlanningContextPtr OMPLPlanningContextManager::getPlanningCo
                                                         wparams.min_corner.y, wparams.max_corner.y,
                                                         wparams.min_corner.z, wparams.max_corner.z);
 
-        // Set the start and goal states for this query
-        robot_state::RobotStatePtr start_state = planning_scene->getCurrentStateUpdated(req.start_state);
-        context->setCompleteInitialRobotState(start_state);
-
+        // Set the goal states for this query
         if (!context->setGoalConstraints(req.goal_constraints, &error_code))
             return planning_interface::PlanningContextPtr();
     }
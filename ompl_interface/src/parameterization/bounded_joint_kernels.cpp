@@ -0,0 +1,192 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/parameterization/bounded_joint_kernels.h"
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <cmath>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+bool ompl_interface::BoundedJointKernels::isApplicable(const robot_model::JointModelGroup *group,
+                                                       const robot_model::JointBoundsVector &bounds)
+{
+  if (!group->getMimicJointModels().empty())
+    return false;
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  if (joints.size() != group->getVariableCount() || bounds.size() != joints.size())
+    return false;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    if (joints[i]->getType() == robot_model::JointModel::REVOLUTE)
+    {
+      if (static_cast<const robot_model::RevoluteJointModel*>(joints[i])->isContinuous())
+        return false;
+    }
+    else
+      if (joints[i]->getType() != robot_model::JointModel::PRISMATIC)
+        return false;
+    if (bounds[i]->size() != 1 || group->getVariableGroupIndex(joints[i]->getName()) != (int)i)
+      return false;
+  }
+  return true;
+}
+
+ompl_interface::BoundedJointKernels::BoundedJointKernels(const robot_model::JointModelGroup *group,
+                                                         const robot_model::JointBoundsVector &bounds, double margin)
+  : size_(bounds.size())
+  , factors_(size_)
+  , lower_(size_)
+  , upper_(size_)
+  , lower_margin_(size_)
+  , upper_margin_(size_)
+{
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  for (std::size_t i = 0 ; i < size_ ; ++i)
+  {
+    factors_[i] = joints[i]->getDistanceFactor();
+    lower_[i] = (*bounds[i])[0].min_position_;
+    upper_[i] = (*bounds[i])[0].max_position_;
+    lower_margin_[i] = lower_[i] - margin;
+    upper_margin_[i] = upper_[i] + margin;
+  }
+}
+
+double ompl_interface::BoundedJointKernels::distance(const double *state1, const double *state2) const
+{
+  // the weighted differences are computed in parallel, but summed in order, as the generic implementation does
+  double d = 0.0;
+  std::size_t i = 0;
+#if defined(__AVX__)
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  double terms[4];
+  for ( ; i + 4 <= size_ ; i += 4)
+  {
+    __m256d diff = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(state1 + i), _mm256_loadu_pd(state2 + i)));
+    _mm256_storeu_pd(terms, _mm256_mul_pd(_mm256_loadu_pd(&factors_[i]), diff));
+    d += terms[0];
+    d += terms[1];
+    d += terms[2];
+    d += terms[3];
+  }
+#elif defined(__SSE2__)
+  const __m128d sign = _mm_set1_pd(-0.0);
+  double terms[2];
+  for ( ; i + 2 <= size_ ; i += 2)
+  {
+    __m128d diff = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(state1 + i), _mm_loadu_pd(state2 + i)));
+    _mm_storeu_pd(terms, _mm_mul_pd(_mm_loadu_pd(&factors_[i]), diff));
+    d += terms[0];
+    d += terms[1];
+  }
+#endif
+  for ( ; i < size_ ; ++i)
+    d += factors_[i] * fabs(state1[i] - state2[i]);
+  return d;
+}
+
+void ompl_interface::BoundedJointKernels::interpolate(const double *from, const double *to, double t, double *state) const
+{
+  std::size_t i = 0;
+#if defined(__AVX__)
+  const __m256d vt = _mm256_set1_pd(t);
+  for ( ; i + 4 <= size_ ; i += 4)
+  {
+    __m256d f = _mm256_loadu_pd(from + i);
+    _mm256_storeu_pd(state + i, _mm256_add_pd(f, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(to + i), f), vt)));
+  }
+#elif defined(__SSE2__)
+  const __m128d vt = _mm_set1_pd(t);
+  for ( ; i + 2 <= size_ ; i += 2)
+  {
+    __m128d f = _mm_loadu_pd(from + i);
+    _mm_storeu_pd(state + i, _mm_add_pd(f, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(to + i), f), vt)));
+  }
+#endif
+  for ( ; i < size_ ; ++i)
+    state[i] = from[i] + (to[i] - from[i]) * t;
+}
+
+bool ompl_interface::BoundedJointKernels::satisfiesBounds(const double *values) const
+{
+  // like the generic implementation, a value is rejected only if it compares outside the bounds (NaN is not)
+  std::size_t i = 0;
+#if defined(__AVX__)
+  for ( ; i + 4 <= size_ ; i += 4)
+  {
+    __m256d v = _mm256_loadu_pd(values + i);
+    __m256d out = _mm256_or_pd(_mm256_cmp_pd(v, _mm256_loadu_pd(&lower_margin_[i]), _CMP_LT_OQ),
+                               _mm256_cmp_pd(v, _mm256_loadu_pd(&upper_margin_[i]), _CMP_GT_OQ));
+    if (_mm256_movemask_pd(out))
+      return false;
+  }
+#elif defined(__SSE2__)
+  for ( ; i + 2 <= size_ ; i += 2)
+  {
+    __m128d v = _mm_loadu_pd(values + i);
+    __m128d out = _mm_or_pd(_mm_cmplt_pd(v, _mm_loadu_pd(&lower_margin_[i])), _mm_cmpgt_pd(v, _mm_loadu_pd(&upper_margin_[i])));
+    if (_mm_movemask_pd(out))
+      return false;
+  }
+#endif
+  for ( ; i < size_ ; ++i)
+    if (values[i] < lower_margin_[i] || values[i] > upper_margin_[i])
+      return false;
+  return true;
+}
+
+void ompl_interface::BoundedJointKernels::enforceBounds(double *values) const
+{
+  // min/max return their second operand when one operand is NaN; the value is passed second so NaN is kept
+  std::size_t i = 0;
+#if defined(__AVX__)
+  for ( ; i + 4 <= size_ ; i += 4)
+    _mm256_storeu_pd(values + i, _mm256_max_pd(_mm256_loadu_pd(&lower_[i]),
+                                               _mm256_min_pd(_mm256_loadu_pd(&upper_[i]), _mm256_loadu_pd(values + i))));
+#elif defined(__SSE2__)
+  for ( ; i + 2 <= size_ ; i += 2)
+    _mm_storeu_pd(values + i, _mm_max_pd(_mm_loadu_pd(&lower_[i]), _mm_min_pd(_mm_loadu_pd(&upper_[i]), _mm_loadu_pd(values + i))));
+#endif
+  for ( ; i < size_ ; ++i)
+  {
+    if (values[i] < lower_[i])
+      values[i] = lower_[i];
+    else
+      if (values[i] > upper_[i])
+        values[i] = upper_[i];
+  }
+}
@@ -35,7 +35,11 @@
 /* Author: Ioan Sucan */
 
 #include "moveit/ompl_interface/parameterization/model_based_state_space.h"
+#include <moveit/robot_model/revolute_joint_model.h>
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <new>
 
 ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(const ModelBasedStateSpaceSpecification &spec)
   : ompl::base::StateSpace()
@@ -46,6 +50,9 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(const ModelBasedState
   variable_count_ = spec_.joint_model_group_->getVariableCount();
   state_values_size_ = variable_count_ * sizeof(double);
   joint_model_vector_ = spec_.joint_model_group_->getActiveJointModels();
+  dimension_ = 0;
+  for (std::size_t i = 0 ; i < joint_model_vector_.size() ; ++i)
+    dimension_ += joint_model_vector_[i]->getStateSpaceDimension();
 
   // make sure we have bounds for every joint stored within the spec (use default bounds if not specified)
   if (!spec_.joint_bounds_.empty() && spec_.joint_bounds_.size() != joint_model_vector_.size())
@@ -67,8 +74,16 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(const ModelBasedState
     spec_.joint_bounds_[i] = &joint_bounds_storage_[i];
   }
 
+  // specialized operations for the common case of arms
+  if (BoundedJointKernels::isApplicable(spec_.joint_model_group_, spec_.joint_bounds_))
+    kernels_.reset(new BoundedJointKernels(spec_.joint_model_group_, spec_.joint_bounds_, std::numeric_limits<double>::epsilon()));
+
+  // the values are stored right after the state, in the same block
+  state_pool_.reset(new StatePool(StatePool::align(sizeof(StateType)) + state_values_size_));
+
   // default settings
   setTagSnapToSegment(0.95);
+  setSerializationFormat(SERIALIZE_RAW);
 
   /// expose parameters
   params_.declareParam<double>("tag_snap_to_segment",
@@ -98,15 +113,22 @@ void ompl_interface::ModelBasedStateSpace::setTagSnapToSegment(double snap)
 
 ompl::base::State* ompl_interface::ModelBasedStateSpace::allocState() const
 {
-  StateType *state = new StateType();
-  state->values = new double[variable_count_];
+  char *block = static_cast<char*>(state_pool_->allocate());
+  StateType *state = new (block) StateType();
+  state->values = reinterpret_cast<double*>(block + StatePool::align(sizeof(StateType)));
   return state;
 }
 
 void ompl_interface::ModelBasedStateSpace::freeState(ompl::base::State *state) const
 {
-  delete[] state->as<StateType>()->values;
-  delete state->as<StateType>();
+  StateType *s = state->as<StateType>();
+  s->~StateType();
+  state_pool_->free(s);
+}
+
+bool ompl_interface::ModelBasedStateSpace::releaseStateMemory()
+{
+  return state_pool_->release();
 }
 
 void ompl_interface::ModelBasedStateSpace::copyState(ompl::base::State *destination, const ompl::base::State *source) const
@@ -117,29 +139,145 @@ void ompl_interface::ModelBasedStateSpace::copyState(ompl::base::State *destinat
   destination->as<StateType>()->distance = source->as<StateType>()->distance;
 }
 
+namespace
+{
+// marker of the serialization format in the space signature
+const int SERIALIZATION_SIGNATURE = 0x5e7a0000;
+const int SERIALIZATION_VERSION = 1;
+
+template<typename T>
+void writeValue(char *&serialization, T value)
+{
+  memcpy(serialization, &value, sizeof(T));
+  serialization += sizeof(T);
+}
+
+template<typename T>
+T readValue(const char *&serialization)
+{
+  T value;
+  memcpy(&value, serialization, sizeof(T));
+  serialization += sizeof(T);
+  return value;
+}
+}
+
+void ompl_interface::ModelBasedStateSpace::setSerializationFormat(SerializationFormat format)
+{
+  serialization_format_ = format;
+  quantization_.assign(variable_count_, std::make_pair(0.0, 0.0));
+  quantization_wraps_.assign(variable_count_, false);
+  serialization_length_ = sizeof(int);
+  if (format == SERIALIZE_RAW)
+  {
+    serialization_length_ += state_values_size_;
+    return;
+  }
+
+  const double steps = format == SERIALIZE_QUANTIZED_16 ? 65535.0 : 4294967295.0;
+  const unsigned int size = format == SERIALIZE_QUANTIZED_16 ? sizeof(boost::uint16_t) : sizeof(boost::uint32_t);
+
+  // the bounds of the active joints come from the specification, those of the mimic joints from the model
+  std::map<const robot_model::JointModel*, const robot_model::JointModel::Bounds*> bounds;
+  for (std::size_t i = 0 ; i < joint_model_vector_.size() ; ++i)
+    bounds[joint_model_vector_[i]] = spec_.joint_bounds_[i];
+  const std::vector<const robot_model::JointModel*> &joints = spec_.joint_model_group_->getJointModels();
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    const std::vector<std::string> &names = joints[i]->getVariableNames();
+    const robot_model::JointModel::Bounds &b = bounds.count(joints[i]) ? *bounds[joints[i]] : joints[i]->getVariableBounds();
+    bool continuous = joints[i]->getType() == robot_model::JointModel::REVOLUTE &&
+      static_cast<const robot_model::RevoluteJointModel*>(joints[i])->isContinuous();
+    for (std::size_t j = 0 ; j < names.size() ; ++j)
+    {
+      int index = spec_.joint_model_group_->getVariableGroupIndex(names[j]);
+      if (index < 0 || index >= (int)variable_count_)
+        continue;
+      if ((b[j].position_bounded_ || continuous) && b[j].max_position_ > b[j].min_position_ &&
+          b[j].max_position_ - b[j].min_position_ < std::numeric_limits<double>::max())
+      {
+        quantization_[index] = std::make_pair(b[j].min_position_, (b[j].max_position_ - b[j].min_position_) / steps);
+        quantization_wraps_[index] = continuous;
+      }
+    }
+  }
+
+  for (unsigned int i = 0 ; i < variable_count_ ; ++i)
+    serialization_length_ += quantization_[i].second > 0.0 ? size : sizeof(double);
+}
+
+void ompl_interface::ModelBasedStateSpace::computeSignature(std::vector<int> &signature) const
+{
+  ompl::base::StateSpace::computeSignature(signature);
+  if (serialization_format_ != SERIALIZE_RAW)
+  {
+    signature.push_back(SERIALIZATION_SIGNATURE + SERIALIZATION_VERSION * 16 + (int)serialization_format_);
+    signature[0] = signature.size() - 1;
+  }
+}
+
 unsigned int ompl_interface::ModelBasedStateSpace::getSerializationLength() const
 {
-  return state_values_size_ + sizeof(int);
+  return serialization_length_;
 }
 
 void ompl_interface::ModelBasedStateSpace::serialize(void *serialization, const ompl::base::State *state) const
 {
-  *reinterpret_cast<int*>(serialization) = state->as<StateType>()->tag;
-  memcpy(reinterpret_cast<char*>(serialization) + sizeof(int), state->as<StateType>()->values, state_values_size_);
+  char *out = reinterpret_cast<char*>(serialization);
+  writeValue<int>(out, state->as<StateType>()->tag);
+  const double *values = state->as<StateType>()->values;
+  if (serialization_format_ == SERIALIZE_RAW)
+  {
+    memcpy(out, values, state_values_size_);
+    return;
+  }
+
+  for (unsigned int i = 0 ; i < variable_count_ ; ++i)
+  {
+    const double step = quantization_[i].second;
+    if (step <= 0.0)
+    {
+      writeValue<double>(out, values[i]);
+      continue;
+    }
+    double v = values[i];
+    if (quantization_wraps_[i])
+      v = quantization_[i].first + fmod(fmod(v - quantization_[i].first, 2.0 * boost::math::constants::pi<double>()) +
+                                        2.0 * boost::math::constants::pi<double>(), 2.0 * boost::math::constants::pi<double>());
+    double q = floor((v - quantization_[i].first) / step + 0.5);
+    if (serialization_format_ == SERIALIZE_QUANTIZED_16)
+      writeValue<boost::uint16_t>(out, (boost::uint16_t)std::min(std::max(q, 0.0), 65535.0));
+    else
+      writeValue<boost::uint32_t>(out, (boost::uint32_t)std::min(std::max(q, 0.0), 4294967295.0));
+  }
 }
 
 void ompl_interface::ModelBasedStateSpace::deserialize(ompl::base::State *state, const void *serialization) const
 {
-  state->as<StateType>()->tag = *reinterpret_cast<const int*>(serialization);
-  memcpy(state->as<StateType>()->values, reinterpret_cast<const char*>(serialization) + sizeof(int), state_values_size_);
+  const char *in = reinterpret_cast<const char*>(serialization);
+  state->as<StateType>()->tag = readValue<int>(in);
+  double *values = state->as<StateType>()->values;
+  if (serialization_format_ == SERIALIZE_RAW)
+  {
+    memcpy(values, in, state_values_size_);
+    return;
+  }
+
+  for (unsigned int i = 0 ; i < variable_count_ ; ++i)
+  {
+    const double step = quantization_[i].second;
+    if (step <= 0.0)
+      values[i] = readValue<double>(in);
+    else if (serialization_format_ == SERIALIZE_QUANTIZED_16)
+      values[i] = quantization_[i].first + readValue<boost::uint16_t>(in) * step;
+    else
+      values[i] = quantization_[i].first + readValue<boost::uint32_t>(in) * step;
+  }
 }
 
 unsigned int ompl_interface::ModelBasedStateSpace::getDimension() const
 {
-  unsigned int d = 0;
-  for (std::size_t i = 0 ; i < joint_model_vector_.size() ; ++i)
-    d += joint_model_vector_[i]->getStateSpaceDimension();
-  return d;
+  return dimension_;
 }
 
 double ompl_interface::ModelBasedStateSpace::getMaximumExtent() const
@@ -166,7 +304,10 @@ double ompl_interface::ModelBasedStateSpace::distance(const ompl::base::State *s
   if (distance_function_)
     return distance_function_(state1, state2);
   else
-    return spec_.joint_model_group_->distance(state1->as<StateType>()->values, state2->as<StateType>()->values);
+    if (kernels_)
+      return kernels_->distance(state1->as<StateType>()->values, state2->as<StateType>()->values);
+    else
+      return spec_.joint_model_group_->distance(state1->as<StateType>()->values, state2->as<StateType>()->values);
 }
 
 bool ompl_interface::ModelBasedStateSpace::equalStates(const ompl::base::State *state1, const ompl::base::State *state2) const
@@ -179,11 +320,16 @@ bool ompl_interface::ModelBasedStateSpace::equalStates(const ompl::base::State *
 
 void ompl_interface::ModelBasedStateSpace::enforceBounds(ompl::base::State *state) const
 {
-  spec_.joint_model_group_->enforcePositionBounds(state->as<StateType>()->values, spec_.joint_bounds_);
+  if (kernels_)
+    kernels_->enforceBounds(state->as<StateType>()->values);
+  else
+    spec_.joint_model_group_->enforcePositionBounds(state->as<StateType>()->values, spec_.joint_bounds_);
 }
 
 bool ompl_interface::ModelBasedStateSpace::satisfiesBounds(const ompl::base::State *state) const
 {
+  if (kernels_)
+    return kernels_->satisfiesBounds(state->as<StateType>()->values);
   return spec_.joint_model_group_->satisfiesPositionBounds(state->as<StateType>()->values, spec_.joint_bounds_, std::numeric_limits<double>::epsilon());
 }
 
@@ -195,19 +341,27 @@ void ompl_interface::ModelBasedStateSpace::interpolate(const ompl::base::State *
   if (!interpolation_function_ || !interpolation_function_(from, to, t, state))
   {
     // perform the actual interpolation
-    spec_.joint_model_group_->interpolate(from->as<StateType>()->values, to->as<StateType>()->values, t, state->as<StateType>()->values);
+    if (kernels_)
+      kernels_->interpolate(from->as<StateType>()->values, to->as<StateType>()->values, t, state->as<StateType>()->values);
+    else
+      spec_.joint_model_group_->interpolate(from->as<StateType>()->values, to->as<StateType>()->values, t, state->as<StateType>()->values);
 
     // compute tag
-    if (from->as<StateType>()->tag >= 0 && t < 1.0 - tag_snap_to_segment_)
-      state->as<StateType>()->tag = from->as<StateType>()->tag;
-    else
-      if (to->as<StateType>()->tag >= 0 && t > tag_snap_to_segment_)
-        state->as<StateType>()->tag = to->as<StateType>()->tag;
-    else
-      state->as<StateType>()->tag = -1;
+    interpolateTag(from, to, t, state);
   }
 }
 
+void ompl_interface::ModelBasedStateSpace::interpolateTag(const ompl::base::State *from, const ompl::base::State *to, const double t, ompl::base::State *state) const
+{
+  if (from->as<StateType>()->tag >= 0 && t < 1.0 - tag_snap_to_segment_)
+    state->as<StateType>()->tag = from->as<StateType>()->tag;
+  else
+    if (to->as<StateType>()->tag >= 0 && t > tag_snap_to_segment_)
+      state->as<StateType>()->tag = to->as<StateType>()->tag;
+  else
+    state->as<StateType>()->tag = -1;
+}
+
 double* ompl_interface::ModelBasedStateSpace::getValueAddressAtIndex(ompl::base::State *state, const unsigned int index) const
 {
   if (index >= variable_count_)
@@ -0,0 +1,324 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/parameterization/projected_space/projected_state_space.h"
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <limits>
+
+const std::string ompl_interface::ProjectedStateSpace::PARAMETERIZATION_TYPE = "ProjectedModel";
+
+namespace
+{
+// Newton iterations before a state is given up on
+const unsigned int PROJECTION_ITERATIONS = 20;
+// Samples drawn before the sampler returns a state that could not be projected
+const unsigned int PROJECTION_ATTEMPTS = 10;
+// Largest change of a joint value in a single iteration
+const double MAX_STEP = 0.5;
+// Damping of the least squares step, for configurations near a singularity
+const double DAMPING = 1e-4;
+// Orientations are projected to within this fraction of the tolerances of the constraint
+const double TOLERANCE_MARGIN = 0.9;
+// An interpolated state is rejected if the path through it is longer than this factor times the distance between
+// the ends of the segment, or than MIN_JUMP_DISTANCE for short segments
+const double JUMP_FACTOR = 3.0;
+const double MIN_JUMP_DISTANCE = 0.2;
+
+Eigen::Vector3d rotationVector(const Eigen::Matrix3d &rotation)
+{
+  Eigen::AngleAxisd aa(rotation);
+  return aa.angle() * aa.axis();
+}
+
+Eigen::Matrix3d rotationMatrix(const Eigen::Vector3d &rotation_vector)
+{
+  double angle = rotation_vector.norm();
+  if (angle < std::numeric_limits<double>::epsilon())
+    return Eigen::Matrix3d::Identity();
+  return Eigen::AngleAxisd(angle, rotation_vector / angle).toRotationMatrix();
+}
+}
+
+ompl_interface::ProjectedStateSpace::ProjectedStateSpace(const ModelBasedStateSpaceSpecification &spec, const moveit_msgs::Constraints &constraints,
+                                                         const robot_state::Transforms &tf, const robot_state::RobotState &reference_state)
+  : JointModelStateSpace(spec)
+  , jump_factor_(JUMP_FACTOR)
+{
+  setName(getName() + "_" + PARAMETERIZATION_TYPE);
+
+  const robot_model::JointModelGroup *group = spec.joint_model_group_;
+  if (!group->isChain())
+    logWarn("Group '%s' is not a chain. Constraints on link poses cannot be projected", group->getName().c_str());
+
+  for (std::size_t i = 0 ; i < constraints.position_constraints.size() ; ++i)
+  {
+    kinematic_constraints::PositionConstraintPtr pc(new kinematic_constraints::PositionConstraint(spec.robot_model_));
+    if (!group->isChain() || !pc->configure(constraints.position_constraints[i], tf))
+      continue;
+    if (pc->mobileReferenceFrame() || !group->isLinkUpdated(pc->getLinkModel()->getName()))
+    {
+      logWarn("The position constraint on link '%s' is not projected (it is only checked for validity)", pc->getLinkModel()->getName().c_str());
+      continue;
+    }
+    position_constraints_.push_back(pc);
+  }
+
+  for (std::size_t i = 0 ; i < constraints.orientation_constraints.size() ; ++i)
+  {
+    kinematic_constraints::OrientationConstraintPtr oc(new kinematic_constraints::OrientationConstraint(spec.robot_model_));
+    if (!group->isChain() || !oc->configure(constraints.orientation_constraints[i], tf))
+      continue;
+    if (oc->mobileReferenceFrame() || !group->isLinkUpdated(oc->getLinkModel()->getName()))
+    {
+      logWarn("The orientation constraint on link '%s' is not projected (it is only checked for validity)", oc->getLinkModel()->getName().c_str());
+      continue;
+    }
+    orientation_constraints_.push_back(oc);
+  }
+
+  const std::vector<std::string> &variables = group->getVariableNames();
+  for (std::size_t i = 0 ; i < constraints.joint_constraints.size() ; ++i)
+  {
+    kinematic_constraints::JointConstraintPtr jc(new kinematic_constraints::JointConstraint(spec.robot_model_));
+    if (!jc->configure(constraints.joint_constraints[i]))
+      continue;
+    std::vector<std::string>::const_iterator it = std::find(variables.begin(), variables.end(), jc->getJointVariableName());
+    if (it == variables.end())
+      continue;
+    joint_constraints_.push_back(jc);
+    joint_constraint_index_.push_back(it - variables.begin());
+  }
+
+  // the Jacobian of a robot state is expressed in the frame of the link the group is attached to
+  base_link_ = group->getJointModels().empty() ? NULL : group->getJointModels()[0]->getParentLinkModel();
+
+  setReferenceState(reference_state);
+}
+
+void ompl_interface::ProjectedStateSpace::setReferenceState(const robot_state::RobotState &reference_state)
+{
+  workspaces_.reset(new ThreadLocalStorage<Workspace>(Workspace(reference_state)));
+}
+
+void ompl_interface::ProjectedStateSpace::clampJointConstraints(ompl::base::State *state) const
+{
+  double *values = state->as<StateType>()->values;
+  for (std::size_t i = 0 ; i < joint_constraints_.size() ; ++i)
+  {
+    const kinematic_constraints::JointConstraint &jc = *joint_constraints_[i];
+    double &value = values[joint_constraint_index_[i]];
+    double dif = value - jc.getDesiredJointPosition();
+    const robot_model::JointModel *joint = jc.getJointModel();
+    if (joint->getType() == robot_model::JointModel::REVOLUTE && static_cast<const robot_model::RevoluteJointModel*>(joint)->isContinuous())
+    {
+      // measure the shortest way around; the bounds of the space normalize the value afterwards
+      const double pi = boost::math::constants::pi<double>();
+      dif = dif - 2.0 * pi * floor((dif + pi) / (2.0 * pi));
+    }
+    value = jc.getDesiredJointPosition() + std::max(-jc.getJointToleranceBelow(), std::min(dif, jc.getJointToleranceAbove()));
+  }
+}
+
+unsigned int ompl_interface::ProjectedStateSpace::computeResidual(Workspace &ws) const
+{
+  const robot_model::JointModelGroup *group = spec_.joint_model_group_;
+  const robot_state::RobotState &rstate = ws.state;
+  const unsigned int columns = group->getVariableCount();
+  const Eigen::Matrix3d to_base = base_link_ ? Eigen::Matrix3d(rstate.getGlobalLinkTransform(base_link_).rotation().transpose()) : Eigen::Matrix3d::Identity();
+
+  // the sizes do not change, so the buffers are only allocated on the first call of a thread
+  ws.error.resize(3 * (position_constraints_.size() + orientation_constraints_.size()));
+  ws.jacobian.resize(ws.error.size(), columns);
+  ws.error.setZero();
+  ws.jacobian.setZero();
+  unsigned int rows = 0;
+
+  for (std::size_t i = 0 ; i < position_constraints_.size() ; ++i)
+  {
+    const kinematic_constraints::PositionConstraint &pc = *position_constraints_[i];
+    if (pc.decide(rstate).satisfied)
+      continue;
+    // without a Jacobian the residual stays, so the projection fails instead of ignoring the constraint
+    if (!rstate.getJacobian(group, pc.getLinkModel(), pc.getLinkOffset(), ws.link_jacobian))
+      ws.link_jacobian.setZero(6, columns);
+
+    // pull the constrained point towards the center of the closest region
+    const Eigen::Vector3d point = rstate.getGlobalLinkTransform(pc.getLinkModel()) * pc.getLinkOffset();
+    const std::vector<bodies::BodyPtr> &regions = pc.getConstraintRegions();
+    Eigen::Vector3d target = point;
+    double closest = std::numeric_limits<double>::infinity();
+    for (std::size_t j = 0 ; j < regions.size() ; ++j)
+    {
+      double d = (regions[j]->getPose().translation() - point).squaredNorm();
+      if (d < closest)
+      {
+        closest = d;
+        target = regions[j]->getPose().translation();
+      }
+    }
+
+    const unsigned int row = 3 * i;
+    ws.error.segment<3>(row) = to_base * (target - point);
+    ws.jacobian.block(row, 0, 3, columns) = ws.link_jacobian.topRows(3);
+    rows += 3;
+  }
+
+  for (std::size_t i = 0 ; i < orientation_constraints_.size() ; ++i)
+  {
+    const kinematic_constraints::OrientationConstraint &oc = *orientation_constraints_[i];
+    if (oc.decide(rstate).satisfied)
+      continue;
+    if (!rstate.getJacobian(group, oc.getLinkModel(), Eigen::Vector3d::Zero(), ws.link_jacobian))
+      ws.link_jacobian.setZero(6, columns);
+
+    // the deviation from the desired orientation, clamped to the tolerances about each axis
+    const Eigen::Matrix3d &desired = oc.getDesiredRotationMatrix();
+    const Eigen::Matrix3d current = rstate.getGlobalLinkTransform(oc.getLinkModel()).rotation();
+    const Eigen::Vector3d deviation = rotationVector(desired.transpose() * current);
+    const Eigen::Vector3d tolerance = TOLERANCE_MARGIN * Eigen::Vector3d(oc.getXAxisTolerance(), oc.getYAxisTolerance(), oc.getZAxisTolerance());
+    Eigen::Vector3d allowed = deviation.cwiseMax(-tolerance).cwiseMin(tolerance);
+    // within the tolerances by this measure, but not by the Euler angles the constraint checks
+    if ((allowed - deviation).squaredNorm() < std::numeric_limits<double>::epsilon())
+      allowed = 0.5 * deviation;
+
+    const unsigned int row = 3 * (position_constraints_.size() + i);
+    ws.error.segment<3>(row) = to_base * rotationVector(desired * rotationMatrix(allowed) * current.transpose());
+    ws.jacobian.block(row, 0, 3, columns) = ws.link_jacobian.bottomRows(3);
+    rows += 3;
+  }
+
+  return rows;
+}
+
+bool ompl_interface::ProjectedStateSpace::project(ompl::base::State *state) const
+{
+  Workspace &ws = *workspaces_->get();
+  double *values = state->as<StateType>()->values;
+
+  for (unsigned int i = 0 ; ; ++i)
+  {
+    clampJointConstraints(state);
+    enforceBounds(state);
+    copyToRobotState(ws.state, state);
+    if (computeResidual(ws) == 0)
+      return true;
+    if (i == PROJECTION_ITERATIONS)
+      break;
+
+    // damped least squares step towards the constraints; the zero rows of the satisfied constraints do not move it
+    ws.jjt.noalias() = ws.jacobian * ws.jacobian.transpose();
+    ws.jjt.diagonal().array() += DAMPING;
+    ws.ldlt.compute(ws.jjt);
+    ws.solution = ws.error;
+    ws.ldlt.solveInPlace(ws.solution);
+    ws.step.noalias() = ws.jacobian.transpose() * ws.solution;
+    double largest = ws.step.cwiseAbs().maxCoeff();
+    if (largest > MAX_STEP)
+      ws.step *= MAX_STEP / largest;
+    for (unsigned int j = 0 ; j < ws.step.size() ; ++j)
+      values[j] += ws.step[j];
+  }
+
+  state->as<StateType>()->markInvalid();
+  return false;
+}
+
+void ompl_interface::ProjectedStateSpace::interpolate(const ompl::base::State *from, const ompl::base::State *to, const double t, ompl::base::State *state) const
+{
+  JointModelStateSpace::interpolate(from, to, t, state);
+  if (!project(state))
+    return;
+
+  // if the projection moved the state away from the segment it was interpolated on
+  double dj = jump_factor_ * distance(from, to);
+  double d_from = distance(from, state);
+  double d_to = distance(state, to);
+  if (d_from + d_to > std::max(MIN_JUMP_DISTANCE, dj))
+    state->as<StateType>()->markInvalid();
+}
+
+ompl::base::StateSamplerPtr ompl_interface::ProjectedStateSpace::allocDefaultStateSampler() const
+{
+  class ProjectedStateSampler : public ompl::base::StateSampler
+  {
+  public:
+
+    ProjectedStateSampler(const ProjectedStateSpace *space, const ompl::base::StateSamplerPtr &sampler)
+      : ompl::base::StateSampler(space)
+      , projected_space_(space)
+      , sampler_(sampler)
+    {
+    }
+
+    virtual void sampleUniform(ompl::base::State *state)
+    {
+      for (unsigned int i = 0 ; i < PROJECTION_ATTEMPTS ; ++i)
+      {
+        sampler_->sampleUniform(state);
+        if (projected_space_->project(state))
+          break;
+      }
+    }
+
+    virtual void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, const double distance)
+    {
+      for (unsigned int i = 0 ; i < PROJECTION_ATTEMPTS ; ++i)
+      {
+        sampler_->sampleUniformNear(state, near, distance);
+        if (projected_space_->project(state))
+          break;
+      }
+    }
+
+    virtual void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, const double stdDev)
+    {
+      for (unsigned int i = 0 ; i < PROJECTION_ATTEMPTS ; ++i)
+      {
+        sampler_->sampleGaussian(state, mean, stdDev);
+        if (projected_space_->project(state))
+          break;
+      }
+    }
+
+  private:
+
+    const ProjectedStateSpace  *projected_space_;
+    ompl::base::StateSamplerPtr sampler_;
+  };
+
+  return ompl::base::StateSamplerPtr(new ProjectedStateSampler(this, JointModelStateSpace::allocDefaultStateSampler()));
+}
@@ -0,0 +1,106 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "moveit/ompl_interface/parameterization/weighted_joint_distance.h"
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <ompl/util/Console.h>
+#include <limits>
+
+ompl_interface::WeightedJointDistance::WeightedJointDistance(const robot_model::RobotModelConstPtr &robot_model,
+                                                             const robot_model::JointModelGroup *group)
+{
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  double total = 0.0;
+  unsigned int revolute = 0;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    joints_.push_back(joints[i]);
+    indices_.push_back(group->getVariableGroupIndex(joints[i]->getVariableNames()[0]));
+    double radius = 1.0;
+    if (joints[i]->getType() == robot_model::JointModel::REVOLUTE)
+    {
+      radius = sweptRadius(joints[i], state);
+      total += radius;
+      ++revolute;
+    }
+    weights_.push_back(radius);
+  }
+
+  // the revolute joints average a unit weight
+  double scale = revolute > 0 && total > std::numeric_limits<double>::epsilon() ? revolute / total : 1.0;
+  for (std::size_t i = 0 ; i < joints_.size() ; ++i)
+  {
+    if (joints_[i]->getType() == robot_model::JointModel::REVOLUTE)
+      weights_[i] = std::max(weights_[i] * scale, 1e-3);
+    logDebug("Distance weight of joint '%s' in group '%s': %lf", joints_[i]->getName().c_str(),
+             group->getName().c_str(), weights_[i]);
+    weights_[i] *= joints_[i]->getDistanceFactor();
+  }
+}
+
+double ompl_interface::WeightedJointDistance::sweptRadius(const robot_model::JointModel *joint, const robot_state::RobotState &state)
+{
+  // the axis of the joint, in the model frame
+  const Eigen::Affine3d &frame = state.getGlobalLinkTransform(joint->getChildLinkModel());
+  const Eigen::Vector3d origin = frame.translation();
+  const Eigen::Vector3d axis = frame.linear() * static_cast<const robot_model::RevoluteJointModel*>(joint)->getAxis().normalized();
+
+  double radius = 0.0;
+  const std::vector<const robot_model::LinkModel*> &links = joint->getDescendantLinkModels();
+  for (std::size_t i = 0 ; i < links.size() ; ++i)
+  {
+    if (links[i]->getShapes().empty())
+      continue;
+    Eigen::Vector3d center = state.getGlobalLinkTransform(links[i]) * links[i]->getCenteredBoundingBoxOffset();
+    Eigen::Vector3d v = center - origin;
+    double r = (v - axis * axis.dot(v)).norm() + 0.5 * links[i]->getShapeExtentsAtOrigin().norm();
+    radius = std::max(radius, r);
+  }
+  return radius;
+}
+
+double ompl_interface::WeightedJointDistance::distance(const ompl::base::State *state1, const ompl::base::State *state2) const
+{
+  const double *v1 = state1->as<ModelBasedStateSpace::StateType>()->values;
+  const double *v2 = state2->as<ModelBasedStateSpace::StateType>()->values;
+  double d = 0.0;
+  for (std::size_t i = 0 ; i < joints_.size() ; ++i)
+    d += weights_[i] * joints_[i]->distance(v1 + indices_[i], v2 + indices_[i]);
+  return d;
+}
@@ -35,12 +35,26 @@
 /* Author: Ioan Sucan */
 
 #include "moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h"
+#include "moveit/ompl_interface/detail/worker_pool.h"
 #include <ompl/base/spaces/SE3StateSpace.h>
+#include <ompl/util/Time.h>
 #include <moveit/profiler/profiler.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <Eigen/Cholesky>
+#include <limits>
+#include <cmath>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <new>
 
 const std::string ompl_interface::PoseModelStateSpace::PARAMETERIZATION_TYPE = "PoseModel";
 
-ompl_interface::PoseModelStateSpace::PoseModelStateSpace(const ModelBasedStateSpaceSpecification &spec) : ModelBasedStateSpace(spec)
+ompl_interface::PoseModelStateSpace::PoseModelStateSpace(const ModelBasedStateSpaceSpecification &spec)
+  : ModelBasedStateSpace(spec)
+  , parallel_ik_(false)
+  , jacobian_steering_(false)
+  , direct_fk_(true)
 {
   jump_factor_ = 3; // \todo make this a param
 
@@ -58,6 +72,11 @@ ompl_interface::PoseModelStateSpace::PoseModelStateSpace(const ModelBasedStateSp
   else
     std::sort(poses_.begin(), poses_.end());
   setName(getName() + "_" + PARAMETERIZATION_TYPE);
+
+  // the state, its values, the pointers to the poses and the poses themselves share one block
+  state_pool_.reset(new StatePool(StatePool::align(sizeof(StateType)) + StatePool::align(state_values_size_) +
+                                  StatePool::align(poses_.size() * sizeof(ompl::base::SE3StateSpace::StateType*)) +
+                                  poses_.size() * getSE3BlockSize()));
 }
 
 ompl_interface::PoseModelStateSpace::~PoseModelStateSpace()
@@ -80,22 +99,59 @@ double ompl_interface::PoseModelStateSpace::getMaximumExtent() const
   return total;
 }
 
+std::size_t ompl_interface::PoseModelStateSpace::getSE3BlockSize()
+{
+  return StatePool::align(sizeof(ompl::base::SE3StateSpace::StateType)) + StatePool::align(2 * sizeof(ompl::base::State*)) +
+    StatePool::align(sizeof(ompl::base::RealVectorStateSpace::StateType)) + StatePool::align(3 * sizeof(double)) +
+    StatePool::align(sizeof(ompl::base::SO3StateSpace::StateType));
+}
+
+ompl::base::SE3StateSpace::StateType* ompl_interface::PoseModelStateSpace::constructSE3State(char *memory)
+{
+  // same layout as ompl::base::SE3StateSpace::allocState(): a position and a rotation component
+  ompl::base::SE3StateSpace::StateType *state = new (memory) ompl::base::SE3StateSpace::StateType();
+  memory += StatePool::align(sizeof(ompl::base::SE3StateSpace::StateType));
+  state->components = reinterpret_cast<ompl::base::State**>(memory);
+  memory += StatePool::align(2 * sizeof(ompl::base::State*));
+
+  ompl::base::RealVectorStateSpace::StateType *position = new (memory) ompl::base::RealVectorStateSpace::StateType();
+  memory += StatePool::align(sizeof(ompl::base::RealVectorStateSpace::StateType));
+  position->values = reinterpret_cast<double*>(memory);
+  memory += StatePool::align(3 * sizeof(double));
+
+  state->components[0] = position;
+  state->components[1] = new (memory) ompl::base::SO3StateSpace::StateType();
+  return state;
+}
+
+void ompl_interface::PoseModelStateSpace::destroySE3State(ompl::base::SE3StateSpace::StateType *state)
+{
+  state->components[0]->as<ompl::base::RealVectorStateSpace::StateType>()->~StateType();
+  state->components[1]->as<ompl::base::SO3StateSpace::StateType>()->~StateType();
+  state->~StateType();
+}
+
 ompl::base::State* ompl_interface::PoseModelStateSpace::allocState() const
 {
-  StateType *state = new StateType();
-  state->values = new double[variable_count_]; // need to allocate this here since ModelBasedStateSpace::allocState() is not called
-  state->poses = new ompl::base::SE3StateSpace::StateType*[poses_.size()];
-  for (std::size_t i = 0 ; i < poses_.size() ; ++i)
-    state->poses[i] = poses_[i].state_space_->allocState()->as<ompl::base::SE3StateSpace::StateType>();
+  char *block = static_cast<char*>(state_pool_->allocate());
+  StateType *state = new (block) StateType();
+  block += StatePool::align(sizeof(StateType));
+  state->values = reinterpret_cast<double*>(block);
+  block += StatePool::align(state_values_size_);
+  state->poses = reinterpret_cast<ompl::base::SE3StateSpace::StateType**>(block);
+  block += StatePool::align(poses_.size() * sizeof(ompl::base::SE3StateSpace::StateType*));
+  for (std::size_t i = 0 ; i < poses_.size() ; ++i, block += getSE3BlockSize())
+    state->poses[i] = constructSE3State(block);
   return state;
 }
 
 void ompl_interface::PoseModelStateSpace::freeState(ompl::base::State *state) const
 {
+  StateType *s = state->as<StateType>();
   for (std::size_t i = 0 ; i < poses_.size() ; ++i)
-    poses_[i].state_space_->freeState(state->as<StateType>()->poses[i]);
-  delete[] state->as<StateType>()->poses;
-  ModelBasedStateSpace::freeState(state);
+    destroySE3State(s->poses[i]);
+  s->~StateType();
+  state_pool_->free(s);
 }
 
 void ompl_interface::PoseModelStateSpace::copyState(ompl::base::State *destination, const ompl::base::State *source) const
@@ -140,8 +196,18 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State *f
   std::cout << "\n\n";
   */
 
-  // after interpolation we cannot be sure about the joint values (we use them as seed only)
-  // so we recompute IK if needed
+  // follow the motion of the tip from the joint values of the start state; if that fails,
+  // we cannot be sure about the joint values (we use them as seed only) so we recompute IK
+  if (jacobian_steering_ && from->as<StateType>()->jointsComputed() && from->as<StateType>()->poseComputed() &&
+      to->as<StateType>()->poseComputed())
+  {
+    bool steered = true;
+    for (std::size_t i = 0 ; i < poses_.size() && steered ; ++i)
+      steered = poses_[i].steer(from->as<StateType>(), to->as<StateType>(), t, state->as<StateType>(), i);
+    if (steered && satisfiesBounds(state))
+      state->as<StateType>()->setJointsComputed(true);
+  }
+
   if (computeStateIK(state))
   {
     double dj = jump_factor_ * ModelBasedStateSpace::distance(from, to);
@@ -150,7 +216,10 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State *f
 
     // if the joint value jumped too much
     if (d_from + d_to > std::max(0.2, dj)) // \todo make 0.2 a param
+    {
       state->as<StateType>()->markInvalid();
+      ++statistics_.get()->jump_rejections;
+    }
   }
 }
 
@@ -169,28 +238,124 @@ ompl_interface::PoseModelStateSpace::PoseComponent::PoseComponent(const robot_mo
   : subgroup_(subgroup)
   , kinematics_solver_(k.allocator_(subgroup))
   , bijection_(k.bijection_)
+  , scratch_(new ThreadLocalStorage<Scratch>())
 {
   state_space_.reset(new ompl::base::SE3StateSpace());
   state_space_->setName(subgroup_->getName() + "_Workspace");
   fk_link_.resize(1, kinematics_solver_->getTipFrame());
   if (!fk_link_[0].empty() && fk_link_[0][0] == '/')
     fk_link_[0] = fk_link_[0].substr(1);
+  initializeChain();
+}
+
+void ompl_interface::PoseModelStateSpace::PoseComponent::initializeChain()
+{
+  const robot_model::RobotModel &model = subgroup_->getParentModel();
+  std::string base_frame = kinematics_solver_->getBaseFrame();
+  if (!base_frame.empty() && base_frame[0] == '/')
+    base_frame = base_frame.substr(1);
+  if (!model.hasLinkModel(fk_link_[0]) || !model.hasLinkModel(base_frame))
+    return;
+
+  // the variables the solver reads from the state
+  const std::vector<std::string> &solver_joints = kinematics_solver_->getJointNames();
+  std::map<std::string, unsigned int> solver_index;
+  for (std::size_t i = 0 ; i < solver_joints.size() && i < bijection_.size() ; ++i)
+    solver_index[solver_joints[i]] = bijection_[i];
+
+  // walk from the tip up to the base
+  const robot_model::LinkModel *base = model.getLinkModel(base_frame);
+  std::vector<const robot_model::LinkModel*> links;
+  for (const robot_model::LinkModel *link = model.getLinkModel(fk_link_[0]) ; link != base ; link = link->getParentJointModel()->getParentLinkModel())
+  {
+    if (!link->getParentJointModel()->getParentLinkModel())
+      return; // the base is not an ancestor of the tip
+    links.push_back(link);
+  }
+
+  // from the base down to the tip, fold everything that does not depend on the state into constant offsets
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  std::vector<ChainJoint, Eigen::aligned_allocator<ChainJoint> > chain;
+  for (std::size_t i = links.size() ; i > 0 ; --i)
+  {
+    const robot_model::JointModel *joint = links[i - 1]->getParentJointModel();
+    offset = offset * links[i - 1]->getJointOriginTransform();
+    if (joint->getVariableCount() == 0)
+      continue;
+    if (joint->getMimic() || joint->getVariableCount() != 1 ||
+        (joint->getType() != robot_model::JointModel::REVOLUTE && joint->getType() != robot_model::JointModel::PRISMATIC))
+      return; // only revolute and prismatic joints with an independent variable are supported
+    std::map<std::string, unsigned int>::const_iterator it = solver_index.find(joint->getName());
+    if (it == solver_index.end())
+    {
+      // the solver keeps the joints it does not control at their default values
+      std::vector<double> values(joint->getVariableCount());
+      joint->getVariableDefaultPositions(&values[0]);
+      Eigen::Affine3d transform;
+      joint->computeTransform(&values[0], transform);
+      offset = offset * transform;
+      continue;
+    }
+    ChainJoint cj;
+    cj.offset = offset;
+    cj.joint = joint;
+    cj.index = it->second;
+    cj.revolute = joint->getType() == robot_model::JointModel::REVOLUTE;
+    cj.axis = cj.revolute ? static_cast<const robot_model::RevoluteJointModel*>(joint)->getAxis() :
+      static_cast<const robot_model::PrismaticJointModel*>(joint)->getAxis();
+    chain.push_back(cj);
+    offset = Eigen::Affine3d::Identity();
+  }
+
+  ChainJoint tip;
+  tip.offset = offset;
+  tip.joint = NULL;
+  tip.index = 0;
+  tip.axis = Eigen::Vector3d::Zero();
+  tip.revolute = false;
+  chain.push_back(tip);
+  chain_.swap(chain);
+  logDebug("Computing forward kinematics of '%s' for group '%s' directly from the robot model (%u joints)",
+           fk_link_[0].c_str(), subgroup_->getName().c_str(), (unsigned int)chain_.size() - 1);
 }
 
-bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateType *full_state, unsigned int idx) const
+bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateType *full_state, unsigned int idx, bool direct) const
 {
+  ompl::base::SE3StateSpace::StateType *se3_state = full_state->poses[idx];
+  if (direct && !chain_.empty())
+  {
+    // compose the transforms of the chain directly
+    Eigen::Affine3d pose = chain_[0].offset;
+    Eigen::Affine3d transform;
+    for (std::size_t i = 0 ; chain_[i].joint ; ++i)
+    {
+      chain_[i].joint->computeTransform(full_state->values + chain_[i].index, transform);
+      pose = pose * transform * chain_[i + 1].offset;
+    }
+
+    se3_state->setXYZ(pose.translation().x(), pose.translation().y(), pose.translation().z());
+    Eigen::Quaterniond q(pose.linear());
+    ompl::base::SO3StateSpace::StateType &so3_state = se3_state->rotation();
+    so3_state.x = q.x();
+    so3_state.y = q.y();
+    so3_state.z = q.z();
+    so3_state.w = q.w();
+    return true;
+  }
+
   // read the values from the joint state, in the order expected by the kinematics solver
-  std::vector<double> values(bijection_.size());
+  Scratch *scratch = scratch_->get();
+  std::vector<double> &values = scratch->values;
+  values.resize(bijection_.size());
   for (unsigned int i = 0 ; i < bijection_.size() ; ++i)
     values[i] = full_state->values[bijection_[i]];
 
   // compute forward kinematics for the link of interest
-  std::vector<geometry_msgs::Pose> poses;
+  std::vector<geometry_msgs::Pose> &poses = scratch->poses;
   if (!kinematics_solver_->getPositionFK(fk_link_, values, poses))
     return false;
 
   // copy the resulting data to the desired location in the state
-  ompl::base::SE3StateSpace::StateType *se3_state = full_state->poses[idx];
   se3_state->setXYZ(poses[0].position.x, poses[0].position.y, poses[0].position.z);
   ompl::base::SO3StateSpace::StateType &so3_state = se3_state->rotation();
   so3_state.x = poses[0].orientation.x;
@@ -201,10 +366,12 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateTyp
   return true;
 }
 
-bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateType *full_state, unsigned int idx) const
+bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateType *full_state, unsigned int idx, IKCache *cache) const
 {
   // read the values from the joint state, in the order expected by the kinematics solver; use these as the seed
-  std::vector<double> seed_values(bijection_.size());
+  Scratch *scratch = scratch_->get();
+  std::vector<double> &seed_values = scratch->values;
+  seed_values.resize(bijection_.size());
   for (std::size_t i = 0 ; i < bijection_.size() ; ++i)
     seed_values[i] = full_state->values[bijection_[i]];
 
@@ -227,15 +394,39 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   pose.orientation.z = so3_state.z;
   pose.orientation.w = so3_state.w;
 
+  // a solution for (almost) the same pose is used as is, one for a nearby pose as the seed
+  std::vector<double> &solution = scratch->solution;
+  const double position[3] = { pose.position.x, pose.position.y, pose.position.z };
+  const double orientation[4] = { pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w };
+  if (cache)
+    switch (cache->lookup(idx, position, orientation, seed_values, solution))
+    {
+    case IKCache::HIT:
+      for (std::size_t i = 0 ; i < bijection_.size() ; ++i)
+        full_state->values[bijection_[i]] = solution[i];
+      return true;
+    case IKCache::SEED:
+      seed_values.swap(solution);
+      break;
+    case IKCache::MISS:
+      break;
+    }
+
   // run IK
-  std::vector<double> solution(bijection_.size());
+  solution.resize(bijection_.size());
   moveit_msgs::MoveItErrorCodes err_code;
-  if (!kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code))
+  ompl::time::point start = ompl::time::now();
+  bool solved = kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code) ||
+    (err_code.val == moveit_msgs::MoveItErrorCodes::TIMED_OUT &&
+     kinematics_solver_->searchPositionIK(pose, seed_values, kinematics_solver_->getDefaultTimeout() * 2.0, solution, err_code));
+  if (cache)
   {
-    if (err_code.val != moveit_msgs::MoveItErrorCodes::TIMED_OUT ||
-        !kinematics_solver_->searchPositionIK(pose, seed_values, kinematics_solver_->getDefaultTimeout() * 2.0, solution, err_code))
-      return false;
+    cache->recordSolverCall(ompl::time::seconds(ompl::time::now() - start));
+    if (solved)
+      cache->insert(idx, position, orientation, solution);
   }
+  if (!solved)
+    return false;
 
   for (std::size_t i = 0 ; i < bijection_.size() ; ++i)
     full_state->values[bijection_[i]] = solution[i];
@@ -243,12 +434,183 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   return true;
 }
 
+void ompl_interface::PoseModelStateSpace::PoseComponent::computeChainJacobian(const double *values, Eigen::Affine3d &pose,
+                                                                              Eigen::Matrix<double, 6, Eigen::Dynamic> &jacobian) const
+{
+  const std::size_t n = chain_.size() - 1;
+  Scratch *scratch = scratch_->get();
+  Eigen::Matrix3Xd &axes = scratch->axes;
+  Eigen::Matrix3Xd &origins = scratch->origins;
+  axes.resize(3, n);
+  origins.resize(3, n);
+  Eigen::Affine3d transform;
+  pose = chain_[0].offset;
+  for (std::size_t i = 0 ; i < n ; ++i)
+  {
+    // the axis is expressed in the frame of the joint, before its own motion
+    axes.col(i) = pose.linear() * chain_[i].axis;
+    origins.col(i) = pose.translation();
+    chain_[i].joint->computeTransform(values + chain_[i].index, transform);
+    pose = pose * transform * chain_[i + 1].offset;
+  }
+
+  jacobian.resize(6, n);
+  for (std::size_t i = 0 ; i < n ; ++i)
+    if (chain_[i].revolute)
+    {
+      jacobian.block<3, 1>(0, i) = axes.col(i).cross(pose.translation() - origins.col(i));
+      jacobian.block<3, 1>(3, i) = axes.col(i);
+    }
+    else
+    {
+      jacobian.block<3, 1>(0, i) = axes.col(i);
+      jacobian.block<3, 1>(3, i).setZero();
+    }
+}
+
+namespace
+{
+// largest motion (m or rad) of the tip followed by a single Jacobian step
+const double STEERING_STEP = 0.02;
+// damping of the least squares steps
+const double STEERING_DAMPING = 1e-3;
+// Newton iterations for each point of the interpolation
+const unsigned int STEERING_ITERATIONS = 4;
+// accepted error on the final pose (m and rad)
+const double STEERING_POSITION_TOLERANCE = 1e-4;
+const double STEERING_ORIENTATION_TOLERANCE = 1e-3;
+
+Eigen::Affine3d poseFromSE3(const ompl::base::SE3StateSpace::StateType *state)
+{
+  Eigen::Affine3d pose(Eigen::Quaterniond(state->rotation().w, state->rotation().x, state->rotation().y, state->rotation().z));
+  pose.translation() = Eigen::Vector3d(state->getX(), state->getY(), state->getZ());
+  return pose;
+}
+
+/// Position and rotation (as a scaled axis) from \e current to \e target
+Eigen::Matrix<double, 6, 1> poseError(const Eigen::Affine3d &target, const Eigen::Affine3d &current)
+{
+  Eigen::Matrix<double, 6, 1> error;
+  error.head<3>() = target.translation() - current.translation();
+  Eigen::AngleAxisd rotation(target.linear() * current.linear().transpose());
+  error.tail<3>() = rotation.angle() * rotation.axis();
+  return error;
+}
+}
+
+bool ompl_interface::PoseModelStateSpace::PoseComponent::steerTo(const Eigen::Affine3d &target, double *values, Scratch &scratch) const
+{
+  Eigen::Matrix<double, 6, Eigen::Dynamic> &jacobian = scratch.jacobian;
+  Eigen::VectorXd &dq = scratch.step;
+  Eigen::Affine3d pose;
+  Eigen::Matrix<double, 6, 1> error;
+  double previous = std::numeric_limits<double>::infinity();
+  for (unsigned int it = 0 ; it < STEERING_ITERATIONS ; ++it)
+  {
+    computeChainJacobian(values, pose, jacobian);
+    error = poseError(target, pose);
+    double e = error.norm();
+    if (error.head<3>().norm() < STEERING_POSITION_TOLERANCE * 0.1 && error.tail<3>().norm() < STEERING_ORIENTATION_TOLERANCE * 0.1)
+      break;
+    if (e > previous)
+      return false; // the steps diverge (e.g., near a singularity)
+    previous = e;
+
+    Eigen::Matrix<double, 6, 6> a = jacobian * jacobian.transpose();
+    a.diagonal().array() += STEERING_DAMPING * STEERING_DAMPING;
+    const Eigen::Matrix<double, 6, 1> solution = a.ldlt().solve(error);
+    dq.noalias() = jacobian.transpose() * solution;
+    for (std::size_t i = 0 ; i + 1 < chain_.size() ; ++i)
+      values[chain_[i].index] += dq[i];
+  }
+  return true;
+}
+
+bool ompl_interface::PoseModelStateSpace::PoseComponent::steer(const StateType *from, const StateType *to, double t, StateType *state,
+                                                               unsigned int idx) const
+{
+  if (chain_.size() < 2)
+    return false;
+  const std::size_t n = chain_.size() - 1;
+
+  const Eigen::Affine3d start = poseFromSE3(from->poses[idx]);
+  const Eigen::Affine3d goal = poseFromSE3(to->poses[idx]);
+  const Eigen::Quaterniond start_rotation(start.linear());
+  const Eigen::Quaterniond goal_rotation(goal.linear());
+  const Eigen::Matrix<double, 6, 1> motion = poseError(goal, start);
+  const unsigned int steps = std::max(1u, (unsigned int)ceil(std::max(motion.head<3>().norm(), motion.tail<3>().norm()) / STEERING_STEP));
+  const unsigned int last = std::min(steps, (unsigned int)floor(t * steps));
+
+  // the motion, identified by the poses of its ends and the joint values it starts from
+  Scratch *scratch = scratch_->get();
+  std::vector<double> &motion_key = scratch->motion;
+  motion_key.resize(14 + n);
+  const ompl::base::SE3StateSpace::StateType *ends[2] = { from->poses[idx], to->poses[idx] };
+  for (int e = 0 ; e < 2 ; ++e)
+  {
+    motion_key[7 * e] = ends[e]->getX();
+    motion_key[7 * e + 1] = ends[e]->getY();
+    motion_key[7 * e + 2] = ends[e]->getZ();
+    motion_key[7 * e + 3] = ends[e]->rotation().x;
+    motion_key[7 * e + 4] = ends[e]->rotation().y;
+    motion_key[7 * e + 5] = ends[e]->rotation().z;
+    motion_key[7 * e + 6] = ends[e]->rotation().w;
+  }
+  for (std::size_t i = 0 ; i < n ; ++i)
+    motion_key[14 + i] = from->values[chain_[i].index];
+
+  // continue from the step the previous call along the same motion reached, unless it is beyond t
+  unsigned int step = 0;
+  if (motion_key == scratch->steered_motion && scratch->steered_step <= last)
+  {
+    step = scratch->steered_step;
+    for (std::size_t i = 0 ; i < n ; ++i)
+      state->values[chain_[i].index] = scratch->steered_values[i];
+  }
+  else
+  {
+    scratch->steered_motion = motion_key;
+    scratch->steered_step = 0;
+    scratch->steered_values.resize(n);
+    for (std::size_t i = 0 ; i < n ; ++i)
+      state->values[chain_[i].index] = scratch->steered_values[i] = from->values[chain_[i].index];
+  }
+
+  Eigen::Affine3d target;
+  while (step < last)
+  {
+    ++step;
+    const double ts = (double)step / steps;
+    target = Eigen::Affine3d(start_rotation.slerp(ts, goal_rotation));
+    target.translation() = start.translation() + ts * (goal.translation() - start.translation());
+    if (!steerTo(target, state->values, *scratch))
+      return false;
+  }
+  scratch->steered_step = step;
+  for (std::size_t i = 0 ; i < n ; ++i)
+    scratch->steered_values[i] = state->values[chain_[i].index];
+
+  // the remainder of the motion up to t, which is not remembered
+  if (t * steps > last)
+  {
+    target = Eigen::Affine3d(start_rotation.slerp(t, goal_rotation));
+    target.translation() = start.translation() + t * (goal.translation() - start.translation());
+    if (!steerTo(target, state->values, *scratch))
+      return false;
+  }
+
+  Eigen::Affine3d pose;
+  computeChainJacobian(state->values, pose, scratch->jacobian);
+  const Eigen::Matrix<double, 6, 1> error = poseError(poseFromSE3(state->poses[idx]), pose);
+  return error.head<3>().norm() < STEERING_POSITION_TOLERANCE && error.tail<3>().norm() < STEERING_ORIENTATION_TOLERANCE;
+}
+
 bool ompl_interface::PoseModelStateSpace::computeStateFK(ompl::base::State *state) const
 {
   if (state->as<StateType>()->poseComputed())
     return true;
   for (std::size_t i = 0 ; i < poses_.size() ; ++i)
-    if (!poses_[i].computeStateFK(state->as<StateType>(), i))
+    if (!poses_[i].computeStateFK(state->as<StateType>(), i, direct_fk_))
     {
       state->as<StateType>()->markInvalid();
       return false;
@@ -261,16 +623,73 @@ bool ompl_interface::PoseModelStateSpace::computeStateIK(ompl::base::State *stat
 {
   if (state->as<StateType>()->jointsComputed())
     return true;
-  for (std::size_t i = 0 ; i < poses_.size() ; ++i)
-    if (!poses_[i].computeStateIK(state->as<StateType>(), i))
+
+  statistics_.get()->ik_calls += poses_.size();
+  if (parallel_ik_ && poses_.size() > 1)
+  {
+    // the components set disjoint sets of joints, each with its own solver
+    std::vector<char> solved(poses_.size(), 0);
+    std::vector<WorkerPool::Task> tasks(poses_.size());
+    for (std::size_t i = 0 ; i < poses_.size() ; ++i)
+      tasks[i] = boost::bind(&PoseModelStateSpace::computeComponentIK, this, state->as<StateType>(), i, &solved[i]);
+    WorkerPool::getShared().run(tasks);
+    if (std::find(solved.begin(), solved.end(), 0) != solved.end())
     {
       state->as<StateType>()->markInvalid();
       return false;
     }
+  }
+  else
+    for (std::size_t i = 0 ; i < poses_.size() ; ++i)
+      if (!poses_[i].computeStateIK(state->as<StateType>(), i, ik_cache_.get()))
+      {
+        state->as<StateType>()->markInvalid();
+        return false;
+      }
   state->as<StateType>()->setJointsComputed(true);
   return true;
 }
 
+void ompl_interface::PoseModelStateSpace::computeComponentIK(StateType *state, unsigned int idx, char *solved) const
+{
+  *solved = poses_[idx].computeStateIK(state, idx, ik_cache_.get());
+}
+
+bool ompl_interface::PoseModelStateSpace::computeJacobian(const ompl::base::State *state, unsigned int idx, Eigen::Affine3d &pose,
+                                                          Eigen::MatrixXd &jacobian) const
+{
+  if (idx >= poses_.size() || poses_[idx].chain_.size() < 2)
+    return false;
+  const PoseComponent &component = poses_[idx];
+  Eigen::Matrix<double, 6, Eigen::Dynamic> &chain_jacobian = component.scratch_->get()->jacobian;
+  component.computeChainJacobian(state->as<StateType>()->values, pose, chain_jacobian);
+  jacobian.setZero(6, getJointModelGroup()->getVariableCount());
+  for (std::size_t i = 0 ; i + 1 < component.chain_.size() ; ++i)
+    jacobian.col(component.chain_[i].index) = chain_jacobian.col(i);
+  return true;
+}
+
+ompl_interface::PoseModelStateSpace::Statistics ompl_interface::PoseModelStateSpace::getStatistics() const
+{
+  std::vector<Statistics*> instances;
+  statistics_.getInstances(instances);
+  Statistics total;
+  for (std::size_t i = 0 ; i < instances.size() ; ++i)
+  {
+    total.ik_calls += instances[i]->ik_calls;
+    total.jump_rejections += instances[i]->jump_rejections;
+  }
+  return total;
+}
+
+void ompl_interface::PoseModelStateSpace::resetStatistics()
+{
+  std::vector<Statistics*> instances;
+  statistics_.getInstances(instances);
+  for (std::size_t i = 0 ; i < instances.size() ; ++i)
+    *instances[i] = Statistics();
+}
+
 bool ompl_interface::PoseModelStateSpace::computeStateK(ompl::base::State *state) const
 {
   if (state->as<StateType>()->jointsComputed() && !state->as<StateType>()->poseComputed())
@@ -0,0 +1,178 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Sampling success rate and time to solution of RRTConnect for the PR2 right arm under path constraints on the
+   orientation of the wrist (and optionally its position), in the joint, projected and pose model parameterizations.
+   Only the constraints are checked, not collisions.  The pose model space solves inverse kinematics with the test
+   solver (damped least squares on RobotState forward kinematics), which is slower than a kinematics plugin. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/ompl_interface/parameterization/projected_space/projected_state_space.h>
+#include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <ompl/geometric/SimpleSetup.h>
+#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <ompl/util/Time.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+class ConstraintValidityChecker : public ompl::base::StateValidityChecker
+{
+public:
+
+  ConstraintValidityChecker(const ompl::base::SpaceInformationPtr &si, const kinematic_constraints::KinematicConstraintSet &constraints,
+                            const robot_state::RobotState &state)
+    : ompl::base::StateValidityChecker(si)
+    , space_(si->getStateSpace()->as<ompl_interface::ModelBasedStateSpace>())
+    , constraints_(constraints)
+    , state_(state)
+  {
+  }
+
+  virtual bool isValid(const ompl::base::State *state) const
+  {
+    const ompl_interface::ModelBasedStateSpace::StateType *s = state->as<ompl_interface::ModelBasedStateSpace::StateType>();
+    if (s->isValidityKnown() && !s->isMarkedValid())
+      return false;
+    space_->copyToRobotState(state_, state);
+    state_.update();
+    return constraints_.decide(state_).satisfied;
+  }
+
+private:
+
+  const ompl_interface::ModelBasedStateSpace           *space_;
+  const kinematic_constraints::KinematicConstraintSet &constraints_;
+  mutable robot_state::RobotState                      state_;
+};
+
+void run(const char *name, const ompl_interface::ModelBasedStateSpacePtr &space, const kinematic_constraints::KinematicConstraintSet &constraints,
+         const robot_state::RobotState &start, const std::vector<robot_state::RobotState> &goals, unsigned int samples, double time_limit)
+{
+  ompl::geometric::SimpleSetup setup(space);
+  setup.setStateValidityChecker(ompl::base::StateValidityCheckerPtr(new ConstraintValidityChecker(setup.getSpaceInformation(), constraints, start)));
+  setup.setPlanner(ompl::base::PlannerPtr(new ompl::geometric::RRTConnect(setup.getSpaceInformation())));
+  setup.setup();
+
+  // sampling
+  ompl::base::StateSamplerPtr sampler = space->allocDefaultStateSampler();
+  ompl::base::State *state = space->allocState();
+  unsigned int satisfied = 0;
+  ompl::time::point begin = ompl::time::now();
+  for (unsigned int i = 0 ; i < samples ; ++i)
+  {
+    state->as<ompl_interface::ModelBasedStateSpace::StateType>()->clearKnownInformation();
+    sampler->sampleUniform(state);
+    if (setup.getStateValidityChecker()->isValid(state))
+      ++satisfied;
+  }
+  double sampling_time = ompl::time::seconds(ompl::time::now() - begin);
+
+  // planning
+  ompl::base::ScopedState<> start_state(space), goal_state(space);
+  space->copyToOMPLState(start_state.get(), start);
+  unsigned int solved = 0;
+  double planning_time = 0.0;
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+  {
+    space->copyToOMPLState(goal_state.get(), goals[i]);
+    setup.clear();
+    setup.setStartAndGoalStates(start_state, goal_state);
+    if (setup.solve(time_limit) == ompl::base::PlannerStatus::EXACT_SOLUTION)
+    {
+      ++solved;
+      planning_time += setup.getLastPlanComputationTime();
+    }
+  }
+  space->freeState(state);
+
+  printf("%-10s %12.1lf %13.1lf %13.3lf %8u/%-3u %13.3lf\n", name, 100.0 * satisfied / samples, samples / sampling_time,
+         satisfied ? sampling_time / satisfied : 0.0, solved, (unsigned int)goals.size(), solved ? planning_time / solved : 0.0);
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int samples = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 2000;
+  const unsigned int queries = argc > 2 ? boost::lexical_cast<unsigned int>(argv[2]) : 20;
+  const double time_limit = argc > 3 ? boost::lexical_cast<double>(argv[3]) : 10.0;
+  const double box_size = argc > 4 ? boost::lexical_cast<double>(argv[4]) : 0.0;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  robot_state::RobotState start(robot_model);
+  start.setToDefaultValues();
+  start.update();
+  robot_state::Transforms tf(robot_model->getModelFrame());
+  moveit_msgs::Constraints path_constraints = ompl_interface_test::rightWristConstraints(start, box_size);
+  kinematic_constraints::KinematicConstraintSet constraints(robot_model);
+  constraints.add(path_constraints, tf);
+
+  const ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model, "right_arm");
+  ompl_interface::ModelBasedStateSpacePtr joint_space(new ompl_interface::JointModelStateSpace(spec));
+  boost::shared_ptr<ompl_interface::ProjectedStateSpace> projected_space(new ompl_interface::ProjectedStateSpace(spec, path_constraints, tf, start));
+  ompl_interface::ModelBasedStateSpacePtr pose_space(new ompl_interface::PoseModelStateSpace(spec));
+
+  // the same goals, on the constraints, for every parameterization
+  random_numbers::RandomNumberGenerator rng(13);
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("right_arm");
+  std::vector<double> values(group->getVariableCount());
+  std::vector<robot_state::RobotState> goals;
+  ompl::base::State *projected = projected_space->allocState();
+  while (goals.size() < queries)
+  {
+    group->getVariableRandomPositions(rng, values);
+    std::copy(values.begin(), values.end(), projected->as<ompl_interface::ModelBasedStateSpace::StateType>()->values);
+    if (!projected_space->project(projected))
+      continue;
+    goals.push_back(start);
+    projected_space->copyToRobotState(goals.back(), projected);
+    goals.back().update();
+  }
+  projected_space->freeState(projected);
+
+  printf("%u samples, %u queries of at most %lf s, wrist orientation constraint%s\n", samples, queries, time_limit,
+         box_size > 0.0 ? (" and " + boost::lexical_cast<std::string>(box_size) + " m position box").c_str() : "");
+  printf("space      satisfied (%%)  samples/s  s/satisfying  solved    mean time (s)\n");
+  run("joint", joint_space, constraints, start, goals, samples, time_limit);
+  run("projected", projected_space, constraints, start, goals, samples, time_limit);
+  run("pose", pose_space, constraints, start, goals, samples, time_limit);
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Goal states per second that the ConstrainedGoalSampler of a GeometricPlanningContext finds for a pose goal of the PR2
+   right wrist, sampling sequentially and with parallel workers (goal_sampling_threads).  The goal states are checked
+   for collisions in an empty scene.  The solvers descend with damped least squares on RobotState forward kinematics,
+   which is slower than a kinematics plugin; the speedup is bounded by the hardware threads. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <ompl/base/goals/GoalLazySamples.h>
+#include <ompl/util/Time.h>
+#include <ros/ros.h>
+#include <boost/thread/thread.hpp>
+#include <boost/lexical_cast.hpp>
+#include <limits>
+#include <cstdio>
+
+namespace
+{
+void run(const planning_scene::PlanningSceneConstPtr &scene, const robot_state::RobotState &start, const moveit_msgs::Constraints &goal,
+         unsigned int threads, unsigned int goal_samples, double time_limit)
+{
+  planning_interface::MotionPlanRequest req;
+  req.group_name = "right_arm";
+  req.goal_constraints.push_back(goal);
+
+  ompl_interface::PlanningContextSpecification spec;
+  spec.name = "benchmark_goal_sampling";
+  spec.group = req.group_name;
+  spec.config["goal_sampling_threads"] = boost::lexical_cast<std::string>(threads);
+  spec.config["max_goal_samples"] = boost::lexical_cast<std::string>(goal_samples);
+  // the sampling stops at the goal state count or the time limit
+  spec.config["goal_sampling_attempts"] = boost::lexical_cast<std::string>(std::numeric_limits<unsigned int>::max());
+  spec.simplify_solution = false;
+  spec.interpolate_solution = false;
+  spec.min_waypoint_count = 2;
+  spec.max_waypoint_distance = 0.1;
+  spec.max_num_threads = 1;
+  spec.model = scene->getRobotModel();
+  spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+  ompl_interface::GeometricPlanningContext context;
+  context.setPlanningScene(scene);
+  context.setMotionPlanRequest(req);
+  context.initialize("", spec);
+  context.setCompleteInitialRobotState(start);
+
+  // the goal sampler starts sampling when it is constructed
+  ompl::time::point begin = ompl::time::now();
+  if (!context.setGoalConstraints(req.goal_constraints, NULL))
+  {
+    printf("%7u  unable to set the goal\n", threads);
+    return;
+  }
+  const ompl::base::GoalLazySamples *gls = context.getOMPLProblemDefinition()->getGoal()->as<ompl::base::GoalLazySamples>();
+  double elapsed = 0.0;
+  while (gls->getStateCount() < goal_samples && elapsed < time_limit)
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    elapsed = ompl::time::seconds(ompl::time::now() - begin);
+  }
+  unsigned int found = gls->getStateCount();
+  printf("%7u %12u %12.3lf %15.1lf\n", threads, found, elapsed, found / elapsed);
+  context.clear();
+}
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "benchmark_goal_sampling", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  const unsigned int goal_samples = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 50;
+  const double time_limit = argc > 2 ? boost::lexical_cast<double>(argv[2]) : 30.0;
+  const unsigned int max_threads = argc > 3 ? boost::lexical_cast<unsigned int>(argv[3]) : 4;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  robot_state::RobotState start(robot_model);
+  start.setToDefaultValues();
+  start.update();
+  // the pose of the wrist in the start state, within 5 cm and about any rotation of the wrist
+  moveit_msgs::Constraints goal = ompl_interface_test::rightWristConstraints(start, 0.05);
+
+  printf("%u goal states, at most %lf s\n", goal_samples, time_limit);
+  printf("threads  goal states     time (s)  goal states/s\n");
+  for (unsigned int threads = 1 ; threads <= max_threads ; threads *= 2)
+    run(scene, start, goal, threads, goal_samples, time_limit);
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Goal checks per second of a union of goals, each a set of goal states, answered by the nearest neighbors index of
+   GoalSampleableRegionMux and by a check of every member goal in turn.  The states are uniform in a 7 dimensional
+   box, as for one arm.  test_goal_union checks that both give the same answers. */
+
+#include <moveit/ompl_interface/detail/goal_union.h>
+#include <ompl/base/goals/GoalStates.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/util/Time.h>
+#include <boost/lexical_cast.hpp>
+#include <limits>
+#include <cstdio>
+
+namespace
+{
+// the goal checks of the union before it indexed the goal states
+bool isSatisfiedByMember(const std::vector<ompl::base::GoalPtr> &goals, const ompl::base::State *st, double *distance)
+{
+  double min_d = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+  {
+    double d;
+    if (goals[i]->isSatisfied(st, &d))
+    {
+      if (distance)
+        *distance = d;
+      return true;
+    }
+    min_d = std::min(min_d, d);
+  }
+  if (distance)
+    *distance = min_d;
+  return false;
+}
+
+double distanceToMembers(const std::vector<ompl::base::GoalPtr> &goals, const ompl::base::State *st)
+{
+  double min_d = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+    min_d = std::min(min_d, goals[i]->as<ompl::base::GoalRegion>()->distanceGoal(st));
+  return min_d;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int goal_count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 200;
+  const unsigned int states_per_goal = argc > 2 ? boost::lexical_cast<unsigned int>(argv[2]) : 5;
+  const unsigned int query_count = argc > 3 ? boost::lexical_cast<unsigned int>(argv[3]) : 20000;
+
+  ompl::base::RealVectorStateSpace *box = new ompl::base::RealVectorStateSpace(7);
+  box->setBounds(-3.14, 3.14);
+  ompl::base::StateSpacePtr space(box);
+  ompl::base::SpaceInformationPtr si(new ompl::base::SpaceInformation(space));
+  si->setup();
+  ompl::base::StateSamplerPtr sampler = space->allocDefaultStateSampler();
+
+  std::vector<ompl::base::GoalPtr> goals;
+  ompl::base::State *state = si->allocState();
+  for (unsigned int i = 0 ; i < goal_count ; ++i)
+  {
+    ompl::base::GoalStates *goal = new ompl::base::GoalStates(si);
+    goal->setThreshold(0.1);
+    for (unsigned int j = 0 ; j < states_per_goal ; ++j)
+    {
+      sampler->sampleUniform(state);
+      goal->addState(state);
+    }
+    goals.push_back(ompl::base::GoalPtr(goal));
+  }
+  si->freeState(state);
+  ompl_interface::GoalSampleableRegionMux mux(goals);
+
+  // half the queries are near a goal state, as the states a planner checks close to the goal
+  std::vector<ompl::base::State*> queries(query_count);
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+  {
+    queries[i] = si->allocState();
+    if (i % 2)
+      sampler->sampleUniform(queries[i]);
+    else
+      sampler->sampleUniformNear(queries[i], goals[i % goal_count]->as<ompl::base::GoalStates>()->getState(0), 0.05);
+  }
+
+  printf("%u goals of %u states, %u queries\n", goal_count, states_per_goal, query_count);
+  printf("method           isSatisfied/s  distanceGoal/s  satisfied  mean distance\n");
+
+  unsigned int satisfied = 0;
+  double distance_sum = 0.0;
+  ompl::time::point start = ompl::time::now();
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+    if (mux.isSatisfied(queries[i], NULL))
+      ++satisfied;
+  double satisfied_time = ompl::time::seconds(ompl::time::now() - start);
+  start = ompl::time::now();
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+    distance_sum += mux.distanceGoal(queries[i]);
+  double distance_time = ompl::time::seconds(ompl::time::now() - start);
+  printf("%-16s %13.0lf %15.0lf %10u %14.4lf\n", "indexed", query_count / satisfied_time, query_count / distance_time, satisfied,
+         distance_sum / query_count);
+
+  unsigned int member_satisfied = 0;
+  double member_distance_sum = 0.0;
+  start = ompl::time::now();
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+    if (isSatisfiedByMember(goals, queries[i], NULL))
+      ++member_satisfied;
+  satisfied_time = ompl::time::seconds(ompl::time::now() - start);
+  start = ompl::time::now();
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+    member_distance_sum += distanceToMembers(goals, queries[i]);
+  distance_time = ompl::time::seconds(ompl::time::now() - start);
+  printf("%-16s %13.0lf %15.0lf %10u %14.4lf\n", "member by member", query_count / satisfied_time, query_count / distance_time, member_satisfied,
+         member_distance_sum / query_count);
+
+  for (unsigned int i = 0 ; i < query_count ; ++i)
+    si->freeState(queries[i]);
+  return 0;
+}
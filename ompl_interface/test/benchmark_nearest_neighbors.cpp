@@ -0,0 +1,125 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Nearest neighbor queries per second, and distance evaluations per query, of the structures the nearest_neighbors
+   context parameter selects, as the number of stored states grows.  The states are uniform in a 7 or 14 dimensional
+   box, as for one or two arms. */
+
+#include <moveit/ompl_interface/detail/nearest_neighbors_hnsw.h>
+#include <moveit/ompl_interface/detail/nearest_neighbors_gnat_cached.h>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+#include <ompl/datastructures/NearestNeighborsSqrtApprox.h>
+#include <ompl/datastructures/NearestNeighborsLinear.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/util/Time.h>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+typedef ompl::base::State* Element;
+
+double countedDistance(const ompl::base::StateSpacePtr &space, std::size_t *count, const Element &a, const Element &b)
+{
+  ++*count;
+  return space->distance(a, b);
+}
+
+void run(const char *name, ompl::NearestNeighbors<Element> *nn, const ompl::base::StateSpacePtr &space,
+         const std::vector<Element> &data, const std::vector<Element> &queries, std::size_t k)
+{
+  std::size_t count = 0;
+  nn->setDistanceFunction(boost::bind(&countedDistance, space, &count, _1, _2));
+  nn->add(data);
+
+  std::vector<Element> nbh;
+  count = 0;
+  ompl::time::point start = ompl::time::now();
+  for (std::size_t i = 0 ; i < queries.size() ; ++i)
+    nn->nearestK(queries[i], k, nbh);
+  double seconds = ompl::time::seconds(ompl::time::now() - start);
+
+  printf("  %-12s %12.0lf queries/s %10.1lf distances/query\n", name, queries.size() / seconds, (double)count / queries.size());
+  delete nn;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const std::size_t max_size = argc > 1 ? boost::lexical_cast<std::size_t>(argv[1]) : 100000;
+  const std::size_t query_count = argc > 2 ? boost::lexical_cast<std::size_t>(argv[2]) : 1000;
+  const std::size_t k = argc > 3 ? boost::lexical_cast<std::size_t>(argv[3]) : 1;
+
+  const unsigned int dimensions[] = { 7, 14 };
+  for (std::size_t d = 0 ; d < sizeof(dimensions) / sizeof(dimensions[0]) ; ++d)
+  {
+    ompl::base::RealVectorStateSpace *rv = new ompl::base::RealVectorStateSpace(dimensions[d]);
+    rv->setBounds(-3.14, 3.14);
+    ompl::base::StateSpacePtr space(rv);
+    ompl::base::StateSamplerPtr sampler = space->allocDefaultStateSampler();
+
+    std::vector<Element> queries(query_count);
+    for (std::size_t i = 0 ; i < query_count ; ++i)
+    {
+      queries[i] = space->allocState();
+      sampler->sampleUniform(queries[i]);
+    }
+
+    for (std::size_t size = 1000 ; size <= max_size ; size *= 10)
+    {
+      std::vector<Element> data(size);
+      for (std::size_t i = 0 ; i < size ; ++i)
+      {
+        data[i] = space->allocState();
+        sampler->sampleUniform(data[i]);
+      }
+
+      printf("%u dimensions, %u states, %u nearest\n", dimensions[d], (unsigned int)size, (unsigned int)k);
+      run("gnat", new ompl::NearestNeighborsGNAT<Element>(), space, data, queries, k);
+      run("gnat_cached", new ompl_interface::NearestNeighborsGNATCached<Element>(), space, data, queries, k);
+      run("sqrtapprox", new ompl::NearestNeighborsSqrtApprox<Element>(), space, data, queries, k);
+      run("linear", new ompl::NearestNeighborsLinear<Element>(), space, data, queries, k);
+      run("hnsw", new ompl_interface::NearestNeighborsHNSW<Element>(), space, data, queries, k);
+
+      for (std::size_t i = 0 ; i < size ; ++i)
+        space->freeState(data[i]);
+    }
+
+    for (std::size_t i = 0 ; i < query_count ; ++i)
+      space->freeState(queries[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Inverse kinematics per second of the PR2 "arms" group (two 7 joint arms, one solver each) in the PoseModelStateSpace,
+   solving the arms one after the other and concurrently on the shared worker pool (parallel_ik).  The states are seeded
+   near their solution, as for states interpolated along a motion.  The solvers descend with damped least squares on
+   RobotState forward kinematics, which is slower than a kinematics plugin; the speedup is bounded by the number of
+   arms and by the hardware threads. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/ompl_interface/detail/worker_pool.h>
+#include <ompl/util/Time.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+struct Sample
+{
+  std::vector<double> solution;
+  std::vector<double> seed;
+};
+
+double measure(ompl_interface::PoseModelStateSpace &space, const std::vector<Sample> &samples, bool parallel, unsigned int &solved)
+{
+  space.setParallelIK(parallel);
+  ompl_interface::PoseModelStateSpace::StateType *state = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  solved = 0;
+  double seconds = 0.0;
+  for (std::size_t i = 0 ; i < samples.size() ; ++i)
+  {
+    // the poses of the solution, and the joints of the seed
+    std::copy(samples[i].solution.begin(), samples[i].solution.end(), state->values);
+    state->setPoseComputed(false);
+    state->setJointsComputed(true);
+    space.computeStateFK(state);
+    std::copy(samples[i].seed.begin(), samples[i].seed.end(), state->values);
+    state->setJointsComputed(false);
+
+    ompl::time::point start = ompl::time::now();
+    if (space.computeStateIK(state))
+      ++solved;
+    seconds += ompl::time::seconds(ompl::time::now() - start);
+  }
+  space.freeState(state);
+  return samples.size() / seconds;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 2000;
+  const double seed_distance = argc > 2 ? boost::lexical_cast<double>(argv[2]) : 0.05;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setPR2ArmsModelKinematics(robot_model);
+  ompl_interface::PoseModelStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "arms"));
+  const robot_model::JointModelGroup *group = space.getJointModelGroup();
+
+  random_numbers::RandomNumberGenerator rng(9);
+  std::vector<Sample> samples(count);
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    samples[i].solution.resize(group->getVariableCount());
+    group->getVariableRandomPositions(rng, samples[i].solution);
+    samples[i].seed.resize(group->getVariableCount());
+    group->getVariableRandomPositionsNearBy(rng, &samples[i].seed[0], group->getActiveJointModelsBounds(),
+                                            &samples[i].solution[0], seed_distance);
+  }
+
+  unsigned int serial_solved, parallel_solved;
+  double serial = measure(space, samples, false, serial_solved);
+  double parallel = measure(space, samples, true, parallel_solved);
+  printf("%u states of both arms, seeds within %lf of the solution, %u hardware threads\n", count, seed_distance,
+         ompl_interface::WorkerPool::getShared().getThreadCount() + 1);
+  printf("serial (IK/s)  parallel (IK/s)  speedup  solved (serial, parallel)\n");
+  printf("%13.1lf  %15.1lf  %7.2lf  %u, %u\n", serial, parallel, parallel / serial, serial_solved, parallel_solved);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Forward kinematics per second of the PR2 right arm in the PoseModelStateSpace, composed directly from the robot model
+   and through the kinematics solver interface (getPositionFK()).  The solver here computes forward kinematics with
+   RobotState, as the test solver does; a kinematics plugin has its own cost, but pays the same interface overhead. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <ompl/util/Time.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+double measure(ompl_interface::PoseModelStateSpace &space, const std::vector<std::vector<double> > &samples, bool direct)
+{
+  space.setDirectFK(direct);
+  ompl_interface::PoseModelStateSpace::StateType *state = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  ompl::time::point start = ompl::time::now();
+  for (std::size_t i = 0 ; i < samples.size() ; ++i)
+  {
+    std::copy(samples[i].begin(), samples[i].end(), state->values);
+    state->setPoseComputed(false);
+    space.computeStateFK(state);
+  }
+  double seconds = ompl::time::seconds(ompl::time::now() - start);
+  space.freeState(state);
+  return samples.size() / seconds;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 200000;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  ompl_interface::PoseModelStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "right_arm"));
+  const robot_model::JointModelGroup *group = space.getJointModelGroup();
+
+  random_numbers::RandomNumberGenerator rng(5);
+  std::vector<std::vector<double> > samples(count, std::vector<double>(group->getVariableCount()));
+  for (unsigned int i = 0 ; i < count ; ++i)
+    group->getVariableRandomPositions(rng, samples[i]);
+
+  double solver = measure(space, samples, false);
+  double direct = measure(space, samples, true);
+  printf("%u right arm states\n", count);
+  printf("solver (FK/s)  direct (FK/s)  speedup\n");
+  printf("%13.0lf  %13.0lf  %7.2lf\n", solver, direct, direct / solver);
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Allocations and frees per second of state sized blocks from the StatePool and from the system allocator, as the
+   number of threads grows.  Each thread repeatedly allocates a batch of blocks and frees it. */
+
+#include <moveit/ompl_interface/detail/state_pool.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cstdio>
+
+namespace
+{
+const std::size_t BLOCK_SIZE = 96;
+
+void usePool(ompl_interface::StatePool *pool, unsigned int rounds, unsigned int batch)
+{
+  std::vector<void*> blocks(batch);
+  for (unsigned int r = 0 ; r < rounds ; ++r)
+  {
+    for (unsigned int i = 0 ; i < batch ; ++i)
+      blocks[i] = pool->allocate();
+    for (unsigned int i = 0 ; i < batch ; ++i)
+      pool->free(blocks[i]);
+  }
+}
+
+void useSystem(unsigned int rounds, unsigned int batch)
+{
+  std::vector<void*> blocks(batch);
+  for (unsigned int r = 0 ; r < rounds ; ++r)
+  {
+    for (unsigned int i = 0 ; i < batch ; ++i)
+      blocks[i] = ::operator new(BLOCK_SIZE);
+    for (unsigned int i = 0 ; i < batch ; ++i)
+      ::operator delete(blocks[i]);
+  }
+}
+
+double seconds(const boost::posix_time::ptime &start)
+{
+  return (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() * 1e-6;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int rounds = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 2000;
+  const unsigned int batch = argc > 2 ? boost::lexical_cast<unsigned int>(argv[2]) : 1000;
+  const unsigned int max_threads = argc > 3 ? boost::lexical_cast<unsigned int>(argv[3]) : 8;
+
+  printf("%u rounds of %u allocations and frees of %u bytes per thread\n", rounds, batch, (unsigned int)BLOCK_SIZE);
+  printf("threads  system (pairs/s)  pool (pairs/s)  speedup\n");
+  for (unsigned int threads = 1 ; threads <= max_threads ; threads *= 2)
+  {
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    boost::thread_group system_threads;
+    for (unsigned int i = 0 ; i < threads ; ++i)
+      system_threads.create_thread(boost::bind(&useSystem, rounds, batch));
+    system_threads.join_all();
+    double system_time = seconds(start);
+
+    ompl_interface::StatePool pool(BLOCK_SIZE);
+    start = boost::posix_time::microsec_clock::universal_time();
+    boost::thread_group pool_threads;
+    for (unsigned int i = 0 ; i < threads ; ++i)
+      pool_threads.create_thread(boost::bind(&usePool, &pool, rounds, batch));
+    pool_threads.join_all();
+    double pool_time = seconds(start);
+
+    double pairs = (double)threads * rounds * batch;
+    printf("%7u  %16.0lf  %14.0lf  %7.2lf\n", threads, pairs / system_time, pairs / pool_time, system_time / pool_time);
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* File size, store time and load time of a StateStorage of PR2 right arm states in every serialization format. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <ompl/base/StateStorage.h>
+#include <ompl/util/Time.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+int main(int argc, char **argv)
+{
+  const unsigned int count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 100000;
+  const std::string filename = (boost::filesystem::temp_directory_path() / "benchmark_state_serialization.db").string();
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface::ModelBasedStateSpacePtr space(new ompl_interface::JointModelStateSpace(
+                                                  ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "right_arm")));
+  space->setup();
+
+  const ompl_interface::ModelBasedStateSpace::SerializationFormat formats[] =
+    { ompl_interface::ModelBasedStateSpace::SERIALIZE_RAW,
+      ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_16,
+      ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_32 };
+  const char *names[] = { "raw", "quantized16", "quantized32" };
+
+  printf("%u right arm states\n", count);
+  printf("format       bytes/state  file size (bytes)  store (s)  load (s)\n");
+  for (std::size_t f = 0 ; f < sizeof(formats) / sizeof(formats[0]) ; ++f)
+  {
+    space->setSerializationFormat(formats[f]);
+    ompl::base::StateStorage storage(space);
+    ompl::base::StateSamplerPtr sampler = space->allocDefaultStateSampler();
+    ompl::base::State *state = space->allocState();
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+      sampler->sampleUniform(state);
+      storage.addState(state);
+    }
+    space->freeState(state);
+
+    ompl::time::point start = ompl::time::now();
+    storage.store(filename.c_str());
+    double store_time = ompl::time::seconds(ompl::time::now() - start);
+
+    ompl::base::StateStorage loaded(space);
+    start = ompl::time::now();
+    loaded.load(filename.c_str());
+    double load_time = ompl::time::seconds(ompl::time::now() - start);
+    if (loaded.size() != count)
+      printf("%s: loaded %u states instead of %u\n", names[f], (unsigned int)loaded.size(), count);
+
+    printf("%-12s %11u  %17u  %9.3lf  %8.3lf\n", names[f], space->getSerializationLength(),
+           (unsigned int)boost::filesystem::file_size(filename), store_time, load_time);
+  }
+  boost::filesystem::remove(filename);
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Validity checks per second of the right arm of the PR2 next to a shelf, with the planning scene and with the
+   precomputed static collision environment. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/detail/static_collision_environment.h>
+#include <random_numbers/random_numbers.h>
+#include <ompl/util/Time.h>
+#include <cstdio>
+
+int main(int argc, char **argv)
+{
+  const unsigned int count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 20000;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  ompl_interface_test::addShelf(scene);
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("right_arm");
+
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  ompl_interface::StaticCollisionEnvironment environment(scene, group, state);
+
+  // the same states for both checkers
+  random_numbers::RandomNumberGenerator rng(42);
+  std::vector<std::vector<double> > samples(count, std::vector<double>(group->getVariableCount()));
+  for (unsigned int i = 0 ; i < count ; ++i)
+    group->getVariableRandomPositions(rng, samples[i]);
+
+  collision_detection::CollisionRequest req;
+  unsigned int scene_collisions = 0;
+  ompl::time::point start = ompl::time::now();
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    state.setJointGroupPositions(group, samples[i]);
+    state.update();
+    collision_detection::CollisionResult res;
+    scene->checkCollision(req, res, state);
+    scene_collisions += res.collision;
+  }
+  double scene_time = ompl::time::seconds(ompl::time::now() - start);
+
+  unsigned int environment_collisions = 0;
+  start = ompl::time::now();
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    state.setJointGroupPositions(group, samples[i]);
+    state.update();
+    collision_detection::CollisionResult res;
+    environment.checkCollision(req, res, state);
+    environment_collisions += res.collision;
+  }
+  double environment_time = ompl::time::seconds(ompl::time::now() - start);
+
+  printf("%u states, %u / %u in collision\n", count, scene_collisions, environment_collisions);
+  printf("planning scene:               %10.0lf checks/s\n", count / scene_time);
+  printf("static collision environment: %10.0lf checks/s (%.2lfx)\n", count / environment_time, scene_time / environment_time);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+/* Lookups per second of the per-thread scratch state as the number of threads grows: ThreadLocalStorage,
+   against the mutex protected map from thread ids previously used by TSStateStorage. */
+
+#include <moveit/ompl_interface/detail/thread_local_storage.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cstdio>
+#include <map>
+
+namespace
+{
+/// The storage previously used by TSStateStorage
+class MutexMapStorage
+{
+public:
+
+  ~MutexMapStorage()
+  {
+    for (std::map<boost::thread::id, int*>::iterator it = instances_.begin() ; it != instances_.end() ; ++it)
+      delete it->second;
+  }
+
+  int* get() const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::map<boost::thread::id, int*>::iterator it = instances_.find(boost::this_thread::get_id());
+    if (it != instances_.end())
+      return it->second;
+    int *instance = new int(0);
+    instances_[boost::this_thread::get_id()] = instance;
+    return instance;
+  }
+
+private:
+
+  mutable std::map<boost::thread::id, int*> instances_;
+  mutable boost::mutex                      lock_;
+};
+
+template<typename S>
+void lookup(const S *storage, unsigned int count)
+{
+  for (unsigned int i = 0 ; i < count ; ++i)
+    ++*storage->get();
+}
+
+template<typename S>
+double measure(unsigned int threads, unsigned int count)
+{
+  S storage;
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  boost::thread_group group;
+  for (unsigned int i = 0 ; i < threads ; ++i)
+    group.create_thread(boost::bind(&lookup<S>, &storage, count));
+  group.join_all();
+  double elapsed = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() * 1e-6;
+  return threads * count / elapsed;
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int count = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 1000000;
+  const unsigned int max_threads = argc > 2 ? boost::lexical_cast<unsigned int>(argv[2]) : 8;
+
+  printf("threads  mutex map (lookups/s)  thread local (lookups/s)  speedup\n");
+  for (unsigned int threads = 1 ; threads <= max_threads ; threads *= 2)
+  {
+    double map_rate = measure<MutexMapStorage>(threads, count);
+    double local_rate = measure<ompl_interface::ThreadLocalStorage<int> >(threads, count);
+    printf("%7u  %21.0lf  %24.0lf  %7.2lf\n", threads, map_rate, local_rate, local_rate / map_rate);
+  }
+  return 0;
+}
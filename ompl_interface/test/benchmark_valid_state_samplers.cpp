@@ -0,0 +1,132 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Time to solution of PRM and RRTConnect for the PR2 right arm reaching into a shelf, with each valid state sampler
+   (valid_state_sampler: uniform, gaussian, bridge_test, obstacle_based, batch).  The goals are random collision free
+   states with the wrist between the boards of the shelf, the same for every sampler; the start is the default state. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <random_numbers/random_numbers.h>
+#include <ros/ros.h>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+void run(const std::string &planner, const std::string &valid_state_sampler, const planning_scene::PlanningSceneConstPtr &scene,
+         const robot_state::RobotState &start, const std::vector<robot_state::RobotState> &goals, double time_limit)
+{
+  const robot_model::JointModelGroup *group = scene->getRobotModel()->getJointModelGroup("right_arm");
+  unsigned int solved = 0;
+  double planning_time = 0.0;
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+  {
+    planning_interface::MotionPlanRequest req;
+    req.group_name = group->getName();
+    req.allowed_planning_time = time_limit;
+    req.num_planning_attempts = 1;
+    req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(goals[i], group));
+
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "benchmark_valid_state_samplers";
+    spec.group = req.group_name;
+    spec.config["type"] = "geometric::" + planner;
+    spec.config["valid_state_sampler"] = valid_state_sampler;
+    spec.simplify_solution = false;
+    spec.interpolate_solution = false;
+    spec.min_waypoint_count = 2;
+    spec.max_waypoint_distance = 0.1;
+    spec.max_num_threads = 1;
+    spec.model = scene->getRobotModel();
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+    ompl_interface::GeometricPlanningContext context;
+    context.setPlanningScene(scene);
+    context.setMotionPlanRequest(req);
+    context.initialize("", spec);
+    context.setCompleteInitialRobotState(start);
+    if (!context.setGoalConstraints(req.goal_constraints, NULL))
+      continue;
+
+    planning_interface::MotionPlanResponse res;
+    if (context.solve(res))
+    {
+      ++solved;
+      planning_time += res.planning_time_;
+    }
+  }
+  printf("%-11s %-15s %8u/%-3u %13.3lf\n", planner.c_str(), valid_state_sampler.c_str(), solved, (unsigned int)goals.size(),
+         solved ? planning_time / solved : 0.0);
+}
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "benchmark_valid_state_samplers", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  const unsigned int queries = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 10;
+  const double time_limit = argc > 2 ? boost::lexical_cast<double>(argv[2]) : 10.0;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  ompl_interface_test::addShelf(scene);
+  robot_state::RobotState start(robot_model);
+  start.setToDefaultValues();
+  start.update();
+
+  // goals with the wrist inside the shelf (between its sides, below the top board)
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("right_arm");
+  random_numbers::RandomNumberGenerator rng(29);
+  std::vector<robot_state::RobotState> goals;
+  for (unsigned long attempt = 0 ; goals.size() < queries && attempt < 10000000 ; ++attempt)
+  {
+    robot_state::RobotState goal(start);
+    goal.setToRandomPositions(group, rng);
+    goal.update();
+    const Eigen::Vector3d &wrist = goal.getGlobalLinkTransform("r_wrist_roll_link").translation();
+    if (wrist.x() > 0.15 && wrist.x() < 0.5 && wrist.y() > -0.78 && wrist.y() < -0.52 && wrist.z() > 0.42 && wrist.z() < 1.13 &&
+        !scene->isStateColliding(goal, group->getName()))
+      goals.push_back(goal);
+  }
+
+  printf("%u queries of at most %lf s, PR2 right arm reaching into a shelf\n", (unsigned int)goals.size(), time_limit);
+  printf("planner     valid sampler     solved    mean time (s)\n");
+  const char *planners[] = { "PRM", "RRTConnect" };
+  const char *samplers[] = { "uniform", "gaussian", "bridge_test", "obstacle_based", "batch" };
+  for (std::size_t p = 0 ; p < sizeof(planners) / sizeof(planners[0]) ; ++p)
+    for (std::size_t s = 0 ; s < sizeof(samplers) / sizeof(samplers[0]) ; ++s)
+      run(planners[p], samplers[s], scene, start, goals, time_limit);
+  return 0;
+}
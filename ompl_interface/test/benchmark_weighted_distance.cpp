@@ -0,0 +1,155 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Time to solution of RRTConnect and PRM for the PR2 right arm next to a shelf, with the default (unweighted) joint
+   distance and with the WeightedJointDistance (distance_metric: weighted).  The states are checked for collisions
+   with the planning scene; the goals are random collision free states, the same for both metrics. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/ompl_interface/parameterization/weighted_joint_distance.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <ompl/geometric/SimpleSetup.h>
+#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <ompl/geometric/planners/prm/PRM.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace
+{
+class SceneValidityChecker : public ompl::base::StateValidityChecker
+{
+public:
+
+  SceneValidityChecker(const ompl::base::SpaceInformationPtr &si, const planning_scene::PlanningSceneConstPtr &scene,
+                       const robot_state::RobotState &state)
+    : ompl::base::StateValidityChecker(si)
+    , space_(si->getStateSpace()->as<ompl_interface::ModelBasedStateSpace>())
+    , scene_(scene)
+    , state_(state)
+  {
+  }
+
+  virtual bool isValid(const ompl::base::State *state) const
+  {
+    space_->copyToRobotState(state_, state);
+    state_.update();
+    return !scene_->isStateColliding(state_, "right_arm");
+  }
+
+private:
+
+  const ompl_interface::ModelBasedStateSpace *space_;
+  planning_scene::PlanningSceneConstPtr       scene_;
+  mutable robot_state::RobotState             state_;
+};
+
+void run(const char *name, const ompl_interface::ModelBasedStateSpacePtr &space, const ompl::base::PlannerAllocator &planner,
+         const planning_scene::PlanningSceneConstPtr &scene, const robot_state::RobotState &start,
+         const std::vector<robot_state::RobotState> &goals, double time_limit)
+{
+  ompl::geometric::SimpleSetup setup(space);
+  setup.setStateValidityChecker(ompl::base::StateValidityCheckerPtr(new SceneValidityChecker(setup.getSpaceInformation(), scene, start)));
+  setup.setPlanner(planner(setup.getSpaceInformation()));
+  setup.setup();
+
+  ompl::base::ScopedState<> start_state(space), goal_state(space);
+  space->copyToOMPLState(start_state.get(), start);
+  unsigned int solved = 0;
+  double planning_time = 0.0;
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+  {
+    space->copyToOMPLState(goal_state.get(), goals[i]);
+    setup.clear();
+    setup.setStartAndGoalStates(start_state, goal_state);
+    if (setup.solve(time_limit) == ompl::base::PlannerStatus::EXACT_SOLUTION)
+    {
+      ++solved;
+      planning_time += setup.getLastPlanComputationTime();
+    }
+  }
+  printf("%-22s %8u/%-3u %13.3lf\n", name, solved, (unsigned int)goals.size(), solved ? planning_time / solved : 0.0);
+}
+
+ompl::base::PlannerPtr allocRRTConnect(const ompl::base::SpaceInformationPtr &si)
+{
+  return ompl::base::PlannerPtr(new ompl::geometric::RRTConnect(si));
+}
+
+ompl::base::PlannerPtr allocPRM(const ompl::base::SpaceInformationPtr &si)
+{
+  return ompl::base::PlannerPtr(new ompl::geometric::PRM(si));
+}
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned int queries = argc > 1 ? boost::lexical_cast<unsigned int>(argv[1]) : 20;
+  const double time_limit = argc > 2 ? boost::lexical_cast<double>(argv[2]) : 10.0;
+
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  ompl_interface_test::addShelf(scene);
+  robot_state::RobotState start(robot_model);
+  start.setToDefaultValues();
+  start.update();
+
+  const ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model, "right_arm");
+  ompl_interface::ModelBasedStateSpacePtr default_space(new ompl_interface::JointModelStateSpace(spec));
+  ompl_interface::ModelBasedStateSpacePtr weighted_space(new ompl_interface::JointModelStateSpace(spec));
+  ompl_interface::WeightedJointDistancePtr metric(new ompl_interface::WeightedJointDistance(robot_model, spec.joint_model_group_));
+  weighted_space->setDistanceFunction(boost::bind(&ompl_interface::WeightedJointDistance::distance, metric, _1, _2));
+
+  // the same collision free goals for both metrics
+  random_numbers::RandomNumberGenerator rng(17);
+  std::vector<robot_state::RobotState> goals;
+  while (goals.size() < queries)
+  {
+    robot_state::RobotState goal(start);
+    goal.setToRandomPositions(spec.joint_model_group_, rng);
+    goal.update();
+    if (!scene->isStateColliding(goal, "right_arm"))
+      goals.push_back(goal);
+  }
+
+  printf("%u queries of at most %lf s, PR2 right arm next to a shelf\n", queries, time_limit);
+  printf("planner, metric         solved    mean time (s)\n");
+  run("RRTConnect, default", default_space, &allocRRTConnect, scene, start, goals, time_limit);
+  run("RRTConnect, weighted", weighted_space, &allocRRTConnect, scene, start, goals, time_limit);
+  run("PRM, default", default_space, &allocPRM, scene, start, goals, time_limit);
+  run("PRM, weighted", weighted_space, &allocPRM, scene, start, goals, time_limit);
+  return 0;
+}
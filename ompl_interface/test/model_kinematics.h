@@ -0,0 +1,288 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_TEST_MODEL_KINEMATICS_
+#define MOVEIT_OMPL_INTERFACE_TEST_MODEL_KINEMATICS_
+
+#include <moveit/kinematics_base/kinematics_base.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <random_numbers/random_numbers.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/bind.hpp>
+#include <Eigen/Cholesky>
+
+namespace ompl_interface_test
+{
+
+/** @class ModelKinematics
+    @brief A kinematics solver whose forward kinematics is computed by RobotState, so tests do not need a kinematics
+    plugin (or a parameter server to initialize one).  Inverse kinematics descends from the seed with damped least
+    squares steps on a numerical Jacobian; searchPositionIK() restarts from random states until the timeout.  Not
+    thread safe: every thread needs its own instance. */
+class ModelKinematics : public kinematics::KinematicsBase
+{
+public:
+
+  ModelKinematics(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup *group,
+                  const std::string &base_frame, const std::string &tip_frame)
+    : group_(group)
+    , state_(robot_model)
+  {
+    setValues("robot_description", group->getName(), base_frame, tip_frame, 0.1);
+    joint_names_ = group->getActiveJointModelNames();
+    link_names_.push_back(tip_frame);
+    state_.setToDefaultValues();
+  }
+
+  virtual bool initialize(const std::string &robot_description, const std::string &group_name,
+                          const std::string &base_frame, const std::string &tip_frame, double search_discretization)
+  {
+    return true;
+  }
+
+  virtual bool getPositionFK(const std::vector<std::string> &link_names, const std::vector<double> &joint_angles,
+                             std::vector<geometry_msgs::Pose> &poses) const
+  {
+    state_.setJointGroupPositions(group_, joint_angles);
+    Eigen::Affine3d base_inverse = state_.getGlobalLinkTransform(base_frame_).inverse();
+    poses.resize(link_names.size());
+    for (std::size_t i = 0 ; i < link_names.size() ; ++i)
+      tf::poseEigenToMsg(base_inverse * state_.getGlobalLinkTransform(link_names[i]), poses[i]);
+    return true;
+  }
+
+  virtual bool getPositionIK(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state,
+                             std::vector<double> &solution, moveit_msgs::MoveItErrorCodes &error_code,
+                             const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const
+  {
+    Eigen::Affine3d target;
+    tf::poseMsgToEigen(ik_pose, target);
+    solution = ik_seed_state;
+    if (descend(target, solution))
+    {
+      error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+      return true;
+    }
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  virtual bool searchPositionIK(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state, double timeout,
+                                std::vector<double> &solution, moveit_msgs::MoveItErrorCodes &error_code,
+                                const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const
+  {
+    return search(ik_pose, ik_seed_state, timeout, std::vector<double>(), solution, IKCallbackFn(), error_code);
+  }
+
+  virtual bool searchPositionIK(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state, double timeout,
+                                const std::vector<double> &consistency_limits, std::vector<double> &solution,
+                                moveit_msgs::MoveItErrorCodes &error_code,
+                                const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const
+  {
+    return search(ik_pose, ik_seed_state, timeout, consistency_limits, solution, IKCallbackFn(), error_code);
+  }
+
+  virtual bool searchPositionIK(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state, double timeout,
+                                std::vector<double> &solution, const IKCallbackFn &solution_callback,
+                                moveit_msgs::MoveItErrorCodes &error_code,
+                                const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const
+  {
+    return search(ik_pose, ik_seed_state, timeout, std::vector<double>(), solution, solution_callback, error_code);
+  }
+
+  virtual bool searchPositionIK(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state, double timeout,
+                                const std::vector<double> &consistency_limits, std::vector<double> &solution,
+                                const IKCallbackFn &solution_callback, moveit_msgs::MoveItErrorCodes &error_code,
+                                const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const
+  {
+    return search(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code);
+  }
+
+  virtual const std::vector<std::string>& getJointNames() const
+  {
+    return joint_names_;
+  }
+
+  virtual const std::vector<std::string>& getLinkNames() const
+  {
+    return link_names_;
+  }
+
+private:
+
+  typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+  /// The pose of the tip frame in the base frame
+  Eigen::Affine3d tipPose(const std::vector<double> &values) const
+  {
+    state_.setJointGroupPositions(group_, values);
+    return state_.getGlobalLinkTransform(base_frame_).inverse() * state_.getGlobalLinkTransform(tip_frame_);
+  }
+
+  /// The translation and the rotation (as a rotation vector) from \e from to \e to
+  static Vector6d poseError(const Eigen::Affine3d &to, const Eigen::Affine3d &from)
+  {
+    Vector6d error;
+    error.head<3>() = to.translation() - from.translation();
+    Eigen::AngleAxisd rotation(to.linear() * from.linear().transpose());
+    error.tail<3>() = rotation.angle() * rotation.axis();
+    return error;
+  }
+
+  /// Damped least squares steps from \e values towards \e target, within the joint bounds.  The buffers are
+  /// members, so that repeated calls do not allocate.
+  bool descend(const Eigen::Affine3d &target, std::vector<double> &values) const
+  {
+    const double delta = 1e-6;
+    Eigen::MatrixXd &jacobian = jacobian_;
+    std::vector<double> &moved = moved_;
+    jacobian.resize(6, values.size());
+    moved.resize(values.size());
+    for (int iteration = 0 ; iteration < 100 ; ++iteration)
+    {
+      Eigen::Affine3d pose = tipPose(values);
+      Vector6d error = poseError(target, pose);
+      if (error.head<3>().norm() < 1e-6 && error.tail<3>().norm() < 1e-5)
+        return true;
+      for (std::size_t j = 0 ; j < values.size() ; ++j)
+      {
+        moved = values;
+        moved[j] += delta;
+        jacobian.col(j) = poseError(tipPose(moved), pose) / delta;
+      }
+      Eigen::Matrix<double, 6, 6> damped = jacobian * jacobian.transpose() + 1e-4 * Eigen::Matrix<double, 6, 6>::Identity();
+      const Vector6d solution = damped.ldlt().solve(error);
+      Eigen::VectorXd &step = step_;
+      step.noalias() = jacobian.transpose() * solution;
+      if (step.norm() > 0.5)
+        step *= 0.5 / step.norm();
+      for (std::size_t j = 0 ; j < values.size() ; ++j)
+        values[j] += step[j];
+      group_->enforcePositionBounds(&values[0]);
+    }
+    return false;
+  }
+
+  /// Descend from the seed, then from random states (near the seed, with consistency limits) until the timeout
+  bool search(const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_seed_state, double timeout,
+              const std::vector<double> &consistency_limits, std::vector<double> &solution,
+              const IKCallbackFn &solution_callback, moveit_msgs::MoveItErrorCodes &error_code) const
+  {
+    Eigen::Affine3d target;
+    tf::poseMsgToEigen(ik_pose, target);
+    const boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time() +
+      boost::posix_time::microseconds((long)(timeout * 1e6));
+    solution = ik_seed_state;
+    while (true)
+    {
+      if (descend(target, solution))
+      {
+        error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+        if (solution_callback)
+          solution_callback(ik_pose, solution, error_code);
+        if (error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+          return true;
+      }
+      if (boost::posix_time::microsec_clock::universal_time() > end)
+      {
+        error_code.val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+        return false;
+      }
+      if (consistency_limits.empty())
+        group_->getVariableRandomPositions(rng_, solution);
+      else
+      {
+        for (std::size_t j = 0 ; j < solution.size() ; ++j)
+          solution[j] = rng_.uniformReal(ik_seed_state[j] - consistency_limits[j], ik_seed_state[j] + consistency_limits[j]);
+        group_->enforcePositionBounds(&solution[0]);
+      }
+    }
+  }
+
+  const robot_model::JointModelGroup *group_;
+  mutable random_numbers::RandomNumberGenerator rng_;
+  mutable robot_state::RobotState state_;
+  mutable Eigen::MatrixXd         jacobian_;
+  mutable std::vector<double>     moved_;
+  mutable Eigen::VectorXd         step_;
+  std::vector<std::string>        joint_names_;
+  std::vector<std::string>        link_names_;
+};
+
+inline kinematics::KinematicsBasePtr allocModelKinematics(const robot_model::RobotModelConstPtr &robot_model,
+                                                          const std::string &base_frame, const std::string &tip_frame,
+                                                          const robot_model::JointModelGroup *group)
+{
+  return kinematics::KinematicsBasePtr(new ModelKinematics(robot_model, group, base_frame, tip_frame));
+}
+
+struct NoDelete
+{
+  void operator()(const robot_model::RobotModel*) const
+  {
+  }
+};
+
+/// An allocator of ModelKinematics solvers between \e base_frame and \e tip_frame.  The solvers do not own the model
+/// (the model owns them, through its groups), so they must not be used after the model is destroyed.
+inline robot_model::SolverAllocatorFn modelKinematicsAllocator(const robot_model::RobotModelPtr &robot_model,
+                                                               const std::string &base_frame, const std::string &tip_frame)
+{
+  robot_model::RobotModelConstPtr model(robot_model.get(), NoDelete());
+  return boost::bind(&allocModelKinematics, model, base_frame, tip_frame, _1);
+}
+
+/// Give \e group a ModelKinematics solver between \e base_frame and \e tip_frame
+inline void setModelKinematics(const robot_model::RobotModelPtr &robot_model, const std::string &group,
+                               const std::string &base_frame, const std::string &tip_frame)
+{
+  robot_model->getJointModelGroup(group)->setSolverAllocators(
+    std::make_pair(modelKinematicsAllocator(robot_model, base_frame, tip_frame), robot_model::SolverAllocatorMapFn()));
+}
+
+/// Give the PR2 "arms" group a ModelKinematics solver for each arm
+inline void setPR2ArmsModelKinematics(const robot_model::RobotModelPtr &robot_model)
+{
+  robot_model::SolverAllocatorMapFn allocators;
+  allocators[robot_model->getJointModelGroup("left_arm")] = modelKinematicsAllocator(robot_model, "torso_lift_link", "l_wrist_roll_link");
+  allocators[robot_model->getJointModelGroup("right_arm")] = modelKinematicsAllocator(robot_model, "torso_lift_link", "r_wrist_roll_link");
+  robot_model->getJointModelGroup("arms")->setSolverAllocators(std::make_pair(robot_model::SolverAllocatorFn(), allocators));
+}
+
+}
+
+#endif
@@ -0,0 +1,262 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+/* Heap allocations of the steady-state planning loop: after a warm-up pass, sampling a state, checking its validity
+   and interpolating to it allocates nothing, for each state space and state sampler of the package.  Allocations are
+   counted by replacing the global operator new and the malloc family (Eigen allocates with malloc).  All pairs of
+   links are allowed to collide, so the collision spheres answer every check: the exact checks of MoveIt's FCL
+   backend allocate per query and are outside this package, as are the constraint samplers of MoveIt. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/ompl_interface/parameterization/projected_space/projected_state_space.h>
+#include <moveit/ompl_interface/detail/halton_state_sampler.h>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void *p, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void  __libc_free(void *p);
+}
+
+namespace
+{
+// the allocations of all threads while counting
+bool counting = false;
+unsigned long allocations = 0;
+
+void countAllocation()
+{
+  if (counting)
+    __sync_fetch_and_add(&allocations, 1);
+}
+}
+
+extern "C"
+{
+void* malloc(std::size_t size) throw()
+{
+  countAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) throw()
+{
+  countAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void *p, std::size_t size) throw()
+{
+  countAllocation();
+  return __libc_realloc(p, size);
+}
+
+int posix_memalign(void **p, std::size_t alignment, std::size_t size) throw()
+{
+  countAllocation();
+  *p = __libc_memalign(alignment, size);
+  return *p ? 0 : ENOMEM;
+}
+
+void free(void *p) throw()
+{
+  __libc_free(p);
+}
+}
+
+void* operator new(std::size_t size) throw(std::bad_alloc)
+{
+  countAllocation();
+  void *p = __libc_malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size) throw(std::bad_alloc)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+  __libc_free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+  __libc_free(p);
+}
+
+class AllocationTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    ompl_interface_test::setModelKinematics(robot_model_, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    const std::vector<std::string> &links = robot_model_->getLinkModelNamesWithCollisionGeometry();
+    scene_->getAllowedCollisionMatrixNonConst().setEntry(links, links, true);
+    start_.reset(new robot_state::RobotState(robot_model_));
+    start_->setToDefaultValues();
+    start_->update();
+  }
+
+  /// A context for the right arm with the parameters in \e config, and constraints on the orientation of the wrist if \e constrained
+  void createContext(std::map<std::string, std::string> config, bool constrained)
+  {
+    planning_interface::MotionPlanRequest req;
+    req.group_name = "right_arm";
+    if (constrained)
+      req.path_constraints = ompl_interface_test::rightWristConstraints(*start_);
+
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "test_allocations";
+    spec.group = req.group_name;
+    spec.config = config;
+    spec.config["static_collision_environment"] = "true";
+    spec.config["collision_spheres"] = "true";
+    spec.max_num_threads = 1;
+    spec.model = robot_model_;
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+    context_.reset(new ompl_interface::GeometricPlanningContext());
+    context_->setPlanningScene(scene_);
+    context_->setMotionPlanRequest(req);
+    context_->initialize("", spec);
+    context_->setCompleteInitialRobotState(*start_);
+  }
+
+  /// Sample states, check them and interpolate to them from the previous sample; return the allocations of the
+  /// second of two passes
+  unsigned long countLoopAllocations(ompl::base::StateSampler &sampler)
+  {
+    const ompl::base::SpaceInformationPtr &si = context_->getOMPLSpaceInformation();
+    const ompl::base::StateValidityCheckerPtr &checker = si->getStateValidityChecker();
+    ompl::base::State *previous = si->allocState();
+    ompl::base::State *sample = si->allocState();
+    ompl::base::State *interpolated = si->allocState();
+    sampler.sampleUniform(previous);
+
+    unsigned long counted = 0;
+    for (int pass = 0 ; pass < 2 ; ++pass)
+    {
+      allocations = 0;
+      counting = pass == 1;
+      for (unsigned int i = 0 ; i < 100 ; ++i)
+      {
+        sampler.sampleUniform(sample);
+        checker->isValid(sample);
+        si->getStateSpace()->interpolate(previous, sample, 0.5, interpolated);
+        checker->isValid(interpolated);
+        si->copyState(previous, sample);
+      }
+      counting = false;
+      counted = allocations;
+    }
+
+    si->freeState(previous);
+    si->freeState(sample);
+    si->freeState(interpolated);
+    return counted;
+  }
+
+  robot_model::RobotModelPtr                                 robot_model_;
+  planning_scene::PlanningScenePtr                           scene_;
+  robot_state::RobotStatePtr                                 start_;
+  boost::shared_ptr<ompl_interface::GeometricPlanningContext> context_;
+};
+
+TEST_F(AllocationTest, JointModelStateSpace)
+{
+  createContext(std::map<std::string, std::string>(), false);
+  ompl::base::StateSamplerPtr sampler = context_->getOMPLStateSpace()->allocDefaultStateSampler();
+  EXPECT_EQ(0u, countLoopAllocations(*sampler));
+}
+
+TEST_F(AllocationTest, HaltonStateSampler)
+{
+  createContext(std::map<std::string, std::string>(), false);
+  ompl_interface::HaltonStateSampler sampler(context_->getOMPLStateSpace().get(), 0);
+  EXPECT_EQ(0u, countLoopAllocations(sampler));
+}
+
+TEST_F(AllocationTest, PoseModelStateSpace)
+{
+  createContext(std::map<std::string, std::string>(), true);
+  ASSERT_TRUE(dynamic_cast<const ompl_interface::PoseModelStateSpace*>(context_->getOMPLStateSpace().get()));
+  ompl::base::StateSamplerPtr sampler = context_->getOMPLStateSpace()->allocDefaultStateSampler();
+  EXPECT_EQ(0u, countLoopAllocations(*sampler));
+}
+
+TEST_F(AllocationTest, PoseModelStateSpaceWithJacobianSteering)
+{
+  std::map<std::string, std::string> config;
+  config["interpolation_steering"] = "jacobian";
+  createContext(config, true);
+  ASSERT_TRUE(dynamic_cast<const ompl_interface::PoseModelStateSpace*>(context_->getOMPLStateSpace().get()));
+  ompl::base::StateSamplerPtr sampler = context_->getOMPLStateSpace()->allocDefaultStateSampler();
+  EXPECT_EQ(0u, countLoopAllocations(*sampler));
+}
+
+TEST_F(AllocationTest, ProjectedStateSpace)
+{
+  std::map<std::string, std::string> config;
+  config["parameterization"] = "projected";
+  createContext(config, true);
+  ASSERT_TRUE(dynamic_cast<const ompl_interface::ProjectedStateSpace*>(context_->getOMPLStateSpace().get()));
+  ompl::base::StateSamplerPtr sampler = context_->getOMPLStateSpace()->allocDefaultStateSampler();
+  EXPECT_EQ(0u, countLoopAllocations(*sampler));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_allocations", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,199 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/detail/batch_state_sampler.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+/// Constraints on the pose of \e link in \e state: within a \e box_size cube around its position, and within
+/// \e angle of its orientation about each axis
+moveit_msgs::Constraints linkConstraints(const robot_state::RobotState &state, const std::string &link, double box_size, double angle)
+{
+  const Eigen::Affine3d &pose = state.getGlobalLinkTransform(link);
+  moveit_msgs::Constraints constraints;
+
+  moveit_msgs::PositionConstraint pc;
+  pc.header.frame_id = state.getRobotModel()->getModelFrame();
+  pc.link_name = link;
+  shape_msgs::SolidPrimitive box;
+  box.type = shape_msgs::SolidPrimitive::BOX;
+  box.dimensions.resize(3, box_size);
+  pc.constraint_region.primitives.push_back(box);
+  geometry_msgs::Pose center;
+  tf::poseEigenToMsg(Eigen::Affine3d(Eigen::Translation3d(pose.translation())), center);
+  pc.constraint_region.primitive_poses.push_back(center);
+  pc.weight = 1.0;
+  constraints.position_constraints.push_back(pc);
+
+  moveit_msgs::OrientationConstraint oc;
+  oc.header.frame_id = pc.header.frame_id;
+  oc.link_name = link;
+  tf::quaternionEigenToMsg(Eigen::Quaterniond(pose.rotation()), oc.orientation);
+  oc.absolute_x_axis_tolerance = angle;
+  oc.absolute_y_axis_tolerance = angle;
+  oc.absolute_z_axis_tolerance = angle;
+  oc.weight = 1.0;
+  constraints.orientation_constraints.push_back(oc);
+  return constraints;
+}
+
+moveit_msgs::JointConstraint jointConstraint(const std::string &joint, double position, double tolerance)
+{
+  moveit_msgs::JointConstraint jc;
+  jc.joint_name = joint;
+  jc.position = position;
+  jc.tolerance_above = tolerance;
+  jc.tolerance_below = tolerance;
+  jc.weight = 1.0;
+  return jc;
+}
+}
+
+class BatchStateSamplerTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+  }
+
+  /// Filter uniform batches of \e group by \e constraints; every sample must be kept exactly when the constraint set
+  /// decides that it satisfies the constraints.  The torso is raised, so the chains start from a moved link.
+  void checkFilter(const robot_model::RobotModelPtr &model, const std::string &group, const moveit_msgs::Constraints &constraints)
+  {
+    robot_state::RobotState work_state(model);
+    work_state.setToDefaultValues();
+    work_state.setVariablePosition("torso_lift_joint", 0.2);
+    work_state.update();
+    robot_state::Transforms tf(model->getModelFrame());
+    kinematic_constraints::KinematicConstraintSet constraint_set(model);
+    ASSERT_TRUE(constraint_set.add(constraints, tf));
+
+    ompl_interface::ModelBasedStateSpacePtr space(new ompl_interface::JointModelStateSpace(
+                                                    ompl_interface::ModelBasedStateSpaceSpecification(model, group)));
+    ompl_interface::BatchStateSampler sampler(space);
+    const robot_model::JointModelGroup *jmg = model->getJointModelGroup(group);
+    robot_state::RobotState state(work_state);
+    std::vector<double> values(jmg->getVariableCount());
+    ompl_interface::SampleBatch batch;
+    std::size_t accepted = 0;
+    std::size_t total = 0;
+    for (int b = 0 ; b < 20 ; ++b)
+    {
+      sampler.sampleUniform(batch, 250);
+      const std::size_t valid = sampler.filter(batch, constraint_set, work_state);
+      EXPECT_EQ(batch.countValid(), valid);
+      for (std::size_t i = 0 ; i < batch.size() ; ++i)
+      {
+        batch.getSample(i, &values[0]);
+        state.setJointGroupPositions(jmg, &values[0]);
+        state.update();
+        EXPECT_EQ(constraint_set.decide(state).satisfied, batch.isValid(i)) << "batch " << b << ", sample " << i;
+      }
+      accepted += valid;
+      total += batch.size();
+    }
+    // both outcomes must be exercised
+    EXPECT_GT(accepted, 0u);
+    EXPECT_LT(accepted, total);
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+};
+
+TEST_F(BatchStateSamplerTest, FilterMatchesDecideWithContinuousJoints)
+{
+  robot_state::RobotState state(robot_model_);
+  state.setToDefaultValues();
+  state.update();
+  moveit_msgs::Constraints constraints = linkConstraints(state, "r_wrist_roll_link", 0.8, 1.2);
+  constraints.joint_constraints.push_back(jointConstraint("r_elbow_flex_joint", -1.0, 0.8));
+  constraints.joint_constraints.push_back(jointConstraint("r_forearm_roll_joint", 0.0, 2.0));
+  checkFilter(robot_model_, "right_arm", constraints);
+}
+
+TEST_F(BatchStateSamplerTest, FilterMatchesDecideWithoutJointConstraints)
+{
+  robot_state::RobotState state(robot_model_);
+  state.setToDefaultValues();
+  state.update();
+  checkFilter(robot_model_, "right_arm", linkConstraints(state, "r_wrist_roll_link", 0.6, 1.0));
+}
+
+TEST_F(BatchStateSamplerTest, FilterMatchesDecideWithMimicJoints)
+{
+  // a chain from the torso to a fingertip of the right gripper, moved by a mimic joint
+  boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+  std::ifstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str());
+  std::stringstream xml_string;
+  xml_string << xml_file.rdbuf();
+  boost::shared_ptr<urdf::ModelInterface> urdf_model = urdf::parseURDF(xml_string.str());
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  ASSERT_TRUE(srdf_model->initString(*urdf_model, "<robot name=\"pr2\"><group name=\"right_finger\">"
+                                     "<chain base_link=\"torso_lift_link\" tip_link=\"r_gripper_l_finger_tip_link\"/>"
+                                     "</group></robot>"));
+  robot_model::RobotModelPtr model(new robot_model::RobotModel(urdf_model, srdf_model));
+  const robot_model::JointModelGroup *group = model->getJointModelGroup("right_finger");
+  ASSERT_TRUE(group);
+  ASSERT_FALSE(group->getMimicJointModels().empty());
+
+  robot_state::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+  moveit_msgs::Constraints constraints = linkConstraints(state, "r_gripper_l_finger_tip_link", 0.8, 1.2);
+  constraints.joint_constraints.push_back(jointConstraint("r_wrist_roll_joint", 0.0, 2.0));
+  constraints.joint_constraints.push_back(jointConstraint("r_gripper_l_finger_joint", 0.2, 0.2));
+  checkFilter(model, "right_finger", constraints);
+}
+
+TEST_F(BatchStateSamplerTest, FilterChecksJointConstraintsAlone)
+{
+  moveit_msgs::Constraints constraints;
+  constraints.joint_constraints.push_back(jointConstraint("r_shoulder_pan_joint", 0.0, 0.5));
+  constraints.joint_constraints.push_back(jointConstraint("r_elbow_flex_joint", -1.0, 0.5));
+  checkFilter(robot_model_, "right_arm", constraints);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,223 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+// This test is built twice, once with the default instruction set (SSE2 on x86_64) and once with -mavx,
+// so both vectorized paths of BoundedJointKernels are compared against the JointModel implementation.
+
+#include <moveit/ompl_interface/parameterization/bounded_joint_kernels.h>
+#include <urdf_parser/urdf_parser.h>
+#include <random_numbers/random_numbers.h>
+#include <gtest/gtest.h>
+#include <boost/math/special_functions/sign.hpp>
+#include <iostream>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+
+// seven joints, so the vectorized loops run at least once and leave a remainder for the scalar loop
+const char *URDF =
+  "<robot name=\"chain\">"
+  "  <link name=\"l0\"/><link name=\"l1\"/><link name=\"l2\"/><link name=\"l3\"/><link name=\"l4\"/>"
+  "  <link name=\"l5\"/><link name=\"l6\"/><link name=\"l7\"/><link name=\"l8\"/>"
+  "  <joint name=\"j1\" type=\"revolute\"><parent link=\"l0\"/><child link=\"l1\"/><axis xyz=\"0 0 1\"/>"
+  "    <limit lower=\"-3.14159\" upper=\"3.14159\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j2\" type=\"prismatic\"><parent link=\"l1\"/><child link=\"l2\"/><axis xyz=\"1 0 0\"/>"
+  "    <limit lower=\"-0.5\" upper=\"0.5\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j3\" type=\"revolute\"><parent link=\"l2\"/><child link=\"l3\"/><axis xyz=\"0 1 0\"/>"
+  "    <limit lower=\"-2.0\" upper=\"1.0\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j4\" type=\"revolute\"><parent link=\"l3\"/><child link=\"l4\"/><axis xyz=\"0 0 1\"/>"
+  "    <limit lower=\"-3.14159\" upper=\"3.14159\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j5\" type=\"prismatic\"><parent link=\"l4\"/><child link=\"l5\"/><axis xyz=\"0 0 1\"/>"
+  "    <limit lower=\"0.0\" upper=\"1.0\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j6\" type=\"revolute\"><parent link=\"l5\"/><child link=\"l6\"/><axis xyz=\"1 0 0\"/>"
+  "    <limit lower=\"-1.5\" upper=\"1.5\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j7\" type=\"revolute\"><parent link=\"l6\"/><child link=\"l7\"/><axis xyz=\"0 0 1\"/>"
+  "    <limit lower=\"-3.14159\" upper=\"3.14159\" effort=\"1\" velocity=\"1\"/></joint>"
+  "  <joint name=\"j8\" type=\"continuous\"><parent link=\"l7\"/><child link=\"l8\"/><axis xyz=\"0 0 1\"/></joint>"
+  "</robot>";
+
+const char *SRDF =
+  "<robot name=\"chain\">"
+  "  <group name=\"bounded\"><joint name=\"j1\"/><joint name=\"j2\"/><joint name=\"j3\"/><joint name=\"j4\"/>"
+  "    <joint name=\"j5\"/><joint name=\"j6\"/><joint name=\"j7\"/></group>"
+  "  <group name=\"with_continuous\"><joint name=\"j1\"/><joint name=\"j2\"/><joint name=\"j3\"/><joint name=\"j4\"/>"
+  "    <joint name=\"j5\"/><joint name=\"j6\"/><joint name=\"j7\"/><joint name=\"j8\"/></group>"
+  "</robot>";
+
+robot_model::RobotModelPtr loadChainModel()
+{
+  boost::shared_ptr<urdf::ModelInterface> urdf_model = urdf::parseURDF(URDF);
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  srdf_model->initString(*urdf_model, SRDF);
+  return robot_model::RobotModelPtr(new robot_model::RobotModel(urdf_model, srdf_model));
+}
+
+// the generic computation, joint by joint
+double jointDistance(const robot_model::JointModelGroup *group, const double *state1, const double *state2)
+{
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  double d = 0.0;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+    d += joints[i]->getDistanceFactor() * joints[i]->distance(state1 + i, state2 + i);
+  return d;
+}
+
+void jointInterpolate(const robot_model::JointModelGroup *group, const double *from, const double *to, double t, double *state)
+{
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+    joints[i]->interpolate(from + i, to + i, t, state + i);
+}
+
+// the results must be identical: same value, same sign of zero, and NaN where the generic code produces NaN
+::testing::AssertionResult identical(double expected, double actual)
+{
+  if (expected != expected && actual != actual)
+    return ::testing::AssertionSuccess();
+  if (expected == actual && boost::math::signbit(expected) == boost::math::signbit(actual))
+    return ::testing::AssertionSuccess();
+  return ::testing::AssertionFailure() << "expected " << expected << " (sign " << boost::math::signbit(expected)
+                                       << "), got " << actual << " (sign " << boost::math::signbit(actual) << ")";
+}
+
+class BoundedJointKernelsTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = loadChainModel();
+    group_ = robot_model_->getJointModelGroup("bounded");
+    ASSERT_TRUE(group_ != NULL);
+    ASSERT_TRUE(ompl_interface::BoundedJointKernels::isApplicable(group_, group_->getActiveJointModelsBounds()));
+    kernels_.reset(new ompl_interface::BoundedJointKernels(group_, group_->getActiveJointModelsBounds(), 0.0));
+  }
+
+  void compare(const std::vector<double> &a, const std::vector<double> &b)
+  {
+    EXPECT_TRUE(identical(jointDistance(group_, &a[0], &b[0]), kernels_->distance(&a[0], &b[0])));
+    EXPECT_TRUE(identical(jointDistance(group_, &b[0], &a[0]), kernels_->distance(&b[0], &a[0])));
+    const double ts[] = { 0.0, 0.25, 0.5, 1.0 / 3.0, 0.999, 1.0 };
+    std::vector<double> expected(a.size()), actual(a.size());
+    for (std::size_t k = 0 ; k < sizeof(ts) / sizeof(ts[0]) ; ++k)
+    {
+      jointInterpolate(group_, &a[0], &b[0], ts[k], &expected[0]);
+      kernels_->interpolate(&a[0], &b[0], ts[k], &actual[0]);
+      for (std::size_t i = 0 ; i < a.size() ; ++i)
+        EXPECT_TRUE(identical(expected[i], actual[i])) << "variable " << i << ", t = " << ts[k];
+    }
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+  const robot_model::JointModelGroup *group_;
+  ompl_interface::BoundedJointKernelsPtr kernels_;
+};
+
+}
+
+TEST_F(BoundedJointKernelsTest, RandomStates)
+{
+  random_numbers::RandomNumberGenerator rng(11);
+  std::vector<double> a(group_->getVariableCount()), b(group_->getVariableCount());
+  for (int i = 0 ; i < 1000 ; ++i)
+  {
+    group_->getVariableRandomPositions(rng, a);
+    group_->getVariableRandomPositions(rng, b);
+    compare(a, b);
+  }
+}
+
+TEST_F(BoundedJointKernelsTest, NaN)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> a(group_->getVariableCount(), 0.1), b(group_->getVariableCount(), -0.2);
+  // one NaN in the vectorized part, one in the scalar remainder
+  a[1] = nan;
+  b[6] = nan;
+  compare(a, b);
+  std::vector<double> c(group_->getVariableCount(), nan);
+  compare(c, b);
+  compare(c, c);
+}
+
+TEST_F(BoundedJointKernelsTest, NegativeZero)
+{
+  std::vector<double> a(group_->getVariableCount(), -0.0), b(group_->getVariableCount(), 0.0);
+  compare(a, a);
+  compare(a, b);
+  b[0] = 0.5;
+  b[5] = -0.5;
+  compare(a, b);
+}
+
+// bounded revolute joints do not wrap around: going from near pi to near -pi is the long way, as for JointModel
+TEST_F(BoundedJointKernelsTest, Wraparound)
+{
+  std::vector<double> a(group_->getVariableCount(), 0.0), b(group_->getVariableCount(), 0.0);
+  a[0] = a[3] = a[6] = 3.14;
+  b[0] = b[3] = b[6] = -3.14;
+  compare(a, b);
+  EXPECT_NEAR(6.28 * 3.0, kernels_->distance(&a[0], &b[0]), 1e-9);
+}
+
+// a continuous joint wraps around, which the kernels do not implement, so such groups must not use them
+TEST(BoundedJointKernels, ContinuousJointIsNotApplicable)
+{
+  robot_model::RobotModelPtr robot_model = loadChainModel();
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("with_continuous");
+  ASSERT_TRUE(group != NULL);
+  EXPECT_FALSE(ompl_interface::BoundedJointKernels::isApplicable(group, group->getActiveJointModelsBounds()));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+#if defined(__AVX__)
+  if (!__builtin_cpu_supports("avx"))
+  {
+    std::cout << "The CPU does not support AVX; not running the AVX build of the test" << std::endl;
+    return 0;
+  }
+  std::cout << "Testing the AVX kernels" << std::endl;
+#elif defined(__SSE2__)
+  std::cout << "Testing the SSE2 kernels" << std::endl;
+#else
+  std::cout << "Testing the scalar kernels" << std::endl;
+#endif
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/detail/collision_spheres.h>
+#include <random_numbers/random_numbers.h>
+#include <gtest/gtest.h>
+
+// the spheres are conservative: a state they accept is collision free
+TEST(CollisionSpheres, AcceptedStatesAreCollisionFree)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  ompl_interface_test::addShelf(scene);
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("right_arm");
+
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  ompl_interface::StaticCollisionEnvironment environment(scene, group, state);
+  ompl_interface::CollisionSpheres spheres(environment, scene, state, 0.01);
+  ASSERT_TRUE(spheres.isValid());
+
+  random_numbers::RandomNumberGenerator rng(7);
+  std::vector<double> values(group->getVariableCount());
+  unsigned int accepted = 0;
+  for (unsigned int i = 0 ; i < 5000 ; ++i)
+  {
+    group->getVariableRandomPositions(rng, values);
+    state.setJointGroupPositions(group, values);
+    state.update();
+    if (spheres.isClear(state))
+    {
+      ++accepted;
+      EXPECT_FALSE(scene->isStateColliding(state)) << "state " << i;
+    }
+  }
+  EXPECT_GT(accepted, 0u);
+}
+
+TEST(CollisionSpheres, ComputeSpheresCoversBox)
+{
+  shapes::Box box(1.0, 0.2, 0.1);
+  Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+  pose.translation() = Eigen::Vector3d(1.0, 2.0, 3.0);
+  std::vector<ompl_interface::CollisionSpheres::Sphere> spheres;
+  ASSERT_TRUE(ompl_interface::CollisionSpheres::computeSpheres(box, pose, spheres));
+  ASSERT_FALSE(spheres.empty());
+
+  // every corner of the box is inside a sphere
+  for (int i = 0 ; i < 8 ; ++i)
+  {
+    Eigen::Vector3d corner = pose * Eigen::Vector3d(i & 1 ? 0.5 : -0.5, i & 2 ? 0.1 : -0.1, i & 4 ? 0.05 : -0.05);
+    bool covered = false;
+    for (std::size_t j = 0 ; j < spheres.size() && !covered ; ++j)
+      covered = (corner - spheres[j].center).norm() <= spheres[j].radius + 1e-9;
+    EXPECT_TRUE(covered) << "corner " << i;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
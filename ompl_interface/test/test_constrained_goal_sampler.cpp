@@ -0,0 +1,199 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/detail/worker_ik_constraint_sampler.h>
+#include <moveit/constraint_samplers/constraint_sampler_manager.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+kinematics::KinematicsBasePtr countAllocation(const robot_model::SolverAllocatorFn &allocator, unsigned int *count,
+                                              const robot_model::JointModelGroup *group)
+{
+  ++*count;
+  return allocator(group);
+}
+
+// the number of sampled states that satisfy the constraints
+void sampleStates(constraint_samplers::ConstraintSampler *sampler, const kinematic_constraints::KinematicConstraintSet *constraints,
+                  const robot_state::RobotState *reference_state, unsigned int samples, unsigned int *satisfied)
+{
+  robot_state::RobotState state(*reference_state);
+  *satisfied = 0;
+  for (unsigned int i = 0 ; i < samples ; ++i)
+    if (sampler->sample(state, *reference_state, 3))
+    {
+      state.update();
+      if (constraints->decide(state).satisfied)
+        ++*satisfied;
+    }
+}
+}
+
+class ConstrainedGoalSamplerTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    allocations_ = 0;
+    robot_model_->getJointModelGroup("right_arm")->setSolverAllocators(
+      boost::bind(&countAllocation, ompl_interface_test::modelKinematicsAllocator(robot_model_, "torso_lift_link", "r_wrist_roll_link"),
+                  &allocations_, _1));
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    state_.reset(new robot_state::RobotState(robot_model_));
+    state_->setToDefaultValues();
+    state_->update();
+    goal_ = ompl_interface_test::rightWristConstraints(*state_, 0.05);
+  }
+
+  ompl_interface::WorkerIKConstraintSamplerPtr allocWorkerSampler() const
+  {
+    ompl_interface::WorkerIKConstraintSamplerPtr sampler(new ompl_interface::WorkerIKConstraintSampler(scene_, "right_arm"));
+    EXPECT_TRUE(sampler->configure(goal_));
+    return sampler;
+  }
+
+  robot_model::RobotModelPtr       robot_model_;
+  planning_scene::PlanningScenePtr scene_;
+  robot_state::RobotStatePtr       state_;
+  moveit_msgs::Constraints         goal_;
+  unsigned int                     allocations_;
+};
+
+TEST_F(ConstrainedGoalSamplerTest, AllocatesSolverPerSampler)
+{
+  const unsigned int shared = allocations_;
+  ompl_interface::WorkerIKConstraintSamplerPtr first = allocWorkerSampler();
+  ompl_interface::WorkerIKConstraintSamplerPtr second = allocWorkerSampler();
+  EXPECT_EQ(shared + 2, allocations_);
+  ASSERT_TRUE(first->getSolver());
+  EXPECT_NE(first->getSolver(), second->getSolver());
+  EXPECT_NE(first->getSolver(), robot_model_->getJointModelGroup("right_arm")->getSolverInstance());
+}
+
+TEST_F(ConstrainedGoalSamplerTest, RejectsOtherConstraints)
+{
+  // joint constraints are left to the samplers of MoveIt
+  moveit_msgs::Constraints constraints = goal_;
+  moveit_msgs::JointConstraint jc;
+  jc.joint_name = "r_elbow_flex_joint";
+  jc.position = -0.5;
+  jc.tolerance_above = jc.tolerance_below = 0.1;
+  jc.weight = 1.0;
+  constraints.joint_constraints.push_back(jc);
+  EXPECT_FALSE(ompl_interface::WorkerIKConstraintSampler::canSample(scene_, "right_arm", constraints));
+
+  // the constrained link is not the tip of the solver
+  constraints = goal_;
+  constraints.position_constraints[0].link_name = constraints.orientation_constraints[0].link_name = "r_elbow_flex_link";
+  EXPECT_FALSE(ompl_interface::WorkerIKConstraintSampler::canSample(scene_, "right_arm", constraints));
+
+  EXPECT_TRUE(ompl_interface::WorkerIKConstraintSampler::canSample(scene_, "right_arm", goal_));
+}
+
+TEST_F(ConstrainedGoalSamplerTest, ManagerAllocatesWorkerSamplers)
+{
+  constraint_samplers::ConstraintSamplerManager manager;
+  manager.registerSamplerAllocator(constraint_samplers::ConstraintSamplerAllocatorPtr(new ompl_interface::WorkerIKConstraintSamplerAllocator()));
+  const unsigned int shared = allocations_;
+  constraint_samplers::ConstraintSamplerPtr sampler = manager.selectSampler(scene_, "right_arm", goal_);
+  EXPECT_TRUE(dynamic_cast<ompl_interface::WorkerIKConstraintSampler*>(sampler.get()));
+  EXPECT_EQ(shared + 1, allocations_);
+
+  moveit_msgs::Constraints constraints = goal_;
+  moveit_msgs::JointConstraint jc;
+  jc.joint_name = "r_elbow_flex_joint";
+  jc.position = -0.5;
+  jc.tolerance_above = jc.tolerance_below = 0.1;
+  jc.weight = 1.0;
+  constraints.joint_constraints.push_back(jc);
+  sampler = manager.selectSampler(scene_, "right_arm", constraints);
+  EXPECT_FALSE(dynamic_cast<ompl_interface::WorkerIKConstraintSampler*>(sampler.get()));
+}
+
+TEST_F(ConstrainedGoalSamplerTest, SamplesSatisfyConstraints)
+{
+  kinematic_constraints::KinematicConstraintSet constraints(robot_model_);
+  ASSERT_TRUE(constraints.add(goal_, scene_->getTransforms()));
+  ompl_interface::WorkerIKConstraintSamplerPtr sampler = allocWorkerSampler();
+
+  const unsigned int SAMPLES = 20;
+  unsigned int satisfied = 0;
+  sampleStates(sampler.get(), &constraints, state_.get(), SAMPLES, &satisfied);
+  EXPECT_GE(satisfied, SAMPLES / 2);
+
+  // projecting a satisfying state keeps it satisfying
+  robot_state::RobotState state(*state_);
+  ASSERT_TRUE(sampler->sample(state, *state_, 10));
+  ASSERT_TRUE(sampler->project(state, 10));
+  state.update();
+  EXPECT_TRUE(constraints.decide(state).satisfied);
+}
+
+TEST_F(ConstrainedGoalSamplerTest, SamplersWithOwnSolversRunConcurrently)
+{
+  // the test solver keeps its state in the instance; concurrent calls on a shared instance corrupt the solutions
+  kinematic_constraints::KinematicConstraintSet constraints(robot_model_);
+  ASSERT_TRUE(constraints.add(goal_, scene_->getTransforms()));
+
+  const unsigned int WORKERS = 4;
+  const unsigned int SAMPLES = 10;
+  std::vector<ompl_interface::WorkerIKConstraintSamplerPtr> samplers;
+  std::vector<unsigned int> satisfied(WORKERS, 0);
+  for (unsigned int i = 0 ; i < WORKERS ; ++i)
+    samplers.push_back(allocWorkerSampler());
+
+  boost::thread_group threads;
+  for (unsigned int i = 0 ; i < WORKERS ; ++i)
+    threads.create_thread(boost::bind(&sampleStates, samplers[i].get(), &constraints, state_.get(), SAMPLES, &satisfied[i]));
+  threads.join_all();
+
+  for (unsigned int i = 0 ; i < WORKERS ; ++i)
+    EXPECT_GE(satisfied[i], SAMPLES / 2) << "worker " << i;
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
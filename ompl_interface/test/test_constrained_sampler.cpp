@@ -0,0 +1,287 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+/* Adaptation and counts of the ConstrainedSampler, driven by a stub constraint sampler whose success rate and cost are
+   known: the budgets have to move in the direction those call for, and the statistics have to count every sample. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/ompl_interface/detail/constrained_sampler.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <random_numbers/random_numbers.h>
+#include <ompl/util/Time.h>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+void spend(double seconds)
+{
+  ompl::time::point end = ompl::time::now() + ompl::time::seconds(seconds);
+  while (ompl::time::now() < end)
+    ;
+}
+
+/** A constraint sampler that pays \e call_cost seconds per call and \e attempt_cost per attempt; each of the first
+    \e useful_attempts attempts of a call succeeds with probability \e success, and the sampled state is the reference
+    state.  It counts its calls and successes. */
+class StubConstraintSampler : public constraint_samplers::ConstraintSampler
+{
+public:
+
+  StubConstraintSampler(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name, double success,
+                        double call_cost, double attempt_cost, unsigned int useful_attempts)
+    : constraint_samplers::ConstraintSampler(scene, group_name)
+    , success_(success)
+    , call_cost_(call_cost)
+    , attempt_cost_(attempt_cost)
+    , useful_attempts_(useful_attempts)
+    , rng_(42)
+    , calls_(0)
+    , successes_(0)
+  {
+    is_valid_ = true;
+  }
+
+  virtual bool configure(const moveit_msgs::Constraints &constr)
+  {
+    return true;
+  }
+
+  virtual bool sample(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts)
+  {
+    ++calls_;
+    spend(call_cost_);
+    for (unsigned int i = 0 ; i < max_attempts ; ++i)
+    {
+      spend(attempt_cost_);
+      if (i < useful_attempts_ && rng_.uniform01() < success_)
+      {
+        state = reference_state;
+        ++successes_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  virtual bool project(robot_state::RobotState &state, unsigned int max_attempts)
+  {
+    return false;
+  }
+
+  virtual const std::string& getName() const
+  {
+    static const std::string name = "stub";
+    return name;
+  }
+
+  unsigned int getCalls() const
+  {
+    return calls_;
+  }
+
+  unsigned int getSuccesses() const
+  {
+    return successes_;
+  }
+
+private:
+
+  double                               success_;
+  double                               call_cost_;
+  double                               attempt_cost_;
+  unsigned int                         useful_attempts_;
+  random_numbers::RandomNumberGenerator rng_;
+  unsigned int                         calls_;
+  unsigned int                         successes_;
+};
+}
+
+class ConstrainedSamplerTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    robot_state::RobotState start(robot_model_);
+    start.setToDefaultValues();
+    start.update();
+
+    planning_interface::MotionPlanRequest req;
+    req.group_name = "right_arm";
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "test_constrained_sampler";
+    spec.group = req.group_name;
+    spec.max_num_threads = 1;
+    spec.model = robot_model_;
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+    context_.reset(new ompl_interface::GeometricPlanningContext());
+    context_->setPlanningScene(scene_);
+    context_->setMotionPlanRequest(req);
+    context_->initialize("", spec);
+    context_->setCompleteInitialRobotState(start);
+
+    // the wrist in a 5 cm box at its start pose: the start state satisfies it, uniform samples practically never do
+    constraints_.reset(new kinematic_constraints::KinematicConstraintSet(robot_model_));
+    ASSERT_TRUE(constraints_->add(ompl_interface_test::rightWristConstraints(start, 0.05), scene_->getTransforms()));
+    ASSERT_TRUE(constraints_->decide(start).satisfied);
+    statistics_.reset(new ompl_interface::ConstrainedSamplerStatistics());
+  }
+
+  boost::shared_ptr<StubConstraintSampler> createStub(double success, double call_cost, double attempt_cost,
+                                                      unsigned int useful_attempts = 1000)
+  {
+    return boost::shared_ptr<StubConstraintSampler>(new StubConstraintSampler(scene_, "right_arm", success, call_cost,
+                                                                              attempt_cost, useful_attempts));
+  }
+
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> createSampler(const constraint_samplers::ConstraintSamplerPtr &cs)
+  {
+    return boost::shared_ptr<ompl_interface::ConstrainedSampler>(
+      new ompl_interface::ConstrainedSampler(context_.get(), cs, constraints_, statistics_));
+  }
+
+  void sample(ompl_interface::ConstrainedSampler &sampler, unsigned int count)
+  {
+    ompl::base::State *state = context_->getOMPLStateSpace()->allocState();
+    for (unsigned int i = 0 ; i < count ; ++i)
+      sampler.sampleUniform(state);
+    context_->getOMPLStateSpace()->freeState(state);
+  }
+
+  robot_model::RobotModelPtr                                  robot_model_;
+  planning_scene::PlanningScenePtr                            scene_;
+  boost::shared_ptr<ompl_interface::GeometricPlanningContext> context_;
+  kinematic_constraints::KinematicConstraintSetPtr            constraints_;
+  ompl_interface::ConstrainedSamplerStatisticsPtr             statistics_;
+};
+
+TEST_F(ConstrainedSamplerTest, AttemptsGrowWhenCallsAreExpensive)
+{
+  // every call pays for a setup ten times the cost of an attempt: more attempts per call yield more states per second
+  boost::shared_ptr<StubConstraintSampler> stub = createStub(0.1, 2e-4, 2e-5);
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> sampler = createSampler(stub);
+  unsigned int initial = sampler->getAttempts();
+  sample(*sampler, 2000);
+  EXPECT_GT(sampler->getAttempts(), initial);
+}
+
+TEST_F(ConstrainedSamplerTest, AttemptsShrinkWhenRetriesAreWasted)
+{
+  // only the first attempt of a call can succeed: every further attempt is time lost
+  boost::shared_ptr<StubConstraintSampler> stub = createStub(0.5, 0.0, 5e-5, 1);
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> sampler = createSampler(stub);
+  unsigned int initial = sampler->getAttempts();
+  sample(*sampler, 2000);
+  EXPECT_LT(sampler->getAttempts(), initial);
+}
+
+TEST_F(ConstrainedSamplerTest, CallsFollowSuccessRate)
+{
+  // calls that hardly ever succeed are repeated before falling back to a uniform sample
+  boost::shared_ptr<StubConstraintSampler> rare = createStub(0.02, 0.0, 1e-6);
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> sampler = createSampler(rare);
+  unsigned int initial = sampler->getCalls();
+  sample(*sampler, 500);
+  EXPECT_GT(sampler->getCalls(), initial);
+
+  // calls that practically always succeed are not repeated
+  boost::shared_ptr<StubConstraintSampler> reliable = createStub(0.99, 0.0, 1e-6);
+  sampler = createSampler(reliable);
+  sample(*sampler, 500);
+  EXPECT_EQ(1u, sampler->getCalls());
+}
+
+TEST_F(ConstrainedSamplerTest, UniformShareDecaysWhenUniformSamplesNeverSatisfy)
+{
+  // the constraint sampler never fails, so all uniform samples come from the uniform share
+  boost::shared_ptr<StubConstraintSampler> stub = createStub(1.0, 0.0, 1e-6);
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> sampler = createSampler(stub);
+  double initial = sampler->getConstrainedFraction();
+  ASSERT_LT(initial, 1.0);
+  sample(*sampler, 1000);
+  double fraction = sampler->getConstrainedFraction();
+  EXPECT_GT(fraction, initial);
+  sample(*sampler, 2000);
+  EXPECT_GE(sampler->getConstrainedFraction(), fraction);
+  EXPECT_GT(sampler->getConstrainedFraction(), 0.99);
+
+  // the uniform samples of a window shrink accordingly
+  statistics_->reset();
+  sample(*sampler, 1000);
+  EXPECT_EQ(0u, statistics_->getCounts().uniform_satisfied);
+  EXPECT_LT(statistics_->getCounts().uniform_samples, 50u);
+}
+
+TEST_F(ConstrainedSamplerTest, CountsAddUpPerSolve)
+{
+  boost::shared_ptr<StubConstraintSampler> stub = createStub(0.3, 0.0, 1e-6);
+  boost::shared_ptr<ompl_interface::ConstrainedSampler> sampler = createSampler(stub);
+
+  // fewer samples than a window: nothing may wait for the window to fill, or for the sampler to be destroyed
+  for (int solve = 0 ; solve < 3 ; ++solve)
+  {
+    statistics_->reset();
+    unsigned int calls = stub->getCalls();
+    unsigned int successes = stub->getSuccesses();
+    const unsigned int count = solve == 0 ? 10 : 150;
+    sample(*sampler, count);
+
+    ompl_interface::ConstrainedSamplerStatistics::Counts counts = statistics_->getCounts();
+    EXPECT_EQ(stub->getCalls() - calls, counts.constrained_calls);
+    EXPECT_EQ(stub->getSuccesses() - successes, counts.constrained_successes);
+    // every sample is either a state of the constraint sampler or a uniform one
+    EXPECT_EQ(count, counts.constrained_successes + counts.uniform_samples);
+    EXPECT_LE(counts.uniform_satisfied, counts.uniform_samples);
+    EXPECT_GT(counts.constrained_time, 0.0);
+  }
+
+  // destroying the sampler adds nothing further
+  ompl_interface::ConstrainedSamplerStatistics::Counts before = statistics_->getCounts();
+  sampler.reset();
+  EXPECT_EQ(before.constrained_calls, statistics_->getCounts().constrained_calls);
+  EXPECT_EQ(before.uniform_samples, statistics_->getCounts().uniform_samples);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_constrained_sampler", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+/* The signed distance field against the exact distances to boxes, and its cache under concurrent requests.  Away
+   from the edges of the boxes the field is within a voxel of the exact distance; near the edges and corners, where
+   the voxels round the boxes off, within a voxel diagonal. */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/detail/environment_distance_field.h>
+#include <random_numbers/random_numbers.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+struct Box
+{
+  Eigen::Vector3d center;
+  Eigen::Vector3d half_size;
+};
+
+/// The exact signed distance to \e box, and in \e offsets the signed distances to its three pairs of faces, sorted
+double boxDistance(const Box &box, const Eigen::Vector3d &point, Eigen::Vector3d &offsets)
+{
+  offsets = (point - box.center).cwiseAbs() - box.half_size;
+  double distance = (offsets.array() > 0.0).any() ? offsets.cwiseMax(0.0).norm() : offsets.maxCoeff();
+  std::sort(offsets.data(), offsets.data() + 3);
+  return distance;
+}
+
+void getField(const ompl_interface::StaticCollisionEnvironment *environment, const std::vector<std::string> *moving_bodies,
+              ompl_interface::EnvironmentDistanceFieldConstPtr *field)
+{
+  *field = ompl_interface::EnvironmentDistanceField::get(*environment, *moving_bodies, 0.03, 1u << 22);
+}
+}
+
+TEST(EnvironmentDistanceField, MatchesBoxDistances)
+{
+  std::vector<Box> boxes(2);
+  boxes[0].center = Eigen::Vector3d(0.6, -0.2, 0.7);
+  boxes[0].half_size = Eigen::Vector3d(0.15, 0.25, 0.1);
+  boxes[1].center = Eigen::Vector3d(0.1, 0.43, 0.3);
+  boxes[1].half_size = Eigen::Vector3d(0.05, 0.05, 0.3);
+
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Affine3d poses;
+  Eigen::Vector3d lo = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+  Eigen::Vector3d hi = -lo;
+  for (std::size_t i = 0 ; i < boxes.size() ; ++i)
+  {
+    const Eigen::Vector3d size = 2.0 * boxes[i].half_size;
+    shapes.push_back(shapes::ShapeConstPtr(new shapes::Box(size.x(), size.y(), size.z())));
+    poses.push_back(Eigen::Affine3d(Eigen::Translation3d(boxes[i].center)));
+    lo = lo.cwiseMin(boxes[i].center - boxes[i].half_size);
+    hi = hi.cwiseMax(boxes[i].center + boxes[i].half_size);
+  }
+
+  const double resolutions[] = { 0.02, 0.05 };
+  for (std::size_t r = 0 ; r < sizeof(resolutions) / sizeof(resolutions[0]) ; ++r)
+  {
+    ompl_interface::EnvironmentDistanceField field(shapes, poses, resolutions[r], 1u << 22);
+    const double resolution = field.getResolution();
+    ASSERT_DOUBLE_EQ(resolutions[r], resolution);
+
+    random_numbers::RandomNumberGenerator rng(42);
+    unsigned int inside = 0;
+    unsigned int faces = 0;
+    for (int i = 0 ; i < 20000 ; ++i)
+    {
+      Eigen::Vector3d point;
+      for (int a = 0 ; a < 3 ; ++a)
+        point[a] = rng.uniformReal(lo[a] - 0.2, hi[a] + 0.2);
+
+      Eigen::Vector3d offsets[2];
+      double d0 = boxDistance(boxes[0], point, offsets[0]);
+      double d1 = boxDistance(boxes[1], point, offsets[1]);
+      const double exact = std::min(d0, d1);
+      const Eigen::Vector3d &offset = offsets[d0 < d1 ? 0 : 1];
+      const double distance = field.getDistance(point);
+      if (exact < 0.0)
+        ++inside;
+
+      // the closest point of the box is on a face, at least a voxel away from its edges
+      if (offset[1] < offset[2] - resolution && offset[1] < -resolution)
+      {
+        ++faces;
+        EXPECT_NEAR(exact, distance, resolution) << "point " << point.transpose();
+      }
+      else
+        EXPECT_NEAR(exact, distance, sqrt(3.0) * resolution) << "point " << point.transpose();
+    }
+    // both signs, and both kinds of points, are exercised
+    EXPECT_GT(inside, 0u);
+    EXPECT_GT(faces, 500u);
+  }
+}
+
+TEST(EnvironmentDistanceField, ConcurrentRequestsShareTheField)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model));
+  ompl_interface_test::addShelf(scene);
+  const robot_model::JointModelGroup *group = robot_model->getJointModelGroup("right_arm");
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  ompl_interface::StaticCollisionEnvironment environment(scene, group, state);
+  ASSERT_TRUE(environment.isValid());
+  const std::vector<std::string> &moving_bodies = group->getLinkModelNames();
+
+  // the threads requesting the field while it is computed wait for it, rather than computing it again
+  std::vector<ompl_interface::EnvironmentDistanceFieldConstPtr> fields(4);
+  boost::thread_group threads;
+  for (std::size_t i = 0 ; i < fields.size() ; ++i)
+    threads.create_thread(boost::bind(&getField, &environment, &moving_bodies, &fields[i]));
+  threads.join_all();
+  ASSERT_TRUE(fields[0]);
+  for (std::size_t i = 1 ; i < fields.size() ; ++i)
+    EXPECT_EQ(fields[0], fields[i]);
+
+  // and the field is cached afterwards
+  ompl_interface::EnvironmentDistanceFieldConstPtr again;
+  getField(&environment, &moving_bodies, &again);
+  EXPECT_EQ(fields[0], again);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
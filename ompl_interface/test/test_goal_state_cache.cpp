@@ -0,0 +1,326 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+/* The goal state cache: eviction of the least recently used goals, the bound on the states of a goal, duplicates
+   and keys; and the ConstrainedGoalSampler with a cache, which starts a repeated request with the cached goal
+   states that are still valid, before its inverse kinematics gets to return anything. */
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/ompl_interface/detail/constrained_goal_sampler.h>
+#include <moveit/ompl_interface/detail/goal_state_cache.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+std::vector<double> values(double a, double b)
+{
+  std::vector<double> v(2);
+  v[0] = a;
+  v[1] = b;
+  return v;
+}
+
+/** A constraint sampler whose calls block until release() (or for ten seconds), then fail.  While it blocks, the
+    goal sampler using it cannot have found a goal state with it. */
+class BlockingConstraintSampler : public constraint_samplers::ConstraintSampler
+{
+public:
+
+  BlockingConstraintSampler(const planning_scene::PlanningSceneConstPtr &scene, const std::string &group_name)
+    : constraint_samplers::ConstraintSampler(scene, group_name)
+    , released_(false)
+    , completed_calls_(0)
+  {
+    is_valid_ = true;
+  }
+
+  virtual bool configure(const moveit_msgs::Constraints &constr)
+  {
+    return true;
+  }
+
+  virtual bool sample(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts)
+  {
+    return project(state, max_attempts);
+  }
+
+  virtual bool project(robot_state::RobotState &state, unsigned int max_attempts)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    boost::system_time deadline = boost::get_system_time() + boost::posix_time::seconds(10);
+    while (!released_ && released_condition_.timed_wait(slock, deadline))
+      ;
+    ++completed_calls_;
+    return false;
+  }
+
+  virtual const std::string& getName() const
+  {
+    static const std::string name = "blocking";
+    return name;
+  }
+
+  void release()
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    released_ = true;
+    released_condition_.notify_all();
+  }
+
+  unsigned int getCompletedCalls() const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    return completed_calls_;
+  }
+
+private:
+
+  mutable boost::mutex      lock_;
+  boost::condition_variable released_condition_;
+  bool                      released_;
+  unsigned int              completed_calls_;
+};
+}
+
+TEST(GoalStateCache, EvictsLeastRecentlyUsedGoals)
+{
+  ompl_interface::GoalStateCache cache(2);
+  cache.addState("a", values(0.0, 0.0));
+  cache.addState("b", values(1.0, 0.0));
+  // reading a goal counts as using it
+  EXPECT_EQ(1u, cache.getStates("a").size());
+  cache.addState("c", values(2.0, 0.0));
+
+  EXPECT_EQ(2u, cache.getGoalCount());
+  EXPECT_TRUE(cache.getStates("b").empty());
+  EXPECT_EQ(1u, cache.getStates("a").size());
+  EXPECT_EQ(1u, cache.getStates("c").size());
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.getGoalCount());
+  EXPECT_TRUE(cache.getStates("a").empty());
+}
+
+TEST(GoalStateCache, KeepsMostRecentStatesPerGoal)
+{
+  ompl_interface::GoalStateCache cache(4, 3);
+  for (int i = 0 ; i < 5 ; ++i)
+    cache.addState("a", values(i, 0.0));
+  std::vector<std::vector<double> > states = cache.getStates("a");
+  ASSERT_EQ(3u, states.size());
+  EXPECT_EQ(4.0, states[0][0]);
+  EXPECT_EQ(3.0, states[1][0]);
+  EXPECT_EQ(2.0, states[2][0]);
+}
+
+TEST(GoalStateCache, RejectsDuplicates)
+{
+  ompl_interface::GoalStateCache cache(4, 10, 1e-3);
+  cache.addState("a", values(0.0, 0.0));
+  // every value within the duplicate distance
+  cache.addState("a", values(5e-4, -5e-4));
+  EXPECT_EQ(1u, cache.getStates("a").size());
+  // one value further away
+  cache.addState("a", values(5e-4, 2e-3));
+  EXPECT_EQ(2u, cache.getStates("a").size());
+  // the same state for another goal
+  cache.addState("b", values(0.0, 0.0));
+  EXPECT_EQ(1u, cache.getStates("b").size());
+}
+
+TEST(GoalStateCache, KeysIgnoreTimeStamps)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  moveit_msgs::Constraints constraints = ompl_interface_test::rightWristConstraints(state, 0.05);
+  const std::string key = ompl_interface::GoalStateCache::computeKey(*robot_model, "right_arm", constraints);
+
+  moveit_msgs::Constraints stamped = constraints;
+  stamped.position_constraints[0].header.stamp = ros::Time(1000, 1);
+  stamped.orientation_constraints[0].header.stamp = ros::Time(2000, 2);
+  EXPECT_EQ(key, ompl_interface::GoalStateCache::computeKey(*robot_model, "right_arm", stamped));
+
+  // anything else is part of the key
+  moveit_msgs::Constraints other = constraints;
+  other.orientation_constraints[0].absolute_x_axis_tolerance *= 2.0;
+  EXPECT_NE(key, ompl_interface::GoalStateCache::computeKey(*robot_model, "right_arm", other));
+  EXPECT_NE(key, ompl_interface::GoalStateCache::computeKey(*robot_model, "left_arm", constraints));
+}
+
+class CachedGoalSamplingTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    ompl_interface_test::setModelKinematics(robot_model_, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+    group_ = robot_model_->getJointModelGroup("right_arm");
+    start_.reset(new robot_state::RobotState(robot_model_));
+    start_->setToDefaultValues();
+    start_->update();
+  }
+
+  /// A context for the right arm in \e scene
+  void createContext(const planning_scene::PlanningScenePtr &scene)
+  {
+    planning_interface::MotionPlanRequest req;
+    req.group_name = group_->getName();
+
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "test_goal_state_cache";
+    spec.group = req.group_name;
+    spec.max_num_threads = 1;
+    spec.model = robot_model_;
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+    context_.reset(new ompl_interface::GeometricPlanningContext());
+    context_->setPlanningScene(scene);
+    context_->setMotionPlanRequest(req);
+    context_->initialize("", spec);
+    context_->setCompleteInitialRobotState(*start_);
+  }
+
+  kinematic_constraints::KinematicConstraintSetPtr createConstraintSet(const planning_scene::PlanningScenePtr &scene,
+                                                                       const moveit_msgs::Constraints &constraints)
+  {
+    kinematic_constraints::KinematicConstraintSetPtr set(new kinematic_constraints::KinematicConstraintSet(robot_model_));
+    EXPECT_TRUE(set->add(constraints, scene->getTransforms()));
+    return set;
+  }
+
+  /// The goal states a goal sampler starts with when its constraint sampler cannot return any
+  unsigned int countInitialGoalStates(const kinematic_constraints::KinematicConstraintSetPtr &constraints,
+                                      ompl_interface::GoalStateCache &cache)
+  {
+    boost::shared_ptr<BlockingConstraintSampler> blocking(new BlockingConstraintSampler(context_->getPlanningScene(), group_->getName()));
+    unsigned int count;
+    {
+      ompl_interface::ConstrainedGoalSampler goal(context_.get(), constraints, blocking, 10, 50, 1,
+                                                  std::vector<constraint_samplers::ConstraintSamplerPtr>(), &cache);
+      count = goal.getStateCount();
+      EXPECT_EQ(0u, blocking->getCompletedCalls());
+      blocking->release();
+    }
+    return count;
+  }
+
+  robot_model::RobotModelPtr                                  robot_model_;
+  const robot_model::JointModelGroup                         *group_;
+  robot_state::RobotStatePtr                                  start_;
+  boost::shared_ptr<ompl_interface::GeometricPlanningContext> context_;
+};
+
+TEST_F(CachedGoalSamplingTest, DropsCachedStatesInCollision)
+{
+  // the start state, and the arm swung out to the side, both within the joint tolerances of the goal
+  robot_state::RobotState swung(*start_);
+  std::vector<double> start_values, swung_values;
+  start_->copyJointGroupPositions(group_, start_values);
+  swung_values = start_values;
+  swung_values[0] = -1.0;
+  swung.setJointGroupPositions(group_, swung_values);
+  swung.update();
+  moveit_msgs::Constraints goal = kinematic_constraints::constructGoalConstraints(*start_, group_, 1.2);
+
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model_));
+  kinematic_constraints::KinematicConstraintSetPtr constraints = createConstraintSet(scene, goal);
+  ASSERT_TRUE(constraints->decide(swung).satisfied);
+  ompl_interface::GoalStateCache cache;
+  const std::string key = ompl_interface::GoalStateCache::computeKey(*robot_model_, group_->getName(), constraints->getAllConstraints());
+  cache.addState(key, start_values);
+  cache.addState(key, swung_values);
+
+  // both states are valid in an empty scene
+  createContext(scene);
+  EXPECT_EQ(2u, countInitialGoalStates(constraints, cache));
+
+  // a box where the swung out wrist is
+  planning_scene::PlanningScenePtr cluttered(new planning_scene::PlanningScene(robot_model_));
+  cluttered->getWorldNonConst()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(0.15, 0.15, 0.15)),
+                                             Eigen::Affine3d(Eigen::Translation3d(swung.getGlobalLinkTransform("r_wrist_roll_link").translation())));
+  ASSERT_TRUE(cluttered->isStateColliding(swung, group_->getName()));
+  ASSERT_FALSE(cluttered->isStateColliding(*start_, group_->getName()));
+  createContext(cluttered);
+  EXPECT_EQ(1u, countInitialGoalStates(constraints, cache));
+  // the cache itself keeps both
+  EXPECT_EQ(2u, cache.getStates(key).size());
+}
+
+TEST_F(CachedGoalSamplingTest, RepeatedRequestStartsWithCachedStates)
+{
+  planning_scene::PlanningScenePtr scene(new planning_scene::PlanningScene(robot_model_));
+  createContext(scene);
+  kinematic_constraints::KinematicConstraintSetPtr constraints =
+    createConstraintSet(scene, ompl_interface_test::rightWristConstraints(*start_, 0.05));
+  ompl_interface::GoalStateCache cache;
+
+  // the first request has nothing cached, and finds goal states with inverse kinematics
+  EXPECT_EQ(0u, countInitialGoalStates(constraints, cache));
+  constraint_samplers::ConstraintSamplerPtr ik =
+    constraint_samplers::ConstraintSamplerManager().selectSampler(scene, group_->getName(), constraints->getAllConstraints());
+  ASSERT_TRUE(ik);
+  {
+    ompl_interface::ConstrainedGoalSampler goal(context_.get(), constraints, ik, 1000, 5, 4,
+                                                std::vector<constraint_samplers::ConstraintSamplerPtr>(), &cache);
+    for (int i = 0 ; i < 1000 && goal.getStateCount() == 0 ; ++i)
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    ASSERT_GT(goal.getStateCount(), 0u);
+  }
+  const std::string key = ompl_interface::GoalStateCache::computeKey(*robot_model_, group_->getName(), constraints->getAllConstraints());
+  const std::size_t cached = cache.getStates(key).size();
+  ASSERT_GT(cached, 0u);
+
+  // the second request starts with them (but for those too close to another one), while its inverse kinematics
+  // has not returned yet
+  unsigned int initial = countInitialGoalStates(constraints, cache);
+  EXPECT_GT(initial, 0u);
+  EXPECT_LE(initial, cached);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_goal_state_cache", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include <moveit/ompl_interface/detail/goal_union.h>
+#include <ompl/base/goals/GoalStates.h>
+#include <ompl/base/goals/GoalLazySamples.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/SpaceInformation.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <limits>
+
+namespace
+{
+ompl::base::SpaceInformationPtr allocSpaceInformation()
+{
+  ompl::base::RealVectorStateSpace *box = new ompl::base::RealVectorStateSpace(7);
+  box->setBounds(-3.14, 3.14);
+  ompl::base::SpaceInformationPtr si(new ompl::base::SpaceInformation(ompl::base::StateSpacePtr(box)));
+  si->setup();
+  return si;
+}
+
+// a set of goal states at x = center (the other coordinates random)
+ompl::base::GoalStates* allocGoalStates(const ompl::base::SpaceInformationPtr &si, double center, unsigned int count)
+{
+  ompl::base::GoalStates *goal = new ompl::base::GoalStates(si);
+  goal->setThreshold(0.1);
+  ompl::base::StateSamplerPtr sampler = si->allocStateSampler();
+  ompl::base::State *state = si->allocState();
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    sampler->sampleUniform(state);
+    state->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] = center;
+    goal->addState(state);
+  }
+  si->freeState(state);
+  return goal;
+}
+
+// the goal checks of every member in turn
+bool isSatisfiedByMember(const std::vector<ompl::base::GoalPtr> &goals, const ompl::base::State *st, double *distance)
+{
+  double min_d = std::numeric_limits<double>::infinity();
+  bool satisfied = false;
+  for (std::size_t i = 0 ; i < goals.size() ; ++i)
+  {
+    double d;
+    satisfied = goals[i]->isSatisfied(st, &d) || satisfied;
+    min_d = std::min(min_d, d);
+  }
+  *distance = min_d;
+  return satisfied;
+}
+
+// a lazy sampler that returns \e invalid states out of bounds, then \e valid states at x = center, then stops
+bool sampleGoal(unsigned int *invalid, unsigned int *valid, double center, bool *done, const ompl::base::GoalLazySamples*,
+                ompl::base::State *st)
+{
+  double *values = st->as<ompl::base::RealVectorStateSpace::StateType>()->values;
+  for (unsigned int i = 0 ; i < 7 ; ++i)
+    values[i] = 0.01 * (*invalid + *valid);
+  if (*invalid > 0)
+  {
+    --*invalid;
+    values[0] = 10.0;
+    return true;
+  }
+  if (*valid > 0)
+  {
+    --*valid;
+    values[0] = center;
+    return true;
+  }
+  *done = true;
+  return false;
+}
+
+// the fraction of the goals sampled from the union that have x = center
+double sampledFraction(const ompl_interface::GoalSampleableRegionMux &mux, const ompl::base::SpaceInformationPtr &si, double center)
+{
+  ompl::base::State *state = si->allocState();
+  unsigned int count = 0;
+  const unsigned int samples = 2000;
+  for (unsigned int i = 0 ; i < samples ; ++i)
+  {
+    mux.sampleGoal(state);
+    if (state->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] == center)
+      ++count;
+  }
+  si->freeState(state);
+  return (double)count / (double)samples;
+}
+}
+
+TEST(GoalUnion, MatchesMemberChecks)
+{
+  ompl::base::SpaceInformationPtr si = allocSpaceInformation();
+  std::vector<ompl::base::GoalPtr> goals;
+  for (unsigned int i = 0 ; i < 150 ; ++i)
+    goals.push_back(ompl::base::GoalPtr(allocGoalStates(si, -3.0 + 0.04 * i, 5)));
+  ompl_interface::GoalSampleableRegionMux mux(goals);
+
+  ompl::base::StateSamplerPtr sampler = si->allocStateSampler();
+  ompl::base::State *query = si->allocState();
+  unsigned int satisfied = 0;
+  for (unsigned int i = 0 ; i < 2000 ; ++i)
+  {
+    // half the queries near a goal state
+    if (i % 2)
+      sampler->sampleUniform(query);
+    else
+      sampler->sampleUniformNear(query, goals[i % goals.size()]->as<ompl::base::GoalStates>()->getState(0), 0.1);
+    double member_distance;
+    bool member_satisfied = isSatisfiedByMember(goals, query, &member_distance);
+    if (member_satisfied)
+      ++satisfied;
+    double distance;
+    EXPECT_EQ(member_satisfied, mux.isSatisfied(query, &distance));
+    EXPECT_NEAR(member_distance, distance, 1e-9);
+    EXPECT_NEAR(member_distance, mux.distanceGoal(query), 1e-9);
+  }
+  si->freeState(query);
+  // both outcomes are exercised
+  EXPECT_GT(satisfied, 0u);
+  EXPECT_LT(satisfied, 2000u);
+}
+
+// states added to a plain set of goal states after the union is built are checked too
+TEST(GoalUnion, IndexesStatesAddedLater)
+{
+  ompl::base::SpaceInformationPtr si = allocSpaceInformation();
+  std::vector<ompl::base::GoalPtr> goals;
+  goals.push_back(ompl::base::GoalPtr(allocGoalStates(si, -2.0, 3)));
+  ompl::base::GoalStates *later = allocGoalStates(si, 2.0, 0);
+  goals.push_back(ompl::base::GoalPtr(later));
+  ompl_interface::GoalSampleableRegionMux mux(goals);
+
+  ompl::base::State *state = si->allocState();
+  si->allocStateSampler()->sampleUniform(state);
+  state->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] = 2.0;
+  EXPECT_FALSE(mux.isSatisfied(state, NULL));
+  later->addState(state);
+  EXPECT_TRUE(mux.isSatisfied(state, NULL));
+  EXPECT_NEAR(0.0, mux.distanceGoal(state), 1e-12);
+
+  // and no longer once they are cleared
+  later->clear();
+  EXPECT_FALSE(mux.isSatisfied(state, NULL));
+  EXPECT_GT(mux.distanceGoal(state), 0.1);
+  si->freeState(state);
+}
+
+TEST(GoalUnion, FavorsCloserGoals)
+{
+  ompl::base::SpaceInformationPtr si = allocSpaceInformation();
+  std::vector<ompl::base::GoalPtr> goals;
+  goals.push_back(ompl::base::GoalPtr(allocGoalStates(si, -3.0, 5)));
+  goals.push_back(ompl::base::GoalPtr(allocGoalStates(si, 3.0, 5)));
+  ompl_interface::GoalSampleableRegionMux mux(goals);
+
+  ompl::base::State *start = si->allocState();
+  si->copyState(start, goals[1]->as<ompl::base::GoalStates>()->getState(0));
+  start->as<ompl::base::RealVectorStateSpace::StateType>()->values[0] = 2.9;
+  mux.setStartState(start);
+  si->freeState(start);
+
+  EXPECT_GT(sampledFraction(mux, si, 3.0), 0.6);
+}
+
+TEST(GoalUnion, FavorsHigherSuccessRates)
+{
+  ompl::base::SpaceInformationPtr si = allocSpaceInformation();
+  // a sampler that finds 10 goal states in 10 attempts, and one that finds 1 in 21
+  unsigned int good_invalid = 0, good_valid = 10, poor_invalid = 20, poor_valid = 1;
+  bool good_done = false, poor_done = false;
+  ompl::base::GoalLazySamples *good = new ompl::base::GoalLazySamples(si, boost::bind(&sampleGoal, &good_invalid, &good_valid, 1.0,
+                                                                                     &good_done, _1, _2), false);
+  ompl::base::GoalLazySamples *poor = new ompl::base::GoalLazySamples(si, boost::bind(&sampleGoal, &poor_invalid, &poor_valid, -1.0,
+                                                                                     &poor_done, _1, _2), false);
+  std::vector<ompl::base::GoalPtr> goals;
+  goals.push_back(ompl::base::GoalPtr(good));
+  goals.push_back(ompl::base::GoalPtr(poor));
+  ompl_interface::GoalSampleableRegionMux mux(goals);
+  mux.startSampling();
+  while (!good_done || !poor_done)
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+  mux.stopSampling();
+  ASSERT_EQ(10u, good->getStateCount());
+  ASSERT_EQ(1u, poor->getStateCount());
+
+  EXPECT_GT(sampledFraction(mux, si, 1.0), 0.75);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
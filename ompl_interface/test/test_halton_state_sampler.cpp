@@ -0,0 +1,215 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+/* The Halton state sampler: a stream always produces the same sequence and different streams different ones, the
+   streams restart with every solve, and the samples respect the joint bounds (continuous joints in [-pi, pi]). */
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/ompl_interface/detail/halton_state_sampler.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+
+namespace
+{
+const unsigned int SAMPLES = 200;
+
+/// The solve hooks of the context are protected
+class HaltonPlanningContext : public ompl_interface::GeometricPlanningContext
+{
+public:
+  using ompl_interface::GeometricPlanningContext::preSolve;
+  using ompl_interface::GeometricPlanningContext::postSolve;
+};
+}
+
+class HaltonStateSamplerTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    robot_state::RobotState start(robot_model_);
+    start.setToDefaultValues();
+    start.update();
+    const robot_model::JointModelGroup *group = robot_model_->getJointModelGroup("right_arm");
+    robot_state::RobotState goal(start);
+    std::vector<double> values;
+    goal.copyJointGroupPositions(group, values);
+    values[0] -= 0.5;
+    goal.setJointGroupPositions(group, values);
+    goal.update();
+
+    planning_interface::MotionPlanRequest req;
+    req.group_name = group->getName();
+    req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(goal, group));
+
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "test_halton_state_sampler";
+    spec.group = req.group_name;
+    spec.config["state_sampler"] = "halton";
+    spec.max_num_threads = 1;
+    spec.model = robot_model_;
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+    context_.reset(new HaltonPlanningContext());
+    context_->setPlanningScene(scene_);
+    context_->setMotionPlanRequest(req);
+    context_->initialize("", spec);
+    context_->setCompleteInitialRobotState(start);
+    ASSERT_TRUE(context_->setGoalConstraints(req.goal_constraints, NULL));
+  }
+
+  /// The values of the first SAMPLES uniform samples of \e sampler, one after the other
+  std::vector<double> sample(ompl::base::StateSampler &sampler)
+  {
+    const ompl_interface::ModelBasedStateSpacePtr &space = context_->getOMPLStateSpace();
+    const unsigned int n = space->getJointModelGroup()->getVariableCount();
+    std::vector<double> values;
+    ompl::base::State *state = space->allocState();
+    for (unsigned int i = 0 ; i < SAMPLES ; ++i)
+    {
+      sampler.sampleUniform(state);
+      const double *v = state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+      values.insert(values.end(), v, v + n);
+    }
+    space->freeState(state);
+    return values;
+  }
+
+  /// The number of samples in which \e a and \e b differ
+  unsigned int differentSamples(const std::vector<double> &a, const std::vector<double> &b)
+  {
+    const unsigned int n = context_->getOMPLStateSpace()->getJointModelGroup()->getVariableCount();
+    unsigned int different = 0;
+    for (unsigned int i = 0 ; i < SAMPLES ; ++i)
+      if (!std::equal(a.begin() + i * n, a.begin() + (i + 1) * n, b.begin() + i * n))
+        ++different;
+    return different;
+  }
+
+  robot_model::RobotModelPtr               robot_model_;
+  planning_scene::PlanningScenePtr         scene_;
+  boost::shared_ptr<HaltonPlanningContext> context_;
+};
+
+TEST_F(HaltonStateSamplerTest, StreamsAreReproducible)
+{
+  const ompl_interface::ModelBasedStateSpace *space = context_->getOMPLStateSpace().get();
+  ompl_interface::HaltonStateSampler a(space, 3);
+  ompl_interface::HaltonStateSampler b(space, 3);
+  ompl_interface::HaltonStateSampler c(space, 4);
+  std::vector<double> sa = sample(a);
+  EXPECT_TRUE(sa == sample(b));
+  // the first variable (base 2) is the same in every stream, the others are scrambled differently
+  EXPECT_GT(differentSamples(sa, sample(c)), SAMPLES * 9 / 10);
+}
+
+TEST_F(HaltonStateSamplerTest, SolvesRestartTheStreams)
+{
+  const ompl::base::SpaceInformationPtr &si = context_->getOMPLSpaceInformation();
+
+  context_->preSolve();
+  ompl::base::StateSamplerPtr first = si->allocStateSampler();
+  ompl::base::StateSamplerPtr second = si->allocStateSampler();
+  ASSERT_TRUE(dynamic_cast<ompl_interface::HaltonStateSampler*>(first.get()));
+  std::vector<double> s1 = sample(*first);
+  std::vector<double> s2 = sample(*second);
+  // samplers of one solve use different streams
+  EXPECT_GT(differentSamples(s1, s2), SAMPLES * 9 / 10);
+  context_->postSolve();
+
+  // a repeated solve allocates its samplers in the same order, and gets the same samples
+  context_->preSolve();
+  EXPECT_TRUE(s1 == sample(*si->allocStateSampler()));
+  EXPECT_TRUE(s2 == sample(*si->allocStateSampler()));
+  context_->postSolve();
+}
+
+TEST_F(HaltonStateSamplerTest, SamplesAreWithinBounds)
+{
+  const ompl_interface::ModelBasedStateSpace *space = context_->getOMPLStateSpace().get();
+  const robot_model::JointModelGroup *group = space->getJointModelGroup();
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  const robot_model::JointBoundsVector &bounds = space->getJointsBounds();
+  const double pi = boost::math::constants::pi<double>();
+
+  unsigned int continuous = 0;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+    if (joints[i]->getType() == robot_model::JointModel::REVOLUTE && !(*bounds[i])[0].position_bounded_)
+      ++continuous;
+  ASSERT_GT(continuous, 0u);
+
+  for (unsigned int stream = 0 ; stream < 3 ; ++stream)
+  {
+    ompl_interface::HaltonStateSampler sampler(space, stream);
+    ompl::base::State *state = space->allocState();
+    for (unsigned int k = 0 ; k < SAMPLES ; ++k)
+    {
+      sampler.sampleUniform(state);
+      EXPECT_TRUE(space->satisfiesBounds(state));
+      const double *values = state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+      for (std::size_t i = 0 ; i < joints.size() ; ++i)
+      {
+        const robot_model::VariableBounds &b = (*bounds[i])[0];
+        double v = values[group->getVariableGroupIndex(joints[i]->getVariableNames()[0])];
+        if (b.position_bounded_)
+        {
+          EXPECT_LE(b.min_position_, v);
+          EXPECT_GE(b.max_position_, v);
+        }
+        else
+        {
+          EXPECT_LE(-pi, v);
+          EXPECT_GE(pi, v);
+        }
+      }
+    }
+    space->freeState(state);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_halton_state_sampler", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  return RUN_ALL_TESTS();
+}
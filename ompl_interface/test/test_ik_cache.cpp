@@ -0,0 +1,198 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/ompl_interface/detail/ik_cache.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace
+{
+const double IDENTITY[4] = { 0.0, 0.0, 0.0, 1.0 };
+
+// a rotation of angle about z
+void rotationZ(double angle, double *q)
+{
+  q[0] = 0.0;
+  q[1] = 0.0;
+  q[2] = sin(angle / 2.0);
+  q[3] = cos(angle / 2.0);
+}
+}
+
+TEST(IKCache, HitSeedMiss)
+{
+  ompl_interface::IKCache cache;
+  const double position[3] = { 0.5, -0.2, 0.8 };
+  std::vector<double> solution(7, 0.1), seed(7, 0.0), result;
+  cache.insert(0, position, IDENTITY, solution);
+
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, position, IDENTITY, seed, result));
+  EXPECT_EQ(solution, result);
+
+  // a nearby position, in a neighboring cell
+  const double nearby[3] = { 0.52, -0.2, 0.8 };
+  EXPECT_EQ(ompl_interface::IKCache::SEED, cache.lookup(0, nearby, IDENTITY, seed, result));
+
+  // another component, a position too far, a seed on another branch
+  EXPECT_EQ(ompl_interface::IKCache::MISS, cache.lookup(1, position, IDENTITY, seed, result));
+  const double far[3] = { 0.7, -0.2, 0.8 };
+  EXPECT_EQ(ompl_interface::IKCache::MISS, cache.lookup(0, far, IDENTITY, seed, result));
+  std::vector<double> other_branch(7, 2.0);
+  EXPECT_EQ(ompl_interface::IKCache::MISS, cache.lookup(0, position, IDENTITY, other_branch, result));
+
+  ompl_interface::IKCache::Statistics stats = cache.getStatistics();
+  EXPECT_EQ(5u, stats.lookups);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.seeds);
+}
+
+// solutions for other orientations at the same position are not returned
+TEST(IKCache, OrientationIsHashed)
+{
+  ompl_interface::IKCache cache;
+  const double position[3] = { 0.5, -0.2, 0.8 };
+  std::vector<double> seed(7, 0.0), result;
+  double q[4];
+  rotationZ(2.0, q);
+  cache.insert(0, position, q, std::vector<double>(7, 0.2));
+
+  EXPECT_EQ(ompl_interface::IKCache::MISS, cache.lookup(0, position, IDENTITY, seed, result));
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, position, q, seed, result));
+
+  // q and -q are the same orientation
+  double negated[4] = { -q[0], -q[1], -q[2], -q[3] };
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, position, negated, seed, result));
+}
+
+// a solution within tolerance of a cached one, on the same branch, is not stored again
+TEST(IKCache, DuplicatesAreSkipped)
+{
+  ompl_interface::IKCache cache;
+  const double position[3] = { 0.5, -0.2, 0.8 };
+  const double close[3] = { 0.5 + 1e-5, -0.2, 0.8 };
+  std::vector<double> seed(7, 0.0), result;
+  cache.insert(0, position, IDENTITY, std::vector<double>(7, 0.1));
+  cache.insert(0, close, IDENTITY, std::vector<double>(7, 0.2));
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, close, IDENTITY, seed, result));
+  EXPECT_EQ(std::vector<double>(7, 0.1), result);
+
+  // a solution on another branch is a different solution
+  cache.insert(0, close, IDENTITY, std::vector<double>(7, 1.2));
+  std::vector<double> other_seed(7, 1.0);
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, close, IDENTITY, other_seed, result));
+  EXPECT_EQ(std::vector<double>(7, 1.2), result);
+}
+
+// a cell keeps a bounded number of solutions, dropping the oldest
+TEST(IKCache, CellsAreCapped)
+{
+  ompl_interface::IKCache cache;
+  std::vector<double> seed(7, 0.0), result;
+  const unsigned int count = 40;
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    // distinct poses in the same 5 cm cell
+    const double position[3] = { 0.501 + 0.001 * i, 0.01, 0.01 };
+    cache.insert(0, position, IDENTITY, std::vector<double>(7, 0.001 * i));
+  }
+  const double oldest[3] = { 0.501, 0.01, 0.01 };
+  EXPECT_EQ(ompl_interface::IKCache::SEED, cache.lookup(0, oldest, IDENTITY, seed, result));
+  const double newest[3] = { 0.501 + 0.001 * (count - 1), 0.01, 0.01 };
+  EXPECT_EQ(ompl_interface::IKCache::HIT, cache.lookup(0, newest, IDENTITY, seed, result));
+  EXPECT_EQ(std::vector<double>(7, 0.001 * (count - 1)), result);
+}
+
+TEST(IKCache, ResetStatistics)
+{
+  ompl_interface::IKCache cache;
+  const double position[3] = { 0.5, -0.2, 0.8 };
+  std::vector<double> seed(7, 0.0), result;
+  cache.lookup(0, position, IDENTITY, seed, result);
+  cache.recordSolverCall(0.5);
+  ompl_interface::IKCache::Statistics stats = cache.getStatistics();
+  EXPECT_EQ(1u, stats.lookups);
+  EXPECT_EQ(1u, stats.solver_calls);
+  EXPECT_DOUBLE_EQ(0.5, stats.solver_time);
+  cache.resetStatistics();
+  stats = cache.getStatistics();
+  EXPECT_EQ(0u, stats.lookups);
+  EXPECT_EQ(0u, stats.solver_calls);
+}
+
+namespace
+{
+void useCache(ompl_interface::IKCache *cache, unsigned int component, bool *consistent)
+{
+  std::vector<double> seed(7, 0.0), result;
+  for (int i = 0 ; i < 2000 ; ++i)
+  {
+    const double position[3] = { 0.001 * (i % 100), 0.0, 0.0 };
+    double q[4];
+    rotationZ(0.01 * (i % 50), q);
+    // every solution stored for this component is filled with the component index
+    if (cache->lookup(component, position, q, seed, result) == ompl_interface::IKCache::MISS)
+      cache->insert(component, position, q, std::vector<double>(7, 0.001 * component));
+    else
+      if (result != std::vector<double>(7, 0.001 * component))
+        *consistent = false;
+  }
+}
+}
+
+// concurrent lookups and insertions of several components, with a cache small enough to be emptied repeatedly
+TEST(IKCache, Concurrent)
+{
+  ompl_interface::IKCache cache(0.05, 1e-4, 1e-3, 0.5, 200);
+  const unsigned int threads = 4;
+  bool consistent[threads];
+  boost::thread_group group;
+  for (unsigned int i = 0 ; i < threads ; ++i)
+  {
+    consistent[i] = true;
+    group.create_thread(boost::bind(&useCache, &cache, i, &consistent[i]));
+  }
+  group.join_all();
+  for (unsigned int i = 0 ; i < threads ; ++i)
+    EXPECT_TRUE(consistent[i]);
+  EXPECT_EQ(threads * 2000u, cache.getStatistics().lookups);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
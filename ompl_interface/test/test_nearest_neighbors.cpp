@@ -0,0 +1,195 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include <moveit/ompl_interface/detail/nearest_neighbors_hnsw.h>
+#include <moveit/ompl_interface/detail/nearest_neighbors_gnat_cached.h>
+#include <ompl/datastructures/NearestNeighborsLinear.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/util/RandomNumbers.h>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+namespace
+{
+typedef ompl::base::State* Element;
+
+class NearestNeighborsTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    ompl::RNG::setSeed(3);
+    ompl::base::RealVectorStateSpace *rv = new ompl::base::RealVectorStateSpace(7);
+    rv->setBounds(-3.14, 3.14);
+    space_.reset(rv);
+    sampler_ = space_->allocDefaultStateSampler();
+    data_.resize(2000);
+    for (std::size_t i = 0 ; i < data_.size() ; ++i)
+    {
+      data_[i] = space_->allocState();
+      sampler_->sampleUniform(data_[i]);
+    }
+    query_ = space_->allocState();
+    linear_.setDistanceFunction(boost::bind(&ompl::base::StateSpace::distance, space_.get(), _1, _2));
+    linear_.add(data_);
+  }
+
+  virtual void TearDown()
+  {
+    for (std::size_t i = 0 ; i < data_.size() ; ++i)
+      space_->freeState(data_[i]);
+    space_->freeState(query_);
+  }
+
+  void fill(ompl::NearestNeighbors<Element> &nn)
+  {
+    nn.setDistanceFunction(boost::bind(&ompl::base::StateSpace::distance, space_.get(), _1, _2));
+    nn.add(data_);
+  }
+
+  ompl::base::StateSpacePtr            space_;
+  ompl::base::StateSamplerPtr          sampler_;
+  std::vector<Element>                 data_;
+  Element                              query_;
+  ompl::NearestNeighborsLinear<Element> linear_;
+};
+}
+
+// the planners reuse one element for consecutive queries, changing its contents: nothing may be cached across queries
+TEST_F(NearestNeighborsTest, GNATCachedIsExact)
+{
+  ompl_interface::NearestNeighborsGNATCached<Element> gnat;
+  fill(gnat);
+  std::vector<Element> expected, actual;
+  for (int i = 0 ; i < 200 ; ++i)
+  {
+    sampler_->sampleUniform(query_);
+    EXPECT_EQ(linear_.nearest(query_), gnat.nearest(query_));
+    linear_.nearestK(query_, 10, expected);
+    gnat.nearestK(query_, 10, actual);
+    EXPECT_EQ(expected, actual);
+    linear_.nearestR(query_, 2.5, expected);
+    gnat.nearestR(query_, 2.5, actual);
+    EXPECT_EQ(expected, actual);
+  }
+
+  std::size_t computed, cached;
+  gnat.getCacheStatistics(computed, cached);
+  EXPECT_GT(computed, 0u);
+}
+
+TEST_F(NearestNeighborsTest, GNATCachedRemove)
+{
+  ompl_interface::NearestNeighborsGNATCached<Element> gnat;
+  fill(gnat);
+  for (std::size_t i = 0 ; i < data_.size() ; i += 2)
+  {
+    EXPECT_TRUE(gnat.remove(data_[i]));
+    EXPECT_TRUE(linear_.remove(data_[i]));
+  }
+  EXPECT_EQ(linear_.size(), gnat.size());
+  for (int i = 0 ; i < 200 ; ++i)
+  {
+    sampler_->sampleUniform(query_);
+    EXPECT_EQ(linear_.nearest(query_), gnat.nearest(query_));
+  }
+}
+
+// HNSW is approximate, but should almost always find the nearest state on a data set this size
+TEST_F(NearestNeighborsTest, HNSWRecall)
+{
+  ompl_interface::NearestNeighborsHNSW<Element> hnsw;
+  fill(hnsw);
+  EXPECT_EQ(data_.size(), hnsw.size());
+  int found = 0;
+  for (int i = 0 ; i < 200 ; ++i)
+  {
+    sampler_->sampleUniform(query_);
+    if (linear_.nearest(query_) == hnsw.nearest(query_))
+      ++found;
+  }
+  EXPECT_GE(found, 180);
+}
+
+// removed elements stay in the graph (below half of them) and must neither be reported nor use up the search
+TEST_F(NearestNeighborsTest, HNSWRemovalRecall)
+{
+  ompl_interface::NearestNeighborsHNSW<Element> hnsw;
+  fill(hnsw);
+  for (std::size_t i = 0 ; i < data_.size() ; ++i)
+    if (i % 20 < 9)
+    {
+      EXPECT_TRUE(hnsw.remove(data_[i]));
+      EXPECT_TRUE(linear_.remove(data_[i]));
+    }
+  EXPECT_EQ(linear_.size(), hnsw.size());
+
+  int found = 0;
+  std::size_t expected_in_radius = 0, found_in_radius = 0;
+  std::vector<Element> expected, actual;
+  for (int i = 0 ; i < 200 ; ++i)
+  {
+    sampler_->sampleUniform(query_);
+    if (linear_.nearest(query_) == hnsw.nearest(query_))
+      ++found;
+    hnsw.nearestK(query_, 10, actual);
+    EXPECT_EQ(10u, actual.size());
+    for (std::size_t j = 0 ; j < actual.size() ; ++j)
+      EXPECT_GE((std::find(data_.begin(), data_.end(), actual[j]) - data_.begin()) % 20, 9);
+    linear_.nearestR(query_, 2.5, expected);
+    hnsw.nearestR(query_, 2.5, actual);
+    expected_in_radius += expected.size();
+    for (std::size_t j = 0 ; j < actual.size() ; ++j)
+      if (std::find(expected.begin(), expected.end(), actual[j]) != expected.end())
+        ++found_in_radius;
+  }
+  EXPECT_GE(found, 180);
+  EXPECT_GE(found_in_radius, 0.9 * expected_in_radius);
+
+  // a single element left, behind many removed ones
+  for (std::size_t i = 0 ; i + 1 < data_.size() ; ++i)
+    hnsw.remove(data_[i]);
+  ASSERT_EQ(1u, hnsw.size());
+  EXPECT_EQ(data_.back(), hnsw.nearest(query_));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/geometric_planning_context.h>
+#include <moveit/ompl_interface/detail/obstacle_valid_state_samplers.h>
+#include <moveit/ompl_interface/detail/constrained_valid_state_sampler.h>
+#include <ompl/base/samplers/UniformValidStateSampler.h>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+
+class ObstacleValidStateSamplersTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    ompl_interface_test::setModelKinematics(robot_model_, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    // only the obstacles count: the links of the robot may touch each other
+    const std::vector<std::string> &links = robot_model_->getLinkModelNamesWithCollisionGeometry();
+    scene_->getAllowedCollisionMatrixNonConst().setEntry(links, links, true);
+    // two walls in front of the right arm, with a 12 cm gap between them
+    shapes::ShapeConstPtr wall(new shapes::Box(0.3, 0.5, 1.2));
+    Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+    pose.translation() = Eigen::Vector3d(0.65, -0.05, 0.8);
+    scene_->getWorldNonConst()->addToObject("wall_0", wall, pose);
+    pose.translation() = Eigen::Vector3d(0.65, -0.67, 0.8);
+    scene_->getWorldNonConst()->addToObject("wall_1", wall, pose);
+    start_.reset(new robot_state::RobotState(robot_model_));
+    start_->setToDefaultValues();
+    start_->update();
+  }
+
+  /// A context for the right arm with the valid state sampler \e valid_state_sampler and the path constraints \e constraints
+  void createContext(const std::string &valid_state_sampler, const moveit_msgs::Constraints &constraints = moveit_msgs::Constraints())
+  {
+    planning_interface::MotionPlanRequest req;
+    req.group_name = "right_arm";
+    req.path_constraints = constraints;
+
+    ompl_interface::PlanningContextSpecification spec;
+    spec.name = "test_obstacle_valid_state_samplers";
+    spec.group = req.group_name;
+    if (!valid_state_sampler.empty())
+      spec.config["valid_state_sampler"] = valid_state_sampler;
+    spec.max_num_threads = 1;
+    spec.model = robot_model_;
+    spec.constraint_sampler_mgr.reset(new constraint_samplers::ConstraintSamplerManager());
+
+    context_.reset(new ompl_interface::GeometricPlanningContext());
+    context_->setPlanningScene(scene_);
+    context_->setMotionPlanRequest(req);
+    context_->initialize("", spec);
+    context_->setCompleteInitialRobotState(*start_);
+  }
+
+  /// True if one of the states of a Gaussian of \e stddev around \e state is invalid
+  bool nearObstacle(const ompl::base::State *state, double stddev)
+  {
+    const ompl::base::SpaceInformationPtr &si = context_->getOMPLSpaceInformation();
+    ompl::base::StateSamplerPtr sampler = si->allocStateSampler();
+    ompl::base::State *near = si->allocState();
+    bool found = false;
+    for (int i = 0 ; i < 200 && !found ; ++i)
+    {
+      sampler->sampleGaussian(near, state, stddev);
+      found = !si->isValid(near);
+    }
+    si->freeState(near);
+    return found;
+  }
+
+  /// Draw \e count samples from the valid state sampler of the context, with Gaussian steps of \e stddev for the
+  /// obstacle samplers; all of them must be valid.  Return the fraction of them that are near an obstacle.
+  double sampleNearObstacles(unsigned int count, double stddev)
+  {
+    const ompl::base::SpaceInformationPtr &si = context_->getOMPLSpaceInformation();
+    ompl::base::ValidStateSamplerPtr sampler = si->allocValidStateSampler();
+    sampler->setNrAttempts(1000);
+    if (ompl_interface::ObstacleValidStateSampler *obstacle_sampler = dynamic_cast<ompl_interface::ObstacleValidStateSampler*>(sampler.get()))
+      obstacle_sampler->setStdDev(stddev);
+    ompl::base::State *state = si->allocState();
+    unsigned int sampled = 0;
+    unsigned int near = 0;
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+      if (!sampler->sample(state))
+        continue;
+      ++sampled;
+      EXPECT_TRUE(si->isValid(state));
+      if (nearObstacle(state, stddev))
+        ++near;
+    }
+    si->freeState(state);
+    EXPECT_GE(sampled, count / 2);
+    return sampled ? double(near) / sampled : 0.0;
+  }
+
+  robot_model::RobotModelPtr                                 robot_model_;
+  planning_scene::PlanningScenePtr                           scene_;
+  robot_state::RobotStatePtr                                 start_;
+  boost::shared_ptr<ompl_interface::GeometricPlanningContext> context_;
+};
+
+TEST_F(ObstacleValidStateSamplersTest, SamplesAreValidAndNearObstacles)
+{
+  createContext("uniform");
+  const double stddev = 0.02 * context_->getOMPLSpaceInformation()->getMaximumExtent();
+  const double uniform = sampleNearObstacles(100, stddev);
+
+  const char *samplers[] = { "gaussian", "bridge_test", "obstacle_based" };
+  for (std::size_t i = 0 ; i < sizeof(samplers) / sizeof(samplers[0]) ; ++i)
+  {
+    createContext(samplers[i]);
+    ASSERT_EQ(std::string(samplers[i]), context_->getOMPLSpaceInformation()->allocValidStateSampler()->getName());
+    const double near = sampleNearObstacles(100, stddev);
+    EXPECT_GE(near, 0.7) << samplers[i];
+    EXPECT_GT(near, uniform) << samplers[i];
+  }
+}
+
+TEST_F(ObstacleValidStateSamplersTest, ConstrainedSamplerOnlyWithConstraintSampler)
+{
+  const robot_model::JointModelGroup *group = robot_model_->getJointModelGroup("right_arm");
+
+  // no path constraints
+  createContext("");
+  EXPECT_FALSE(dynamic_cast<ompl_interface::ValidConstrainedSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+
+  // path constraints the IK constraint sampler of the right arm samples
+  const moveit_msgs::Constraints wrist = ompl_interface_test::rightWristConstraints(*start_, 0.3);
+  ASSERT_TRUE(constraint_samplers::ConstraintSamplerManager().selectSampler(scene_, group->getName(), wrist));
+  createContext("", wrist);
+  EXPECT_TRUE(dynamic_cast<ompl_interface::ValidConstrainedSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+  createContext("default", wrist);
+  EXPECT_TRUE(dynamic_cast<ompl_interface::ValidConstrainedSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+
+  // ... unless another valid state sampler is configured
+  createContext("uniform", wrist);
+  EXPECT_TRUE(dynamic_cast<ompl::base::UniformValidStateSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+  createContext("gaussian", wrist);
+  EXPECT_TRUE(dynamic_cast<ompl_interface::GaussianValidSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+
+  // path constraints no constraint sampler handles: the left wrist is not moved by the right arm
+  moveit_msgs::Constraints left_wrist;
+  moveit_msgs::PositionConstraint pc = wrist.position_constraints[0];
+  pc.link_name = "l_wrist_roll_link";
+  tf::poseEigenToMsg(Eigen::Affine3d(Eigen::Translation3d(start_->getGlobalLinkTransform(pc.link_name).translation())),
+                     pc.constraint_region.primitive_poses[0]);
+  left_wrist.position_constraints.push_back(pc);
+  ASSERT_FALSE(constraint_samplers::ConstraintSamplerManager().selectSampler(scene_, group->getName(), left_wrist));
+  createContext("", left_wrist);
+  EXPECT_TRUE(dynamic_cast<ompl::base::UniformValidStateSampler*>(context_->getOMPLSpaceInformation()->allocValidStateSampler().get()));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_obstacle_valid_state_samplers", ros::init_options::AnonymousName | ros::init_options::NoSigintHandler);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,211 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "test_robot_model.h"
+#include "model_kinematics.h"
+#include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <ompl/base/spaces/SE3StateSpace.h>
+#include <random_numbers/random_numbers.h>
+#include <gtest/gtest.h>
+
+// forward kinematics composed from the robot model must give the pose the kinematics solver gives
+TEST(PoseModelStateSpace, DirectFKMatchesSolver)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  ompl_interface::PoseModelStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "right_arm"));
+  const robot_model::JointModelGroup *group = space.getJointModelGroup();
+
+  ompl_interface::PoseModelStateSpace::StateType *state = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  random_numbers::RandomNumberGenerator rng(5);
+  std::vector<double> values(group->getVariableCount());
+  for (int i = 0 ; i < 1000 ; ++i)
+  {
+    group->getVariableRandomPositions(rng, values);
+    std::copy(values.begin(), values.end(), state->values);
+
+    space.setDirectFK(false);
+    state->setPoseComputed(false);
+    ASSERT_TRUE(space.computeStateFK(state));
+    const ompl::base::SE3StateSpace::StateType &pose = *state->poses[0];
+    const double expected[7] = { pose.getX(), pose.getY(), pose.getZ(),
+                                 pose.rotation().x, pose.rotation().y, pose.rotation().z, pose.rotation().w };
+
+    space.setDirectFK(true);
+    state->setPoseComputed(false);
+    ASSERT_TRUE(space.computeStateFK(state));
+    EXPECT_NEAR(expected[0], pose.getX(), 1e-9);
+    EXPECT_NEAR(expected[1], pose.getY(), 1e-9);
+    EXPECT_NEAR(expected[2], pose.getZ(), 1e-9);
+    // q and -q are the same rotation
+    double dot = expected[3] * pose.rotation().x + expected[4] * pose.rotation().y +
+      expected[5] * pose.rotation().z + expected[6] * pose.rotation().w;
+    double sign = dot < 0.0 ? -1.0 : 1.0;
+    EXPECT_NEAR(expected[3], sign * pose.rotation().x, 1e-9) << "state " << i;
+    EXPECT_NEAR(expected[4], sign * pose.rotation().y, 1e-9) << "state " << i;
+    EXPECT_NEAR(expected[5], sign * pose.rotation().z, 1e-9) << "state " << i;
+    EXPECT_NEAR(expected[6], sign * pose.rotation().w, 1e-9) << "state " << i;
+  }
+  space.freeState(state);
+}
+
+namespace
+{
+Eigen::Affine3d statePose(const ompl_interface::PoseModelStateSpace::StateType *state)
+{
+  const ompl::base::SE3StateSpace::StateType &pose = *state->poses[0];
+  Eigen::Affine3d result(Eigen::Quaterniond(pose.rotation().w, pose.rotation().x, pose.rotation().y, pose.rotation().z));
+  result.translation() = Eigen::Vector3d(pose.getX(), pose.getY(), pose.getZ());
+  return result;
+}
+
+/// A state of the right arm with the elbow and the wrist bent, away from singularities
+void setBentArm(ompl_interface::PoseModelStateSpace &space, ompl_interface::PoseModelStateSpace::StateType *state, double offset)
+{
+  const double values[7] = { -0.3, 0.2, -0.5, -1.2, 0.3, -0.8, 0.0 };
+  const std::vector<std::string> &variables = space.getJointModelGroup()->getVariableNames();
+  const char *names[7] = { "r_shoulder_pan_joint", "r_shoulder_lift_joint", "r_upper_arm_roll_joint", "r_elbow_flex_joint",
+                           "r_forearm_roll_joint", "r_wrist_flex_joint", "r_wrist_roll_joint" };
+  for (std::size_t i = 0 ; i < variables.size() ; ++i)
+    for (int j = 0 ; j < 7 ; ++j)
+      if (variables[i] == names[j])
+        state->values[i] = values[j] - offset;
+  state->clearKnownInformation();
+  state->setJointsComputed(true);
+  state->setPoseComputed(false);
+  space.computeStateFK(state);
+}
+}
+
+// the geometric Jacobian of the chain must match finite differences of the forward kinematics
+TEST(PoseModelStateSpace, JacobianMatchesFiniteDifferences)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  ompl_interface::PoseModelStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "right_arm"));
+  const robot_model::JointModelGroup *group = space.getJointModelGroup();
+  const double h = 1e-6;
+
+  ompl_interface::PoseModelStateSpace::StateType *state = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  random_numbers::RandomNumberGenerator rng(7);
+  std::vector<double> values(group->getVariableCount());
+  Eigen::Affine3d pose;
+  Eigen::MatrixXd jacobian;
+  for (int i = 0 ; i < 100 ; ++i)
+  {
+    group->getVariableRandomPositions(rng, values);
+    std::copy(values.begin(), values.end(), state->values);
+    ASSERT_TRUE(space.computeJacobian(state, 0, pose, jacobian));
+    ASSERT_EQ(6, jacobian.rows());
+    ASSERT_EQ((int)values.size(), jacobian.cols());
+    state->setPoseComputed(false);
+    ASSERT_TRUE(space.computeStateFK(state));
+    EXPECT_TRUE(pose.isApprox(statePose(state), 1e-9));
+
+    for (std::size_t v = 0 ; v < values.size() ; ++v)
+    {
+      state->values[v] = values[v] + h;
+      state->setPoseComputed(false);
+      space.computeStateFK(state);
+      const Eigen::Affine3d plus = statePose(state);
+      state->values[v] = values[v] - h;
+      state->setPoseComputed(false);
+      space.computeStateFK(state);
+      const Eigen::Affine3d minus = statePose(state);
+      state->values[v] = values[v];
+
+      const Eigen::Vector3d linear = (plus.translation() - minus.translation()) / (2.0 * h);
+      const Eigen::AngleAxisd rotation(plus.linear() * minus.linear().transpose());
+      const Eigen::Vector3d angular = rotation.angle() * rotation.axis() / (2.0 * h);
+      for (int r = 0 ; r < 3 ; ++r)
+      {
+        EXPECT_NEAR(linear(r), jacobian(r, v), 1e-6) << "state " << i << ", variable " << v;
+        EXPECT_NEAR(angular(r), jacobian(3 + r, v), 1e-6) << "state " << i << ", variable " << v;
+      }
+    }
+  }
+  space.freeState(state);
+}
+
+// with Jacobian steering, the states along a straight line of the tip come from the steps, not from inverse kinematics,
+// whatever the order of the interpolations
+TEST(PoseModelStateSpace, SteeredMotionNeedsNoIK)
+{
+  robot_model::RobotModelPtr robot_model = ompl_interface_test::loadPR2Model();
+  ompl_interface_test::setModelKinematics(robot_model, "right_arm", "torso_lift_link", "r_wrist_roll_link");
+  ompl_interface::PoseModelStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model, "right_arm"));
+  space.setJacobianSteering(true);
+
+  ompl_interface::PoseModelStateSpace::StateType *from = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  ompl_interface::PoseModelStateSpace::StateType *to = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  ompl_interface::PoseModelStateSpace::StateType *state = space.allocState()->as<ompl_interface::PoseModelStateSpace::StateType>();
+  setBentArm(space, from, 0.0);
+  setBentArm(space, to, 0.15);
+  space.resetStatistics();
+
+  const double ts[] = { 0.5, 0.25, 0.75, 0.1, 0.2, 0.3, 0.4, 0.6, 0.7, 0.8, 0.9, 1.0 };
+  for (std::size_t i = 0 ; i < sizeof(ts) / sizeof(ts[0]) ; ++i)
+  {
+    space.interpolate(from, to, ts[i], state);
+    EXPECT_TRUE(state->jointsComputed()) << "t = " << ts[i];
+    EXPECT_FALSE(state->isValidityKnown() && !state->isMarkedValid()) << "t = " << ts[i];
+
+    // the joint values reach the interpolated pose
+    Eigen::Affine3d pose;
+    Eigen::MatrixXd jacobian;
+    ASSERT_TRUE(space.computeJacobian(state, 0, pose, jacobian));
+    EXPECT_NEAR(0.0, (pose.translation() - statePose(state).translation()).norm(), 1e-4) << "t = " << ts[i];
+  }
+  EXPECT_EQ(0u, space.getStatistics().ik_calls);
+  EXPECT_EQ(0u, space.getStatistics().jump_rejections);
+
+  // without steering, every interpolated state needs inverse kinematics
+  space.setJacobianSteering(false);
+  space.resetStatistics();
+  for (std::size_t i = 0 ; i < sizeof(ts) / sizeof(ts[0]) ; ++i)
+    space.interpolate(from, to, ts[i], state);
+  EXPECT_EQ(sizeof(ts) / sizeof(ts[0]), space.getStatistics().ik_calls);
+
+  space.freeState(from);
+  space.freeState(to);
+  space.freeState(state);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/parameterization/projected_space/projected_state_space.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <random_numbers/random_numbers.h>
+#include <gtest/gtest.h>
+
+class ProjectedStateSpaceTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    group_ = robot_model_->getJointModelGroup("right_arm");
+  }
+
+  /// Project random states of the right arm; every state the projection accepts must satisfy the constraints,
+  /// as decided by the kinematic constraints themselves
+  void checkProjection(const moveit_msgs::Constraints &constraints, unsigned int min_projected)
+  {
+    robot_state::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    state.update();
+    robot_state::Transforms tf(robot_model_->getModelFrame());
+    ompl_interface::ProjectedStateSpace space(ompl_interface::ModelBasedStateSpaceSpecification(robot_model_, "right_arm"),
+                                              constraints, tf, state);
+    ASSERT_TRUE(space.hasProjectedConstraints());
+
+    kinematic_constraints::KinematicConstraintSet constraint_set(robot_model_);
+    ASSERT_TRUE(constraint_set.add(constraints, tf));
+
+    random_numbers::RandomNumberGenerator rng(3);
+    std::vector<double> values(group_->getVariableCount());
+    ompl::base::State *projected = space.allocState();
+    unsigned int count = 0;
+    for (int i = 0 ; i < 500 ; ++i)
+    {
+      group_->getVariableRandomPositions(rng, values);
+      std::copy(values.begin(), values.end(), projected->as<ompl_interface::ModelBasedStateSpace::StateType>()->values);
+      if (!space.project(projected))
+      {
+        EXPECT_TRUE(projected->as<ompl_interface::ModelBasedStateSpace::StateType>()->isValidityKnown());
+        EXPECT_FALSE(projected->as<ompl_interface::ModelBasedStateSpace::StateType>()->isMarkedValid());
+        continue;
+      }
+      ++count;
+      EXPECT_TRUE(space.satisfiesBounds(projected));
+      space.copyToRobotState(state, projected);
+      state.update();
+      EXPECT_TRUE(constraint_set.decide(state).satisfied) << "state " << i;
+    }
+    space.freeState(projected);
+    EXPECT_GE(count, min_projected);
+  }
+
+  robot_model::RobotModelPtr          robot_model_;
+  const robot_model::JointModelGroup *group_;
+};
+
+TEST_F(ProjectedStateSpaceTest, ProjectedStatesSatisfyOrientationConstraint)
+{
+  robot_state::RobotState state(robot_model_);
+  state.setToDefaultValues();
+  state.update();
+  checkProjection(ompl_interface_test::rightWristConstraints(state), 200);
+}
+
+TEST_F(ProjectedStateSpaceTest, ProjectedStatesSatisfyPoseConstraints)
+{
+  robot_state::RobotState state(robot_model_);
+  state.setToDefaultValues();
+  state.update();
+  checkProjection(ompl_interface_test::rightWristConstraints(state, 0.3), 50);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_TEST_TEST_ROBOT_MODEL_
+#define MOVEIT_OMPL_INTERFACE_TEST_TEST_ROBOT_MODEL_
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit_msgs/Constraints.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <moveit_resources/config.h>
+#include <urdf_parser/urdf_parser.h>
+#include <geometric_shapes/shapes.h>
+#include <boost/filesystem/path.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <fstream>
+#include <sstream>
+
+namespace ompl_interface_test
+{
+
+/// Load the PR2 model from moveit_resources
+inline robot_model::RobotModelPtr loadPR2Model()
+{
+  boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+  std::ifstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str());
+  std::stringstream xml_string;
+  xml_string << xml_file.rdbuf();
+  boost::shared_ptr<urdf::ModelInterface> urdf_model = urdf::parseURDF(xml_string.str());
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  srdf_model->initFile(*urdf_model, (res_path / "pr2_description/srdf/robot.xml").string());
+  return robot_model::RobotModelPtr(new robot_model::RobotModel(urdf_model, srdf_model));
+}
+
+/// Add a shelf to the right of the PR2, within reach of its right arm only.  The robot in its default state
+/// does not touch the shelf.
+inline void addShelf(const planning_scene::PlanningScenePtr &scene)
+{
+  shapes::ShapeConstPtr board(new shapes::Box(0.4, 0.3, 0.02));
+  shapes::ShapeConstPtr side(new shapes::Box(0.4, 0.02, 1.0));
+  for (int i = 0 ; i < 4 ; ++i)
+  {
+    Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+    pose.translation() = Eigen::Vector3d(0.3, -0.65, 0.4 + 0.25 * i);
+    scene->getWorldNonConst()->addToObject("shelf_board_" + boost::lexical_cast<std::string>(i), board, pose);
+  }
+  for (int i = 0 ; i < 2 ; ++i)
+  {
+    Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+    pose.translation() = Eigen::Vector3d(0.3, -0.5 - 0.3 * i, 0.9);
+    scene->getWorldNonConst()->addToObject("shelf_side_" + boost::lexical_cast<std::string>(i), side, pose);
+  }
+}
+
+/// Path constraints on the right wrist of the PR2: keep its orientation in \e state, up to 0.1 rad about the x and
+/// y axes and any rotation about the z axis, and optionally keep it in a \e box_size cube around its position in \e state
+inline moveit_msgs::Constraints rightWristConstraints(const robot_state::RobotState &state, double box_size = 0.0)
+{
+  const std::string link = "r_wrist_roll_link";
+  const Eigen::Affine3d &pose = state.getGlobalLinkTransform(link);
+  moveit_msgs::Constraints constraints;
+
+  moveit_msgs::OrientationConstraint oc;
+  oc.header.frame_id = state.getRobotModel()->getModelFrame();
+  oc.link_name = link;
+  tf::quaternionEigenToMsg(Eigen::Quaterniond(pose.rotation()), oc.orientation);
+  oc.absolute_x_axis_tolerance = 0.1;
+  oc.absolute_y_axis_tolerance = 0.1;
+  oc.absolute_z_axis_tolerance = boost::math::constants::pi<double>();
+  oc.weight = 1.0;
+  constraints.orientation_constraints.push_back(oc);
+
+  if (box_size > 0.0)
+  {
+    moveit_msgs::PositionConstraint pc;
+    pc.header.frame_id = oc.header.frame_id;
+    pc.link_name = link;
+    shape_msgs::SolidPrimitive box;
+    box.type = shape_msgs::SolidPrimitive::BOX;
+    box.dimensions.resize(3, box_size);
+    pc.constraint_region.primitives.push_back(box);
+    geometry_msgs::Pose center;
+    tf::poseEigenToMsg(Eigen::Affine3d(Eigen::Translation3d(pose.translation())), center);
+    pc.constraint_region.primitive_poses.push_back(center);
+    pc.weight = 1.0;
+    constraints.position_constraints.push_back(pc);
+  }
+  return constraints;
+}
+
+}
+
+#endif
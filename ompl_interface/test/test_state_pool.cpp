@@ -0,0 +1,163 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/ompl_interface/detail/state_pool.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
+
+TEST(StatePool, BlocksAreDistinctAndAligned)
+{
+  ompl_interface::StatePool pool(40, 16);
+  EXPECT_EQ(48u, pool.getBlockSize());
+
+  std::set<void*> blocks;
+  for (int i = 0 ; i < 1000 ; ++i)
+  {
+    void *block = pool.allocate();
+    EXPECT_EQ(0u, reinterpret_cast<std::size_t>(block) % ompl_interface::StatePool::ALIGNMENT);
+    EXPECT_TRUE(blocks.insert(block).second);
+    // the whole block is usable
+    memset(block, i & 0xff, pool.getBlockSize());
+  }
+  for (std::set<void*>::iterator it = blocks.begin() ; it != blocks.end() ; ++it)
+    pool.free(*it);
+}
+
+// freed blocks are allocated again before new memory is used
+TEST(StatePool, FreedBlocksAreReused)
+{
+  const std::size_t blocks_per_chunk = 128;
+  ompl_interface::StatePool pool(64, blocks_per_chunk);
+  std::vector<char*> blocks(100);
+  for (std::size_t i = 0 ; i < blocks.size() ; ++i)
+    blocks[i] = static_cast<char*>(pool.allocate());
+  // all blocks fit in the first chunk
+  char *chunk = *std::min_element(blocks.begin(), blocks.end());
+  char *chunk_end = chunk + blocks_per_chunk * pool.getBlockSize();
+  for (int round = 0 ; round < 10 ; ++round)
+  {
+    for (std::size_t i = 0 ; i < blocks.size() ; ++i)
+      pool.free(blocks[i]);
+    for (std::size_t i = 0 ; i < blocks.size() ; ++i)
+    {
+      blocks[i] = static_cast<char*>(pool.allocate());
+      EXPECT_TRUE(blocks[i] >= chunk && blocks[i] < chunk_end);
+    }
+  }
+  for (std::size_t i = 0 ; i < blocks.size() ; ++i)
+    pool.free(blocks[i]);
+}
+
+TEST(StatePool, ReleaseOnlyWhenUnused)
+{
+  ompl_interface::StatePool pool(64);
+  void *block = pool.allocate();
+  EXPECT_FALSE(pool.release());
+  pool.free(block);
+  EXPECT_TRUE(pool.release());
+
+  // the pool is usable after a release
+  block = pool.allocate();
+  EXPECT_TRUE(block != NULL);
+  pool.free(block);
+  EXPECT_TRUE(pool.release());
+}
+
+namespace
+{
+void allocateBlocks(ompl_interface::StatePool *pool, std::vector<void*> *blocks, std::size_t count)
+{
+  blocks->resize(count);
+  for (std::size_t i = 0 ; i < count ; ++i)
+  {
+    (*blocks)[i] = pool->allocate();
+    // mark the block with its owner, to detect blocks handed out twice
+    *static_cast<std::vector<void*>**>((*blocks)[i]) = blocks;
+  }
+}
+
+void freeBlocks(ompl_interface::StatePool *pool, std::vector<void*> *blocks, bool *intact)
+{
+  *intact = true;
+  for (std::size_t i = 0 ; i < blocks->size() ; ++i)
+  {
+    *intact = *intact && *static_cast<std::vector<void*>**>((*blocks)[i]) == blocks;
+    pool->free((*blocks)[i]);
+  }
+}
+}
+
+// blocks allocated on some threads and freed on others
+TEST(StatePool, ConcurrentAllocateAndFree)
+{
+  ompl_interface::StatePool pool(32, 64);
+  const int threads = 8;
+  for (int round = 0 ; round < 10 ; ++round)
+  {
+    std::vector<std::vector<void*> > blocks(threads);
+    boost::thread_group allocating;
+    for (int i = 0 ; i < threads ; ++i)
+      allocating.create_thread(boost::bind(&allocateBlocks, &pool, &blocks[i], 1000 + 37 * i));
+    allocating.join_all();
+
+    std::set<void*> distinct;
+    std::size_t total = 0;
+    for (int i = 0 ; i < threads ; ++i)
+    {
+      distinct.insert(blocks[i].begin(), blocks[i].end());
+      total += blocks[i].size();
+    }
+    EXPECT_EQ(total, distinct.size());
+    EXPECT_FALSE(pool.release());
+
+    bool intact[threads];
+    boost::thread_group freeing;
+    for (int i = 0 ; i < threads ; ++i)
+      freeing.create_thread(boost::bind(&freeBlocks, &pool, &blocks[(i + 1) % threads], &intact[(i + 1) % threads]));
+    freeing.join_all();
+    for (int i = 0 ; i < threads ; ++i)
+      EXPECT_TRUE(intact[i]);
+  }
+  EXPECT_TRUE(pool.release());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
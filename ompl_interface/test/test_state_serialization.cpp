@@ -0,0 +1,156 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <boost/math/constants/constants.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+class StateSerializationTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    // the right arm has two continuous joints, the forearm and the wrist roll
+    space_.reset(new ompl_interface::JointModelStateSpace(ompl_interface::ModelBasedStateSpaceSpecification(robot_model_, "right_arm")));
+    space_->setup();
+
+    const robot_model::JointModelGroup *group = space_->getJointModelGroup();
+    const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+    for (std::size_t i = 0 ; i < joints.size() ; ++i)
+      if (joints[i]->getType() == robot_model::JointModel::REVOLUTE &&
+          static_cast<const robot_model::RevoluteJointModel*>(joints[i])->isContinuous())
+        continuous_.push_back(group->getVariableGroupIndex(joints[i]->getName()));
+    ASSERT_EQ(2u, continuous_.size());
+  }
+
+  /// Serialize and deserialize random states, some with continuous joint values far outside [-pi, pi], and check
+  /// every variable comes back within half a quantization step.  If the format \e wraps, the continuous joints
+  /// come back in [-pi, pi] and are compared modulo 2 pi.
+  void roundTrip(double max_error, bool wraps)
+  {
+    ompl::base::StateSamplerPtr sampler = space_->allocDefaultStateSampler();
+    ompl::base::State *state = space_->allocState();
+    ompl::base::State *copy = space_->allocState();
+    std::vector<char> buffer(space_->getSerializationLength());
+    const double offsets[] = { 0.0, 2.0, -2.0, 7.0, -7.0 };
+    const double two_pi = 2.0 * boost::math::constants::pi<double>();
+    const unsigned int variable_count = space_->getJointModelGroup()->getVariableCount();
+
+    for (int i = 0 ; i < 1000 ; ++i)
+    {
+      sampler->sampleUniform(state);
+      for (std::size_t j = 0 ; j < continuous_.size() ; ++j)
+        state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values[continuous_[j]] += offsets[i % 5] * two_pi;
+      state->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag = i % 3 - 1;
+
+      space_->serialize(&buffer[0], state);
+      space_->deserialize(copy, &buffer[0]);
+
+      const double *values = state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+      const double *decoded = copy->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+      EXPECT_EQ(state->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag,
+                copy->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag);
+      for (unsigned int v = 0 ; v < variable_count ; ++v)
+      {
+        double error = values[v] - decoded[v];
+        if (wraps && std::find(continuous_.begin(), continuous_.end(), v) != continuous_.end())
+        {
+          // the decoded value is the wrapped one
+          EXPECT_GE(decoded[v], -boost::math::constants::pi<double>() - 1e-9) << "variable " << v;
+          EXPECT_LE(decoded[v], boost::math::constants::pi<double>() + 1e-9) << "variable " << v;
+          error = std::fabs(error - two_pi * floor(error / two_pi + 0.5));
+        }
+        EXPECT_LE(std::fabs(error), max_error) << "state " << i << ", variable " << v;
+      }
+      EXPECT_LE(space_->distance(state, copy), max_error * variable_count);
+      space_->enforceBounds(copy);
+      EXPECT_TRUE(space_->satisfiesBounds(copy));
+    }
+    space_->freeState(copy);
+    space_->freeState(state);
+  }
+
+  robot_model::RobotModelPtr                  robot_model_;
+  ompl_interface::ModelBasedStateSpacePtr     space_;
+  std::vector<unsigned int>                   continuous_;
+};
+
+TEST_F(StateSerializationTest, Raw)
+{
+  EXPECT_EQ(sizeof(int) + 7 * sizeof(double), space_->getSerializationLength());
+  roundTrip(0.0, false);
+}
+
+// half a step of the widest joint range (2 pi) in each format
+TEST_F(StateSerializationTest, Quantized16)
+{
+  space_->setSerializationFormat(ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_16);
+  EXPECT_EQ(sizeof(int) + 7 * 2, space_->getSerializationLength());
+  roundTrip(4.9e-5, true);
+}
+
+TEST_F(StateSerializationTest, Quantized32)
+{
+  space_->setSerializationFormat(ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_32);
+  EXPECT_EQ(sizeof(int) + 7 * 4, space_->getSerializationLength());
+  roundTrip(7.4e-10, true);
+}
+
+// states stored in one format are never loaded in another
+TEST_F(StateSerializationTest, SignatureDependsOnFormat)
+{
+  std::vector<int> raw, quantized16, quantized32;
+  space_->computeSignature(raw);
+  space_->setSerializationFormat(ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_16);
+  space_->computeSignature(quantized16);
+  space_->setSerializationFormat(ompl_interface::ModelBasedStateSpace::SERIALIZE_QUANTIZED_32);
+  space_->computeSignature(quantized32);
+  EXPECT_NE(raw, quantized16);
+  EXPECT_NE(raw, quantized32);
+  EXPECT_NE(quantized16, quantized32);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
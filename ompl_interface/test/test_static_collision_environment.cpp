@@ -0,0 +1,109 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/detail/static_collision_environment.h>
+#include <random_numbers/random_numbers.h>
+#include <gtest/gtest.h>
+
+class StaticCollisionEnvironmentTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    ompl_interface_test::addShelf(scene_);
+    group_ = robot_model_->getJointModelGroup("right_arm");
+  }
+
+  /// Compare the environment with the planning scene for random states of the right arm
+  void compareWithPlanningScene(unsigned int count)
+  {
+    robot_state::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    state.update();
+    ASSERT_FALSE(scene_->isStateColliding(state));
+
+    ompl_interface::StaticCollisionEnvironment environment(scene_, group_, state);
+    ASSERT_TRUE(environment.isValid());
+
+    random_numbers::RandomNumberGenerator rng(42);
+    std::vector<double> values(group_->getVariableCount());
+    unsigned int colliding = 0;
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+      group_->getVariableRandomPositions(rng, values);
+      state.setJointGroupPositions(group_, values);
+      state.update();
+
+      collision_detection::CollisionRequest req;
+      collision_detection::CollisionResult scene_res;
+      scene_->checkCollision(req, scene_res, state);
+      collision_detection::CollisionResult env_res;
+      environment.checkCollision(req, env_res, state);
+      EXPECT_EQ(scene_res.collision, env_res.collision) << "state " << i;
+      if (scene_res.collision)
+        ++colliding;
+    }
+    // both outcomes are exercised
+    EXPECT_GT(colliding, 0u);
+    EXPECT_LT(colliding, count);
+  }
+
+  robot_model::RobotModelPtr          robot_model_;
+  planning_scene::PlanningScenePtr    scene_;
+  const robot_model::JointModelGroup *group_;
+};
+
+TEST_F(StaticCollisionEnvironmentTest, MatchesPlanningScene)
+{
+  compareWithPlanningScene(2000);
+}
+
+// the padding applies to the world objects only; the static links of the robot are checked as in self collision
+TEST_F(StaticCollisionEnvironmentTest, MatchesPlanningSceneWithPadding)
+{
+  scene_->getCollisionRobotNonConst()->setPadding(0.03);
+  scene_->propogateRobotPadding();
+  compareWithPlanningScene(2000);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/ompl_interface/detail/thread_local_storage.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <set>
+
+namespace
+{
+void recordInstance(const ompl_interface::ThreadLocalStorage<int> *storage, int value, int **instance, bool *stable)
+{
+  *instance = storage->get();
+  **instance += value;
+  *stable = true;
+  for (int i = 0 ; i < 1000 ; ++i)
+    *stable = *stable && storage->get() == *instance;
+}
+}
+
+TEST(ThreadLocalStorage, OneInstancePerThread)
+{
+  ompl_interface::ThreadLocalStorage<int> storage(10);
+  int *mine = storage.get();
+  EXPECT_EQ(10, *mine);
+  EXPECT_EQ(mine, storage.get());
+
+  const int count = 8;
+  std::vector<int*> instances(count, (int*)NULL);
+  bool stable[count];
+  boost::thread_group threads;
+  for (int i = 0 ; i < count ; ++i)
+    threads.create_thread(boost::bind(&recordInstance, &storage, i, &instances[i], &stable[i]));
+  threads.join_all();
+
+  std::set<int*> distinct(instances.begin(), instances.end());
+  distinct.insert(mine);
+  EXPECT_EQ((std::size_t)count + 1, distinct.size());
+  for (int i = 0 ; i < count ; ++i)
+  {
+    EXPECT_TRUE(stable[i]);
+    // each thread started from the prototype
+    EXPECT_EQ(10 + i, *instances[i]);
+  }
+  EXPECT_EQ(10, *mine);
+}
+
+TEST(ThreadLocalStorage, StoragesDoNotShareInstances)
+{
+  ompl_interface::ThreadLocalStorage<int> a(1);
+  ompl_interface::ThreadLocalStorage<int> b(2);
+  EXPECT_NE(a.get(), b.get());
+  EXPECT_EQ(1, *a.get());
+  EXPECT_EQ(2, *b.get());
+}
+
+// a thread that outlives many storages never sees the instance of a destroyed one
+TEST(ThreadLocalStorage, DestroyedStoragesAreForgotten)
+{
+  for (int i = 0 ; i < 1000 ; ++i)
+  {
+    ompl_interface::ThreadLocalStorage<int> storage(i);
+    EXPECT_EQ(i, *storage.get());
+    *storage.get() = -1;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
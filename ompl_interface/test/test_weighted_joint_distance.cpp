@@ -0,0 +1,116 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include "test_robot_model.h"
+#include <moveit/ompl_interface/parameterization/weighted_joint_distance.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <gtest/gtest.h>
+
+class WeightedJointDistanceTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    robot_model_ = ompl_interface_test::loadPR2Model();
+    group_ = robot_model_->getJointModelGroup("right_arm");
+    distance_.reset(new ompl_interface::WeightedJointDistance(robot_model_, group_));
+  }
+
+  double weight(const std::string &joint) const
+  {
+    const std::vector<const robot_model::JointModel*> &joints = group_->getActiveJointModels();
+    for (std::size_t i = 0 ; i < joints.size() ; ++i)
+      if (joints[i]->getName() == joint)
+        return distance_->getWeights()[i];
+    ADD_FAILURE() << "no joint " << joint;
+    return 0.0;
+  }
+
+  robot_model::RobotModelPtr                    robot_model_;
+  const robot_model::JointModelGroup           *group_;
+  ompl_interface::WeightedJointDistancePtr      distance_;
+};
+
+TEST_F(WeightedJointDistanceTest, WeightsDecreaseTowardsTheWrist)
+{
+  EXPECT_GT(weight("r_shoulder_pan_joint"), weight("r_elbow_flex_joint"));
+  EXPECT_GT(weight("r_shoulder_lift_joint"), weight("r_elbow_flex_joint"));
+  EXPECT_GT(weight("r_elbow_flex_joint"), weight("r_wrist_flex_joint"));
+}
+
+TEST_F(WeightedJointDistanceTest, RevoluteWeightsAverageOne)
+{
+  const std::vector<const robot_model::JointModel*> &joints = group_->getActiveJointModels();
+  double total = 0.0;
+  unsigned int revolute = 0;
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+    if (joints[i]->getType() == robot_model::JointModel::REVOLUTE)
+    {
+      EXPECT_GT(distance_->getWeights()[i], 0.0);
+      total += distance_->getWeights()[i] / joints[i]->getDistanceFactor();
+      ++revolute;
+    }
+  ASSERT_EQ(joints.size(), revolute);
+  EXPECT_NEAR(1.0, total / revolute, 1e-9);
+}
+
+TEST_F(WeightedJointDistanceTest, DistanceIsSymmetricAndZeroOnIdenticalStates)
+{
+  ompl_interface::ModelBasedStateSpacePtr space(new ompl_interface::JointModelStateSpace(
+                                                  ompl_interface::ModelBasedStateSpaceSpecification(robot_model_, "right_arm")));
+  ompl::base::StateSamplerPtr sampler = space->allocDefaultStateSampler();
+  ompl::base::State *a = space->allocState();
+  ompl::base::State *b = space->allocState();
+  for (int i = 0 ; i < 200 ; ++i)
+  {
+    sampler->sampleUniform(a);
+    sampler->sampleUniform(b);
+    const double d = distance_->distance(a, b);
+    EXPECT_GT(d, 0.0);
+    EXPECT_DOUBLE_EQ(d, distance_->distance(b, a));
+    EXPECT_EQ(0.0, distance_->distance(a, a));
+    space->copyState(b, a);
+    EXPECT_EQ(0.0, distance_->distance(a, b));
+  }
+  space->freeState(a);
+  space->freeState(b);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2015, Rice University
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Rice University nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/ompl_interface/detail/worker_pool.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace
+{
+void increment(boost::mutex *lock, int *counter)
+{
+  boost::mutex::scoped_lock slock(*lock);
+  ++*counter;
+}
+
+// a batch of tasks that each run a nested batch
+void nested(ompl_interface::WorkerPool *pool, boost::mutex *lock, int *counter)
+{
+  std::vector<ompl_interface::WorkerPool::Task> tasks(4, boost::bind(&increment, lock, counter));
+  pool->run(tasks);
+}
+
+void runNested(ompl_interface::WorkerPool *pool, boost::mutex *lock, int *counter)
+{
+  std::vector<ompl_interface::WorkerPool::Task> tasks(8, boost::bind(&nested, pool, lock, counter));
+  for (int i = 0 ; i < 50 ; ++i)
+    pool->run(tasks);
+}
+
+void fail()
+{
+  throw std::runtime_error("task failed");
+}
+}
+
+TEST(WorkerPool, RunsEveryTaskOnce)
+{
+  ompl_interface::WorkerPool pool(3);
+  boost::mutex lock;
+  std::vector<int> counters(100, 0);
+  std::vector<ompl_interface::WorkerPool::Task> tasks;
+  for (std::size_t i = 0 ; i < counters.size() ; ++i)
+    tasks.push_back(boost::bind(&increment, &lock, &counters[i]));
+  pool.run(tasks);
+  for (std::size_t i = 0 ; i < counters.size() ; ++i)
+    EXPECT_EQ(1, counters[i]);
+}
+
+// tasks that run batches themselves, from several threads at once, do not deadlock
+TEST(WorkerPool, NestedAndConcurrentRuns)
+{
+  ompl_interface::WorkerPool pool(3);
+  boost::mutex lock;
+  int counter = 0;
+  const int callers = 4;
+  boost::thread_group group;
+  for (int i = 0 ; i < callers ; ++i)
+    group.create_thread(boost::bind(&runNested, &pool, &lock, &counter));
+  group.join_all();
+  EXPECT_EQ(callers * 50 * 8 * 4, counter);
+}
+
+// an exception of a task reaches the caller of run() once the other tasks are done, and the pool stays usable
+TEST(WorkerPool, ExceptionsArePassedOn)
+{
+  const unsigned int thread_counts[] = { 1, 3 };
+  for (int t = 0 ; t < 2 ; ++t)
+  {
+    ompl_interface::WorkerPool pool(thread_counts[t]);
+    boost::mutex lock;
+    int counter = 0;
+    std::vector<ompl_interface::WorkerPool::Task> tasks(20, boost::bind(&increment, &lock, &counter));
+    tasks[3] = &fail;
+    tasks[11] = &fail;
+    EXPECT_THROW(pool.run(tasks), std::runtime_error);
+    EXPECT_EQ(18, counter);
+
+    tasks[3] = tasks[11] = boost::bind(&increment, &lock, &counter);
+    pool.run(tasks);
+    EXPECT_EQ(38, counter);
+
+    // a batch of one task runs on the calling thread
+    EXPECT_THROW(pool.run(std::vector<ompl_interface::WorkerPool::Task>(1, &fail)), std::runtime_error);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}